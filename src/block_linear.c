@@ -0,0 +1,296 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * NVIDIA Block-Linear Layout
+ */
+
+#include "block_linear.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* DRM_FORMAT_MOD_NVIDIA_BLOCK_LINEAR_2D(c, s, g, k, h) fields */
+#define NVIDIA_MOD_VENDOR 0x03
+#define NVIDIA_MOD_BLOCK_LINEAR_2D 0x10
+#define NVIDIA_MOD_MAX_LOG2_BLOCK_HEIGHT 5
+
+/* Bytes moved at once: one run of a GOB row */
+#define GOB_RUN 16
+
+gboolean block_linear_layout_from_modifier(guint64 modifier, BlockLinearLayout *layout)
+{
+    BlockLinearLayout l;
+
+    if ((modifier >> 56) != NVIDIA_MOD_VENDOR || !(modifier & NVIDIA_MOD_BLOCK_LINEAR_2D))
+        return FALSE;
+
+    l.log2_block_height = modifier & 0xf;
+    l.kind = (modifier >> 12) & 0xff;
+    l.gob_generation = (modifier >> 20) & 0x3;
+    l.desktop_sectors = (modifier >> 22) & 0x1;
+    l.compression = (modifier >> 23) & 0x7;
+
+    if (layout)
+        *layout = l;
+
+    /* Tegra (pre-Xavier) sectors are remapped below the GOB swizzle and
+     * compressed surfaces need the GPU to decompress */
+    return l.log2_block_height <= NVIDIA_MOD_MAX_LOG2_BLOCK_HEIGHT &&
+           l.desktop_sectors && l.compression == 0;
+}
+
+guint block_linear_block_rows(const BlockLinearLayout *layout)
+{
+    return BLOCK_LINEAR_GOB_HEIGHT << layout->log2_block_height;
+}
+
+static inline gsize
+block_size(const BlockLinearLayout *layout)
+{
+    return (gsize)BLOCK_LINEAR_GOB_SIZE << layout->log2_block_height;
+}
+
+gsize block_linear_plane_size(const BlockLinearLayout *layout, guint pitch, guint rows)
+{
+    guint block_rows = block_linear_block_rows(layout);
+    gsize blocks_y = (rows + block_rows - 1) / block_rows;
+
+    return blocks_y * (pitch / BLOCK_LINEAR_GOB_WIDTH) * block_size(layout);
+}
+
+gsize block_linear_offset(const BlockLinearLayout *layout, guint pitch, guint x, guint y)
+{
+    guint block_rows = block_linear_block_rows(layout);
+    gsize block = (gsize)(y / block_rows) * (pitch / BLOCK_LINEAR_GOB_WIDTH) +
+                  x / BLOCK_LINEAR_GOB_WIDTH;
+
+    return block * block_size(layout) +
+           (y % block_rows / BLOCK_LINEAR_GOB_HEIGHT) * BLOCK_LINEAR_GOB_SIZE +
+           (x % 64 / 32) * 256 + (y % 8 / 2) * 64 + (x % 32 / 16) * 32 + (y % 2) * 16 +
+           x % 16;
+}
+
+/* Offset of the first run of row @y, before the x terms */
+static inline gsize
+row_base(const BlockLinearLayout *layout, guint pitch, guint y)
+{
+    guint block_rows = block_linear_block_rows(layout);
+
+    return (gsize)(y / block_rows) * (pitch / BLOCK_LINEAR_GOB_WIDTH) * block_size(layout) +
+           (y % block_rows / BLOCK_LINEAR_GOB_HEIGHT) * BLOCK_LINEAR_GOB_SIZE +
+           (y % 8 / 2) * 64 + (y % 2) * 16;
+}
+
+/* Offset of run @x (a multiple of GOB_RUN) within its row */
+static inline gsize
+run_offset(const BlockLinearLayout *layout, guint x)
+{
+    return (gsize)(x / BLOCK_LINEAR_GOB_WIDTH) * block_size(layout) +
+           (x % 64 / 32) * 256 + (x % 32 / 16) * 32;
+}
+
+static inline void
+copy_run(guint8 *dst, const guint8 *src)
+{
+#if defined(__SSE2__)
+    _mm_storeu_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+#elif defined(__aarch64__)
+    vst1q_u8(dst, vld1q_u8(src));
+#else
+    memcpy(dst, src, GOB_RUN);
+#endif
+}
+
+void block_linear_detile(const BlockLinearLayout *layout,
+                         const guint8 *tiled, guint pitch,
+                         guint8 *linear, gint stride,
+                         guint row_bytes, guint rows)
+{
+    guint full = row_bytes & ~(GOB_RUN - 1);
+
+    for (guint y = 0; y < rows; y++)
+    {
+        const guint8 *src = tiled + row_base(layout, pitch, y);
+        guint8 *dst = linear + (gsize)y * stride;
+        guint x = 0;
+
+        for (; x < full; x += GOB_RUN)
+            copy_run(dst + x, src + run_offset(layout, x));
+        if (x < row_bytes)
+            memcpy(dst + x, src + run_offset(layout, x), row_bytes - x);
+    }
+}
+
+void block_linear_tile(const BlockLinearLayout *layout,
+                       const guint8 *linear, gint stride,
+                       guint8 *tiled, guint pitch,
+                       guint row_bytes, guint rows)
+{
+    guint full = row_bytes & ~(GOB_RUN - 1);
+
+    for (guint y = 0; y < rows; y++)
+    {
+        const guint8 *src = linear + (gsize)y * stride;
+        guint8 *dst = tiled + row_base(layout, pitch, y);
+        guint x = 0;
+
+        for (; x < full; x += GOB_RUN)
+            copy_run(dst + run_offset(layout, x), src + x);
+        if (x < row_bytes)
+            memcpy(dst + run_offset(layout, x), src + x, row_bytes - x);
+    }
+}
+
+/* ============================================================================
+ * GstVideoMeta map hook
+ * ============================================================================ */
+
+/* Per-buffer state: the layout plus one linear shadow per plane, shared by
+ * concurrent maps of that plane */
+typedef struct
+{
+    BlockLinearLayout layout;
+    GMutex lock;
+    guint8 *shadow[GST_VIDEO_MAX_PLANES];
+    gint shadow_stride[GST_VIDEO_MAX_PLANES];
+    guint map_count[GST_VIDEO_MAX_PLANES];
+} BlockLinearMapping;
+
+static GQuark
+block_linear_mapping_quark(void)
+{
+    return g_quark_from_static_string("block-linear-mapping");
+}
+
+static void
+block_linear_mapping_free(BlockLinearMapping *m)
+{
+    for (guint i = 0; i < GST_VIDEO_MAX_PLANES; i++)
+        g_free(m->shadow[i]);
+    g_mutex_clear(&m->lock);
+    g_free(m);
+}
+
+/* Bytes per row and rows of @plane */
+static void
+plane_extent(const GstVideoMeta *meta, guint plane, guint *row_bytes, guint *rows)
+{
+    const GstVideoFormatInfo *finfo = gst_video_format_get_info(meta->format);
+
+    *row_bytes = 0;
+    *rows = 0;
+    for (guint c = 0; c < GST_VIDEO_FORMAT_INFO_N_COMPONENTS(finfo); c++)
+    {
+        if (GST_VIDEO_FORMAT_INFO_PLANE(finfo, c) != plane)
+            continue;
+
+        /* Interleaved components (UV) share the plane: the pixel stride
+         * of the first one covers them all */
+        *row_bytes = GST_VIDEO_FORMAT_INFO_SCALE_WIDTH(finfo, c, meta->width) *
+                     GST_VIDEO_FORMAT_INFO_PSTRIDE(finfo, c);
+        *rows = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT(finfo, c, meta->height);
+        return;
+    }
+}
+
+static gboolean
+block_linear_meta_map(GstVideoMeta *meta, guint plane, GstMapInfo *info,
+                      gpointer *data, gint *stride, GstMapFlags flags)
+{
+    BlockLinearMapping *m = gst_mini_object_get_qdata(GST_MINI_OBJECT(meta->buffer),
+                                                      block_linear_mapping_quark());
+
+    /* Meta copied onto another buffer: plain map, as the default does */
+    if (!m)
+    {
+        if (!gst_buffer_map(meta->buffer, info, flags))
+            return FALSE;
+        *data = info->data + meta->offset[plane];
+        *stride = meta->stride[plane];
+        return TRUE;
+    }
+
+    /* Even a write-only map needs the current contents: the caller may
+     * write part of the plane and the whole plane is retiled */
+    if (!gst_buffer_map(meta->buffer, info, flags | GST_MAP_READ))
+        return FALSE;
+
+    guint row_bytes, rows;
+    plane_extent(meta, plane, &row_bytes, &rows);
+    guint pitch = (guint)meta->stride[plane];
+
+    if (pitch % BLOCK_LINEAR_GOB_WIDTH != 0 || pitch < row_bytes ||
+        meta->offset[plane] + block_linear_plane_size(&m->layout, pitch, rows) > info->size)
+    {
+        GST_WARNING("Plane %u (pitch %u, %ux%u bytes) doesn't fit a block-linear layout",
+                    plane, pitch, row_bytes, rows);
+        gst_buffer_unmap(meta->buffer, info);
+        return FALSE;
+    }
+
+    g_mutex_lock(&m->lock);
+    if (m->map_count[plane]++ == 0)
+    {
+        m->shadow_stride[plane] = (gint)GST_ROUND_UP_64(row_bytes);
+        m->shadow[plane] = g_malloc((gsize)m->shadow_stride[plane] * rows);
+        block_linear_detile(&m->layout, info->data + meta->offset[plane], pitch,
+                            m->shadow[plane], m->shadow_stride[plane], row_bytes, rows);
+    }
+    *data = m->shadow[plane];
+    *stride = m->shadow_stride[plane];
+    g_mutex_unlock(&m->lock);
+
+    return TRUE;
+}
+
+static gboolean
+block_linear_meta_unmap(GstVideoMeta *meta, guint plane, GstMapInfo *info)
+{
+    BlockLinearMapping *m = gst_mini_object_get_qdata(GST_MINI_OBJECT(meta->buffer),
+                                                      block_linear_mapping_quark());
+
+    if (m)
+    {
+        g_mutex_lock(&m->lock);
+        if (info->flags & GST_MAP_WRITE)
+        {
+            guint row_bytes, rows;
+            plane_extent(meta, plane, &row_bytes, &rows);
+            block_linear_tile(&m->layout, m->shadow[plane], m->shadow_stride[plane],
+                              info->data + meta->offset[plane], (guint)meta->stride[plane],
+                              row_bytes, rows);
+        }
+        if (--m->map_count[plane] == 0)
+        {
+            g_free(m->shadow[plane]);
+            m->shadow[plane] = NULL;
+        }
+        g_mutex_unlock(&m->lock);
+    }
+
+    gst_buffer_unmap(meta->buffer, info);
+    return TRUE;
+}
+
+gboolean block_linear_install_video_meta_map(GstVideoMeta *vmeta, guint64 modifier)
+{
+    BlockLinearLayout layout;
+
+    if (!block_linear_layout_from_modifier(modifier, &layout))
+        return FALSE;
+
+    BlockLinearMapping *m = g_new0(BlockLinearMapping, 1);
+    m->layout = layout;
+    g_mutex_init(&m->lock);
+
+    gst_mini_object_set_qdata(GST_MINI_OBJECT(vmeta->buffer), block_linear_mapping_quark(),
+                              m, (GDestroyNotify)block_linear_mapping_free);
+    vmeta->map = block_linear_meta_map;
+    vmeta->unmap = block_linear_meta_unmap;
+    return TRUE;
+}
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * NVIDIA Block-Linear Layout
+ * CPU conversion between the block-linear layout of the NVIDIA tiled DRM
+ * modifiers (0x03000000006060xx, ...) and linear rows, plus a GstVideoMeta
+ * map/unmap hook so CPU maps of tiled output buffers see linear planes.
+ *
+ * A plane is a grid of blocks, each (1 << log2_block_height) GOBs stacked
+ * vertically; a GOB is 64 bytes x 8 rows, stored as 16-byte runs:
+ *
+ *   offset in GOB = (x % 64 / 32) * 256 + (y % 8 / 2) * 64 +
+ *                   (x % 32 / 16) * 32 + (y % 2) * 16 + x % 16
+ *
+ * Only the desktop/Xavier+ sector layout without compression can be
+ * converted on the CPU.
+ */
+
+#ifndef __BLOCK_LINEAR_H__
+#define __BLOCK_LINEAR_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+#define BLOCK_LINEAR_GOB_WIDTH 64
+#define BLOCK_LINEAR_GOB_HEIGHT 8
+#define BLOCK_LINEAR_GOB_SIZE (BLOCK_LINEAR_GOB_WIDTH * BLOCK_LINEAR_GOB_HEIGHT)
+
+typedef struct
+{
+    guint log2_block_height; /* Block height in GOBs, log2 (h, 0-5) */
+    guint kind;              /* Page kind (k) */
+    guint gob_generation;    /* GOB height/kind generation (g) */
+    gboolean desktop_sectors; /* Sector layout (s): desktop/Xavier+ */
+    guint compression;       /* Compression (c), 0 = none */
+} BlockLinearLayout;
+
+/**
+ * Decode an NVIDIA block-linear modifier.
+ *
+ * @param modifier DRM format modifier
+ * @param layout Decoded fields (may be NULL)
+ * @return TRUE if @modifier is an NVIDIA block-linear 2D modifier the CPU
+ *         can convert (desktop sector layout, no compression)
+ */
+gboolean block_linear_layout_from_modifier(guint64 modifier, BlockLinearLayout *layout);
+
+/**
+ * Rows covered by one block.
+ */
+guint block_linear_block_rows(const BlockLinearLayout *layout);
+
+/**
+ * Byte size of a tiled plane with @pitch bytes per row of GOBs (a multiple
+ * of BLOCK_LINEAR_GOB_WIDTH) and @rows rows, padded to whole blocks.
+ */
+gsize block_linear_plane_size(const BlockLinearLayout *layout, guint pitch, guint rows);
+
+/**
+ * Scalar reference: byte offset of linear byte (@x, @y) in a tiled plane.
+ */
+gsize block_linear_offset(const BlockLinearLayout *layout, guint pitch, guint x, guint y);
+
+/**
+ * Tiled → linear for rows [0, @rows) of @row_bytes bytes, moving whole
+ * 16-byte GOB runs.
+ *
+ * @param layout Block layout
+ * @param tiled Tiled plane
+ * @param pitch Tiled pitch (multiple of BLOCK_LINEAR_GOB_WIDTH, >= @row_bytes)
+ * @param linear Linear destination
+ * @param stride Linear stride
+ * @param row_bytes Bytes per row to convert
+ * @param rows Rows to convert
+ */
+void block_linear_detile(const BlockLinearLayout *layout,
+                         const guint8 *tiled, guint pitch,
+                         guint8 *linear, gint stride,
+                         guint row_bytes, guint rows);
+
+/**
+ * Linear → tiled, the inverse of block_linear_detile(). Tiled bytes
+ * outside the converted rectangle are left untouched.
+ */
+void block_linear_tile(const BlockLinearLayout *layout,
+                       const guint8 *linear, gint stride,
+                       guint8 *tiled, guint pitch,
+                       guint row_bytes, guint rows);
+
+/**
+ * Make CPU maps of @vmeta's planes (gst_video_frame_map(),
+ * gst_video_meta_map()) detile into a linear shadow, and retile it on
+ * unmap after a write map. Does nothing unless @modifier is convertible.
+ * The meta's strides must hold the tiled pitch of each plane.
+ *
+ * @param vmeta Video meta of a buffer in @modifier layout
+ * @param modifier DRM format modifier of the buffer
+ * @return TRUE if the map hook was installed
+ */
+gboolean block_linear_install_video_meta_map(GstVideoMeta *vmeta, guint64 modifier);
+
+G_END_DECLS
+
+#endif /* __BLOCK_LINEAR_H__ */
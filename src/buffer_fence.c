@@ -0,0 +1,317 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Buffer Fences
+ * Deferred GPU completion tracking for output DMA-BUFs
+ */
+
+#include "buffer_fence.h"
+
+#include <gst/allocators/allocators.h>
+
+struct _BufferFence
+{
+    gint refcount;
+    const BufferFenceBackend *backend;
+    gpointer event;
+
+    /* Protects pending/keepalive: the streaming thread records while
+     * downstream threads may wait on the same fence through a map. */
+    GMutex lock;
+    gboolean pending;
+    GstBuffer *keepalive;
+};
+
+static GQuark
+buffer_fence_quark(void)
+{
+    static GQuark quark = 0;
+    if (!quark)
+        quark = g_quark_from_static_string("buffer-fence");
+    return quark;
+}
+
+BufferFence *
+buffer_fence_new(const BufferFenceBackend *backend)
+{
+    g_return_val_if_fail(backend != NULL, NULL);
+
+    gpointer event = backend->event_create(backend->user_data);
+    if (!event)
+    {
+        g_warning("Failed to create fence event");
+        return NULL;
+    }
+
+    BufferFence *fence = g_new0(BufferFence, 1);
+    fence->refcount = 1;
+    fence->backend = backend;
+    fence->event = event;
+    g_mutex_init(&fence->lock);
+    return fence;
+}
+
+BufferFence *
+buffer_fence_ref(BufferFence *fence)
+{
+    g_return_val_if_fail(fence != NULL, NULL);
+
+    g_atomic_int_inc(&fence->refcount);
+    return fence;
+}
+
+void buffer_fence_unref(BufferFence *fence)
+{
+    if (!fence)
+        return;
+
+    if (!g_atomic_int_dec_and_test(&fence->refcount))
+        return;
+
+    /* The event may still be referenced by the stream */
+    buffer_fence_wait(fence);
+
+    fence->backend->event_destroy(fence->event, fence->backend->user_data);
+    g_mutex_clear(&fence->lock);
+    g_free(fence);
+}
+
+/* Called with the lock held once the event is known to be complete.
+ * Returns the keepalive buffer for the caller to unref outside the lock. */
+static GstBuffer *
+buffer_fence_complete_locked(BufferFence *fence)
+{
+    GstBuffer *keepalive = fence->keepalive;
+
+    fence->keepalive = NULL;
+    fence->pending = FALSE;
+    return keepalive;
+}
+
+gboolean
+buffer_fence_record(BufferFence *fence, gpointer stream, GstBuffer *keepalive)
+{
+    g_return_val_if_fail(fence != NULL, FALSE);
+
+    /* Never re-record over unfinished work: the old keepalive must outlive it */
+    if (!buffer_fence_wait(fence))
+        return FALSE;
+
+    g_mutex_lock(&fence->lock);
+
+    if (!fence->backend->event_record(fence->event, stream, fence->backend->user_data))
+    {
+        g_mutex_unlock(&fence->lock);
+        g_warning("Failed to record fence event");
+        return FALSE;
+    }
+
+    fence->pending = TRUE;
+    fence->keepalive = keepalive ? gst_buffer_ref(keepalive) : NULL;
+
+    g_mutex_unlock(&fence->lock);
+    return TRUE;
+}
+
+gboolean
+buffer_fence_is_signaled(BufferFence *fence)
+{
+    g_return_val_if_fail(fence != NULL, TRUE);
+
+    GstBuffer *keepalive = NULL;
+    gboolean signaled;
+
+    g_mutex_lock(&fence->lock);
+    signaled = !fence->pending ||
+               fence->backend->event_query(fence->event, fence->backend->user_data);
+    if (signaled && fence->pending)
+        keepalive = buffer_fence_complete_locked(fence);
+    g_mutex_unlock(&fence->lock);
+
+    if (keepalive)
+        gst_buffer_unref(keepalive);
+
+    return signaled;
+}
+
+gboolean
+buffer_fence_wait(BufferFence *fence)
+{
+    g_return_val_if_fail(fence != NULL, FALSE);
+
+    GstBuffer *keepalive = NULL;
+    gboolean ret = TRUE;
+
+    g_mutex_lock(&fence->lock);
+    if (fence->pending)
+    {
+        ret = fence->backend->event_synchronize(fence->event, fence->backend->user_data);
+        if (!ret)
+            g_warning("Fence synchronize failed");
+
+        /* Even on failure there is nothing more to wait for */
+        keepalive = buffer_fence_complete_locked(fence);
+    }
+    g_mutex_unlock(&fence->lock);
+
+    if (keepalive)
+        gst_buffer_unref(keepalive);
+
+    return ret;
+}
+
+void buffer_fence_attach(GstMemory *mem, BufferFence *fence)
+{
+    g_return_if_fail(mem != NULL);
+    g_return_if_fail(fence != NULL);
+
+    gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(mem), buffer_fence_quark(),
+                              buffer_fence_ref(fence), (GDestroyNotify)buffer_fence_unref);
+}
+
+BufferFence *
+buffer_fence_get(GstMemory *mem)
+{
+    while (mem)
+    {
+        BufferFence *fence = gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(mem),
+                                                       buffer_fence_quark());
+        if (fence)
+            return fence;
+        mem = mem->parent;
+    }
+    return NULL;
+}
+
+gboolean
+buffer_fence_wait_buffer(GstBuffer *buffer)
+{
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), FALSE);
+
+    gboolean ret = TRUE;
+    guint n = gst_buffer_n_memory(buffer);
+
+    for (guint i = 0; i < n; i++)
+    {
+        BufferFence *fence = buffer_fence_get(gst_buffer_peek_memory(buffer, i));
+        if (fence && !buffer_fence_wait(fence))
+            ret = FALSE;
+    }
+
+    return ret;
+}
+
+gboolean
+buffer_fence_export_buffer(GstBuffer *buffer, BufferFenceExportFunc export_func,
+                           gpointer user_data)
+{
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), FALSE);
+    g_return_val_if_fail(export_func != NULL, FALSE);
+
+    gboolean ret = TRUE;
+    guint n = gst_buffer_n_memory(buffer);
+
+    for (guint i = 0; i < n; i++)
+    {
+        GstMemory *mem = gst_buffer_peek_memory(buffer, i);
+        BufferFence *fence = buffer_fence_get(mem);
+        gboolean exported;
+
+        if (!fence)
+            continue;
+
+        /* Held across the export so the event can't be re-recorded under it */
+        g_mutex_lock(&fence->lock);
+        exported = !fence->pending ||
+                   export_func(fence->event, mem, user_data);
+        g_mutex_unlock(&fence->lock);
+
+        if (!exported && !buffer_fence_wait(fence))
+            ret = FALSE;
+    }
+
+    return ret;
+}
+
+/* ============================================================================
+ * Fenced DMA-BUF allocator
+ *
+ * A GstDmaBufAllocator whose map functions wait on the memory's fence first,
+ * so CPU readers always observe completed GPU writes.
+ * ============================================================================ */
+
+typedef struct _BufferFenceAllocator
+{
+    GstDmaBufAllocator parent;
+
+    /* Map functions installed by GstFdAllocator, chained after waiting.
+     * Kept per instance: instances may be initialized concurrently. */
+    GstMemoryMapFunction parent_mem_map;
+    GstMemoryMapFullFunction parent_mem_map_full;
+} BufferFenceAllocator;
+
+typedef struct _BufferFenceAllocatorClass
+{
+    GstDmaBufAllocatorClass parent_class;
+} BufferFenceAllocatorClass;
+
+G_DEFINE_TYPE(BufferFenceAllocator, buffer_fence_allocator, GST_TYPE_DMABUF_ALLOCATOR)
+
+static void
+buffer_fence_mem_wait(GstMemory *mem)
+{
+    BufferFence *fence = buffer_fence_get(mem);
+    if (fence)
+        buffer_fence_wait(fence);
+}
+
+static gpointer
+buffer_fence_mem_map(GstMemory *mem, gsize maxsize, GstMapFlags flags)
+{
+    BufferFenceAllocator *alloc = (BufferFenceAllocator *)mem->allocator;
+
+    buffer_fence_mem_wait(mem);
+    return alloc->parent_mem_map(mem, maxsize, flags);
+}
+
+static gpointer
+buffer_fence_mem_map_full(GstMemory *mem, GstMapInfo *info, gsize maxsize)
+{
+    BufferFenceAllocator *alloc = (BufferFenceAllocator *)mem->allocator;
+
+    buffer_fence_mem_wait(mem);
+    return alloc->parent_mem_map_full(mem, info, maxsize);
+}
+
+static void
+buffer_fence_allocator_class_init(BufferFenceAllocatorClass *klass)
+{
+    (void)klass;
+}
+
+static void
+buffer_fence_allocator_init(BufferFenceAllocator *self)
+{
+    GstAllocator *alloc = GST_ALLOCATOR(self);
+
+    /* The parent instance init has installed the fd map functions by now */
+    if (alloc->mem_map_full)
+    {
+        self->parent_mem_map_full = alloc->mem_map_full;
+        alloc->mem_map_full = buffer_fence_mem_map_full;
+    }
+    if (alloc->mem_map)
+    {
+        self->parent_mem_map = alloc->mem_map;
+        alloc->mem_map = buffer_fence_mem_map;
+    }
+}
+
+GstAllocator *
+buffer_fence_allocator_new(void)
+{
+    GstAllocator *alloc = g_object_new(buffer_fence_allocator_get_type(), NULL);
+
+    gst_object_ref_sink(alloc);
+    return alloc;
+}
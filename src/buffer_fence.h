@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Buffer Fences
+ * Deferred GPU completion tracking for output DMA-BUFs
+ *
+ * A BufferFence wraps a backend event (a CUevent in production) that is
+ * recorded on a pool slot's stream after the copy/convert work for a frame
+ * has been enqueued. Instead of blocking the streaming thread, the fence is
+ * attached to the output GstMemory and only waited on when:
+ *   - the element is about to push the buffer and the fence could not be
+ *     exported to the DMA-BUF (unless the consumer syncs),
+ *   - downstream maps the memory (through the fenced DMA-BUF allocator),
+ *   - the pool slot is about to be overwritten, or
+ *   - a consumer explicitly syncs the buffer (the "sync-buffer" signal).
+ *
+ * The backend is a plain vtable so the ordering logic can be exercised in
+ * unit tests without a GPU.
+ */
+
+#ifndef __BUFFER_FENCE_H__
+#define __BUFFER_FENCE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * BufferFenceBackend - Event primitives used by BufferFence
+ *
+ * All callbacks receive the backend's user_data as their last argument.
+ */
+typedef struct _BufferFenceBackend
+{
+    /* Create a new event, or NULL on failure */
+    gpointer (*event_create)(gpointer user_data);
+    /* Enqueue the event on @stream, returns TRUE on success */
+    gboolean (*event_record)(gpointer event, gpointer stream, gpointer user_data);
+    /* Non-blocking completion check, returns TRUE once the event has completed */
+    gboolean (*event_query)(gpointer event, gpointer user_data);
+    /* Block until the event has completed, returns TRUE on success */
+    gboolean (*event_synchronize)(gpointer event, gpointer user_data);
+    void (*event_destroy)(gpointer event, gpointer user_data);
+
+    gpointer user_data;
+} BufferFenceBackend;
+
+typedef struct _BufferFence BufferFence;
+
+/**
+ * Get the CUDA driver API backend (cuEventRecord/cuEventSynchronize).
+ */
+const BufferFenceBackend *buffer_fence_cuda_backend(void);
+
+/**
+ * Create a fence using the given backend.
+ *
+ * @param backend Event backend (must outlive the fence)
+ * @return New fence with a refcount of 1, or NULL if the event could not be created
+ */
+BufferFence *buffer_fence_new(const BufferFenceBackend *backend);
+
+BufferFence *buffer_fence_ref(BufferFence *fence);
+
+/**
+ * Drop a reference. The last unref waits for pending work before
+ * destroying the event.
+ */
+void buffer_fence_unref(BufferFence *fence);
+
+/**
+ * Record the fence on a stream after work has been enqueued on it.
+ * If the fence is still pending from a previous frame it is waited on first.
+ *
+ * @param fence The fence
+ * @param stream Backend stream handle (CUstream for the CUDA backend)
+ * @param keepalive Optional buffer the pending work reads from. A reference
+ *                  is held until the fence is known to be complete so the
+ *                  producer cannot recycle it underneath the GPU.
+ * @return TRUE on success
+ */
+gboolean buffer_fence_record(BufferFence *fence, gpointer stream, GstBuffer *keepalive);
+
+/**
+ * Check whether the fence has completed without blocking.
+ */
+gboolean buffer_fence_is_signaled(BufferFence *fence);
+
+/**
+ * Block until the fence has completed. Returns immediately if nothing is pending.
+ *
+ * @return TRUE on success
+ */
+gboolean buffer_fence_wait(BufferFence *fence);
+
+/**
+ * Attach a fence to a memory. The memory holds a reference to the fence.
+ */
+void buffer_fence_attach(GstMemory *mem, BufferFence *fence);
+
+/**
+ * Get the fence attached to a memory (or its parent for shared sub-memories).
+ *
+ * @return The fence (transfer none), or NULL
+ */
+BufferFence *buffer_fence_get(GstMemory *mem);
+
+/**
+ * Wait on the fences of all memories in a buffer.
+ *
+ * @return TRUE on success, also TRUE if no fences are attached
+ */
+gboolean buffer_fence_wait_buffer(GstBuffer *buffer);
+
+/**
+ * Make @mem carry the completion of @event, so whoever imports it waits on
+ * the GPU by itself (e.g. by attaching a sync_file to the DMA-BUF).
+ * Called with the fence locked; the event stays valid for the call.
+ *
+ * @return TRUE if the event was exported, FALSE to fall back to waiting
+ */
+typedef gboolean (*BufferFenceExportFunc)(gpointer event, GstMemory *mem, gpointer user_data);
+
+/**
+ * Export the pending fences of all memories in a buffer through
+ * @export_func, waiting on the CPU only for those it fails to export.
+ * Completed fences are skipped. Exported fences stay pending, so mapping
+ * the memory or reusing its pool slot still waits for them.
+ *
+ * @return TRUE on success, also TRUE if no fences are attached
+ */
+gboolean buffer_fence_export_buffer(GstBuffer *buffer,
+                                    BufferFenceExportFunc export_func,
+                                    gpointer user_data);
+
+/**
+ * Create a DMA-BUF allocator whose memories wait on their attached fence
+ * before being mapped for CPU access. Otherwise identical to
+ * gst_dmabuf_allocator_new().
+ */
+GstAllocator *buffer_fence_allocator_new(void);
+
+G_END_DECLS
+
+#endif /* __BUFFER_FENCE_H__ */
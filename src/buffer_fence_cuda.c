@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Buffer Fences - CUDA driver API backend
+ */
+
+#include "buffer_fence.h"
+
+#include <cuda.h>
+
+static gpointer
+cuda_fence_event_create(gpointer user_data)
+{
+    (void)user_data;
+    CUevent event = NULL;
+
+    /* Timing is never queried, disabling it makes record/sync cheaper */
+    CUresult cu_res = cuEventCreate(&event, CU_EVENT_DISABLE_TIMING);
+    if (cu_res != CUDA_SUCCESS)
+    {
+        g_warning("cuEventCreate failed: %d", cu_res);
+        return NULL;
+    }
+    return event;
+}
+
+static gboolean
+cuda_fence_event_record(gpointer event, gpointer stream, gpointer user_data)
+{
+    (void)user_data;
+
+    CUresult cu_res = cuEventRecord((CUevent)event, (CUstream)stream);
+    if (cu_res != CUDA_SUCCESS)
+    {
+        g_warning("cuEventRecord failed: %d", cu_res);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+cuda_fence_event_query(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+
+    /* Errors are sticky and will be reported by the next synchronize;
+     * only NOT_READY means the work is still in flight. */
+    return cuEventQuery((CUevent)event) != CUDA_ERROR_NOT_READY;
+}
+
+static gboolean
+cuda_fence_event_synchronize(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+
+    CUresult cu_res = cuEventSynchronize((CUevent)event);
+    if (cu_res != CUDA_SUCCESS)
+    {
+        g_warning("cuEventSynchronize failed: %d", cu_res);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+cuda_fence_event_destroy(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+    cuEventDestroy((CUevent)event);
+}
+
+static const BufferFenceBackend cuda_fence_backend = {
+    .event_create = cuda_fence_event_create,
+    .event_record = cuda_fence_event_record,
+    .event_query = cuda_fence_event_query,
+    .event_synchronize = cuda_fence_event_synchronize,
+    .event_destroy = cuda_fence_event_destroy,
+    .user_data = NULL,
+};
+
+const BufferFenceBackend *
+buffer_fence_cuda_backend(void)
+{
+    return &cuda_fence_backend;
+}
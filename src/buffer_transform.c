@@ -2,13 +2,22 @@
  * SPDX-FileCopyrightText: 2025 Ericky
  *
  * Buffer Transform Operations
- * Handles the actual buffer transform logic (NV12 passthrough, NV12→BGRx, BGRx copy)
+ * Handles the actual buffer transform logic (NV12/P010 passthrough, NV12/P010→RGB,
+ * optional scaling, BGRx copy)
  */
 
 #include "buffer_transform.h"
+#include "buffer_fence.h"
 #include "cuda_nv12_to_bgrx.h"
 #include "gstcudadmabufupload.h"
 #include "external_fd_pool.h"
+#include "dmabuf_wrapper.h"
+#include "semi_planar_copy.h"
+#include "row_copy.h"
+#include "gbm_dmabuf_pool.h"
+#include "drm_format_table.h"
+#include "modifier_ranking.h"
+#include "render_node.h"
 
 #define GST_USE_UNSTABLE_API
 #include <gst/cuda/gstcuda.h>
@@ -17,58 +26,187 @@
 #include <unistd.h>
 #include <string.h>
 #include <cuda_runtime.h>
-#include <dirent.h>
-#include <limits.h>
 #include <xf86drm.h>
 #include <drm/drm_fourcc.h>
 #include <fcntl.h>
 #include <stdio.h>
 
-/* Find NVIDIA render node path dynamically */
-static const gchar *
-find_nvidia_render_node_path(void)
+/* Identity of the driver behind @drm_device, the key of the format table
+ * cache. nvidia-drm reports a fixed DRM version, so the kernel module
+ * version is what changes across driver updates. */
+static gchar *
+format_table_driver_key(const gchar *drm_device)
 {
-    static gchar nvidia_path[PATH_MAX] = {0};
+    gchar *module_version = NULL;
+    gchar *key;
+    int fd = open(drm_device, O_RDWR | O_CLOEXEC);
+    drmVersionPtr version = fd >= 0 ? drmGetVersion(fd) : NULL;
+
+    g_file_get_contents("/sys/module/nvidia/version", &module_version, NULL, NULL);
+
+    key = g_strdup_printf("%s %s %d.%d.%d %s", drm_device,
+                          version && version->name ? version->name : "unknown",
+                          version ? version->version_major : 0,
+                          version ? version->version_minor : 0,
+                          version ? version->version_patchlevel : 0,
+                          module_version ? g_strstrip(module_version) : "");
+
+    if (version)
+        drmFreeVersion(version);
+    if (fd >= 0)
+        close(fd);
+    g_free(module_version);
+    return key;
+}
+
+const DrmFormatTable *
+buffer_transform_probe_formats(const gchar *drm_device, ModifierRanking **ranking)
+{
+    gchar *key = format_table_driver_key(drm_device);
+    gchar *path = drm_format_table_default_cache_path(drm_device);
+    const DrmFormatTable *table = drm_format_table_ensure_probed(path, key,
+                                                                 cuda_egl_probe_formats,
+                                                                 (gpointer)drm_device);
+
+    if (table)
+        GST_INFO("DRM format table ready for %s", key);
+    else
+        GST_WARNING("Couldn't probe %s, advertising every candidate modifier", drm_device);
+    g_free(path);
+
+    /* Earlier calibrations on the device order the modifiers from the start */
+    path = modifier_ranking_default_cache_path(drm_device);
+    *ranking = modifier_ranking_ensure_loaded(path, key);
+    g_free(path);
+
+    g_free(key);
+    return table ? table : drm_format_table_get_default();
+}
+
+/* Copies timed per modifier, after one untimed warm-up copy */
+#define CALIBRATION_FRAMES 30
+
+/* Microseconds per Y+UV copy into @buf, or a negative value on error */
+static gdouble
+calibration_time_copy(CudaEglBuffer *buf, CUdeviceptr src, size_t src_pitch,
+                      guint width_bytes, guint height, CUevent start, CUevent stop)
+{
+    const guint8 *y = (const guint8 *)src;
+    const guint8 *uv = y + src_pitch * height;
+    gfloat ms = 0;
+
+    for (guint i = 0; i <= CALIBRATION_FRAMES; i++)
+    {
+        if (i == 1 && cuEventRecord(start, buf->cuda_stream) != CUDA_SUCCESS)
+            return -1;
+
+        if (cuda_egl_copy_plane_async(y, src_pitch, &buf->cuda_frame, 0,
+                                      width_bytes, height, buf->cuda_stream) != CUDA_SUCCESS ||
+            cuda_egl_copy_plane_async(uv, src_pitch, &buf->cuda_frame, 1,
+                                      width_bytes, height / 2, buf->cuda_stream) != CUDA_SUCCESS)
+            return -1;
+    }
 
-    if (nvidia_path[0] != '\0')
-        return nvidia_path;
+    if (cuEventRecord(stop, buf->cuda_stream) != CUDA_SUCCESS ||
+        cuEventSynchronize(stop) != CUDA_SUCCESS ||
+        cuEventElapsedTime(&ms, start, stop) != CUDA_SUCCESS)
+        return -1;
 
-    DIR *dir = opendir("/dev/dri");
-    if (!dir)
-        return "/dev/dri/renderD128"; /* fallback */
+    return ms * 1000.0 / CALIBRATION_FRAMES;
+}
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL)
+gboolean
+buffer_transform_calibrate_modifiers(CudaEglContext *egl_ctx, const DrmFormatTable *table,
+                                     ModifierRanking *ranking, gboolean is_p010,
+                                     guint width, guint height, guint64 *best)
+{
+    /* Same layout as the CUDA-EGL pool: P010 as double-width NV12, so the
+     * allocation width is the row size in bytes */
+    guint32 fourcc = is_p010 ? DRM_FORMAT_P010 : DRM_FORMAT_NV12;
+    guint width_bytes = width * (is_p010 ? 2 : 1);
+    CUdeviceptr src = 0;
+    size_t src_pitch = 0;
+    CUevent start = NULL, stop = NULL;
+    gdouble best_usec = G_MAXDOUBLE;
+    guint measured = 0;
+
+    if (cuMemAllocPitch(&src, &src_pitch, width_bytes, height + height / 2, 4) != CUDA_SUCCESS ||
+        cuMemsetD8(src, 0x80, src_pitch * (height + height / 2)) != CUDA_SUCCESS ||
+        cuEventCreate(&start, CU_EVENT_DEFAULT) != CUDA_SUCCESS ||
+        cuEventCreate(&stop, CU_EVENT_DEFAULT) != CUDA_SUCCESS)
     {
-        if (strncmp(entry->d_name, "renderD", 7) != 0)
+        GST_WARNING("Failed to set up modifier calibration");
+        goto done;
+    }
+
+    for (guint i = 0; i < drm_format_table_get_n_entries(table); i++)
+    {
+        const DrmFormatEntry *e = drm_format_table_get_entry(table, i);
+        CudaEglBuffer buf;
+
+        if (e->fourcc != fourcc || !e->supported || e->modifier == DRM_FORMAT_MOD_LINEAR)
             continue;
 
-        char path[PATH_MAX];
-        snprintf(path, sizeof(path), "/dev/dri/%s", entry->d_name);
+        if (!cuda_egl_buffer_alloc(egl_ctx, &buf, width_bytes, height,
+                                   GBM_FORMAT_NV12, e->modifier, FALSE))
+            continue;
 
-        int fd = open(path, O_RDWR | O_CLOEXEC);
-        if (fd < 0)
+        /* The allocator falls back to LINEAR rather than failing */
+        if (buf.modifier != e->modifier)
+        {
+            GST_DEBUG("%s: not allocatable at %ux%u", e->drm_format, width, height);
+            cuda_egl_buffer_free(egl_ctx, &buf);
             continue;
+        }
+
+        gdouble usec = calibration_time_copy(&buf, src, src_pitch, width_bytes, height,
+                                             start, stop);
+        cuda_egl_buffer_free(egl_ctx, &buf);
 
-        drmVersionPtr version = drmGetVersion(fd);
-        if (version)
+        if (usec < 0)
         {
-            if (version->name && strcmp(version->name, "nvidia-drm") == 0)
-            {
-                drmFreeVersion(version);
-                close(fd);
-                strncpy(nvidia_path, path, sizeof(nvidia_path) - 1);
-                closedir(dir);
-                g_info("Found NVIDIA render node: %s", nvidia_path);
-                return nvidia_path;
-            }
-            drmFreeVersion(version);
+            GST_DEBUG("%s: copy failed", e->drm_format);
+            continue;
         }
-        close(fd);
+
+        GST_INFO("%s at %ux%u: %.1f us per frame", e->drm_format, width, height, usec);
+        modifier_ranking_record(ranking, fourcc, width, height, e->modifier, usec);
+        measured++;
+
+        if (usec < best_usec)
+        {
+            best_usec = usec;
+            if (best)
+                *best = e->modifier;
+        }
+    }
+
+    /* Keyed by the device measured on, the one @ranking belongs to */
+    if (measured)
+    {
+        gchar *key = format_table_driver_key(egl_ctx->drm_device);
+        gchar *path = modifier_ranking_default_cache_path(egl_ctx->drm_device);
+        GError *error = NULL;
+
+        if (!modifier_ranking_save(ranking, path, key, &error))
+        {
+            GST_WARNING("Failed to cache modifier ranking: %s", error->message);
+            g_clear_error(&error);
+        }
+
+        g_free(path);
+        g_free(key);
     }
 
-    closedir(dir);
-    return "/dev/dri/renderD128"; /* fallback */
+done:
+    if (start)
+        cuEventDestroy(start);
+    if (stop)
+        cuEventDestroy(stop);
+    if (src)
+        cuMemFree(src);
+
+    return measured > 0;
 }
 
 gboolean
@@ -82,7 +220,7 @@ buffer_transform_context_init(BufferTransformContext *btx,
     /* Initialize EGL context if needed */
     if (!egl_ctx->initialized)
     {
-        const gchar *drm_device = find_nvidia_render_node_path();
+        const gchar *drm_device = render_node_find(NULL);
         if (!cuda_egl_context_init(egl_ctx, drm_device))
         {
             GST_ERROR("Failed to initialize CUDA-EGL context with %s", drm_device);
@@ -92,14 +230,158 @@ buffer_transform_context_init(BufferTransformContext *btx,
 
     /* Create dmabuf allocator if needed */
     if (!btx->dmabuf_allocator)
-        btx->dmabuf_allocator = gst_dmabuf_allocator_new();
+        btx->dmabuf_allocator = buffer_fence_allocator_new();
+
+    return TRUE;
+}
+
+void buffer_transform_context_cleanup(BufferTransformContext *btx)
+{
+    if (btx->input_ready)
+    {
+        cuEventDestroy(btx->input_ready);
+        btx->input_ready = NULL;
+    }
+    if (btx->dmabuf_allocator)
+    {
+        gst_object_unref(btx->dmabuf_allocator);
+        btx->dmabuf_allocator = NULL;
+    }
+    btx->egl_ctx = NULL;
+}
+
+/* Complete a frame's async work on @stream.
+ * In deferred mode the fence is only recorded; the input buffer is kept
+ * alive by the fence until the GPU is done reading from it. */
+static gboolean
+buffer_transform_complete(BufferTransformContext *btx,
+                          BufferFence *fence,
+                          CUstream stream,
+                          GstBuffer *inbuf)
+{
+    if (!fence)
+        return cuStreamSynchronize(stream) == CUDA_SUCCESS;
+
+    if (!buffer_fence_record(fence, stream, inbuf))
+        return FALSE;
+
+    if (!btx->deferred_sync)
+        return buffer_fence_wait(fence);
+
+    return TRUE;
+}
+
+/* Order work queued on @stream after whatever upstream queued on the input
+ * memory's own stream (e.g. the decoder's output copy). This is a GPU-side
+ * dependency: neither the host nor unrelated CUDA streams are blocked. */
+static gboolean
+buffer_transform_wait_input(BufferTransformContext *btx,
+                            GstBuffer *inbuf,
+                            CUstream stream)
+{
+    GstCudaMemory *cmem = GST_CUDA_MEMORY_CAST(gst_buffer_peek_memory(inbuf, 0));
+    GstCudaStream *in_stream = gst_cuda_memory_get_stream(cmem);
+    CUstream in_handle = in_stream ? gst_cuda_stream_get_handle(in_stream) : NULL;
+
+    /* Default-stream input has been synchronized by the CUDA map already */
+    if (!in_handle || in_handle == stream)
+        return TRUE;
+
+    if (!btx->input_ready)
+    {
+        CUresult cu_res = cuEventCreate(&btx->input_ready, CU_EVENT_DISABLE_TIMING);
+        if (cu_res != CUDA_SUCCESS)
+        {
+            GST_ERROR("cuEventCreate failed: %d", cu_res);
+            btx->input_ready = NULL;
+            return FALSE;
+        }
+    }
+
+    /* The wait captures the event state at enqueue time, so one event can be
+     * re-recorded for every frame. */
+    CUresult cu_res = cuEventRecord(btx->input_ready, in_handle);
+    if (cu_res == CUDA_SUCCESS)
+        cu_res = cuStreamWaitEvent(stream, btx->input_ready, 0);
+    if (cu_res != CUDA_SUCCESS)
+    {
+        GST_ERROR("Failed to order after upstream stream: %d", cu_res);
+        return FALSE;
+    }
 
     return TRUE;
 }
 
+/* Resample both planes into @slot per btx->scale. The kernel writes
+ * pitch-linear memory, so block-linear (array) frames are staged in the
+ * slot's scratch buffer and then copied in like the unscaled path. */
+static CUresult
+buffer_transform_scale_semi_planar(BufferTransformContext *btx,
+                                   CudaEglBuffer *slot,
+                                   const uint8_t *y_in,
+                                   const uint8_t *uv_in,
+                                   gint y_stride,
+                                   gint uv_stride,
+                                   gboolean is_p010)
+{
+    const ScaleGeometry *geo = &btx->scale;
+    size_t bps = is_p010 ? 2 : 1;
+    size_t row_bytes = (size_t)((geo->out_w + 1) / 2) * 2 * bps;
+    size_t uv_rows = (size_t)(geo->out_h + 1) / 2;
+    int err;
+
+    if (slot->cuda_frame.frameType == CU_EGL_FRAME_TYPE_PITCH)
+    {
+        err = cuda_scale_semi_planar(y_in, uv_in, y_stride, uv_stride,
+                                     slot->cuda_frame.frame.pPitch[0],
+                                     slot->cuda_frame.frame.pPitch[1],
+                                     (int)slot->cuda_frame.pitch, (int)slot->cuda_frame.pitch,
+                                     geo, is_p010, slot->cuda_stream);
+        return err == 0 ? CUDA_SUCCESS : CUDA_ERROR_LAUNCH_FAILED;
+    }
+
+    size_t rows = (size_t)geo->out_h + uv_rows;
+    if (!slot->scratch || slot->scratch_rows < rows || slot->scratch_pitch < row_bytes)
+    {
+        if (slot->scratch)
+            cuMemFree(slot->scratch);
+        slot->scratch = 0;
+        slot->scratch_rows = 0;
+
+        CUresult cu_res = cuMemAllocPitch(&slot->scratch, &slot->scratch_pitch, row_bytes, rows, 16);
+        if (cu_res != CUDA_SUCCESS)
+        {
+            slot->scratch = 0;
+            return cu_res;
+        }
+        slot->scratch_rows = rows;
+    }
+
+    uint8_t *y_tmp = (uint8_t *)(uintptr_t)slot->scratch;
+    uint8_t *uv_tmp = y_tmp + (size_t)geo->out_h * slot->scratch_pitch;
+
+    err = cuda_scale_semi_planar(y_in, uv_in, y_stride, uv_stride,
+                                 y_tmp, uv_tmp,
+                                 (int)slot->scratch_pitch, (int)slot->scratch_pitch,
+                                 geo, is_p010, slot->cuda_stream);
+    if (err != 0)
+        return CUDA_ERROR_LAUNCH_FAILED;
+
+    CUresult cu_res = cuda_egl_copy_plane_async(y_tmp, slot->scratch_pitch,
+                                                &slot->cuda_frame, 0,
+                                                (size_t)geo->out_w * bps, (size_t)geo->out_h,
+                                                slot->cuda_stream);
+    if (cu_res == CUDA_SUCCESS)
+        cu_res = cuda_egl_copy_plane_async(uv_tmp, slot->scratch_pitch,
+                                           &slot->cuda_frame, 1,
+                                           row_bytes, uv_rows,
+                                           slot->cuda_stream);
+    return cu_res;
+}
+
 GstFlowReturn
 buffer_transform_semi_planar_passthrough(BufferTransformContext *btx,
-                                         PooledBufferPool *pool,
+                                         GstBufferPool *pool,
                                          GstBuffer *inbuf,
                                          GstBuffer **outbuf,
                                          const GstVideoInfo *info,
@@ -125,11 +407,20 @@ buffer_transform_semi_planar_passthrough(BufferTransformContext *btx,
     gint uv_stride_in = in_vmeta ? in_vmeta->stride[1] : (gint)width_bytes;
     gsize uv_offset_in = in_vmeta ? in_vmeta->offset[1] : (gsize)width_bytes * height;
 
-    /* Acquire next buffer from pool */
-    CudaEglBuffer *pool_buf = pooled_buffer_pool_acquire(pool);
+    /* Acquire a free buffer from the pool (blocks or grows if all are in flight) */
+    GstBuffer *pooled = NULL;
+    GstFlowReturn ret = gst_buffer_pool_acquire_buffer(pool, &pooled, NULL);
+    if (ret != GST_FLOW_OK)
+    {
+        GST_ERROR("Failed to acquire buffer from pool: %s", gst_flow_get_name(ret));
+        return ret;
+    }
+
+    CudaEglBuffer *pool_buf = gst_pooled_buffer_pool_get_slot(pooled);
     if (!pool_buf)
     {
-        GST_ERROR("Failed to acquire buffer from pool");
+        GST_ERROR("Buffer does not belong to a CUDA-EGL pool");
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
@@ -138,69 +429,80 @@ buffer_transform_semi_planar_passthrough(BufferTransformContext *btx,
     if (!gst_buffer_map(inbuf, &in_map, GST_MAP_READ | GST_MAP_CUDA))
     {
         GST_ERROR("Failed to map input buffer");
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
     const uint8_t *in_base = (const uint8_t *)in_map.data;
 
-    /* Async copy Y plane */
-    CUresult cu_res = cuda_egl_copy_plane_async(
-        in_base, (size_t)y_stride_in,
-        &pool_buf->cuda_frame, 0,
-        (size_t)width_bytes, (size_t)height,
-        pool_buf->cuda_stream);
-
-    if (cu_res != CUDA_SUCCESS)
+    if (!buffer_transform_wait_input(btx, inbuf, pool_buf->cuda_stream))
     {
-        GST_ERROR("Y plane copy failed: %d", cu_res);
         gst_buffer_unmap(inbuf, &in_map);
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
-    /* Async copy UV plane (interleaved U/V, half height) */
-    cu_res = cuda_egl_copy_plane_async(
-        in_base + uv_offset_in, (size_t)uv_stride_in,
-        &pool_buf->cuda_frame, 1,
-        (size_t)width_bytes, (size_t)(height / 2),
-        pool_buf->cuda_stream);
-
-    if (cu_res != CUDA_SUCCESS)
+    CUresult cu_res;
+    if (btx->scaling)
     {
-        GST_ERROR("UV plane copy failed: %d", cu_res);
-        gst_buffer_unmap(inbuf, &in_map);
-        return GST_FLOW_ERROR;
-    }
+        /* Resample both planes to the output size in one pass */
+        cu_res = buffer_transform_scale_semi_planar(
+            btx, pool_buf, in_base, in_base + uv_offset_in,
+            y_stride_in, uv_stride_in, is_p010);
 
-    gst_buffer_unmap(inbuf, &in_map);
+        if (cu_res != CUDA_SUCCESS)
+        {
+            GST_ERROR("Scaled semi-planar copy failed: %d", cu_res);
+            gst_buffer_unmap(inbuf, &in_map);
+            gst_buffer_unref(pooled);
+            return GST_FLOW_ERROR;
+        }
+    }
+    else
+    {
+        /* Async copy Y plane */
+        cu_res = cuda_egl_copy_plane_async(
+            in_base, (size_t)y_stride_in,
+            &pool_buf->cuda_frame, 0,
+            (size_t)width_bytes, (size_t)height,
+            pool_buf->cuda_stream);
+
+        if (cu_res != CUDA_SUCCESS)
+        {
+            GST_ERROR("Y plane copy failed: %d", cu_res);
+            gst_buffer_unmap(inbuf, &in_map);
+            gst_buffer_unref(pooled);
+            return GST_FLOW_ERROR;
+        }
 
-    /* Sync before handing to compositor */
-    cuStreamSynchronize(pool_buf->cuda_stream);
+        /* Async copy UV plane (interleaved U/V, half height) */
+        cu_res = cuda_egl_copy_plane_async(
+            in_base + uv_offset_in, (size_t)uv_stride_in,
+            &pool_buf->cuda_frame, 1,
+            (size_t)width_bytes, (size_t)(height / 2),
+            pool_buf->cuda_stream);
 
-    /* Wrap DMABUF in GstBuffer */
-    int fd_dup = dup(pool_buf->dmabuf_fd);
-    if (fd_dup < 0)
-    {
-        GST_ERROR("Failed to dup fd");
-        return GST_FLOW_ERROR;
+        if (cu_res != CUDA_SUCCESS)
+        {
+            GST_ERROR("UV plane copy failed: %d", cu_res);
+            gst_buffer_unmap(inbuf, &in_map);
+            gst_buffer_unref(pooled);
+            return GST_FLOW_ERROR;
+        }
     }
 
-    GstMemory *dmabuf_mem = gst_dmabuf_allocator_alloc(
-        btx->dmabuf_allocator, fd_dup, pool_buf->size);
-    if (!dmabuf_mem)
+    gst_buffer_unmap(inbuf, &in_map);
+
+    /* Sync (or fence) before handing to compositor */
+    if (!buffer_transform_complete(btx, pool_buf->fence, pool_buf->cuda_stream, inbuf))
     {
-        close(fd_dup);
+        GST_ERROR("Failed to complete semi-planar copy");
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
-    *outbuf = gst_buffer_new();
-    gst_buffer_append_memory(*outbuf, dmabuf_mem);
-
-    /* Add video meta with actual pixel format for proper stride/offset handling */
-    GstVideoFormat vid_fmt = is_p010 ? GST_VIDEO_FORMAT_P010_10LE : GST_VIDEO_FORMAT_NV12;
-    gsize offsets[4] = {0, pool_buf->offsets[1], 0, 0};
-    gint strides[4] = {(gint)pool_buf->strides[0], (gint)pool_buf->strides[1], 0, 0};
-    gst_buffer_add_video_meta_full(*outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-                                   vid_fmt, width, height, 2, offsets, strides);
+    /* The pooled buffer already wraps the DMA-BUF with NV12/P010 video meta */
+    *outbuf = pooled;
 
     /* Copy timestamps */
     GST_BUFFER_PTS(*outbuf) = GST_BUFFER_PTS(inbuf);
@@ -232,17 +534,9 @@ buffer_transform_cuda_export(BufferTransformContext *btx,
         return GST_FLOW_ERROR;
     }
 
-    /* Sync CUDA operations before exporting */
+    /* The decoder's writes must be complete before the compositor reads */
     gst_cuda_memory_sync(cmem);
 
-    /* Export CUDA memory as a POSIX file descriptor (DMA-BUF) */
-    int fd = -1;
-    if (!gst_cuda_memory_export(cmem, &fd))
-    {
-        GST_ERROR("Failed to export CUDA memory as DMA-BUF");
-        return GST_FLOW_ERROR;
-    }
-
     guint width = GST_VIDEO_INFO_WIDTH(info);
     guint height = GST_VIDEO_INFO_HEIGHT(info);
 
@@ -287,38 +581,69 @@ buffer_transform_cuda_export(BufferTransformContext *btx,
 
     /* Create DMA-BUF allocator if needed */
     if (!btx->dmabuf_allocator)
-        btx->dmabuf_allocator = gst_dmabuf_allocator_new();
+        btx->dmabuf_allocator = buffer_fence_allocator_new();
+
+    /* Upstream pools recycle their CUDA memories, so the DMA-BUF wrapper is
+     * created once per CUDA memory and cached on it. */
+    GQuark export_quark = g_quark_from_static_string("cuda-export-dmabuf");
+    GstMemory *dmabuf_mem = gst_mini_object_get_qdata(GST_MINI_OBJECT(mem), export_quark);
 
-    GstMemory *dmabuf_mem = gst_dmabuf_allocator_alloc(btx->dmabuf_allocator, fd, total_size);
     if (!dmabuf_mem)
     {
-        close(fd);
-        GST_ERROR("Failed to wrap CUDA DMA-BUF fd in allocator");
-        return GST_FLOW_ERROR;
+        /* Export CUDA memory as a POSIX file descriptor (DMA-BUF).
+         * The fd stays owned by the CUDA memory: wrap it without closing. */
+        int fd = -1;
+        if (!gst_cuda_memory_export(cmem, &fd))
+        {
+            GST_ERROR("Failed to export CUDA memory as DMA-BUF");
+            return GST_FLOW_ERROR;
+        }
+
+        dmabuf_mem = gst_dmabuf_allocator_alloc_with_flags(btx->dmabuf_allocator, fd, total_size,
+                                                           GST_FD_MEMORY_FLAG_DONT_CLOSE);
+        if (!dmabuf_mem)
+        {
+            GST_ERROR("Failed to wrap CUDA DMA-BUF fd in allocator");
+            return GST_FLOW_ERROR;
+        }
+
+        gst_mini_object_set_qdata(GST_MINI_OBJECT(mem), export_quark,
+                                  dmabuf_mem, (GDestroyNotify)gst_memory_unref);
+
+        GST_LOG("CUDA direct DMA-BUF export: fd=%d, %ux%u, size=%zu", fd, width, height, total_size);
     }
 
     *outbuf = gst_buffer_new();
-    gst_buffer_append_memory(*outbuf, dmabuf_mem);
+    gst_buffer_append_memory(*outbuf, gst_memory_ref(dmabuf_mem));
 
     /* Add video meta with correct format and plane info */
     gst_buffer_add_video_meta_full(*outbuf, GST_VIDEO_FRAME_FLAG_NONE,
                                    vid_fmt, width, height, n_planes, offsets, strides);
 
+    /* The DMA-BUF is the decoder's own memory: keep the input buffer (and so
+     * its pool slot) alive until downstream releases the output. */
+    gst_mini_object_set_qdata(GST_MINI_OBJECT(*outbuf),
+                              g_quark_from_static_string("cuda-export-input"),
+                              gst_buffer_ref(inbuf), (GDestroyNotify)gst_buffer_unref);
+
     /* Copy timestamps */
     GST_BUFFER_PTS(*outbuf) = GST_BUFFER_PTS(inbuf);
     GST_BUFFER_DTS(*outbuf) = GST_BUFFER_DTS(inbuf);
     GST_BUFFER_DURATION(*outbuf) = GST_BUFFER_DURATION(inbuf);
 
-    GST_LOG("CUDA direct DMA-BUF export: fd=%d, %ux%u, size=%zu", fd, width, height, total_size);
-
     return GST_FLOW_OK;
 }
 
-GstFlowReturn
-buffer_transform_nv12_to_bgrx(BufferTransformContext *btx,
-                              GstBuffer *inbuf,
-                              GstBuffer **outbuf,
-                              const GstVideoInfo *info)
+/* Run a YUV→RGB kernel from CUDA @inbuf into a buffer acquired from @pool.
+ * The kernel follows the input format: NV12 always produces BGRx, P010
+ * produces BGRx or, with @rgb10, XRGB2101010. */
+static GstFlowReturn
+buffer_transform_convert_to_rgb(BufferTransformContext *btx,
+                                GstBufferPool *pool,
+                                GstBuffer *inbuf,
+                                GstBuffer **outbuf,
+                                const GstVideoInfo *info,
+                                gboolean rgb10)
 {
     GstMemory *mem = gst_buffer_peek_memory(inbuf, 0);
     if (!gst_is_cuda_memory(mem))
@@ -327,21 +652,30 @@ buffer_transform_nv12_to_bgrx(BufferTransformContext *btx,
         return GST_FLOW_ERROR;
     }
 
+    gboolean is_p010 = GST_VIDEO_INFO_FORMAT(info) == GST_VIDEO_FORMAT_P010_10LE;
+    const gchar *name = is_p010 ? (rgb10 ? "P010→XR30" : "P010→BGRx") : "NV12→BGRx";
     guint width = GST_VIDEO_INFO_WIDTH(info);
     guint height = GST_VIDEO_INFO_HEIGHT(info);
 
     GstVideoMeta *in_vmeta = gst_buffer_get_video_meta(inbuf);
-    gint y_stride = in_vmeta ? in_vmeta->stride[0] : (gint)width;
-    gint uv_stride = in_vmeta ? in_vmeta->stride[1] : (gint)width;
-    gsize uv_offset = in_vmeta ? in_vmeta->offset[1] : (gsize)width * height;
+    gint y_stride = in_vmeta ? in_vmeta->stride[0] : GST_VIDEO_INFO_PLANE_STRIDE(info, 0);
+    gint uv_stride = in_vmeta ? in_vmeta->stride[1] : GST_VIDEO_INFO_PLANE_STRIDE(info, 1);
+    gsize uv_offset = in_vmeta ? in_vmeta->offset[1] : GST_VIDEO_INFO_PLANE_OFFSET(info, 1);
+
+    /* Acquire a pre-registered conversion buffer */
+    GstBuffer *pooled = NULL;
+    GstFlowReturn ret = gst_buffer_pool_acquire_buffer(pool, &pooled, NULL);
+    if (ret != GST_FLOW_OK)
+    {
+        GST_ERROR("Failed to acquire conversion buffer: %s", gst_flow_get_name(ret));
+        return ret;
+    }
 
-    /* Allocate single-use buffer for conversion
-     * Force linear for XR24 since CUDA doesn't support tiled XR24 EGL interop */
-    CudaEglBuffer conv_buf;
-    if (!cuda_egl_buffer_alloc(btx->egl_ctx, &conv_buf, width, height,
-                               GBM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR, TRUE))
+    CudaEglBuffer *conv_buf = gst_pooled_buffer_pool_get_slot(pooled);
+    if (!conv_buf)
     {
-        GST_ERROR("Failed to allocate conversion buffer");
+        GST_ERROR("Buffer does not belong to a CUDA-EGL pool");
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
@@ -349,88 +683,104 @@ buffer_transform_nv12_to_bgrx(BufferTransformContext *btx,
     GstMapInfo in_map;
     if (!gst_buffer_map(inbuf, &in_map, GST_MAP_READ | GST_MAP_CUDA))
     {
-        cuda_egl_buffer_free(btx->egl_ctx, &conv_buf);
         GST_ERROR("Failed to map input");
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
-    CUdeviceptr cuda_out_ptr = (CUdeviceptr)conv_buf.cuda_frame.frame.pPitch[0];
-    guint cuda_pitch = conv_buf.cuda_frame.pitch;
-
-    /* Run NV12→BGRx kernel */
-    int cuda_err = cuda_nv12_to_bgrx(
-        in_map.data,
-        (const uint8_t *)in_map.data + uv_offset,
-        (void *)cuda_out_ptr,
-        width, height,
-        y_stride, uv_stride, cuda_pitch, NULL);
-
-    cudaDeviceSynchronize();
-    gst_buffer_unmap(inbuf, &in_map);
-
-    /* Unregister CUDA but keep GBM/DMABUF */
-    cuGraphicsUnregisterResource(conv_buf.cuda_resource);
-    conv_buf.cuda_resource = NULL;
-
-    /* Destroy CUDA stream - no longer needed after sync */
-    if (conv_buf.cuda_stream)
+    if (!buffer_transform_wait_input(btx, inbuf, conv_buf->cuda_stream))
     {
-        cuStreamDestroy(conv_buf.cuda_stream);
-        conv_buf.cuda_stream = NULL;
+        gst_buffer_unmap(inbuf, &in_map);
+        gst_buffer_unref(pooled);
+        return GST_FLOW_ERROR;
     }
 
-    /* Destroy EGL image - no longer needed after CUDA unregister */
-    cuda_egl_buffer_destroy_egl_image(btx->egl_ctx, &conv_buf);
+    CUdeviceptr cuda_out_ptr = (CUdeviceptr)conv_buf->cuda_frame.frame.pPitch[0];
+    guint cuda_pitch = conv_buf->cuda_frame.pitch;
+
+    /* Run the conversion kernel on the slot's own stream */
+    int cuda_err;
+    if (btx->scaling)
+        cuda_err = cuda_scale_yuv_to_rgb(
+            in_map.data,
+            (const uint8_t *)in_map.data + uv_offset,
+            y_stride, uv_stride, is_p010,
+            (void *)cuda_out_ptr, cuda_pitch,
+            &btx->scale, &btx->yuv_coeffs, rgb10, conv_buf->cuda_stream);
+    else if (is_p010)
+        cuda_err = cuda_p010_to_rgb(
+            in_map.data,
+            (const uint8_t *)in_map.data + uv_offset,
+            (void *)cuda_out_ptr,
+            width, height,
+            y_stride, uv_stride, cuda_pitch,
+            &btx->yuv_coeffs, rgb10, conv_buf->cuda_stream);
+    else
+        cuda_err = cuda_nv12_to_bgrx(
+            in_map.data,
+            (const uint8_t *)in_map.data + uv_offset,
+            (void *)cuda_out_ptr,
+            width, height,
+            y_stride, uv_stride, cuda_pitch,
+            &btx->yuv_coeffs, conv_buf->cuda_stream);
+
+    gst_buffer_unmap(inbuf, &in_map);
 
     if (cuda_err != 0)
     {
-        GST_ERROR("NV12→BGRx kernel failed: %d", cuda_err);
-        cuda_egl_buffer_free(btx->egl_ctx, &conv_buf);
+        GST_ERROR("%s kernel failed: %d", name, cuda_err);
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
-    /* Create output buffer */
-    GstMemory *dmabuf_mem = gst_dmabuf_allocator_alloc(
-        btx->dmabuf_allocator, conv_buf.dmabuf_fd, conv_buf.size);
-    conv_buf.dmabuf_fd = -1; /* Ownership transferred */
-
-    if (!dmabuf_mem)
+    /* Per-buffer completion: wait only for this slot's stream (or fence it) */
+    if (!buffer_transform_complete(btx, conv_buf->fence, conv_buf->cuda_stream, inbuf))
     {
-        cuda_egl_buffer_free(btx->egl_ctx, &conv_buf);
+        GST_ERROR("Failed to complete %s conversion", name);
+        gst_buffer_unref(pooled);
         return GST_FLOW_ERROR;
     }
 
-    *outbuf = gst_buffer_new();
-    gst_buffer_append_memory(*outbuf, dmabuf_mem);
-
-    /* Add video meta with actual BGRx format for proper stride/offset handling */
-    gsize offsets[4] = {0, 0, 0, 0};
-    gint strides[4] = {(gint)cuda_pitch, 0, 0, 0};
-    gst_buffer_add_video_meta_full(*outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-                                   GST_VIDEO_FORMAT_BGRx, width, height, 1, offsets, strides);
+    /* The pooled buffer already wraps the DMA-BUF with RGB video meta */
+    *outbuf = pooled;
 
     /* Copy timestamps */
     GST_BUFFER_PTS(*outbuf) = GST_BUFFER_PTS(inbuf);
     GST_BUFFER_DTS(*outbuf) = GST_BUFFER_DTS(inbuf);
     GST_BUFFER_DURATION(*outbuf) = GST_BUFFER_DURATION(inbuf);
 
-    /* Store GBM BO with buffer for cleanup */
-    gst_mini_object_set_qdata(GST_MINI_OBJECT(*outbuf),
-                              g_quark_from_static_string("gbm-bo"),
-                              conv_buf.bo, (GDestroyNotify)gbm_bo_destroy);
-    conv_buf.bo = NULL;
-
     return GST_FLOW_OK;
 }
 
+GstFlowReturn
+buffer_transform_nv12_to_bgrx(BufferTransformContext *btx,
+                              GstBufferPool *pool,
+                              GstBuffer *inbuf,
+                              GstBuffer **outbuf,
+                              const GstVideoInfo *info)
+{
+    return buffer_transform_convert_to_rgb(btx, pool, inbuf, outbuf, info, FALSE);
+}
+
+GstFlowReturn
+buffer_transform_p010_to_rgb(BufferTransformContext *btx,
+                             GstBufferPool *pool,
+                             GstBuffer *inbuf,
+                             GstBuffer **outbuf,
+                             const GstVideoInfo *info,
+                             gboolean rgb10)
+{
+    return buffer_transform_convert_to_rgb(btx, pool, inbuf, outbuf, info, rgb10);
+}
+
 GstFlowReturn
 buffer_transform_bgrx_copy(GstBuffer *inbuf,
                            GstBuffer *outbuf,
-                           const GstVideoInfo *info)
+                           const GstVideoInfo *info,
+                           WorkerPool *workers)
 {
     guint width = GST_VIDEO_INFO_WIDTH(info);
     guint height = GST_VIDEO_INFO_HEIGHT(info);
-    const guint row_bytes = width * 4;
 
     GstVideoFrame in_frame;
     if (!gst_video_frame_map(&in_frame, (GstVideoInfo *)info, inbuf, GST_MAP_READ))
@@ -439,8 +789,8 @@ buffer_transform_bgrx_copy(GstBuffer *inbuf,
         return GST_FLOW_ERROR;
     }
 
-    GstMapInfo outmap;
-    if (!gst_buffer_map(outbuf, &outmap, GST_MAP_WRITE))
+    GstGbmCpuAccess out;
+    if (!gst_gbm_dmabuf_pool_begin_cpu_access(outbuf, GST_MAP_WRITE, &out))
     {
         gst_video_frame_unmap(&in_frame);
         return GST_FLOW_ERROR;
@@ -450,22 +800,108 @@ buffer_transform_bgrx_copy(GstBuffer *inbuf,
     gint dst_stride = vmeta ? vmeta->stride[0] : (gint)(width * 4);
     gint src_stride = GST_VIDEO_FRAME_PLANE_STRIDE(&in_frame, 0);
 
-    const guint8 *srcp = (const guint8 *)GST_VIDEO_FRAME_PLANE_DATA(&in_frame, 0);
-    guint8 *dstp = (guint8 *)outmap.data;
+    /* The destination is write-combined DMA-BUF memory: stream the stores
+     * so the copy doesn't evict the source (or anything else) from cache */
+    RowCopy copy = {
+        GST_VIDEO_FRAME_PLANE_DATA(&in_frame, 0),
+        src_stride,
+        out.data,
+        dst_stride,
+        (gsize)width * 4,
+        (gint)height,
+    };
+    row_copy_frame(workers, ROW_COPY_STREAM, &copy);
+
+    gst_gbm_dmabuf_pool_end_cpu_access(&out);
+    gst_video_frame_unmap(&in_frame);
+
+    return GST_FLOW_OK;
+}
+
+GstFlowReturn
+buffer_transform_system_semi_planar(GstBuffer *inbuf,
+                                    GstBuffer *outbuf,
+                                    const GstVideoInfo *info,
+                                    WorkerPool *workers)
+{
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(outbuf);
+    if (!vmeta || vmeta->n_planes < 2)
+    {
+        GST_ERROR("Output buffer has no semi-planar video meta");
+        return GST_FLOW_ERROR;
+    }
+
+    GstVideoFrame in_frame;
+    if (!gst_video_frame_map(&in_frame, (GstVideoInfo *)info, inbuf, GST_MAP_READ))
+    {
+        GST_ERROR("Failed to map input");
+        return GST_FLOW_ERROR;
+    }
+
+    GstGbmCpuAccess out;
+    if (!gst_gbm_dmabuf_pool_begin_cpu_access(outbuf, GST_MAP_WRITE, &out))
+    {
+        gst_video_frame_unmap(&in_frame);
+        return GST_FLOW_ERROR;
+    }
 
-    for (guint y = 0; y < height; y++)
+    SemiPlanarCopy copy = {0};
+    switch (GST_VIDEO_INFO_FORMAT(info))
     {
-        memcpy(dstp, srcp, row_bytes);
-        srcp += src_stride;
-        dstp += dst_stride;
+    case GST_VIDEO_FORMAT_I420:
+        copy.src_format = SEMI_PLANAR_SRC_I420;
+        break;
+    case GST_VIDEO_FORMAT_P010_10LE:
+        copy.src_format = SEMI_PLANAR_SRC_P010;
+        break;
+    default:
+        copy.src_format = SEMI_PLANAR_SRC_NV12;
+        break;
     }
 
-    gst_buffer_unmap(outbuf, &outmap);
+    for (guint i = 0; i < GST_VIDEO_FRAME_N_PLANES(&in_frame) && i < 3; i++)
+    {
+        copy.src[i] = GST_VIDEO_FRAME_PLANE_DATA(&in_frame, i);
+        copy.src_stride[i] = GST_VIDEO_FRAME_PLANE_STRIDE(&in_frame, i);
+    }
+    for (guint i = 0; i < 2; i++)
+    {
+        copy.dst[i] = out.data + vmeta->offset[i];
+        copy.dst_stride[i] = vmeta->stride[i];
+    }
+    copy.width = GST_VIDEO_INFO_WIDTH(info);
+    copy.height = GST_VIDEO_INFO_HEIGHT(info);
+
+    semi_planar_copy_frame(workers, &copy);
+
+    gst_gbm_dmabuf_pool_end_cpu_access(&out);
     gst_video_frame_unmap(&in_frame);
 
     return GST_FLOW_OK;
 }
 
+/* Wrap both planes of an external FD buffer in a GstBuffer with video meta */
+static GstBuffer *
+external_fd_wrap_buffer(BufferTransformContext *btx,
+                        ExternalFdBuffer *ext_buf,
+                        guint width, guint height,
+                        gboolean is_p010)
+{
+    const int fds[2] = {ext_buf->y_fd, ext_buf->uv_fd};
+    const gsize sizes[2] = {ext_buf->y_size, ext_buf->uv_size};
+    const gsize offsets[4] = {0, 0, 0, 0};
+    const gint strides[4] = {(gint)ext_buf->y_stride, (gint)ext_buf->uv_stride, 0, 0};
+    GstVideoFormat vid_fmt = is_p010 ? GST_VIDEO_FORMAT_P010_10LE : GST_VIDEO_FORMAT_NV12;
+
+    GstBuffer *buffer = dmabuf_wrapper_build_buffer(btx->dmabuf_allocator, 2, fds, sizes,
+                                                    ext_buf->fence, vid_fmt,
+                                                    width, height, 2, offsets, strides);
+    if (!buffer)
+        GST_ERROR("Failed to wrap external FDs (y=%d, uv=%d)", ext_buf->y_fd, ext_buf->uv_fd);
+
+    return buffer;
+}
+
 GstFlowReturn
 buffer_transform_external_fd_passthrough(BufferTransformContext *btx,
                                          ExternalFdPool *pool,
@@ -513,6 +949,12 @@ buffer_transform_external_fd_passthrough(BufferTransformContext *btx,
     const uint8_t *in_base = (const uint8_t *)in_map.data;
     CUresult cu_res;
 
+    if (!buffer_transform_wait_input(btx, inbuf, ext_buf->cuda_stream))
+    {
+        gst_buffer_unmap(inbuf, &in_map);
+        return GST_FLOW_ERROR;
+    }
+
     /* Async copy Y plane: CUDA device → external FD device ptr */
     CUDA_MEMCPY2D y_copy = {0};
     y_copy.srcMemoryType = CU_MEMORYTYPE_DEVICE;
@@ -553,48 +995,35 @@ buffer_transform_external_fd_passthrough(BufferTransformContext *btx,
 
     gst_buffer_unmap(inbuf, &in_map);
 
-    /* Sync before handing to Vulkan */
-    cuStreamSynchronize(ext_buf->cuda_stream);
+    /* Sync (or fence) before handing to Vulkan */
+    if (!buffer_transform_complete(btx, ext_buf->fence, ext_buf->cuda_stream, inbuf))
+    {
+        GST_ERROR("Failed to complete external FD copy");
+        return GST_FLOW_ERROR;
+    }
 
     /* Create DMA-BUF allocator if needed */
     if (!btx->dmabuf_allocator)
-        btx->dmabuf_allocator = gst_dmabuf_allocator_new();
-
-    /* Wrap external FDs in GstBuffer.
-     * dup() the FDs because GstDmaBufAllocator takes ownership. */
-    int y_fd_dup = dup(ext_buf->y_fd);
-    int uv_fd_dup = dup(ext_buf->uv_fd);
-    if (y_fd_dup < 0 || uv_fd_dup < 0)
-    {
-        GST_ERROR("Failed to dup external FDs (y=%d, uv=%d)", ext_buf->y_fd, ext_buf->uv_fd);
-        if (y_fd_dup >= 0)
-            close(y_fd_dup);
-        if (uv_fd_dup >= 0)
-            close(uv_fd_dup);
-        return GST_FLOW_ERROR;
-    }
+        btx->dmabuf_allocator = buffer_fence_allocator_new();
 
-    GstMemory *y_mem = gst_dmabuf_allocator_alloc(btx->dmabuf_allocator, y_fd_dup, ext_buf->y_size);
-    GstMemory *uv_mem = gst_dmabuf_allocator_alloc(btx->dmabuf_allocator, uv_fd_dup, ext_buf->uv_size);
-    if (!y_mem || !uv_mem)
+    /* Reuse the slot's prebuilt output buffer once downstream has released it */
+    if (!ext_buf->wrapper)
     {
-        if (y_mem)
-            gst_memory_unref(y_mem);
-        if (uv_mem)
-            gst_memory_unref(uv_mem);
-        return GST_FLOW_ERROR;
+        GstBuffer *wrapped = external_fd_wrap_buffer(btx, ext_buf, width, height, is_p010);
+        if (!wrapped)
+            return GST_FLOW_ERROR;
+        ext_buf->wrapper = dmabuf_wrapper_new(wrapped);
     }
 
-    *outbuf = gst_buffer_new();
-    gst_buffer_append_memory(*outbuf, y_mem);
-    gst_buffer_append_memory(*outbuf, uv_mem);
-
-    /* Add video meta with correct format and plane info */
-    GstVideoFormat vid_fmt = is_p010 ? GST_VIDEO_FORMAT_P010_10LE : GST_VIDEO_FORMAT_NV12;
-    gsize offsets[4] = {0, 0, 0, 0};
-    gint strides[4] = {(gint)ext_buf->y_stride, (gint)ext_buf->uv_stride, 0, 0};
-    gst_buffer_add_video_meta_full(*outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-                                   vid_fmt, width, height, 2, offsets, strides);
+    *outbuf = dmabuf_wrapper_acquire(ext_buf->wrapper);
+    if (!*outbuf)
+    {
+        /* Previous frame from this slot is still held downstream */
+        GST_LOG("External FD wrapper busy, building a one-off buffer");
+        *outbuf = external_fd_wrap_buffer(btx, ext_buf, width, height, is_p010);
+        if (!*outbuf)
+            return GST_FLOW_ERROR;
+    }
 
     /* Copy timestamps */
     GST_BUFFER_PTS(*outbuf) = GST_BUFFER_PTS(inbuf);
@@ -2,15 +2,20 @@
  * SPDX-FileCopyrightText: 2025 Ericky
  *
  * Buffer Transform Operations
- * Handles the actual buffer transform logic (NV12 passthrough, NV12→BGRx, BGRx copy)
+ * Handles the actual buffer transform logic (NV12/P010 passthrough, NV12/P010→RGB,
+ * optional scaling, BGRx copy, system-memory NV12/I420/P010 copy)
  */
 
 #ifndef __BUFFER_TRANSFORM_H__
 #define __BUFFER_TRANSFORM_H__
 
 #include "cuda_egl_interop.h"
+#include "cuda_nv12_to_bgrx.h"
+#include "scale_geometry.h"
 #include "pooled_buffers.h"
 #include "external_fd_pool.h"
+#include "worker_pool.h"
+#include "modifier_ranking.h"
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
@@ -24,8 +29,59 @@ typedef struct _BufferTransformContext
     CudaEglContext *egl_ctx;
     GstAllocator *dmabuf_allocator;
     guint64 negotiated_modifier;
+
+    /* If TRUE, don't block on GPU completion before returning output buffers.
+     * Completion is tracked by the fence attached to the output memory. */
+    gboolean deferred_sync;
+
+    /* Recorded on the input memory's stream so our streams can wait on
+     * upstream work without a host sync. Created on first use. */
+    CUevent input_ready;
+
+    /* YUV→RGB matrix/range for the BGRx conversion, set on caps change */
+    YuvToRgbCoeffs yuv_coeffs;
+
+    /* Resampling/letterboxing done by the copy and conversion passes when
+     * the output size differs from the input, set on caps change */
+    gboolean scaling;
+    ScaleGeometry scale;
 } BufferTransformContext;
 
+/**
+ * The DRM format table of the render node @drm_device, probed (or read
+ * from its cache file) on the first call for the node, so caps only
+ * offer modifiers that device supports, and its modifier ranking in
+ * @ranking. Cheap after the first call.
+ *
+ * @return The device's table, or the unprobed candidates if the device
+ *         couldn't be probed; valid for the lifetime of the process
+ */
+const DrmFormatTable *buffer_transform_probe_formats(const gchar *drm_device,
+                                                     ModifierRanking **ranking);
+
+/**
+ * Time the passthrough copy (Y+UV, as in
+ * buffer_transform_semi_planar_passthrough()) into a @width x @height
+ * NV12 or P010 buffer of each tiled modifier @table supports, record the costs
+ * in @ranking and save it to the device's cache file.
+ * Modifiers the device can't allocate at that size are skipped. Needs a
+ * current CUDA context.
+ *
+ * @param egl_ctx Initialized CUDA-EGL context
+ * @param table Format table of egl_ctx's render node
+ * @param ranking Modifier ranking of the same node
+ * @param is_p010 TRUE for P010, FALSE for NV12
+ * @param width Frame width
+ * @param height Frame height
+ * @param best Set to the fastest modifier (may be NULL)
+ * @return TRUE if at least one modifier was measured
+ */
+gboolean buffer_transform_calibrate_modifiers(CudaEglContext *egl_ctx,
+                                              const DrmFormatTable *table,
+                                              ModifierRanking *ranking,
+                                              gboolean is_p010, guint width, guint height,
+                                              guint64 *best);
+
 /**
  * Initialize buffer transform context.
  * Ensures EGL context is initialized and dmabuf allocator is ready.
@@ -39,21 +95,29 @@ gboolean buffer_transform_context_init(BufferTransformContext *btx,
                                        CudaEglContext *egl_ctx,
                                        guint64 modifier);
 
+/**
+ * Release resources owned by the transform context.
+ * Does not clean up the CUDA-EGL context, which is owned by the caller.
+ */
+void buffer_transform_context_cleanup(BufferTransformContext *btx);
+
 /**
  * Semi-planar 4:2:0 zero-copy passthrough transform.
  * Copies Y+UV planes from CUDA memory to DMA-BUF using async CUDA operations.
  * Works for both NV12 (8-bit) and P010 (10-bit).
+ * With btx->deferred_sync the copies are fenced rather than waited on.
+ * With btx->scaling both planes are resampled to the pool's size instead.
  *
  * @param btx Transform context
- * @param pool Buffer pool (NV12 or P010 format)
+ * @param pool Active GstPooledBufferPool (NV12 or P010 layout)
  * @param inbuf Input GstBuffer (CUDA NV12 or P010_10LE)
- * @param outbuf Output GstBuffer pointer (will be allocated)
+ * @param outbuf Output GstBuffer pointer (acquired from the pool)
  * @param info Video info for dimensions
  * @param is_p010 TRUE for P010 (16-bit samples), FALSE for NV12 (8-bit)
  * @return GST_FLOW_OK on success
  */
 GstFlowReturn buffer_transform_semi_planar_passthrough(BufferTransformContext *btx,
-                                                       PooledBufferPool *pool,
+                                                       GstBufferPool *pool,
                                                        GstBuffer *inbuf,
                                                        GstBuffer **outbuf,
                                                        const GstVideoInfo *info,
@@ -61,8 +125,10 @@ GstFlowReturn buffer_transform_semi_planar_passthrough(BufferTransformContext *b
 
 /**
  * CUDA memory direct DMA-BUF export (zero-copy, no intermediate buffer).
- * Exports CUDA MMAP-allocated memory directly as DMA-BUF.
- * Used for P010 where GBM doesn't support the format.
+ * Exports CUDA MMAP-allocated memory directly as DMA-BUF. The output buffer
+ * references the input buffer, so the decoder's memory is not recycled
+ * while downstream still displays it. The caller must check that the input
+ * layout is one downstream accepts.
  *
  * @param btx Transform context (needs dmabuf_allocator)
  * @param inbuf Input GstBuffer (CUDA MMAP memory)
@@ -78,35 +144,81 @@ GstFlowReturn buffer_transform_cuda_export(BufferTransformContext *btx,
 /**
  * NV12→BGRx conversion transform.
  * Converts CUDA NV12 to DMA-BUF XR24 using a CUDA kernel.
+ * Output buffers come from a persistent pool, so GBM/EGL/CUDA registration
+ * happens once at negotiation rather than per frame.
  *
  * @param btx Transform context
+ * @param pool Active GstPooledBufferPool (BGRx, LINEAR)
  * @param inbuf Input GstBuffer (CUDA NV12)
- * @param outbuf Output GstBuffer pointer (will be allocated)
+ * @param outbuf Output GstBuffer pointer (acquired from the pool)
  * @param info Video info for dimensions
  * @return GST_FLOW_OK on success
  */
 GstFlowReturn buffer_transform_nv12_to_bgrx(BufferTransformContext *btx,
+                                            GstBufferPool *pool,
                                             GstBuffer *inbuf,
                                             GstBuffer **outbuf,
                                             const GstVideoInfo *info);
 
+/**
+ * P010→RGB conversion transform.
+ * Converts CUDA P010 to DMA-BUF XR24 (8-bit) or XR30/AR30 (10-bit) using a
+ * CUDA kernel, so 10-bit content stays on the GPU when the sink cannot take
+ * P010. btx->yuv_coeffs must be computed for 10-bit input at the output
+ * depth. No tone mapping is applied.
+ *
+ * @param btx Transform context
+ * @param pool Active GstPooledBufferPool (BGRx or BGR10A2_LE, LINEAR)
+ * @param inbuf Input GstBuffer (CUDA P010)
+ * @param outbuf Output GstBuffer pointer (acquired from the pool)
+ * @param info Video info for dimensions
+ * @param rgb10 TRUE for 2:10:10:10 output, FALSE for BGRx
+ * @return GST_FLOW_OK on success
+ */
+GstFlowReturn buffer_transform_p010_to_rgb(BufferTransformContext *btx,
+                                           GstBufferPool *pool,
+                                           GstBuffer *inbuf,
+                                           GstBuffer **outbuf,
+                                           const GstVideoInfo *info,
+                                           gboolean rgb10);
+
 /**
  * BGRx CPU copy transform.
- * Copies BGRx from system memory to DMA-BUF.
+ * Copies BGRx from system memory to DMA-BUF in row bands across @workers,
+ * with non-temporal stores, as one block when the strides match.
  *
  * @param inbuf Input GstBuffer (system memory BGRx)
  * @param outbuf Output GstBuffer (from DMA-BUF pool)
  * @param info Video info for dimensions
+ * @param workers Worker pool for the row bands (or NULL)
  * @return GST_FLOW_OK on success
  */
 GstFlowReturn buffer_transform_bgrx_copy(GstBuffer *inbuf,
                                          GstBuffer *outbuf,
-                                         const GstVideoInfo *info);
+                                         const GstVideoInfo *info,
+                                         WorkerPool *workers);
+
+/**
+ * System-memory semi-planar copy transform.
+ * Copies NV12/P010 planes, or interleaves I420 chroma into NV12, from system
+ * memory into a LINEAR semi-planar DMA-BUF, split across @workers.
+ *
+ * @param inbuf Input GstBuffer (system memory NV12, I420 or P010_10LE)
+ * @param outbuf Output GstBuffer (from the NV12/P010 DMA-BUF pool)
+ * @param info Input video info
+ * @param workers Worker pool for the row bands (or NULL)
+ * @return GST_FLOW_OK on success
+ */
+GstFlowReturn buffer_transform_system_semi_planar(GstBuffer *inbuf,
+                                                  GstBuffer *outbuf,
+                                                  const GstVideoInfo *info,
+                                                  WorkerPool *workers);
 
 /**
  * Semi-planar passthrough using externally-allocated DMA-BUF FDs.
  * Copies Y+UV planes from CUDA memory into Vulkan-exported buffers via CUDA
  * device-to-device copy. The output GstBuffer wraps the external DMA-BUF FDs.
+ * With btx->deferred_sync the copies are fenced rather than waited on.
  *
  * @param btx Transform context (needs dmabuf_allocator)
  * @param pool External FD pool (Vulkan-exported buffers)
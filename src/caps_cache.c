@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Caps Cache
+ */
+
+#include "caps_cache.h"
+
+typedef struct
+{
+    CapsCacheKey key;
+    GstCaps *caps;
+    GstCaps *result;
+} CapsCacheEntry;
+
+struct _CapsCache
+{
+    GMutex lock;
+    GQueue entries; /* Most recently used first */
+    guint capacity;
+    guint64 hits;
+    guint64 misses;
+};
+
+static void
+caps_cache_entry_free(CapsCacheEntry *entry)
+{
+    gst_caps_unref(entry->caps);
+    gst_caps_unref(entry->result);
+    g_free(entry);
+}
+
+CapsCache *
+caps_cache_new(guint capacity)
+{
+    CapsCache *cache = g_new0(CapsCache, 1);
+
+    g_mutex_init(&cache->lock);
+    g_queue_init(&cache->entries);
+    cache->capacity = MAX(capacity, 1);
+    return cache;
+}
+
+void caps_cache_free(CapsCache *cache)
+{
+    if (!cache)
+        return;
+
+    g_queue_clear_full(&cache->entries, (GDestroyNotify)caps_cache_entry_free);
+    g_mutex_clear(&cache->lock);
+    g_free(cache);
+}
+
+static gboolean
+key_equal(const CapsCacheKey *a, const CapsCacheKey *b)
+{
+    return a->direction == b->direction && !a->force_linear == !b->force_linear &&
+           a->formats == b->formats && a->ranking == b->ranking;
+}
+
+GstCaps *
+caps_cache_lookup(CapsCache *cache, const CapsCacheKey *key, GstCaps *caps)
+{
+    GstCaps *result = NULL;
+
+    g_mutex_lock(&cache->lock);
+    for (GList *l = cache->entries.head; l; l = l->next)
+    {
+        CapsCacheEntry *entry = l->data;
+
+        if (!key_equal(&entry->key, key))
+            continue;
+        if (entry->caps != caps && !gst_caps_is_strictly_equal(entry->caps, caps))
+            continue;
+
+        /* Move to the front so the working set stays cached */
+        g_queue_unlink(&cache->entries, l);
+        g_queue_push_head_link(&cache->entries, l);
+        result = gst_caps_ref(entry->result);
+        break;
+    }
+
+    if (result)
+        cache->hits++;
+    else
+        cache->misses++;
+    g_mutex_unlock(&cache->lock);
+
+    return result;
+}
+
+void caps_cache_insert(CapsCache *cache, const CapsCacheKey *key,
+                       GstCaps *caps, GstCaps *result)
+{
+    CapsCacheEntry *entry = g_new0(CapsCacheEntry, 1);
+
+    entry->key = *key;
+    entry->caps = gst_caps_ref(caps);
+    entry->result = gst_caps_ref(result);
+
+    g_mutex_lock(&cache->lock);
+    g_queue_push_head(&cache->entries, entry);
+    while (g_queue_get_length(&cache->entries) > cache->capacity)
+        caps_cache_entry_free(g_queue_pop_tail(&cache->entries));
+    g_mutex_unlock(&cache->lock);
+}
+
+void caps_cache_clear(CapsCache *cache)
+{
+    g_mutex_lock(&cache->lock);
+    g_queue_clear_full(&cache->entries, (GDestroyNotify)caps_cache_entry_free);
+    g_mutex_unlock(&cache->lock);
+}
+
+void caps_cache_get_stats(CapsCache *cache, guint64 *hits, guint64 *misses)
+{
+    g_mutex_lock(&cache->lock);
+    if (hits)
+        *hits = cache->hits;
+    if (misses)
+        *misses = cache->misses;
+    g_mutex_unlock(&cache->lock);
+}
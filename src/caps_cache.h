@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Caps Cache
+ * Small LRU of caps_transform results, so repeated transform_caps queries
+ * during startup and renegotiation (tee, compositor, queue reconfigure)
+ * don't rebuild the same DMA_DRM structures each time.
+ */
+
+#ifndef __CAPS_CACHE_H__
+#define __CAPS_CACHE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Everything besides the input caps a transform result depends on */
+typedef struct
+{
+    GstPadDirection direction;
+    gboolean force_linear;
+    gconstpointer formats; /* DRM format table the result was built from */
+    guint ranking;         /* Modifier ranking generation */
+} CapsCacheKey;
+
+typedef struct _CapsCache CapsCache;
+
+/**
+ * Create a cache holding the @capacity most recently used results.
+ */
+CapsCache *caps_cache_new(guint capacity);
+
+void caps_cache_free(CapsCache *cache);
+
+/**
+ * Find the result for @caps under @key. Input caps match if they are
+ * strictly equal, not only the same object.
+ *
+ * @return A reference to the cached result (immutable: intersect or copy
+ *         it, never modify it), or NULL on a miss
+ */
+GstCaps *caps_cache_lookup(CapsCache *cache, const CapsCacheKey *key, GstCaps *caps);
+
+/**
+ * Remember @result for @caps under @key, evicting the least recently used
+ * entry when full. Both caps are referenced, not copied.
+ */
+void caps_cache_insert(CapsCache *cache, const CapsCacheKey *key,
+                       GstCaps *caps, GstCaps *result);
+
+/**
+ * Drop every entry (property or device change).
+ */
+void caps_cache_clear(CapsCache *cache);
+
+/**
+ * Lookup counters since creation.
+ */
+void caps_cache_get_stats(CapsCache *cache, guint64 *hits, guint64 *misses);
+
+G_END_DECLS
+
+#endif /* __CAPS_CACHE_H__ */
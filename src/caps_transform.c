@@ -7,39 +7,14 @@
 
 #include "caps_transform.h"
 #include "drm_format_utils.h"
+#include "drm_format_table.h"
+#include "modifier_ranking.h"
 
 #define GST_USE_UNSTABLE_API
 #include <gst/cuda/gstcuda.h>
 #include <drm/drm_fourcc.h>
 #include <string.h>
 
-/* NV12 modifiers supported */
-static const char *nv12_modifiers[] = {
-    "NV12:0x0300000000606010", "NV12:0x0300000000606011",
-    "NV12:0x0300000000606012", "NV12:0x0300000000606013",
-    "NV12:0x0300000000606014", "NV12:0x0300000000606015",
-    "NV12:0x0300000000e08010", "NV12:0x0300000000e08011",
-    "NV12:0x0300000000e08012", "NV12:0x0300000000e08013",
-    "NV12:0x0300000000e08014", "NV12:0x0300000000e08015",
-    "NV12:0x0", "NV12:0x100000000000001", NULL};
-
-/* P010 (10-bit 4:2:0) modifiers supported - same NVIDIA tiled modifiers as NV12 */
-static const char *p010_modifiers[] = {
-    "P010:0x0300000000606010", "P010:0x0300000000606011",
-    "P010:0x0300000000606012", "P010:0x0300000000606013",
-    "P010:0x0300000000606014", "P010:0x0300000000606015",
-    "P010:0x0300000000e08010", "P010:0x0300000000e08011",
-    "P010:0x0300000000e08012", "P010:0x0300000000e08013",
-    "P010:0x0300000000e08014", "P010:0x0300000000e08015",
-    "P010:0x0", "P010:0x100000000000001", NULL};
-
-/* XR24 modifiers supported - linear (0x0) first for Vulkan/wgpu compatibility */
-static const char *xr24_modifiers[] = {
-    "XR24:0x0",
-    "XR24:0x0300000000606010", "XR24:0x0300000000606011",
-    "XR24:0x0300000000606012", "XR24:0x0300000000606013",
-    "XR24:0x0300000000606014", "XR24:0x0300000000606015", NULL};
-
 void caps_transform_add_drm(GstCaps *caps, const gchar *drm_format,
                             const GValue *width, const GValue *height,
                             const GValue *framerate)
@@ -62,14 +37,127 @@ void caps_transform_add_drm(GstCaps *caps, const gchar *drm_format,
     gst_caps_append(caps, tmp);
 }
 
+/* Append the drm-formats of @fourcc @table supports, in table
+ * (preference) order reordered by @ranking if given: only LINEAR if
+ * @linear_only, at most @limit (0 for all) */
+static void
+add_drm_formats(GstCaps *caps, const DrmFormatTable *table, ModifierRanking *ranking,
+                guint32 fourcc, gboolean linear_only, guint limit,
+                const GValue *width, const GValue *height, const GValue *framerate)
+{
+    guint n_entries = drm_format_table_get_n_entries(table);
+    const DrmFormatEntry **entries = g_new(const DrmFormatEntry *, n_entries);
+    guint64 *modifiers = g_new(guint64, n_entries);
+    guint n = 0;
+
+    for (guint i = 0; i < n_entries; i++)
+    {
+        const DrmFormatEntry *e = drm_format_table_get_entry(table, i);
+
+        if (e->fourcc != fourcc || !e->supported)
+            continue;
+        if (linear_only && e->modifier != DRM_FORMAT_MOD_LINEAR)
+            continue;
+
+        entries[n] = e;
+        modifiers[n++] = e->modifier;
+    }
+
+    /* Rank at the input size when it's fixed */
+    guint w = width && G_VALUE_HOLDS_INT(width) ? (guint)g_value_get_int(width) : 0;
+    guint h = height && G_VALUE_HOLDS_INT(height) ? (guint)g_value_get_int(height) : 0;
+    if (ranking)
+        modifier_ranking_sort(ranking, fourcc, w, h, modifiers, n);
+
+    for (guint i = 0; i < n && (!limit || i < limit); i++)
+    {
+        for (guint j = 0; j < n; j++)
+        {
+            if (entries[j]->modifier == modifiers[i])
+            {
+                caps_transform_add_drm(caps, entries[j]->drm_format, width, height, framerate);
+                break;
+            }
+        }
+    }
+
+    g_free(entries);
+    g_free(modifiers);
+}
+
+GstCaps *
+caps_transform_src_template_caps(void)
+{
+    DrmFormatTable *table = drm_format_table_new();
+    GstCaps *caps = gst_caps_new_empty();
+    guint n = drm_format_table_get_n_entries(table);
+
+    /* One structure per fourcc listing every candidate modifier */
+    for (guint i = 0; i < n;)
+    {
+        guint32 fourcc = drm_format_table_get_entry(table, i)->fourcc;
+        GValue list = G_VALUE_INIT;
+
+        g_value_init(&list, GST_TYPE_LIST);
+        for (; i < n && drm_format_table_get_entry(table, i)->fourcc == fourcc; i++)
+        {
+            GValue v = G_VALUE_INIT;
+            g_value_init(&v, G_TYPE_STRING);
+            g_value_set_string(&v, drm_format_table_get_entry(table, i)->drm_format);
+            gst_value_list_append_and_take_value(&list, &v);
+        }
+
+        GstStructure *s = gst_structure_new("video/x-raw",
+                                            "format", G_TYPE_STRING, "DMA_DRM",
+                                            "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                                            "height", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                                            "framerate", GST_TYPE_FRACTION_RANGE, 0, 1, G_MAXINT, 1,
+                                            NULL);
+        gst_structure_take_value(s, "drm-format", &list);
+        gst_caps_append_structure_full(caps, s, gst_caps_features_new("memory:DMABuf", NULL));
+    }
+
+    gst_caps_append_structure(caps,
+                              gst_structure_new("video/x-raw",
+                                                "format", G_TYPE_STRING, "BGRx",
+                                                "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                                                "height", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                                                "framerate", GST_TYPE_FRACTION_RANGE, 0, 1, G_MAXINT, 1,
+                                                NULL));
+
+    drm_format_table_free(table);
+    return caps;
+}
+
+/* Append copies of structures [@start, @end) of @src to @dst with any
+ * width/height: the CUDA paths scale inside the copy/conversion pass.
+ * Appended after the native-size structures so those stay preferred. */
+static void
+append_any_size(GstCaps *dst, GstCaps *src, guint start, guint end)
+{
+    for (guint i = start; i < end; i++)
+    {
+        GstStructure *s = gst_structure_copy(gst_caps_get_structure(src, i));
+        GstCapsFeatures *f = gst_caps_features_copy(gst_caps_get_features(src, i));
+
+        gst_structure_set(s,
+                          "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                          "height", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+                          NULL);
+        gst_caps_append_structure_full(dst, s, f);
+    }
+}
+
 GstCaps *
-caps_transform_sink_to_src(GstCaps *caps, gboolean force_linear)
+caps_transform_sink_to_src(GstCaps *caps, gboolean force_linear,
+                           const DrmFormatTable *table, ModifierRanking *ranking)
 {
     /* Handle empty caps */
     if (gst_caps_get_size(caps) == 0)
         return gst_caps_new_empty();
 
     GstCaps *outcaps = gst_caps_new_empty();
+    GstCaps *scaled = gst_caps_new_empty();
 
     /* Normalize caps to expand value lists (e.g., format={NV12,P010_10LE})
      * into separate structures so we can handle each format individually. */
@@ -84,49 +172,44 @@ caps_transform_sink_to_src(GstCaps *caps, gboolean force_linear)
         const GValue *w = gst_structure_get_value(in_s, "width");
         const GValue *h = gst_structure_get_value(in_s, "height");
         const GValue *fr = gst_structure_get_value(in_s, "framerate");
+        guint before = gst_caps_get_size(outcaps);
 
         if (is_cuda && g_strcmp0(in_format, "NV12") == 0)
         {
-            if (force_linear)
-            {
-                caps_transform_add_drm(outcaps, "NV12:0x0", w, h, fr);
-                caps_transform_add_drm(outcaps, "XR24:0x0", w, h, fr);
-            }
-            else
-            {
-                for (int i = 0; nv12_modifiers[i]; i++)
-                    caps_transform_add_drm(outcaps, nv12_modifiers[i], w, h, fr);
-                for (int i = 0; xr24_modifiers[i]; i++)
-                    caps_transform_add_drm(outcaps, xr24_modifiers[i], w, h, fr);
-            }
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_NV12, force_linear, 0, w, h, fr);
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_XRGB8888, force_linear, 0, w, h, fr);
         }
         else if (is_cuda && g_strcmp0(in_format, "P010_10LE") == 0)
         {
-            if (force_linear)
-            {
-                caps_transform_add_drm(outcaps, "P010:0x0", w, h, fr);
-            }
-            else
-            {
-                for (int i = 0; p010_modifiers[i]; i++)
-                    caps_transform_add_drm(outcaps, p010_modifiers[i], w, h, fr);
-            }
+            /* Passthrough first, then 10-bit RGB (keeps the depth), then
+             * 8-bit XR24 for sinks without 10-bit support */
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_P010, force_linear, 0, w, h, fr);
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_XRGB2101010, TRUE, 0, w, h, fr);
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_ARGB2101010, TRUE, 0, w, h, fr);
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_XRGB8888, force_linear, 0, w, h, fr);
+        }
+        else if (!is_cuda && (g_strcmp0(in_format, "NV12") == 0 ||
+                              g_strcmp0(in_format, "I420") == 0))
+        {
+            /* System-memory YUV is copied into a LINEAR semi-planar
+             * DMA-BUF; I420 chroma is interleaved on the way */
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_NV12, TRUE, 0, w, h, fr);
+        }
+        else if (!is_cuda && g_strcmp0(in_format, "P010_10LE") == 0)
+        {
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_P010, TRUE, 0, w, h, fr);
         }
         else if (g_strcmp0(in_format, "BGRx") == 0)
         {
-            if (force_linear)
-            {
-                caps_transform_add_drm(outcaps, "XR24:0x0", w, h, fr);
-            }
-            else
-            {
-                for (int i = 0; xr24_modifiers[i] && i < 3; i++)
-                    caps_transform_add_drm(outcaps, xr24_modifiers[i], w, h, fr);
-            }
+            add_drm_formats(outcaps, table, ranking, DRM_FORMAT_XRGB8888, force_linear, 3, w, h, fr);
         }
+
+        if (is_cuda)
+            append_any_size(scaled, outcaps, before, gst_caps_get_size(outcaps));
     }
 
     gst_caps_unref(normalized);
+    gst_caps_append(outcaps, scaled);
     return outcaps;
 }
 
@@ -166,12 +249,13 @@ add_cuda_p010_caps(GstCaps *outcaps, const GValue *w, const GValue *h, const GVa
     gst_caps_append(outcaps, tmp);
 }
 
-/* Helper to add BGRx caps */
+/* Helper to add system-memory caps (BGRx, NV12, I420, P010_10LE) */
 static void
-add_bgrx_caps(GstCaps *outcaps, const GValue *w, const GValue *h, const GValue *fr)
+add_system_caps(GstCaps *outcaps, const gchar *format,
+                const GValue *w, const GValue *h, const GValue *fr)
 {
     GstCaps *tmp = gst_caps_new_simple(
-        "video/x-raw", "format", G_TYPE_STRING, "BGRx", NULL);
+        "video/x-raw", "format", G_TYPE_STRING, format, NULL);
     GstStructure *s = gst_caps_get_structure(tmp, 0);
     if (w)
         gst_structure_set_value(s, "width", w);
@@ -182,10 +266,45 @@ add_bgrx_caps(GstCaps *outcaps, const GValue *w, const GValue *h, const GValue *
     gst_caps_append(outcaps, tmp);
 }
 
+/* Output formats present in downstream caps */
+typedef struct
+{
+    gboolean nv12, p010, xr24, rgb10;
+    gboolean nv12_linear, p010_linear;
+} DrmFormatSet;
+
+static void
+drm_format_set_add(DrmFormatSet *set, const gchar *drm_format)
+{
+    gboolean linear = drm_format_parse_modifier(drm_format) == DRM_FORMAT_MOD_LINEAR;
+
+    switch (drm_format_get_fourcc(drm_format))
+    {
+    case DRM_FORMAT_NV12:
+        set->nv12 = TRUE;
+        set->nv12_linear |= linear;
+        break;
+    case DRM_FORMAT_P010:
+        set->p010 = TRUE;
+        set->p010_linear |= linear;
+        break;
+    case DRM_FORMAT_XRGB8888:
+        set->xr24 = TRUE;
+        break;
+    case DRM_FORMAT_XRGB2101010:
+    case DRM_FORMAT_ARGB2101010:
+        set->rgb10 = TRUE;
+        break;
+    default:
+        break;
+    }
+}
+
 GstCaps *
 caps_transform_src_to_sink(GstCaps *caps)
 {
     GstCaps *outcaps = gst_caps_new_empty();
+    GstCaps *scaled = gst_caps_new_empty();
 
     for (guint i = 0; i < gst_caps_get_size(caps); i++)
     {
@@ -202,54 +321,60 @@ caps_transform_src_to_sink(GstCaps *caps)
         if (format && g_strcmp0(format, "DMA_DRM") == 0 && is_dmabuf)
         {
             const GValue *drm_val = gst_structure_get_value(out_s, "drm-format");
-            gboolean has_nv12 = FALSE, has_p010 = FALSE, has_xr24 = FALSE;
+            DrmFormatSet set = {0};
 
-            if (drm_val)
+            if (drm_val && G_VALUE_HOLDS_STRING(drm_val))
             {
-                if (G_VALUE_HOLDS_STRING(drm_val))
-                {
-                    const gchar *drm = g_value_get_string(drm_val);
-                    has_nv12 = drm_format_is_nv12(drm);
-                    has_p010 = drm_format_is_p010(drm);
-                    has_xr24 = drm_format_is_xr24(drm);
-                }
-                else if (GST_VALUE_HOLDS_LIST(drm_val))
+                drm_format_set_add(&set, g_value_get_string(drm_val));
+            }
+            else if (drm_val && GST_VALUE_HOLDS_LIST(drm_val))
+            {
+                for (guint j = 0; j < gst_value_list_get_size(drm_val); j++)
                 {
-                    for (guint j = 0; j < gst_value_list_get_size(drm_val); j++)
-                    {
-                        const GValue *v = gst_value_list_get_value(drm_val, j);
-                        if (G_VALUE_HOLDS_STRING(v))
-                        {
-                            const gchar *drm = g_value_get_string(v);
-                            if (drm_format_is_nv12(drm))
-                                has_nv12 = TRUE;
-                            if (drm_format_is_p010(drm))
-                                has_p010 = TRUE;
-                            if (drm_format_is_xr24(drm))
-                                has_xr24 = TRUE;
-                        }
-                    }
+                    const GValue *v = gst_value_list_get_value(drm_val, j);
+                    if (G_VALUE_HOLDS_STRING(v))
+                        drm_format_set_add(&set, g_value_get_string(v));
                 }
             }
 
-            if (has_nv12)
+            if (set.nv12)
                 add_cuda_nv12_caps(outcaps, w, h, fr);
 
-            if (has_p010)
+            if (set.p010 || set.rgb10)
                 add_cuda_p010_caps(outcaps, w, h, fr);
 
-            if (has_xr24)
+            if (set.xr24)
             {
-                /* XR24 can come from CUDA NV12 or regular BGRx */
+                /* XR24 can come from CUDA NV12/P010 or regular BGRx */
                 add_cuda_nv12_caps(outcaps, w, h, fr);
-                add_bgrx_caps(outcaps, w, h, fr);
+                add_cuda_p010_caps(outcaps, w, h, fr);
+                add_system_caps(outcaps, "BGRx", w, h, fr);
+            }
+
+            /* System-memory YUV can only be copied into LINEAR planes */
+            if (set.nv12_linear)
+            {
+                add_system_caps(outcaps, "NV12", w, h, fr);
+                add_system_caps(outcaps, "I420", w, h, fr);
             }
+
+            if (set.p010_linear)
+                add_system_caps(outcaps, "P010_10LE", w, h, fr);
         }
         else if (format && g_strcmp0(format, "BGRx") == 0)
         {
-            add_bgrx_caps(outcaps, w, h, fr);
+            add_system_caps(outcaps, "BGRx", w, h, fr);
         }
     }
 
+    /* CUDA input of any size can be scaled to the requested output */
+    for (guint i = 0; i < gst_caps_get_size(outcaps); i++)
+    {
+        GstCapsFeatures *features = gst_caps_get_features(outcaps, i);
+        if (features && gst_caps_features_contains(features, GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY))
+            append_any_size(scaled, outcaps, i, i + 1);
+    }
+
+    gst_caps_append(outcaps, scaled);
     return outcaps;
 }
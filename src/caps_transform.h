@@ -8,6 +8,9 @@
 #ifndef __CAPS_TRANSFORM_H__
 #define __CAPS_TRANSFORM_H__
 
+#include "drm_format_table.h"
+#include "modifier_ranking.h"
+
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
@@ -26,21 +29,41 @@ void caps_transform_add_drm(GstCaps *caps, const gchar *drm_format,
                             const GValue *width, const GValue *height,
                             const GValue *framerate);
 
+/**
+ * Source pad template caps: every candidate drm-format of the format
+ * table, one structure per fourcc, plus system-memory BGRx. Negotiation
+ * only offers the subset the device supports.
+ *
+ * @return Template caps (caller owns reference)
+ */
+GstCaps *caps_transform_src_template_caps(void);
+
 /**
  * Transform sink caps to source caps.
  * CUDA NV12 → NV12 DMA-BUF (preferred) or XR24 DMA-BUF (fallback)
  * BGRx → XR24 DMA-BUF
+ * System NV12/I420 → LINEAR NV12 DMA-BUF, system P010 → LINEAR P010 DMA-BUF
+ * CUDA input is also offered at any output size (scaled in the conversion
+ * pass), after the native-size structures. Modifiers come from @table,
+ * so only those the device supports are offered once it's probed,
+ * fastest first once @ranking has measurements.
  *
  * @param caps Input caps from sink
  * @param force_linear If TRUE, only advertise linear modifiers (0x0)
+ * @param table Format table of the output device
+ * @param ranking Modifier ranking of the same device (may be NULL)
  * @return Transformed caps for source (caller owns reference)
  */
-GstCaps *caps_transform_sink_to_src(GstCaps *caps, gboolean force_linear);
+GstCaps *caps_transform_sink_to_src(GstCaps *caps, gboolean force_linear,
+                                    const DrmFormatTable *table,
+                                    ModifierRanking *ranking);
 
 /**
  * Transform source caps to sink caps (reverse direction).
  * NV12 DMA-BUF → CUDA NV12
  * XR24 DMA-BUF → CUDA NV12 or BGRx
+ * LINEAR NV12/P010 DMA-BUF → also system NV12/I420/P010, after the CUDA caps
+ * CUDA input of any size is accepted after the same-size structures.
  *
  * @param caps Input caps from source
  * @return Transformed caps for sink (caller owns reference)
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Colorimetry - YUV→RGB coefficient derivation
+ */
+
+#include "colorimetry.h"
+
+/* Round half away from zero to Q13 */
+static int32_t
+to_fixed(gdouble v)
+{
+    gdouble scaled = v * (1 << YUV_TO_RGB_SHIFT);
+    return scaled >= 0.0 ? (int32_t)(scaled + 0.5) : -(int32_t)(-scaled + 0.5);
+}
+
+/* Kr/Kb of @matrix, falling back to BT.709 for UNKNOWN/RGB */
+static GstVideoColorMatrix
+get_Kr_Kb(GstVideoColorMatrix matrix, gdouble *Kr, gdouble *Kb)
+{
+    if (!gst_video_color_matrix_get_Kr_Kb(matrix, Kr, Kb))
+    {
+        /* UNKNOWN/RGB: keep the previous hard-coded behaviour's matrix */
+        matrix = GST_VIDEO_COLOR_MATRIX_BT709;
+        gst_video_color_matrix_get_Kr_Kb(matrix, Kr, Kb);
+    }
+    return matrix;
+}
+
+static gint32
+round_clamp(gdouble v, gint32 max)
+{
+    gint32 i = v >= 0.0 ? (gint32)(v + 0.5) : 0;
+    return i > max ? max : i;
+}
+
+void colorimetry_get_yuv_to_rgb_coeffs(const GstVideoColorimetry *cinfo,
+                                       YuvToRgbCoeffs *coeffs)
+{
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(cinfo, 8, 8, coeffs);
+}
+
+void colorimetry_get_yuv_to_rgb_coeffs_for_depth(const GstVideoColorimetry *cinfo,
+                                                 guint in_depth,
+                                                 guint out_depth,
+                                                 YuvToRgbCoeffs *coeffs)
+{
+    gdouble Kr, Kb;
+    GstVideoColorMatrix matrix = get_Kr_Kb(cinfo->matrix, &Kr, &Kb);
+
+    gboolean full_range = cinfo->range == GST_VIDEO_COLOR_RANGE_0_255;
+    gdouble Kg = 1.0 - Kr - Kb;
+
+    /* Limited-range levels scale with the sample depth (16-235 at 8 bits,
+     * 64-940 at 10 bits); full range spans every code value */
+    guint shift = in_depth - 8;
+    gdouble in_max = (gdouble)((1u << in_depth) - 1);
+    gdouble out_max = (gdouble)((1u << out_depth) - 1);
+
+    /* Scale from code values to normalised [0,1] luma / [-0.5,0.5] chroma,
+     * then back to RGB at the output depth */
+    gdouble y_scale = out_max / (full_range ? in_max : (gdouble)(219u << shift));
+    gdouble c_scale = out_max / (full_range ? in_max : (gdouble)(224u << shift));
+
+    coeffs->y_offset = full_range ? 0 : (int32_t)(16u << shift);
+    coeffs->uv_offset = (int32_t)(128u << shift);
+    coeffs->cy = to_fixed(y_scale);
+    coeffs->crv = to_fixed(c_scale * 2.0 * (1.0 - Kr));
+    coeffs->cgu = to_fixed(-c_scale * 2.0 * Kb * (1.0 - Kb) / Kg);
+    coeffs->cgv = to_fixed(-c_scale * 2.0 * Kr * (1.0 - Kr) / Kg);
+    coeffs->cbu = to_fixed(c_scale * 2.0 * (1.0 - Kb));
+    coeffs->out_max = (int32_t)out_max;
+
+    g_debug("YUV→RGB: matrix=%d range=%s depth=%u→%u cy=%d crv=%d cgu=%d cgv=%d cbu=%d",
+            matrix, full_range ? "full" : "limited", in_depth, out_depth,
+            coeffs->cy, coeffs->crv, coeffs->cgu, coeffs->cgv, coeffs->cbu);
+}
+
+void colorimetry_rgb_to_yuv(const GstVideoColorimetry *cinfo, guint depth,
+                            guint8 r, guint8 g, guint8 b,
+                            gint32 *y, gint32 *u, gint32 *v)
+{
+    gdouble Kr, Kb;
+    get_Kr_Kb(cinfo->matrix, &Kr, &Kb);
+
+    gboolean full_range = cinfo->range == GST_VIDEO_COLOR_RANGE_0_255;
+    guint shift = depth - 8;
+    gint32 max = (gint32)((1u << depth) - 1);
+
+    gdouble R = r / 255.0, G = g / 255.0, B = b / 255.0;
+    gdouble Y = Kr * R + (1.0 - Kr - Kb) * G + Kb * B;
+    gdouble Cb = (B - Y) / (2.0 * (1.0 - Kb));
+    gdouble Cr = (R - Y) / (2.0 * (1.0 - Kr));
+
+    gdouble y_scale = full_range ? max : (gdouble)(219u << shift);
+    gdouble c_scale = full_range ? max : (gdouble)(224u << shift);
+    gdouble y_offset = full_range ? 0.0 : (gdouble)(16u << shift);
+    gdouble c_offset = (gdouble)(128u << shift);
+
+    *y = round_clamp(y_offset + Y * y_scale, max);
+    *u = round_clamp(c_offset + Cb * c_scale, max);
+    *v = round_clamp(c_offset + Cr * c_scale, max);
+}
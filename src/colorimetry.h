@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Colorimetry
+ * YUV→RGB conversion coefficients derived from negotiated caps
+ */
+
+#ifndef __COLORIMETRY_H__
+#define __COLORIMETRY_H__
+
+#include "cuda_nv12_to_bgrx.h"
+#include <glib.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Compute fixed-point YUV→RGB coefficients for 8-bit input and output.
+ *
+ * The matrix (BT.601, BT.709, BT.2020, SMPTE 240M, FCC) and the range
+ * (limited 16-235/240 or full 0-255) come from @cinfo. An unknown or RGB
+ * matrix falls back to BT.709 and an unknown range to limited.
+ *
+ * @param cinfo Colorimetry of the YUV input (e.g. from GST_VIDEO_INFO_COLORIMETRY)
+ * @param coeffs Output coefficients
+ */
+void colorimetry_get_yuv_to_rgb_coeffs(const GstVideoColorimetry *cinfo,
+                                       YuvToRgbCoeffs *coeffs);
+
+/**
+ * Compute fixed-point YUV→RGB coefficients for a given input and output
+ * bit depth, e.g. 10-bit P010 to 8-bit BGRx or to 10-bit XRGB2101010.
+ * Matrix/range handling is the same as colorimetry_get_yuv_to_rgb_coeffs().
+ *
+ * @param cinfo Colorimetry of the YUV input
+ * @param in_depth Significant bits per input sample (8 or 10)
+ * @param out_depth Bits per output component (8 or 10)
+ * @param coeffs Output coefficients
+ */
+void colorimetry_get_yuv_to_rgb_coeffs_for_depth(const GstVideoColorimetry *cinfo,
+                                                 guint in_depth,
+                                                 guint out_depth,
+                                                 YuvToRgbCoeffs *coeffs);
+
+/**
+ * Convert an 8-bit RGB colour to Y/U/V code values of the given depth,
+ * e.g. for filling letterbox borders of NV12/P010 output. Uses the same
+ * matrix/range fallbacks as colorimetry_get_yuv_to_rgb_coeffs().
+ *
+ * @param cinfo Colorimetry of the YUV output
+ * @param depth Bits per YUV sample (8 or 10)
+ * @param r, g, b RGB colour (0-255)
+ * @param y, u, v Output code values
+ */
+void colorimetry_rgb_to_yuv(const GstVideoColorimetry *cinfo, guint depth,
+                            guint8 r, guint8 g, guint8 b,
+                            gint32 *y, gint32 *u, gint32 *v);
+
+G_END_DECLS
+
+#endif /* __COLORIMETRY_H__ */
@@ -0,0 +1,476 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * CPU NV12/P010→RGB Conversion
+ */
+
+#include "cpu_convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_CONVERT_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define CPU_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+/* Rows per band below which splitting a frame across threads costs more
+ * than it saves */
+#define CPU_CONVERT_MIN_BAND_ROWS 16
+
+static const gchar *isa_names[CPU_CONVERT_ISA_COUNT] = {"scalar", "sse2", "avx2", "neon"};
+
+/* Row pointers of output row @y */
+typedef struct
+{
+    const guint8 *y_row;
+    const guint8 *uv_row;
+    guint8 *out_row;
+} RowPtrs;
+
+static inline RowPtrs
+row_ptrs(const CpuConvertFrame *f, gint y)
+{
+    RowPtrs r = {
+        f->y_plane + (gsize)y * f->y_stride,
+        f->uv_plane + (gsize)(y / 2) * f->uv_stride,
+        f->out + (gsize)y * f->out_stride,
+    };
+    return r;
+}
+
+/* Pixels [@x0, width) of one row, one at a time. @x0 is even. */
+static void
+convert_row_scalar(const CpuConvertFrame *f, const YuvToRgbCoeffs *c,
+                   const RowPtrs *r, gint x0)
+{
+    for (gint x = x0; x < f->width; x++)
+    {
+        gint cx = (x / 2) * 2;
+        int32_t y, u, v;
+
+        if (f->p010)
+        {
+            y = p010_sample(r->y_row + x * 2);
+            u = p010_sample(r->uv_row + cx * 2);
+            v = p010_sample(r->uv_row + cx * 2 + 2);
+        }
+        else
+        {
+            y = r->y_row[x];
+            u = r->uv_row[cx];
+            v = r->uv_row[cx + 1];
+        }
+
+        uint32_t px = f->rgb10 ? yuv_to_x2rgb10_packed(c, y, u, v)
+                               : yuv_to_bgrx_packed(c, y, u, v);
+        memcpy(r->out_row + x * 4, &px, 4);
+    }
+}
+
+/* Output row @oy of a scaled frame */
+static void
+convert_row_scaled(const CpuConvertFrame *f, const YuvToRgbCoeffs *c, gint oy)
+{
+    guint8 *out_row = f->out + (gsize)oy * f->out_stride;
+
+    for (gint ox = 0; ox < f->scale->out_w; ox++)
+    {
+        uint32_t px = scale_yuv_to_rgb_pixel(f->scale, c, f->y_plane, f->uv_plane,
+                                             f->y_stride, f->uv_stride,
+                                             f->p010, f->rgb10, ox, oy);
+        memcpy(out_row + ox * 4, &px, 4);
+    }
+}
+
+/*
+ * SIMD rows. Every ISA evaluates exactly the scalar expression
+ *
+ *   luma = (Y - y_offset) * cy + round
+ *   R = (luma + crv * V') >> 13, G = (luma + cgu * U' + cgv * V') >> 13, ...
+ *
+ * in 32-bit lanes. On x86 the products come from 16-bit multiply-add:
+ * (Y', 1) x (cy, round) for luma and (U', V') x (cgu, cgv) etc. for
+ * chroma, which is why every coefficient must fit in int16. Results are
+ * narrowed with saturation and clamped to [0, out_max], which gives the
+ * same values as clamping the 32-bit result.
+ */
+
+#ifdef CPU_CONVERT_X86
+
+/* Pair constants for _mm_madd_epi16: @lo in the even lane, @hi in the odd */
+#define PAIR_EPI32(lo, hi) ((int32_t)(((uint32_t)(uint16_t)(hi) << 16) | (uint16_t)(lo)))
+
+__attribute__((target("sse2"))) static inline void
+store_sse2(guint8 *dst, __m128i b, __m128i g, __m128i r, gboolean rgb10)
+{
+    __m128i lo, hi;
+
+    if (rgb10)
+    {
+        /* B | G << 10 | R << 20 | 3 << 30, split into 16-bit halves */
+        lo = _mm_or_si128(b, _mm_slli_epi16(g, 10));
+        hi = _mm_or_si128(_mm_or_si128(_mm_srli_epi16(g, 6), _mm_slli_epi16(r, 4)),
+                          _mm_set1_epi16((short)0xc000));
+    }
+    else
+    {
+        lo = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        hi = _mm_or_si128(r, _mm_set1_epi16((short)0xff00));
+    }
+
+    _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(lo, hi));
+}
+
+__attribute__((target("sse2"))) static void
+convert_row_sse2(const CpuConvertFrame *f, const YuvToRgbCoeffs *c, const RowPtrs *r)
+{
+    const __m128i y_off = _mm_set1_epi16((short)c->y_offset);
+    const __m128i uv_off = _mm_set1_epi16((short)c->uv_offset);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16((short)c->out_max);
+    const __m128i k_luma = _mm_set1_epi32(PAIR_EPI32(c->cy, 1 << (YUV_TO_RGB_SHIFT - 1)));
+    const __m128i k_r = _mm_set1_epi32(PAIR_EPI32(0, c->crv));
+    const __m128i k_g = _mm_set1_epi32(PAIR_EPI32(c->cgu, c->cgv));
+    const __m128i k_b = _mm_set1_epi32(PAIR_EPI32(c->cbu, 0));
+    gint x = 0;
+
+    for (; x + 8 <= f->width; x += 8)
+    {
+        __m128i ys, uv;
+
+        if (f->p010)
+        {
+            ys = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(r->y_row + x * 2)), 6);
+            uv = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(r->uv_row + x * 2)), 6);
+        }
+        else
+        {
+            ys = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r->y_row + x)), zero);
+            uv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r->uv_row + x)), zero);
+        }
+        ys = _mm_sub_epi16(ys, y_off);
+        uv = _mm_sub_epi16(uv, uv_off);
+
+        /* One 32-bit term per chroma pair, duplicated for its two pixels */
+        __m128i cr = _mm_madd_epi16(uv, k_r);
+        __m128i cg = _mm_madd_epi16(uv, k_g);
+        __m128i cb = _mm_madd_epi16(uv, k_b);
+
+        __m128i luma_lo = _mm_madd_epi16(_mm_unpacklo_epi16(ys, one), k_luma);
+        __m128i luma_hi = _mm_madd_epi16(_mm_unpackhi_epi16(ys, one), k_luma);
+
+#define CHANNEL_SSE2(term)                                                                   \
+    _mm_min_epi16(_mm_max_epi16(                                                             \
+                      _mm_packs_epi32(                                                       \
+                          _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_unpacklo_epi32(term, term)), \
+                                         YUV_TO_RGB_SHIFT),                                  \
+                          _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_unpackhi_epi32(term, term)), \
+                                         YUV_TO_RGB_SHIFT)),                                 \
+                      zero),                                                                 \
+                  max)
+
+        __m128i R = CHANNEL_SSE2(cr);
+        __m128i G = CHANNEL_SSE2(cg);
+        __m128i B = CHANNEL_SSE2(cb);
+#undef CHANNEL_SSE2
+
+        store_sse2(r->out_row + x * 4, B, G, R, f->rgb10);
+    }
+
+    convert_row_scalar(f, c, r, x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_row_avx2(const CpuConvertFrame *f, const YuvToRgbCoeffs *c, const RowPtrs *r)
+{
+    const __m256i y_off = _mm256_set1_epi16((short)c->y_offset);
+    const __m256i uv_off = _mm256_set1_epi16((short)c->uv_offset);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16((short)c->out_max);
+    const __m256i k_luma = _mm256_set1_epi32(PAIR_EPI32(c->cy, 1 << (YUV_TO_RGB_SHIFT - 1)));
+    const __m256i k_r = _mm256_set1_epi32(PAIR_EPI32(0, c->crv));
+    const __m256i k_g = _mm256_set1_epi32(PAIR_EPI32(c->cgu, c->cgv));
+    const __m256i k_b = _mm256_set1_epi32(PAIR_EPI32(c->cbu, 0));
+    gint x = 0;
+
+    for (; x + 16 <= f->width; x += 16)
+    {
+        __m256i ys, uv;
+
+        if (f->p010)
+        {
+            ys = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(r->y_row + x * 2)), 6);
+            uv = _mm256_srli_epi16(_mm256_loadu_si256((const __m256i *)(r->uv_row + x * 2)), 6);
+        }
+        else
+        {
+            ys = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(r->y_row + x)));
+            uv = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(r->uv_row + x)));
+        }
+        ys = _mm256_sub_epi16(ys, y_off);
+        uv = _mm256_sub_epi16(uv, uv_off);
+
+        /* Unpacks work per 128-bit lane: the "lo" halves hold pixels 0-3
+         * and 8-11, the "hi" halves 4-7 and 12-15, for luma and chroma
+         * alike, and packs puts them back in order */
+        __m256i cr = _mm256_madd_epi16(uv, k_r);
+        __m256i cg = _mm256_madd_epi16(uv, k_g);
+        __m256i cb = _mm256_madd_epi16(uv, k_b);
+
+        __m256i luma_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(ys, one), k_luma);
+        __m256i luma_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(ys, one), k_luma);
+
+#define CHANNEL_AVX2(term)                                                                         \
+    _mm256_min_epi16(_mm256_max_epi16(                                                             \
+                         _mm256_packs_epi32(                                                       \
+                             _mm256_srai_epi32(_mm256_add_epi32(luma_lo,                           \
+                                                                _mm256_unpacklo_epi32(term, term)), \
+                                               YUV_TO_RGB_SHIFT),                                  \
+                             _mm256_srai_epi32(_mm256_add_epi32(luma_hi,                           \
+                                                                _mm256_unpackhi_epi32(term, term)), \
+                                               YUV_TO_RGB_SHIFT)),                                 \
+                         zero),                                                                    \
+                     max)
+
+        __m256i R = CHANNEL_AVX2(cr);
+        __m256i G = CHANNEL_AVX2(cg);
+        __m256i B = CHANNEL_AVX2(cb);
+#undef CHANNEL_AVX2
+
+        __m256i lo, hi;
+        if (f->rgb10)
+        {
+            lo = _mm256_or_si256(B, _mm256_slli_epi16(G, 10));
+            hi = _mm256_or_si256(_mm256_or_si256(_mm256_srli_epi16(G, 6), _mm256_slli_epi16(R, 4)),
+                                 _mm256_set1_epi16((short)0xc000));
+        }
+        else
+        {
+            lo = _mm256_or_si256(B, _mm256_slli_epi16(G, 8));
+            hi = _mm256_or_si256(R, _mm256_set1_epi16((short)0xff00));
+        }
+
+        /* Pixels 0-3|8-11 and 4-7|12-15 */
+        __m256i px_a = _mm256_unpacklo_epi16(lo, hi);
+        __m256i px_b = _mm256_unpackhi_epi16(lo, hi);
+        guint8 *dst = r->out_row + x * 4;
+        _mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(px_a, px_b, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(px_a, px_b, 0x31));
+    }
+
+    convert_row_scalar(f, c, r, x);
+}
+
+#endif /* CPU_CONVERT_X86 */
+
+#ifdef CPU_CONVERT_NEON
+
+static void
+convert_row_neon(const CpuConvertFrame *f, const YuvToRgbCoeffs *c, const RowPtrs *r)
+{
+    const int16x8_t y_off = vdupq_n_s16((int16_t)c->y_offset);
+    const int16x8_t uv_off = vdupq_n_s16((int16_t)c->uv_offset);
+    const int16x8_t zero = vdupq_n_s16(0);
+    const int16x8_t max = vdupq_n_s16((int16_t)c->out_max);
+    const int32x4_t round = vdupq_n_s32(1 << (YUV_TO_RGB_SHIFT - 1));
+    gint x = 0;
+
+    for (; x + 8 <= f->width; x += 8)
+    {
+        uint16x8_t ys, uv;
+
+        if (f->p010)
+        {
+            ys = vshrq_n_u16(vld1q_u16((const uint16_t *)(r->y_row + x * 2)), 6);
+            uv = vshrq_n_u16(vld1q_u16((const uint16_t *)(r->uv_row + x * 2)), 6);
+        }
+        else
+        {
+            ys = vmovl_u8(vld1_u8(r->y_row + x));
+            uv = vmovl_u8(vld1_u8(r->uv_row + x));
+        }
+
+        int16x8_t yv = vsubq_s16(vreinterpretq_s16_u16(ys), y_off);
+        int16x8_t uvv = vsubq_s16(vreinterpretq_s16_u16(uv), uv_off);
+
+        /* U0 U0 U1 U1 ... and V0 V0 V1 V1 ...: one chroma pair per two pixels */
+        int16x8_t u = vtrn1q_s16(uvv, uvv);
+        int16x8_t v = vtrn2q_s16(uvv, uvv);
+
+        int32x4_t luma_lo = vmlal_n_s16(round, vget_low_s16(yv), (int16_t)c->cy);
+        int32x4_t luma_hi = vmlal_n_s16(round, vget_high_s16(yv), (int16_t)c->cy);
+
+        int32x4_t r_lo = vmlal_n_s16(luma_lo, vget_low_s16(v), (int16_t)c->crv);
+        int32x4_t r_hi = vmlal_n_s16(luma_hi, vget_high_s16(v), (int16_t)c->crv);
+        int32x4_t g_lo = vmlal_n_s16(vmlal_n_s16(luma_lo, vget_low_s16(u), (int16_t)c->cgu),
+                                     vget_low_s16(v), (int16_t)c->cgv);
+        int32x4_t g_hi = vmlal_n_s16(vmlal_n_s16(luma_hi, vget_high_s16(u), (int16_t)c->cgu),
+                                     vget_high_s16(v), (int16_t)c->cgv);
+        int32x4_t b_lo = vmlal_n_s16(luma_lo, vget_low_s16(u), (int16_t)c->cbu);
+        int32x4_t b_hi = vmlal_n_s16(luma_hi, vget_high_s16(u), (int16_t)c->cbu);
+
+#define CHANNEL_NEON(lo, hi)                                                               \
+    vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(vcombine_s16(vqshrn_n_s32(lo, YUV_TO_RGB_SHIFT), \
+                                                           vqshrn_n_s32(hi, YUV_TO_RGB_SHIFT)), \
+                                              zero),                                       \
+                                    max))
+
+        uint16x8_t R = CHANNEL_NEON(r_lo, r_hi);
+        uint16x8_t G = CHANNEL_NEON(g_lo, g_hi);
+        uint16x8_t B = CHANNEL_NEON(b_lo, b_hi);
+#undef CHANNEL_NEON
+
+        guint8 *dst = r->out_row + x * 4;
+        if (f->rgb10)
+        {
+            const uint32x4_t alpha = vdupq_n_u32(0xc0000000u);
+            uint32x4_t lo = vorrq_u32(vorrq_u32(vmovl_u16(vget_low_u16(B)),
+                                                vshlq_n_u32(vmovl_u16(vget_low_u16(G)), 10)),
+                                      vorrq_u32(vshlq_n_u32(vmovl_u16(vget_low_u16(R)), 20), alpha));
+            uint32x4_t hi = vorrq_u32(vorrq_u32(vmovl_u16(vget_high_u16(B)),
+                                                vshlq_n_u32(vmovl_u16(vget_high_u16(G)), 10)),
+                                      vorrq_u32(vshlq_n_u32(vmovl_u16(vget_high_u16(R)), 20), alpha));
+            vst1q_u8(dst, vreinterpretq_u8_u32(lo));
+            vst1q_u8(dst + 16, vreinterpretq_u8_u32(hi));
+        }
+        else
+        {
+            uint8x8x4_t px;
+            px.val[0] = vmovn_u16(B);
+            px.val[1] = vmovn_u16(G);
+            px.val[2] = vmovn_u16(R);
+            px.val[3] = vdup_n_u8(255);
+            vst4_u8(dst, px);
+        }
+    }
+
+    convert_row_scalar(f, c, r, x);
+}
+
+#endif /* CPU_CONVERT_NEON */
+
+gboolean
+cpu_convert_isa_supported(CpuConvertIsa isa)
+{
+    switch (isa)
+    {
+    case CPU_CONVERT_ISA_SCALAR:
+        return TRUE;
+#ifdef CPU_CONVERT_X86
+    case CPU_CONVERT_ISA_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case CPU_CONVERT_ISA_AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+#ifdef CPU_CONVERT_NEON
+    case CPU_CONVERT_ISA_NEON:
+        /* Mandatory on AArch64 */
+        return TRUE;
+#endif
+    default:
+        return FALSE;
+    }
+}
+
+CpuConvertIsa
+cpu_convert_best_isa(void)
+{
+    static const CpuConvertIsa order[] = {
+        CPU_CONVERT_ISA_AVX2, CPU_CONVERT_ISA_NEON, CPU_CONVERT_ISA_SSE2};
+
+    for (guint i = 0; i < G_N_ELEMENTS(order); i++)
+        if (cpu_convert_isa_supported(order[i]))
+            return order[i];
+    return CPU_CONVERT_ISA_SCALAR;
+}
+
+const gchar *
+cpu_convert_isa_name(CpuConvertIsa isa)
+{
+    return isa < CPU_CONVERT_ISA_COUNT ? isa_names[isa] : "unknown";
+}
+
+void cpu_convert_rows(CpuConvertIsa isa, const CpuConvertFrame *frame,
+                      const YuvToRgbCoeffs *coeffs, gint y0, gint y1)
+{
+    if (frame->scale)
+    {
+        for (gint y = y0; y < y1; y++)
+            convert_row_scaled(frame, coeffs, y);
+        return;
+    }
+
+    if (!cpu_convert_isa_supported(isa))
+        isa = CPU_CONVERT_ISA_SCALAR;
+
+    for (gint y = y0; y < y1; y++)
+    {
+        RowPtrs r = row_ptrs(frame, y);
+
+        switch (isa)
+        {
+#ifdef CPU_CONVERT_X86
+        case CPU_CONVERT_ISA_SSE2:
+            convert_row_sse2(frame, coeffs, &r);
+            break;
+        case CPU_CONVERT_ISA_AVX2:
+            convert_row_avx2(frame, coeffs, &r);
+            break;
+#endif
+#ifdef CPU_CONVERT_NEON
+        case CPU_CONVERT_ISA_NEON:
+            convert_row_neon(frame, coeffs, &r);
+            break;
+#endif
+        default:
+            convert_row_scalar(frame, coeffs, &r, 0);
+            break;
+        }
+    }
+}
+
+typedef struct
+{
+    CpuConvertIsa isa;
+    const CpuConvertFrame *frame;
+    const YuvToRgbCoeffs *coeffs;
+    gint band_rows;
+    gint height;
+} BandJob;
+
+static void
+convert_band(guint job, gpointer user_data)
+{
+    const BandJob *b = user_data;
+    gint y0 = (gint)job * b->band_rows;
+    gint y1 = MIN(y0 + b->band_rows, b->height);
+
+    cpu_convert_rows(b->isa, b->frame, b->coeffs, y0, y1);
+}
+
+void cpu_convert_frame(WorkerPool *pool, CpuConvertIsa isa,
+                       const CpuConvertFrame *frame,
+                       const YuvToRgbCoeffs *coeffs)
+{
+    gint height = frame->scale ? frame->scale->out_h : frame->height;
+    guint n_threads = pool ? worker_pool_get_n_threads(pool) : 1;
+
+    /* Even band heights keep both luma rows of a chroma row together */
+    gint band_rows = MAX((height + (gint)n_threads - 1) / (gint)n_threads,
+                         CPU_CONVERT_MIN_BAND_ROWS);
+    band_rows = (band_rows + 1) & ~1;
+
+    BandJob b = {isa, frame, coeffs, band_rows, height};
+    guint n_bands = (guint)((height + band_rows - 1) / band_rows);
+
+    if (pool)
+        worker_pool_run(pool, n_bands, convert_band, &b);
+    else
+        cpu_convert_rows(isa, frame, coeffs, 0, height);
+}
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * CPU NV12/P010→RGB Conversion
+ * SIMD (SSE2/AVX2/NEON) software path for when the GPU conversion is not
+ * available. Uses the same Q13 coefficient table and rounding as the CUDA
+ * kernels, so every ISA produces output bit-identical to the GPU.
+ */
+
+#ifndef __CPU_CONVERT_H__
+#define __CPU_CONVERT_H__
+
+#include "cuda_nv12_to_bgrx.h"
+#include "scale_geometry.h"
+#include "worker_pool.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    CPU_CONVERT_ISA_SCALAR,
+    CPU_CONVERT_ISA_SSE2,
+    CPU_CONVERT_ISA_AVX2,
+    CPU_CONVERT_ISA_NEON,
+    CPU_CONVERT_ISA_COUNT,
+} CpuConvertIsa;
+
+/**
+ * Planes of one conversion. Input and output are in system memory.
+ */
+typedef struct
+{
+    const guint8 *y_plane;
+    const guint8 *uv_plane;
+    gint y_stride;
+    gint uv_stride;
+
+    guint8 *out;
+    gint out_stride;
+
+    /* Input size */
+    gint width;
+    gint height;
+
+    gboolean p010;  /* P010 input, NV12 otherwise */
+    gboolean rgb10; /* XRGB2101010 output, BGRx otherwise */
+
+    /* Output size, picture rectangle and border when scaling (scalar
+     * only); NULL to convert at the input size */
+    const ScaleGeometry *scale;
+} CpuConvertFrame;
+
+/**
+ * Whether @isa was built in and the running CPU supports it.
+ */
+gboolean cpu_convert_isa_supported(CpuConvertIsa isa);
+
+/**
+ * Fastest ISA supported by the running CPU.
+ */
+CpuConvertIsa cpu_convert_best_isa(void);
+
+/**
+ * Short name of @isa ("scalar", "sse2", "avx2", "neon").
+ */
+const gchar *cpu_convert_isa_name(CpuConvertIsa isa);
+
+/**
+ * Convert output rows [@y0, @y1) of @frame on the calling thread.
+ * @y0 must be even. Falls back to scalar code when @isa is not supported
+ * or @frame is scaled.
+ *
+ * @param isa Instruction set to use
+ * @param frame Planes to convert
+ * @param coeffs Conversion matrix/range for the input/output depths
+ * @param y0 First output row
+ * @param y1 One past the last output row
+ */
+void cpu_convert_rows(CpuConvertIsa isa, const CpuConvertFrame *frame,
+                      const YuvToRgbCoeffs *coeffs, gint y0, gint y1);
+
+/**
+ * Convert a whole frame, split into row bands across @pool.
+ *
+ * @param pool Worker pool (NULL to convert on the calling thread)
+ * @param isa Instruction set to use
+ * @param frame Planes to convert
+ * @param coeffs Conversion matrix/range for the input/output depths
+ */
+void cpu_convert_frame(WorkerPool *pool, CpuConvertIsa isa,
+                       const CpuConvertFrame *frame,
+                       const YuvToRgbCoeffs *coeffs);
+
+G_END_DECLS
+
+#endif /* __CPU_CONVERT_H__ */
@@ -6,6 +6,7 @@
  */
 
 #include "cuda_egl_interop.h"
+#include "device_registry.h"
 
 #include <drm/drm_fourcc.h>
 #include <fcntl.h>
@@ -17,109 +18,172 @@ static PFNEGLGETPLATFORMDISPLAYEXTPROC _eglGetPlatformDisplayEXT = NULL;
 static PFNEGLCREATEIMAGEKHRPROC _eglCreateImageKHR = NULL;
 static PFNEGLDESTROYIMAGEKHRPROC _eglDestroyImageKHR = NULL;
 
+/* Element instances may initialize concurrently */
 static gboolean
 load_egl_extensions(void)
 {
-    static gboolean loaded = FALSE;
-    if (loaded)
-        return TRUE;
-
-    _eglGetPlatformDisplayEXT =
-        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
-    _eglCreateImageKHR =
-        (PFNEGLCREATEIMAGEKHRPROC)eglGetProcAddress("eglCreateImageKHR");
-    _eglDestroyImageKHR =
-        (PFNEGLDESTROYIMAGEKHRPROC)eglGetProcAddress("eglDestroyImageKHR");
-
-    loaded = TRUE;
+    static gsize loaded = 0;
+
+    if (g_once_init_enter(&loaded))
+    {
+        _eglGetPlatformDisplayEXT =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        _eglCreateImageKHR =
+            (PFNEGLCREATEIMAGEKHRPROC)eglGetProcAddress("eglCreateImageKHR");
+        _eglDestroyImageKHR =
+            (PFNEGLDESTROYIMAGEKHRPROC)eglGetProcAddress("eglDestroyImageKHR");
+        g_once_init_leave(&loaded, 1);
+    }
+
     return (_eglCreateImageKHR != NULL && _eglDestroyImageKHR != NULL);
 }
 
-gboolean
-cuda_egl_context_init(CudaEglContext *ctx, const gchar *drm_device)
-{
-    g_return_val_if_fail(ctx != NULL, FALSE);
-    g_return_val_if_fail(drm_device != NULL, FALSE);
+/* ============================================================================
+ * Shared devices
+ * ============================================================================ */
 
-    memset(ctx, 0, sizeof(CudaEglContext));
-    ctx->drm_fd = -1;
-    ctx->egl_display = EGL_NO_DISPLAY;
-    ctx->egl_context = EGL_NO_CONTEXT;
+static gpointer
+device_open(const gchar *drm_device, gpointer user_data)
+{
+    (void)user_data;
 
-    if (!load_egl_extensions())
-    {
-        g_warning("Failed to load required EGL extensions");
-        return FALSE;
-    }
+    CudaEglDevice *dev = g_new0(CudaEglDevice, 1);
+    dev->egl_display = EGL_NO_DISPLAY;
 
     /* Open DRM render node */
-    ctx->drm_fd = open(drm_device, O_RDWR | O_CLOEXEC);
-    if (ctx->drm_fd < 0)
+    dev->drm_fd = open(drm_device, O_RDWR | O_CLOEXEC);
+    if (dev->drm_fd < 0)
     {
         g_warning("Failed to open DRM device: %s", drm_device);
-        return FALSE;
+        goto fail;
     }
 
     /* Create GBM device */
-    ctx->gbm = gbm_create_device(ctx->drm_fd);
-    if (!ctx->gbm)
+    dev->gbm = gbm_create_device(dev->drm_fd);
+    if (!dev->gbm)
     {
         g_warning("Failed to create GBM device");
-        close(ctx->drm_fd);
-        ctx->drm_fd = -1;
-        return FALSE;
+        goto fail;
     }
 
     /* Get EGL display from GBM */
     if (_eglGetPlatformDisplayEXT)
     {
-        ctx->egl_display = _eglGetPlatformDisplayEXT(
-            EGL_PLATFORM_GBM_MESA, ctx->gbm, NULL);
+        dev->egl_display = _eglGetPlatformDisplayEXT(
+            EGL_PLATFORM_GBM_MESA, dev->gbm, NULL);
     }
     else
     {
-        ctx->egl_display = eglGetDisplay((EGLNativeDisplayType)ctx->gbm);
+        dev->egl_display = eglGetDisplay((EGLNativeDisplayType)dev->gbm);
     }
 
-    if (ctx->egl_display == EGL_NO_DISPLAY)
+    if (dev->egl_display == EGL_NO_DISPLAY)
     {
         g_warning("Failed to get EGL display: 0x%x", eglGetError());
-        gbm_device_destroy(ctx->gbm);
-        ctx->gbm = NULL;
-        close(ctx->drm_fd);
-        ctx->drm_fd = -1;
-        return FALSE;
+        goto fail;
     }
 
     /* Initialize EGL */
     EGLint major, minor;
-    if (!eglInitialize(ctx->egl_display, &major, &minor))
+    if (!eglInitialize(dev->egl_display, &major, &minor))
     {
         g_warning("Failed to initialize EGL: 0x%x", eglGetError());
-        ctx->egl_display = EGL_NO_DISPLAY;
-        gbm_device_destroy(ctx->gbm);
-        ctx->gbm = NULL;
-        close(ctx->drm_fd);
-        ctx->drm_fd = -1;
-        return FALSE;
+        dev->egl_display = EGL_NO_DISPLAY;
+        goto fail;
+    }
+
+    g_debug("Opened %s (EGL %d.%d)", drm_device, major, minor);
+    return dev;
+
+fail:
+    if (dev->gbm)
+        gbm_device_destroy(dev->gbm);
+    if (dev->drm_fd >= 0)
+        close(dev->drm_fd);
+    g_free(dev);
+    return NULL;
+}
+
+static void
+device_close(gpointer device, gpointer user_data)
+{
+    CudaEglDevice *dev = device;
+    (void)user_data;
+
+    /* Only the last user terminates: eglTerminate() is per display, not
+     * per caller of eglInitialize() */
+    if (dev->egl_display != EGL_NO_DISPLAY)
+        eglTerminate(dev->egl_display);
+    gbm_device_destroy(dev->gbm);
+    close(dev->drm_fd);
+    g_free(dev);
+}
+
+static DeviceRegistry *
+device_registry(void)
+{
+    static DeviceRegistry *registry = NULL;
+
+    if (g_once_init_enter(&registry))
+        g_once_init_leave(&registry, device_registry_new(device_open, device_close, NULL));
+    return registry;
+}
+
+CudaEglDevice *
+cuda_egl_device_acquire(const gchar *drm_device)
+{
+    g_return_val_if_fail(drm_device != NULL, NULL);
+
+    if (!load_egl_extensions())
+    {
+        g_warning("Failed to load required EGL extensions");
+        return NULL;
     }
 
+    return device_registry_acquire(device_registry(), drm_device);
+}
+
+void cuda_egl_device_release(CudaEglDevice *device)
+{
+    device_registry_release(device_registry(), device);
+}
+
+/* ============================================================================
+ * Context
+ * ============================================================================ */
+
+gboolean
+cuda_egl_context_init(CudaEglContext *ctx, const gchar *drm_device)
+{
+    g_return_val_if_fail(ctx != NULL, FALSE);
+    g_return_val_if_fail(drm_device != NULL, FALSE);
+
+    memset(ctx, 0, sizeof(CudaEglContext));
+    ctx->drm_fd = -1;
+    ctx->egl_display = EGL_NO_DISPLAY;
+    ctx->egl_context = EGL_NO_CONTEXT;
+
+    ctx->device = cuda_egl_device_acquire(drm_device);
+    if (!ctx->device)
+        return FALSE;
+
     /* Initialize CUDA driver API */
     CUresult cu_res = cuInit(0);
     if (cu_res != CUDA_SUCCESS)
     {
         g_warning("cuInit failed: %d", cu_res);
-        eglTerminate(ctx->egl_display);
-        ctx->egl_display = EGL_NO_DISPLAY;
-        gbm_device_destroy(ctx->gbm);
-        ctx->gbm = NULL;
-        close(ctx->drm_fd);
-        ctx->drm_fd = -1;
+        cuda_egl_device_release(ctx->device);
+        ctx->device = NULL;
         return FALSE;
     }
 
+    ctx->drm_fd = ctx->device->drm_fd;
+    ctx->gbm = ctx->device->gbm;
+    ctx->egl_display = ctx->device->egl_display;
+    ctx->drm_device = g_strdup(drm_device);
+
     ctx->initialized = TRUE;
-    g_debug("CUDA-EGL context initialized (EGL %d.%d)", major, minor);
+    g_debug("CUDA-EGL context initialized on %s", drm_device);
     return TRUE;
 }
 
@@ -134,25 +198,88 @@ void cuda_egl_context_cleanup(CudaEglContext *ctx)
         ctx->egl_context = EGL_NO_CONTEXT;
     }
 
-    if (ctx->egl_display != EGL_NO_DISPLAY)
+    /* The display, GBM device and fd belong to the shared device */
+    if (ctx->device)
+    {
+        cuda_egl_device_release(ctx->device);
+        ctx->device = NULL;
+    }
+    ctx->egl_display = EGL_NO_DISPLAY;
+    ctx->gbm = NULL;
+    ctx->drm_fd = -1;
+    g_clear_pointer(&ctx->drm_device, g_free);
+
+    ctx->initialized = FALSE;
+}
+
+gboolean
+cuda_egl_probe_formats(DrmFormatTable *table, gpointer user_data)
+{
+    const gchar *drm_device = user_data;
+    PFNEGLQUERYDMABUFMODIFIERSEXTPROC query_modifiers =
+        (PFNEGLQUERYDMABUFMODIFIERSEXTPROC)eglGetProcAddress("eglQueryDmaBufModifiersEXT");
+    gboolean ok = FALSE;
+
+    if (!load_egl_extensions() || !_eglGetPlatformDisplayEXT || !query_modifiers)
+    {
+        g_warning("EGL_EXT_image_dma_buf_import_modifiers unavailable");
+        return FALSE;
+    }
+
+    /* A display of its own: probing must not depend on (or disturb) an
+     * element's context */
+    int fd = open(drm_device, O_RDWR | O_CLOEXEC);
+    if (fd < 0)
     {
-        eglTerminate(ctx->egl_display);
-        ctx->egl_display = EGL_NO_DISPLAY;
+        g_warning("Failed to open DRM device: %s", drm_device);
+        return FALSE;
     }
 
-    if (ctx->gbm)
+    struct gbm_device *gbm = gbm_create_device(fd);
+    EGLDisplay display = gbm ? _eglGetPlatformDisplayEXT(EGL_PLATFORM_GBM_MESA, gbm, NULL)
+                             : EGL_NO_DISPLAY;
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
     {
-        gbm_device_destroy(ctx->gbm);
-        ctx->gbm = NULL;
+        g_warning("Failed to initialize EGL on %s for the format probe", drm_device);
+        goto out;
     }
 
-    if (ctx->drm_fd >= 0)
+    for (guint i = 0; i < drm_format_table_get_n_entries(table); i++)
     {
-        close(ctx->drm_fd);
-        ctx->drm_fd = -1;
+        guint32 fourcc = drm_format_table_get_entry(table, i)->fourcc;
+        EGLint n = 0;
+
+        /* Entries are grouped by fourcc: query each once */
+        if (i > 0 && drm_format_table_get_entry(table, i - 1)->fourcc == fourcc)
+            continue;
+
+        if (!query_modifiers(display, (EGLint)fourcc, 0, NULL, NULL, &n) || n < 0)
+            n = 0;
+
+        EGLuint64KHR *modifiers = g_new(EGLuint64KHR, MAX(n, 1));
+        if (n > 0 && !query_modifiers(display, (EGLint)fourcc, n, modifiers, NULL, &n))
+            n = 0;
+
+        /* The GBM pool allocates P010 as a double-width NV12 BO */
+        guint32 gbm_format = fourcc == DRM_FORMAT_P010 ? GBM_FORMAT_NV12 : fourcc;
+        gboolean gbm_ok = gbm_device_is_format_supported(gbm, gbm_format, GBM_BO_USE_RENDERING);
+
+        drm_format_table_set_device_modifiers(table, fourcc, (const guint64 *)modifiers,
+                                              (guint)n, gbm_ok);
+        g_debug("Format %.4s: %d modifiers, GBM %s", (const gchar *)&fourcc, n,
+                gbm_ok ? "yes" : "no");
+        g_free(modifiers);
     }
 
-    ctx->initialized = FALSE;
+    ok = TRUE;
+    eglTerminate(display);
+
+out:
+    if (gbm)
+        gbm_device_destroy(gbm);
+    close(fd);
+    return ok;
 }
 
 gboolean
@@ -342,6 +469,12 @@ void cuda_egl_buffer_free(CudaEglContext *ctx, CudaEglBuffer *buf)
         buf->cuda_stream = NULL;
     }
 
+    if (buf->scratch)
+    {
+        cuMemFree(buf->scratch);
+        buf->scratch = 0;
+    }
+
     if (buf->cuda_resource)
     {
         cuGraphicsUnregisterResource(buf->cuda_resource);
@@ -8,6 +8,8 @@
 #ifndef __CUDA_EGL_INTEROP_H__
 #define __CUDA_EGL_INTEROP_H__
 
+#include "drm_format_table.h"
+
 #include <glib.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -17,6 +19,32 @@
 
 G_BEGIN_DECLS
 
+/**
+ * CudaEglDevice - DRM fd, GBM device and initialized EGL display of one
+ * render node, shared process-wide by every context and pool on it
+ */
+typedef struct _CudaEglDevice
+{
+    int drm_fd;
+    struct gbm_device *gbm;
+    EGLDisplay egl_display; /* EGL_NO_DISPLAY when only GBM was needed */
+} CudaEglDevice;
+
+/**
+ * The shared device on @drm_device, opened (render node, GBM device and
+ * EGL display) on first use. Concurrent callers get the same device.
+ * Balance with cuda_egl_device_release().
+ *
+ * @param drm_device Path to DRM render node (e.g., "/dev/dri/renderD129")
+ * @return The device, or NULL on failure
+ */
+CudaEglDevice *cuda_egl_device_acquire(const gchar *drm_device);
+
+/**
+ * Drop a device reference; the last one closes it.
+ */
+void cuda_egl_device_release(CudaEglDevice *device);
+
 /**
  * CudaEglContext - Manages EGL display and CUDA interop state
  */
@@ -29,11 +57,15 @@ typedef struct _CudaEglContext
     /* GBM device for buffer allocation */
     struct gbm_device *gbm;
     int drm_fd;
+
+    /* Shared device the handles above belong to, and its render node */
+    CudaEglDevice *device;
+    gchar *drm_device;
 } CudaEglContext;
 
 /**
- * Initialize CUDA-EGL interop context.
- * Opens the DRM render node and creates EGL display.
+ * Initialize CUDA-EGL interop context on the shared device of the DRM
+ * render node, opening it if no other context or pool holds it.
  *
  * @param ctx Context to initialize
  * @param drm_device Path to DRM render node (e.g., "/dev/dri/renderD129")
@@ -42,10 +74,19 @@ typedef struct _CudaEglContext
 gboolean cuda_egl_context_init(CudaEglContext *ctx, const gchar *drm_device);
 
 /**
- * Clean up CUDA-EGL context.
+ * Clean up CUDA-EGL context, releasing its shared device.
  */
 void cuda_egl_context_cleanup(CudaEglContext *ctx);
 
+/**
+ * Query the DMA-BUF modifiers EGL on @user_data (a DRM render node path)
+ * supports for each fourcc of @table, and whether GBM can allocate it.
+ * A #DrmFormatProbeFunc; uses a display of its own.
+ *
+ * @return FALSE if EGL couldn't be initialized on the device
+ */
+gboolean cuda_egl_probe_formats(DrmFormatTable *table, gpointer user_data);
+
 /**
  * CudaEglBuffer - A GPU buffer accessible via both EGL and CUDA
  */
@@ -58,6 +99,15 @@ typedef struct _CudaEglBuffer
     CUeglFrame cuda_frame;
     CUstream cuda_stream;
 
+    /* Completion fence recorded on cuda_stream (owned by the pool, may be NULL) */
+    struct _BufferFence *fence;
+
+    /* Pitch-linear staging for kernels writing into block-linear (array)
+     * frames, allocated on first use and freed with the buffer */
+    CUdeviceptr scratch;
+    size_t scratch_pitch;
+    size_t scratch_rows;
+
     /* Buffer properties */
     guint width;
     guint height;
@@ -71,6 +121,7 @@ typedef struct _CudaEglBuffer
     gsize size;
 
     gboolean in_use;
+    gboolean retire; /* Picked for shrinking, freed on the pool's next acquire */
 } CudaEglBuffer;
 
 /**
@@ -1,7 +1,7 @@
 /* SPDX-License-Identifier: MIT
  * SPDX-FileCopyrightText: 2025 Ericky
  *
- * CUDA kernel for NV12 to BGRx color conversion
+ * CUDA kernels for NV12 to BGRx and P010 to BGRx/XRGB2101010 color conversion
  *
  * This runs the colorspace conversion on the GPU, keeping the zero-copy
  * pipeline entirely on GPU memory.
@@ -10,19 +10,33 @@
  *   - Y plane: width x height, 1 byte per pixel
  *   - UV plane: (width/2) x (height/2), 2 bytes per pixel (U,V interleaved)
  *
+ * P010 format:
+ *   - Same layout as NV12 with 2 bytes per sample, 10 bits in the MSBs
+ *
  * BGRx format:
  *   - 4 bytes per pixel (B, G, R, x)
+ *
+ * XRGB2101010 format:
+ *   - 32-bit little-endian word per pixel, B in bits 0-9, G 10-19, R 20-29
  */
 
 #include <cuda_runtime.h>
 
+#include "cuda_nv12_to_bgrx.h"
+#include "nv12_launch.h"
+#include "scale_geometry.h"
+
 /**
- * NV12 to BGRx conversion kernel
+ * NV12 to BGRx conversion kernel family
  *
- * Each thread handles one pixel in the output BGRx image.
- * Uses BT.709 coefficients for HD content.
+ * Each thread converts a TILE_W x 2 block: both luma rows share a single
+ * chroma load, the math is the Q13 fixed-point yuv_to_rgb_pixel() shared
+ * with the CPU reference, and each output row is written with one 128-bit
+ * (TILE_W = 4) or 64-bit (TILE_W = 2) store. VEC = false keeps the tiling
+ * but uses byte/word access for unaligned planes.
  */
-__global__ void nv12_to_bgrx_kernel(
+template <int TILE_W, bool VEC>
+__global__ void nv12_to_bgrx_tile_kernel(
     const unsigned char *__restrict__ y_plane,
     const unsigned char *__restrict__ uv_plane,
     unsigned char *__restrict__ bgrx_out,
@@ -30,55 +44,103 @@ __global__ void nv12_to_bgrx_kernel(
     int height,
     int y_stride,
     int uv_stride,
-    int out_stride)
+    int out_stride,
+    YuvToRgbCoeffs coeffs)
 {
-    int x = blockIdx.x * blockDim.x + threadIdx.x;
-    int y = blockIdx.y * blockDim.y + threadIdx.y;
+    int x0 = (blockIdx.x * blockDim.x + threadIdx.x) * TILE_W;
+    int y0 = (blockIdx.y * blockDim.y + threadIdx.y) * NV12_TILE_H;
 
-    if (x >= width || y >= height)
+    if (x0 >= width || y0 >= height)
         return;
 
-    /* Sample Y at full resolution */
-    int y_idx = y * y_stride + x;
-    float Y = (float)y_plane[y_idx];
+    nv12_to_bgrx_tile(&coeffs, y_plane, uv_plane, bgrx_out,
+                      width, height, y_stride, uv_stride, out_stride,
+                      x0, y0, TILE_W, VEC);
+}
+
+/**
+ * P010 to BGRx / XRGB2101010 conversion kernel
+ *
+ * Each thread converts a 2x2 block sharing one chroma sample. RGB10
+ * selects the 2:10:10:10 packing; both outputs are 32 bits per pixel.
+ */
+template <bool RGB10>
+__global__ void p010_to_rgb_kernel(
+    const unsigned char *__restrict__ y_plane,
+    const unsigned char *__restrict__ uv_plane,
+    unsigned char *__restrict__ rgb_out,
+    int width,
+    int height,
+    int y_stride,
+    int uv_stride,
+    int out_stride,
+    YuvToRgbCoeffs coeffs)
+{
+    int x0 = (blockIdx.x * blockDim.x + threadIdx.x) * 2;
+    int y0 = (blockIdx.y * blockDim.y + threadIdx.y) * 2;
 
-    /* Sample UV at half resolution (NV12 is 4:2:0) */
-    int uv_x = x / 2;
-    int uv_y = y / 2;
-    int uv_idx = uv_y * uv_stride + uv_x * 2;
+    if (x0 >= width || y0 >= height)
+        return;
 
-    float U = (float)uv_plane[uv_idx] - 128.0f;
-    float V = (float)uv_plane[uv_idx + 1] - 128.0f;
+    p010_to_rgb_tile(&coeffs, y_plane, uv_plane, rgb_out,
+                     width, height, y_stride, uv_stride, out_stride,
+                     x0, y0, RGB10);
+}
 
-    /* BT.709 YUV to RGB conversion (for HD content)
-     * R = Y + 1.5748 * V
-     * G = Y - 0.1873 * U - 0.4681 * V
-     * B = Y + 1.8556 * U
-     */
-    float R = Y + 1.5748f * V;
-    float G = Y - 0.1873f * U - 0.4681f * V;
-    float B = Y + 1.8556f * U;
-
-    /* Clamp to 0-255 using ternary (no fminf/fmaxf to avoid headers) */
-    if (R < 0.0f)
-        R = 0.0f;
-    else if (R > 255.0f)
-        R = 255.0f;
-    if (G < 0.0f)
-        G = 0.0f;
-    else if (G > 255.0f)
-        G = 255.0f;
-    if (B < 0.0f)
-        B = 0.0f;
-    else if (B > 255.0f)
-        B = 255.0f;
-
-    /* Write BGRx output (4 bytes per pixel) */
-    int out_idx = y * out_stride + x * 4;
-    bgrx_out[out_idx + 0] = (unsigned char)B;
-    bgrx_out[out_idx + 1] = (unsigned char)G;
-    bgrx_out[out_idx + 2] = (unsigned char)R;
-    bgrx_out[out_idx + 3] = 255; /* x = 0xFF */
+/**
+ * Scaled NV12/P010 to BGRx / XRGB2101010 conversion kernel
+ *
+ * One thread per output pixel: resample luma and chroma at the pixel's
+ * source position, convert and pack. Pixels outside the picture
+ * rectangle get the border word.
+ */
+template <bool P010, bool RGB10>
+__global__ void scale_yuv_to_rgb_kernel(
+    const unsigned char *__restrict__ y_plane,
+    const unsigned char *__restrict__ uv_plane,
+    int y_stride,
+    int uv_stride,
+    unsigned char *__restrict__ rgb_out,
+    int out_stride,
+    ScaleGeometry geo,
+    YuvToRgbCoeffs coeffs)
+{
+    int ox = blockIdx.x * blockDim.x + threadIdx.x;
+    int oy = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if (ox >= geo.out_w || oy >= geo.out_h)
+        return;
+
+    *(uint32_t *)(rgb_out + oy * out_stride + ox * 4) =
+        scale_yuv_to_rgb_pixel(&geo, &coeffs, y_plane, uv_plane,
+                               y_stride, uv_stride, P010, RGB10, ox, oy);
+}
+
+/**
+ * Scaled NV12/P010 to NV12/P010 kernel
+ *
+ * One thread per output chroma sample, writing it and its 2x2 luma block.
+ */
+template <bool P010>
+__global__ void scale_semi_planar_kernel(
+    const unsigned char *__restrict__ y_plane,
+    const unsigned char *__restrict__ uv_plane,
+    int y_stride,
+    int uv_stride,
+    unsigned char *__restrict__ y_out,
+    unsigned char *__restrict__ uv_out,
+    int y_out_stride,
+    int uv_out_stride,
+    ScaleGeometry geo)
+{
+    int bx = blockIdx.x * blockDim.x + threadIdx.x;
+    int by = blockIdx.y * blockDim.y + threadIdx.y;
+
+    if (bx >= (geo.out_w + 1) / 2 || by >= (geo.out_h + 1) / 2)
+        return;
+
+    scale_semi_planar_block(&geo, y_plane, uv_plane, y_stride, uv_stride,
+                            y_out, uv_out, y_out_stride, uv_out_stride, P010, bx, by);
 }
 
 extern "C"
@@ -96,19 +158,131 @@ extern "C"
         int y_stride,
         int uv_stride,
         int out_stride,
+        const YuvToRgbCoeffs *coeffs,
+        void *stream)
+    {
+        Nv12LaunchGeometry geo;
+        nv12_launch_geometry(width, height,
+                             (uintptr_t)y_plane, (uintptr_t)uv_plane, (uintptr_t)bgrx_out,
+                             y_stride, uv_stride, out_stride, &geo);
+
+        dim3 block(geo.block_x, geo.block_y);
+        dim3 grid(geo.grid_x, geo.grid_y);
+        cudaStream_t cu_stream = (cudaStream_t)stream;
+
+        const unsigned char *y = (const unsigned char *)y_plane;
+        const unsigned char *uv = (const unsigned char *)uv_plane;
+        unsigned char *out = (unsigned char *)bgrx_out;
+
+        /* Coefficients travel as a by-value kernel parameter (constant bank) */
+        if (geo.tile_w == 4)
+            nv12_to_bgrx_tile_kernel<4, true><<<grid, block, 0, cu_stream>>>(
+                y, uv, out, width, height, y_stride, uv_stride, out_stride, *coeffs);
+        else if (geo.vectorized)
+            nv12_to_bgrx_tile_kernel<2, true><<<grid, block, 0, cu_stream>>>(
+                y, uv, out, width, height, y_stride, uv_stride, out_stride, *coeffs);
+        else
+            nv12_to_bgrx_tile_kernel<2, false><<<grid, block, 0, cu_stream>>>(
+                y, uv, out, width, height, y_stride, uv_stride, out_stride, *coeffs);
+
+        return (int)cudaGetLastError();
+    }
+
+    /**
+     * Host function to launch the P010 to BGRx / XRGB2101010 conversion
+     */
+    int cuda_p010_to_rgb(
+        const void *y_plane,
+        const void *uv_plane,
+        void *rgb_out,
+        int width,
+        int height,
+        int y_stride,
+        int uv_stride,
+        int out_stride,
+        const YuvToRgbCoeffs *coeffs,
+        int rgb10,
         void *stream)
     {
-        /* Use 16x16 thread blocks */
-        dim3 block(16, 16);
-        dim3 grid((width + block.x - 1) / block.x,
-                  (height + block.y - 1) / block.y);
-
-        nv12_to_bgrx_kernel<<<grid, block, 0, (cudaStream_t)stream>>>(
-            (const unsigned char *)y_plane,
-            (const unsigned char *)uv_plane,
-            (unsigned char *)bgrx_out,
-            width, height,
-            y_stride, uv_stride, out_stride);
+        dim3 block(32, 8);
+        dim3 grid(((width + 1) / 2 + block.x - 1) / block.x,
+                  ((height + 1) / 2 + block.y - 1) / block.y);
+        cudaStream_t cu_stream = (cudaStream_t)stream;
+
+        const unsigned char *y = (const unsigned char *)y_plane;
+        const unsigned char *uv = (const unsigned char *)uv_plane;
+        unsigned char *out = (unsigned char *)rgb_out;
+
+        if (rgb10)
+            p010_to_rgb_kernel<true><<<grid, block, 0, cu_stream>>>(
+                y, uv, out, width, height, y_stride, uv_stride, out_stride, *coeffs);
+        else
+            p010_to_rgb_kernel<false><<<grid, block, 0, cu_stream>>>(
+                y, uv, out, width, height, y_stride, uv_stride, out_stride, *coeffs);
+
+        return (int)cudaGetLastError();
+    }
+
+    /**
+     * Host function to launch the scaled YUV to RGB conversion
+     */
+    int cuda_scale_yuv_to_rgb(const void *y_plane, const void *uv_plane,
+                              int y_stride, int uv_stride, int p010,
+                              void *rgb_out, int out_stride,
+                              const ScaleGeometry *geo,
+                              const YuvToRgbCoeffs *coeffs,
+                              int rgb10, void *stream)
+    {
+        dim3 block(32, 8);
+        dim3 grid((geo->out_w + block.x - 1) / block.x,
+                  (geo->out_h + block.y - 1) / block.y);
+        cudaStream_t cu_stream = (cudaStream_t)stream;
+
+        const unsigned char *y = (const unsigned char *)y_plane;
+        const unsigned char *uv = (const unsigned char *)uv_plane;
+        unsigned char *out = (unsigned char *)rgb_out;
+
+        if (p010 && rgb10)
+            scale_yuv_to_rgb_kernel<true, true><<<grid, block, 0, cu_stream>>>(
+                y, uv, y_stride, uv_stride, out, out_stride, *geo, *coeffs);
+        else if (p010)
+            scale_yuv_to_rgb_kernel<true, false><<<grid, block, 0, cu_stream>>>(
+                y, uv, y_stride, uv_stride, out, out_stride, *geo, *coeffs);
+        else
+            scale_yuv_to_rgb_kernel<false, false><<<grid, block, 0, cu_stream>>>(
+                y, uv, y_stride, uv_stride, out, out_stride, *geo, *coeffs);
+
+        return (int)cudaGetLastError();
+    }
+
+    /**
+     * Host function to launch the scaled semi-planar copy
+     */
+    int cuda_scale_semi_planar(const void *y_plane, const void *uv_plane,
+                               int y_stride, int uv_stride,
+                               void *y_out, void *uv_out,
+                               int y_out_stride, int uv_out_stride,
+                               const ScaleGeometry *geo,
+                               int p010, void *stream)
+    {
+        dim3 block(32, 8);
+        dim3 grid(((geo->out_w + 1) / 2 + block.x - 1) / block.x,
+                  ((geo->out_h + 1) / 2 + block.y - 1) / block.y);
+        cudaStream_t cu_stream = (cudaStream_t)stream;
+
+        const unsigned char *y = (const unsigned char *)y_plane;
+        const unsigned char *uv = (const unsigned char *)uv_plane;
+
+        if (p010)
+            scale_semi_planar_kernel<true><<<grid, block, 0, cu_stream>>>(
+                y, uv, y_stride, uv_stride,
+                (unsigned char *)y_out, (unsigned char *)uv_out,
+                y_out_stride, uv_out_stride, *geo);
+        else
+            scale_semi_planar_kernel<false><<<grid, block, 0, cu_stream>>>(
+                y, uv, y_stride, uv_stride,
+                (unsigned char *)y_out, (unsigned char *)uv_out,
+                y_out_stride, uv_out_stride, *geo);
 
         return (int)cudaGetLastError();
     }
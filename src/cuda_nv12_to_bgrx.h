@@ -2,18 +2,237 @@
  * SPDX-FileCopyrightText: 2025 Ericky
  *
  * CUDA NV12 to BGRx conversion - C header
+ * Also covers P010 input to 8-bit BGRx or 10-bit XRGB2101010 output.
  */
 
 #ifndef CUDA_NV12_TO_BGRX_H
 #define CUDA_NV12_TO_BGRX_H
 
 #include <stdint.h>
+#include <string.h>
+
+#ifdef __CUDACC__
+#define YUV_TO_RGB_INLINE __host__ __device__ static inline
+#else
+#define YUV_TO_RGB_INLINE static inline
+#endif
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/* Fractional bits of the fixed-point conversion coefficients */
+#define YUV_TO_RGB_SHIFT 13
+
+    /**
+     * YUV→RGB conversion coefficients in Q13 fixed point.
+     *
+     * R = cy * (Y - y_offset)                        + crv * (V - uv_offset)
+     * G = cy * (Y - y_offset) + cgu * (U - uv_offset) + cgv * (V - uv_offset)
+     * B = cy * (Y - y_offset) + cbu * (U - uv_offset)
+     *
+     * and each component is clamped to [0, out_max]. Offsets are in input
+     * code values (16/128 for 8-bit, 64/512 for 10-bit limited range) and
+     * the scale folds in the output depth, so one table covers NV12→8-bit,
+     * P010→8-bit and P010→10-bit.
+     *
+     * Every coefficient fits in int16 so the same table can drive 16-bit
+     * multiply-add SIMD code. Passed to the kernel by value, so each element
+     * instance can convert with its own matrix.
+     */
+    typedef struct
+    {
+        int32_t y_offset;
+        int32_t uv_offset;
+        int32_t cy;
+        int32_t crv;
+        int32_t cgu;
+        int32_t cgv;
+        int32_t cbu;
+        int32_t out_max;
+    } YuvToRgbCoeffs;
+
+    YUV_TO_RGB_INLINE int32_t yuv_to_rgb_clamp(int32_t v, int32_t max)
+    {
+        return v < 0 ? 0 : (v > max ? max : v);
+    }
+
+    /**
+     * Convert one pixel at the coefficients' output depth. Shared by the
+     * CUDA kernels and the CPU references so both produce bit-identical
+     * output.
+     */
+    YUV_TO_RGB_INLINE void yuv_to_rgb(const YuvToRgbCoeffs *c,
+                                      int32_t y, int32_t u, int32_t v,
+                                      int32_t *r, int32_t *g, int32_t *b)
+    {
+        const int32_t round = 1 << (YUV_TO_RGB_SHIFT - 1);
+        int32_t luma = (y - c->y_offset) * c->cy + round;
+        u -= c->uv_offset;
+        v -= c->uv_offset;
+
+        *r = yuv_to_rgb_clamp((luma + c->crv * v) >> YUV_TO_RGB_SHIFT, c->out_max);
+        *g = yuv_to_rgb_clamp((luma + c->cgu * u + c->cgv * v) >> YUV_TO_RGB_SHIFT, c->out_max);
+        *b = yuv_to_rgb_clamp((luma + c->cbu * u) >> YUV_TO_RGB_SHIFT, c->out_max);
+    }
+
+    /**
+     * Convert one pixel to 8-bit RGB (coefficients with out_max = 255).
+     */
+    YUV_TO_RGB_INLINE void yuv_to_rgb_pixel(const YuvToRgbCoeffs *c,
+                                            int32_t y, int32_t u, int32_t v,
+                                            uint8_t *r, uint8_t *g, uint8_t *b)
+    {
+        int32_t R, G, B;
+        yuv_to_rgb(c, y, u, v, &R, &G, &B);
+        *r = (uint8_t)R;
+        *g = (uint8_t)G;
+        *b = (uint8_t)B;
+    }
+
+    YUV_TO_RGB_INLINE uint32_t yuv_to_bgrx_packed(const YuvToRgbCoeffs *c,
+                                                  int32_t y, int32_t u, int32_t v)
+    {
+        uint8_t r, g, b;
+        yuv_to_rgb_pixel(c, y, u, v, &r, &g, &b);
+        return (uint32_t)b | ((uint32_t)g << 8) | ((uint32_t)r << 16) | 0xff000000u;
+    }
+
+    /**
+     * Pack one pixel as DRM XRGB2101010/ARGB2101010 (GStreamer BGR10A2_LE):
+     * B in bits 0-9, G in 10-19, R in 20-29 and opaque alpha in 30-31.
+     * Expects coefficients with out_max = 1023.
+     */
+    YUV_TO_RGB_INLINE uint32_t yuv_to_x2rgb10_packed(const YuvToRgbCoeffs *c,
+                                                     int32_t y, int32_t u, int32_t v)
+    {
+        int32_t r, g, b;
+        yuv_to_rgb(c, y, u, v, &r, &g, &b);
+        return (uint32_t)b | ((uint32_t)g << 10) | ((uint32_t)r << 20) | 0xc0000000u;
+    }
+
+    /* Vector load/store of n bytes (n = 2/4 for loads, 8/16 for stores).
+     * The device uses native vector types; the host path is what the CPU
+     * emulation in the tests runs. */
+    YUV_TO_RGB_INLINE void nv12_vec_load(uint8_t *dst, const uint8_t *src, int n)
+    {
+#ifdef __CUDA_ARCH__
+        if (n == 4)
+            *(uchar4 *)dst = *(const uchar4 *)src;
+        else
+            *(uchar2 *)dst = *(const uchar2 *)src;
+#else
+        memcpy(dst, src, (size_t)n);
+#endif
+    }
+
+    YUV_TO_RGB_INLINE void nv12_vec_store(uint8_t *dst, const uint32_t *src, int n_px)
+    {
+#ifdef __CUDA_ARCH__
+        if (n_px == 4)
+            *(uint4 *)dst = make_uint4(src[0], src[1], src[2], src[3]);
+        else
+            *(uint2 *)dst = make_uint2(src[0], src[1]);
+#else
+        memcpy(dst, src, (size_t)n_px * 4);
+#endif
+    }
+
+    /**
+     * Convert the tile_w x 2 pixel tile whose top-left corner is (x0, y0).
+     * x0 must be a multiple of tile_w and y0 even. Whole tiles use vector
+     * loads/stores when @vectorized; tiles on the right/bottom edge fall
+     * back to per-pixel access and never touch memory past width/height.
+     */
+    YUV_TO_RGB_INLINE void nv12_to_bgrx_tile(const YuvToRgbCoeffs *c,
+                                             const uint8_t *y_plane,
+                                             const uint8_t *uv_plane,
+                                             uint8_t *bgrx_out,
+                                             int width, int height,
+                                             int y_stride, int uv_stride, int out_stride,
+                                             int x0, int y0, int tile_w, int vectorized)
+    {
+        int cols = width - x0 < tile_w ? width - x0 : tile_w;
+        int rows = height - y0 < 2 ? height - y0 : 2;
+        int whole = vectorized && cols == tile_w;
+
+        /* One chroma row serves both luma rows; for even x0 the interleaved
+         * U/V pairs for the tile start at byte x0 */
+        uint8_t uv[4];
+        const uint8_t *uv_src = uv_plane + (y0 / 2) * uv_stride + x0;
+        if (whole)
+            nv12_vec_load(uv, uv_src, tile_w);
+        else
+            for (int i = 0; i < ((cols + 1) / 2) * 2; i++)
+                uv[i] = uv_src[i];
+
+        for (int r = 0; r < rows; r++)
+        {
+            uint8_t ys[4];
+            uint32_t px[4];
+            const uint8_t *y_src = y_plane + (y0 + r) * y_stride + x0;
+            uint8_t *dst = bgrx_out + (y0 + r) * out_stride + x0 * 4;
+
+            if (whole)
+                nv12_vec_load(ys, y_src, tile_w);
+            else
+                for (int i = 0; i < cols; i++)
+                    ys[i] = y_src[i];
+
+            for (int i = 0; i < cols; i++)
+                px[i] = yuv_to_bgrx_packed(c, ys[i], uv[(i / 2) * 2], uv[(i / 2) * 2 + 1]);
+
+            if (whole)
+                nv12_vec_store(dst, px, tile_w);
+            else
+                for (int i = 0; i < cols; i++)
+                    memcpy(dst + i * 4, &px[i], 4);
+        }
+    }
+
+    /* P010 stores each 10-bit sample in the high bits of a little-endian
+     * 16-bit word */
+    YUV_TO_RGB_INLINE int32_t p010_sample(const uint8_t *p)
+    {
+        return (int32_t)(((uint32_t)p[0] | ((uint32_t)p[1] << 8)) >> 6);
+    }
+
+    /**
+     * Convert the 2x2 P010 pixel tile whose top-left corner is (x0, y0),
+     * both even, to BGRx (@rgb10 = 0) or XRGB2101010 (@rgb10 = 1). Both
+     * outputs are one 32-bit word per pixel. Pixels past width/height are
+     * skipped.
+     */
+    YUV_TO_RGB_INLINE void p010_to_rgb_tile(const YuvToRgbCoeffs *c,
+                                            const uint8_t *y_plane,
+                                            const uint8_t *uv_plane,
+                                            uint8_t *out,
+                                            int width, int height,
+                                            int y_stride, int uv_stride, int out_stride,
+                                            int x0, int y0, int rgb10)
+    {
+        const uint8_t *uv_src = uv_plane + (y0 / 2) * uv_stride + x0 * 2;
+        int32_t u = p010_sample(uv_src);
+        int32_t v = p010_sample(uv_src + 2);
+        int cols = width - x0 < 2 ? width - x0 : 2;
+        int rows = height - y0 < 2 ? height - y0 : 2;
+
+        for (int r = 0; r < rows; r++)
+        {
+            const uint8_t *y_src = y_plane + (y0 + r) * y_stride + x0 * 2;
+            uint8_t *dst = out + (y0 + r) * out_stride + x0 * 4;
+
+            for (int i = 0; i < cols; i++)
+            {
+                int32_t y = p010_sample(y_src + i * 2);
+                uint32_t px = rgb10 ? yuv_to_x2rgb10_packed(c, y, u, v)
+                                    : yuv_to_bgrx_packed(c, y, u, v);
+                memcpy(dst + i * 4, &px, 4);
+            }
+        }
+    }
+
     /**
      * Convert NV12 image to BGRx on the GPU
      *
@@ -25,6 +244,7 @@ extern "C"
      * @param y_stride    Stride of Y plane in bytes
      * @param uv_stride   Stride of UV plane in bytes
      * @param out_stride  Stride of output BGRx buffer in bytes
+     * @param coeffs      Conversion matrix/range for the input colorimetry
      * @param stream      CUDA stream to use (NULL/0 for default)
      *
      * @return 0 (cudaSuccess) on success, CUDA error code otherwise
@@ -38,8 +258,104 @@ extern "C"
         int y_stride,
         int uv_stride,
         int out_stride,
+        const YuvToRgbCoeffs *coeffs,
+        void *stream);
+
+    /**
+     * Convert P010 image to BGRx or XRGB2101010 on the GPU
+     *
+     * @param y_plane     Pointer to Y plane in device memory (16-bit samples)
+     * @param uv_plane    Pointer to UV plane in device memory
+     * @param rgb_out     Pointer to output buffer in device memory
+     * @param width       Image width
+     * @param height      Image height
+     * @param y_stride    Stride of Y plane in bytes
+     * @param uv_stride   Stride of UV plane in bytes
+     * @param out_stride  Stride of output buffer in bytes
+     * @param coeffs      Conversion matrix/range, 10-bit input at the output depth
+     * @param rgb10       Non-zero for XRGB2101010 output, zero for BGRx
+     * @param stream      CUDA stream to use (NULL/0 for default)
+     *
+     * @return 0 (cudaSuccess) on success, CUDA error code otherwise
+     */
+    int cuda_p010_to_rgb(
+        const void *y_plane,
+        const void *uv_plane,
+        void *rgb_out,
+        int width,
+        int height,
+        int y_stride,
+        int uv_stride,
+        int out_stride,
+        const YuvToRgbCoeffs *coeffs,
+        int rgb10,
         void *stream);
 
+    /**
+     * CPU reference of cuda_nv12_to_bgrx() (bit-exact), for tests and
+     * verification without a GPU.
+     */
+    YUV_TO_RGB_INLINE void nv12_to_bgrx_reference(
+        const uint8_t *y_plane,
+        const uint8_t *uv_plane,
+        uint8_t *bgrx_out,
+        int width,
+        int height,
+        int y_stride,
+        int uv_stride,
+        int out_stride,
+        const YuvToRgbCoeffs *coeffs)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *uv_row = uv_plane + (y / 2) * uv_stride;
+            for (int x = 0; x < width; x++)
+            {
+                uint8_t *px = bgrx_out + y * out_stride + x * 4;
+                yuv_to_rgb_pixel(coeffs, y_plane[y * y_stride + x],
+                                 uv_row[(x / 2) * 2], uv_row[(x / 2) * 2 + 1],
+                                 &px[2], &px[1], &px[0]);
+                px[3] = 255;
+            }
+        }
+    }
+
+    /**
+     * CPU reference of cuda_p010_to_rgb(), pixel by pixel.
+     */
+    YUV_TO_RGB_INLINE void p010_to_rgb_reference(
+        const uint8_t *y_plane,
+        const uint8_t *uv_plane,
+        uint8_t *rgb_out,
+        int width,
+        int height,
+        int y_stride,
+        int uv_stride,
+        int out_stride,
+        const YuvToRgbCoeffs *coeffs,
+        int rgb10)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *uv_row = uv_plane + (y / 2) * uv_stride;
+            for (int x = 0; x < width; x++)
+            {
+                int32_t luma = p010_sample(y_plane + y * y_stride + x * 2);
+                int32_t u = p010_sample(uv_row + (x / 2) * 4);
+                int32_t v = p010_sample(uv_row + (x / 2) * 4 + 2);
+                int32_t r, g, b;
+                uint32_t px;
+
+                yuv_to_rgb(coeffs, luma, u, v, &r, &g, &b);
+                if (rgb10)
+                    px = (uint32_t)b | ((uint32_t)g << 10) | ((uint32_t)r << 20) | 0xc0000000u;
+                else
+                    px = (uint32_t)b | ((uint32_t)g << 8) | ((uint32_t)r << 16) | 0xff000000u;
+                memcpy(rgb_out + y * out_stride + x * 4, &px, 4);
+            }
+        }
+    }
+
 #ifdef __cplusplus
 }
 #endif
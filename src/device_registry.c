@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Device Registry
+ */
+
+#include "device_registry.h"
+
+typedef struct
+{
+    gchar *path;
+    gpointer device;
+    guint refcount;
+} RegistryEntry;
+
+struct _DeviceRegistry
+{
+    GMutex lock;
+    GPtrArray *entries; /* RegistryEntry, a handful at most */
+    DeviceOpenFunc open_func;
+    DeviceCloseFunc close_func;
+    gpointer user_data;
+};
+
+DeviceRegistry *
+device_registry_new(DeviceOpenFunc open_func, DeviceCloseFunc close_func,
+                    gpointer user_data)
+{
+    DeviceRegistry *registry = g_new0(DeviceRegistry, 1);
+
+    g_mutex_init(&registry->lock);
+    registry->entries = g_ptr_array_new();
+    registry->open_func = open_func;
+    registry->close_func = close_func;
+    registry->user_data = user_data;
+    return registry;
+}
+
+static void
+entry_close(DeviceRegistry *registry, RegistryEntry *entry)
+{
+    registry->close_func(entry->device, registry->user_data);
+    g_free(entry->path);
+    g_free(entry);
+}
+
+void device_registry_free(DeviceRegistry *registry)
+{
+    if (!registry)
+        return;
+
+    for (guint i = 0; i < registry->entries->len; i++)
+    {
+        RegistryEntry *entry = g_ptr_array_index(registry->entries, i);
+        g_warning("Closing %s with %u users left", entry->path, entry->refcount);
+        entry_close(registry, entry);
+    }
+
+    g_ptr_array_unref(registry->entries);
+    g_mutex_clear(&registry->lock);
+    g_free(registry);
+}
+
+gpointer
+device_registry_acquire(DeviceRegistry *registry, const gchar *path)
+{
+    gpointer device = NULL;
+
+    g_return_val_if_fail(path != NULL, NULL);
+
+    g_mutex_lock(&registry->lock);
+
+    for (guint i = 0; i < registry->entries->len; i++)
+    {
+        RegistryEntry *entry = g_ptr_array_index(registry->entries, i);
+        if (g_strcmp0(entry->path, path) == 0)
+        {
+            entry->refcount++;
+            device = entry->device;
+            break;
+        }
+    }
+
+    /* Opening is rare and short next to the streaming lifetime, so it is
+     * simply done under the lock */
+    if (!device)
+    {
+        device = registry->open_func(path, registry->user_data);
+        if (device)
+        {
+            RegistryEntry *entry = g_new0(RegistryEntry, 1);
+            entry->path = g_strdup(path);
+            entry->device = device;
+            entry->refcount = 1;
+            g_ptr_array_add(registry->entries, entry);
+            g_debug("Opened shared device %s", path);
+        }
+    }
+
+    g_mutex_unlock(&registry->lock);
+    return device;
+}
+
+void device_registry_release(DeviceRegistry *registry, gpointer device)
+{
+    RegistryEntry *closing = NULL;
+
+    if (!device)
+        return;
+
+    g_mutex_lock(&registry->lock);
+
+    for (guint i = 0; i < registry->entries->len; i++)
+    {
+        RegistryEntry *entry = g_ptr_array_index(registry->entries, i);
+        if (entry->device != device)
+            continue;
+
+        if (--entry->refcount == 0)
+        {
+            g_ptr_array_remove_index_fast(registry->entries, i);
+            closing = entry;
+        }
+        device = NULL;
+        break;
+    }
+
+    /* Closed under the lock too, so a concurrent acquire of the same node
+     * can't open a second device while this one is still being torn down */
+    if (closing)
+    {
+        g_debug("Closing shared device %s", closing->path);
+        entry_close(registry, closing);
+    }
+
+    g_mutex_unlock(&registry->lock);
+
+    if (device)
+        g_warning("Releasing a device the registry doesn't hold");
+}
+
+guint device_registry_get_n_devices(DeviceRegistry *registry)
+{
+    g_mutex_lock(&registry->lock);
+    guint n = registry->entries->len;
+    g_mutex_unlock(&registry->lock);
+
+    return n;
+}
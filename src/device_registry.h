@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Device Registry
+ * Refcounted devices keyed by DRM render node path, opened on the first
+ * acquire and closed when the last user releases them, so element
+ * instances and pools on the same node share one DRM fd / GBM device /
+ * EGL display. Thread-safe; concurrent first acquires of a node open it
+ * once.
+ */
+
+#ifndef __DEVICE_REGISTRY_H__
+#define __DEVICE_REGISTRY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DeviceRegistry DeviceRegistry;
+
+/**
+ * Open the device on @path.
+ *
+ * @return The device, or NULL on failure (nothing is cached then)
+ */
+typedef gpointer (*DeviceOpenFunc)(const gchar *path, gpointer user_data);
+
+/**
+ * Close a device returned by a #DeviceOpenFunc.
+ */
+typedef void (*DeviceCloseFunc)(gpointer device, gpointer user_data);
+
+DeviceRegistry *device_registry_new(DeviceOpenFunc open_func, DeviceCloseFunc close_func,
+                                    gpointer user_data);
+
+/**
+ * Free @registry. Devices still acquired are closed.
+ */
+void device_registry_free(DeviceRegistry *registry);
+
+/**
+ * The device on @path, opened if no one holds it yet. Opening happens
+ * under the registry lock, so concurrent callers wait for the first one
+ * and get the same device. Balance with device_registry_release().
+ *
+ * @return The device, or NULL if it couldn't be opened
+ */
+gpointer device_registry_acquire(DeviceRegistry *registry, const gchar *path);
+
+/**
+ * Drop a reference taken by device_registry_acquire(), closing the
+ * device with the last one.
+ */
+void device_registry_release(DeviceRegistry *registry, gpointer device);
+
+/**
+ * Number of devices currently open.
+ */
+guint device_registry_get_n_devices(DeviceRegistry *registry);
+
+G_END_DECLS
+
+#endif /* __DEVICE_REGISTRY_H__ */
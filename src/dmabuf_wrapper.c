@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * DMA-BUF Wrapper Recycling
+ */
+
+#include "dmabuf_wrapper.h"
+#include "buffer_fence.h"
+
+#include <gst/allocators/allocators.h>
+#include <unistd.h>
+
+struct _DmaBufWrapper
+{
+    /* One reference for the owner, one while the buffer is downstream */
+    gint refcount;
+
+    /* Protects buffer/closed: dispose runs on whichever thread drops the
+     * last downstream reference. */
+    GMutex lock;
+    GstBuffer *buffer; /* Parked buffer, NULL while downstream */
+    gboolean closed;   /* Owner released the wrapper */
+};
+
+static GQuark
+dmabuf_wrapper_quark(void)
+{
+    static GQuark quark = 0;
+    if (!quark)
+        quark = g_quark_from_static_string("dmabuf-wrapper");
+    return quark;
+}
+
+static void
+dmabuf_wrapper_unref(DmaBufWrapper *wrapper)
+{
+    if (!g_atomic_int_dec_and_test(&wrapper->refcount))
+        return;
+
+    g_mutex_clear(&wrapper->lock);
+    g_free(wrapper);
+}
+
+/* Last downstream reference dropped: park the buffer instead of freeing it */
+static gboolean
+dmabuf_wrapper_buffer_dispose(GstMiniObject *obj)
+{
+    GstBuffer *buffer = GST_BUFFER_CAST(obj);
+    DmaBufWrapper *wrapper = gst_mini_object_get_qdata(obj, dmabuf_wrapper_quark());
+    gboolean revive;
+
+    g_mutex_lock(&wrapper->lock);
+    /* Memory replaced downstream: the buffer no longer wraps our slot */
+    revive = !wrapper->closed &&
+             !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+    if (revive)
+    {
+        gst_buffer_ref(buffer);
+        wrapper->buffer = buffer;
+    }
+    g_mutex_unlock(&wrapper->lock);
+
+    dmabuf_wrapper_unref(wrapper);
+
+    /* FALSE keeps the buffer alive */
+    return !revive;
+}
+
+GstBuffer *
+dmabuf_wrapper_build_buffer(GstAllocator *alloc,
+                            guint n_mem,
+                            const int *fds,
+                            const gsize *sizes,
+                            BufferFence *fence,
+                            GstVideoFormat format,
+                            guint width, guint height,
+                            guint n_planes,
+                            const gsize *offsets,
+                            const gint *strides)
+{
+    g_return_val_if_fail(alloc != NULL, NULL);
+    g_return_val_if_fail(n_mem > 0 && n_planes <= GST_VIDEO_MAX_PLANES, NULL);
+
+    GstBuffer *buffer = gst_buffer_new();
+
+    for (guint i = 0; i < n_mem; i++)
+    {
+        /* GstDmaBufAllocator takes ownership of the fd it is given */
+        int fd_dup = dup(fds[i]);
+        if (fd_dup < 0)
+        {
+            g_warning("dmabuf_wrapper: failed to dup fd %d", fds[i]);
+            gst_buffer_unref(buffer);
+            return NULL;
+        }
+
+        GstMemory *mem = gst_dmabuf_allocator_alloc(alloc, fd_dup, sizes[i]);
+        if (!mem)
+        {
+            close(fd_dup);
+            gst_buffer_unref(buffer);
+            return NULL;
+        }
+
+        if (fence)
+            buffer_fence_attach(mem, fence);
+
+        gst_buffer_append_memory(buffer, mem);
+    }
+
+    GstVideoMeta *vmeta = gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE,
+                                                         format, width, height,
+                                                         n_planes, (gsize *)offsets,
+                                                         (gint *)strides);
+    GST_META_FLAG_SET(vmeta, GST_META_FLAG_POOLED);
+
+    return buffer;
+}
+
+DmaBufWrapper *
+dmabuf_wrapper_new(GstBuffer *buffer)
+{
+    g_return_val_if_fail(GST_IS_BUFFER(buffer), NULL);
+
+    DmaBufWrapper *wrapper = g_new0(DmaBufWrapper, 1);
+    wrapper->refcount = 1;
+    g_mutex_init(&wrapper->lock);
+    wrapper->buffer = buffer;
+
+    gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(buffer), dmabuf_wrapper_quark(),
+                              wrapper, NULL);
+    GST_MINI_OBJECT_CAST(buffer)->dispose = dmabuf_wrapper_buffer_dispose;
+
+    return wrapper;
+}
+
+static gboolean
+dmabuf_wrapper_remove_unpooled_meta(GstBuffer *buffer, GstMeta **meta, gpointer user_data)
+{
+    (void)buffer;
+    (void)user_data;
+
+    if (!GST_META_FLAG_IS_SET(*meta, GST_META_FLAG_POOLED))
+    {
+        GST_META_FLAG_UNSET(*meta, GST_META_FLAG_LOCKED);
+        *meta = NULL;
+    }
+    return TRUE;
+}
+
+GstBuffer *
+dmabuf_wrapper_acquire(DmaBufWrapper *wrapper)
+{
+    g_return_val_if_fail(wrapper != NULL, NULL);
+
+    g_mutex_lock(&wrapper->lock);
+    GstBuffer *buffer = wrapper->buffer;
+    wrapper->buffer = NULL;
+    g_mutex_unlock(&wrapper->lock);
+
+    if (!buffer)
+        return NULL;
+
+    /* Held by dispose until the buffer comes back */
+    g_atomic_int_inc(&wrapper->refcount);
+
+    GST_BUFFER_PTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION(buffer) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_OFFSET(buffer) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_OFFSET_END(buffer) = GST_BUFFER_OFFSET_NONE;
+    GST_BUFFER_FLAGS(buffer) = 0;
+
+    gst_buffer_foreach_meta(buffer, dmabuf_wrapper_remove_unpooled_meta, NULL);
+
+    return buffer;
+}
+
+gboolean
+dmabuf_wrapper_is_free(DmaBufWrapper *wrapper)
+{
+    g_return_val_if_fail(wrapper != NULL, FALSE);
+
+    g_mutex_lock(&wrapper->lock);
+    gboolean is_free = wrapper->buffer != NULL;
+    g_mutex_unlock(&wrapper->lock);
+
+    return is_free;
+}
+
+void dmabuf_wrapper_free(DmaBufWrapper *wrapper)
+{
+    if (!wrapper)
+        return;
+
+    g_mutex_lock(&wrapper->lock);
+    GstBuffer *parked = wrapper->buffer;
+    wrapper->buffer = NULL;
+    wrapper->closed = TRUE;
+    g_mutex_unlock(&wrapper->lock);
+
+    if (parked)
+    {
+        /* Dispose drops one reference as if the buffer came from downstream */
+        g_atomic_int_inc(&wrapper->refcount);
+        gst_buffer_unref(parked);
+    }
+
+    dmabuf_wrapper_unref(wrapper);
+}
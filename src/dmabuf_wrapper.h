@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * DMA-BUF Wrapper Recycling
+ * Long-lived output GstBuffers for fixed DMA-BUF slots
+ *
+ * Wrapping a DMA-BUF in a GstBuffer costs an fd dup, a GstMemory, a
+ * GstBuffer and a GstVideoMeta. For slots that are written over and over
+ * (external FD pool entries) the wrapper is built once and parked in a
+ * DmaBufWrapper. When downstream drops the last reference the buffer is
+ * revived in its dispose handler and parked again, so the steady-state
+ * path does no heap allocation and no fd syscalls.
+ */
+
+#ifndef __DMABUF_WRAPPER_H__
+#define __DMABUF_WRAPPER_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+struct _BufferFence;
+
+typedef struct _DmaBufWrapper DmaBufWrapper;
+
+/**
+ * Build a GstBuffer wrapping one DMA-BUF memory per fd, with video meta.
+ * Each fd is dup'd (the allocator takes ownership of the dup); the caller
+ * keeps its own fds. The video meta is flagged POOLED so it survives
+ * recycling.
+ *
+ * @param alloc DMA-BUF allocator
+ * @param n_mem Number of fds/memories
+ * @param fds DMA-BUF fds, one per memory
+ * @param sizes Size of each memory in bytes
+ * @param fence Completion fence attached to every memory (may be NULL)
+ * @param format Video format for the meta
+ * @param width Frame width
+ * @param height Frame height
+ * @param n_planes Number of planes in the meta
+ * @param offsets Plane offsets (relative to the whole buffer)
+ * @param strides Plane strides
+ * @return New buffer, or NULL on failure
+ */
+GstBuffer *dmabuf_wrapper_build_buffer(GstAllocator *alloc,
+                                       guint n_mem,
+                                       const int *fds,
+                                       const gsize *sizes,
+                                       struct _BufferFence *fence,
+                                       GstVideoFormat format,
+                                       guint width, guint height,
+                                       guint n_planes,
+                                       const gsize *offsets,
+                                       const gint *strides);
+
+/**
+ * Create a recycler around a prebuilt buffer.
+ *
+ * @param buffer Buffer to recycle (ownership transferred)
+ * @return New wrapper
+ */
+DmaBufWrapper *dmabuf_wrapper_new(GstBuffer *buffer);
+
+/**
+ * Take the parked buffer for a new frame.
+ * Timestamps, offsets and flags are reset; metas added downstream on the
+ * previous round are removed.
+ *
+ * @return The buffer (caller owns the only reference), or NULL if the
+ *         previous frame is still referenced downstream
+ */
+GstBuffer *dmabuf_wrapper_acquire(DmaBufWrapper *wrapper);
+
+/**
+ * Check whether the parked buffer is available without taking it.
+ */
+gboolean dmabuf_wrapper_is_free(DmaBufWrapper *wrapper);
+
+/**
+ * Release the wrapper. A buffer still referenced downstream stays valid and
+ * is freed normally when its last reference is dropped.
+ */
+void dmabuf_wrapper_free(DmaBufWrapper *wrapper);
+
+G_END_DECLS
+
+#endif /* __DMABUF_WRAPPER_H__ */
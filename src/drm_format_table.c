@@ -0,0 +1,344 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * DRM Format Table
+ */
+
+#include "drm_format_table.h"
+
+#include <drm/drm_fourcc.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <string.h>
+
+#define CACHE_GROUP "cache"
+
+struct _DrmFormatTable
+{
+    DrmFormatEntry *entries;
+    guint n_entries;
+    GHashTable *index; /* drm_format → entry */
+    gchar *candidates; /* Checksum of the candidate strings */
+};
+
+/* NVIDIA block-linear 2D modifiers, block heights 1-32 GOBs: uncompressed
+ * (kind 0x06) then compressed (kind 0xe0) */
+#define NVIDIA_BLOCK_LINEAR_MODIFIERS                                          \
+    0x0300000000606010ULL, 0x0300000000606011ULL, 0x0300000000606012ULL,       \
+        0x0300000000606013ULL, 0x0300000000606014ULL, 0x0300000000606015ULL
+
+#define NVIDIA_COMPRESSED_MODIFIERS                                            \
+    0x0300000000e08010ULL, 0x0300000000e08011ULL, 0x0300000000e08012ULL,       \
+        0x0300000000e08013ULL, 0x0300000000e08014ULL, 0x0300000000e08015ULL
+
+/* NV12/P010: tiled first (zero-copy from the decoder) */
+static const guint64 yuv_modifiers[] = {
+    NVIDIA_BLOCK_LINEAR_MODIFIERS,
+    NVIDIA_COMPRESSED_MODIFIERS,
+    DRM_FORMAT_MOD_LINEAR,
+    I915_FORMAT_MOD_X_TILED,
+};
+
+/* XR24: linear first for Vulkan/wgpu compatibility */
+static const guint64 xr24_modifiers[] = {
+    DRM_FORMAT_MOD_LINEAR,
+    NVIDIA_BLOCK_LINEAR_MODIFIERS,
+};
+
+/* 2:10:10:10 RGB: the CUDA-EGL conversion target is always LINEAR */
+static const guint64 linear_modifiers[] = {
+    DRM_FORMAT_MOD_LINEAR,
+};
+
+static const struct
+{
+    guint32 fourcc;
+    guint n_planes;
+    guint bpp;
+    const guint64 *modifiers;
+    guint n_modifiers;
+} candidates[] = {
+    {DRM_FORMAT_NV12, 2, 12, yuv_modifiers, G_N_ELEMENTS(yuv_modifiers)},
+    {DRM_FORMAT_P010, 2, 24, yuv_modifiers, G_N_ELEMENTS(yuv_modifiers)},
+    {DRM_FORMAT_XRGB8888, 1, 32, xr24_modifiers, G_N_ELEMENTS(xr24_modifiers)},
+    {DRM_FORMAT_XRGB2101010, 1, 32, linear_modifiers, G_N_ELEMENTS(linear_modifiers)},
+    {DRM_FORMAT_ARGB2101010, 1, 32, linear_modifiers, G_N_ELEMENTS(linear_modifiers)},
+};
+
+/* "NV12" from DRM_FORMAT_NV12 */
+static void
+fourcc_name(guint32 fourcc, gchar name[5])
+{
+    for (guint i = 0; i < 4; i++)
+        name[i] = (gchar)((fourcc >> (8 * i)) & 0xff);
+    name[4] = '\0';
+}
+
+DrmFormatTable *
+drm_format_table_new(void)
+{
+    DrmFormatTable *table = g_new0(DrmFormatTable, 1);
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA1);
+
+    for (guint i = 0; i < G_N_ELEMENTS(candidates); i++)
+        table->n_entries += candidates[i].n_modifiers;
+
+    table->entries = g_new0(DrmFormatEntry, table->n_entries);
+    table->index = g_hash_table_new(g_str_hash, g_str_equal);
+
+    DrmFormatEntry *e = table->entries;
+    for (guint i = 0; i < G_N_ELEMENTS(candidates); i++)
+    {
+        gchar name[5];
+        fourcc_name(candidates[i].fourcc, name);
+
+        for (guint m = 0; m < candidates[i].n_modifiers; m++, e++)
+        {
+            e->fourcc = candidates[i].fourcc;
+            e->modifier = candidates[i].modifiers[m];
+            e->n_planes = candidates[i].n_planes;
+            e->bpp = candidates[i].bpp;
+            e->gbm = TRUE;
+            e->supported = TRUE;
+
+            /* LINEAR keeps the short "0x0" form the caps have always used */
+            if (e->modifier == DRM_FORMAT_MOD_LINEAR)
+                g_snprintf(e->drm_format, sizeof(e->drm_format), "%s:0x0", name);
+            else
+                g_snprintf(e->drm_format, sizeof(e->drm_format), "%s:0x%016" G_GINT64_MODIFIER "x",
+                           name, e->modifier);
+
+            g_hash_table_insert(table->index, e->drm_format, e);
+            g_checksum_update(checksum, (const guchar *)e->drm_format, -1);
+        }
+    }
+
+    table->candidates = g_strdup(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+    return table;
+}
+
+void drm_format_table_free(DrmFormatTable *table)
+{
+    if (!table)
+        return;
+
+    g_hash_table_unref(table->index);
+    g_free(table->entries);
+    g_free(table->candidates);
+    g_free(table);
+}
+
+guint drm_format_table_get_n_entries(const DrmFormatTable *table)
+{
+    return table->n_entries;
+}
+
+const DrmFormatEntry *
+drm_format_table_get_entry(const DrmFormatTable *table, guint index)
+{
+    g_return_val_if_fail(index < table->n_entries, NULL);
+    return &table->entries[index];
+}
+
+const DrmFormatEntry *
+drm_format_table_lookup(const DrmFormatTable *table, const gchar *drm_format)
+{
+    if (!drm_format)
+        return NULL;
+    return g_hash_table_lookup(table->index, drm_format);
+}
+
+void drm_format_table_set_device_modifiers(DrmFormatTable *table, guint32 fourcc,
+                                           const guint64 *modifiers, guint n_modifiers,
+                                           gboolean gbm)
+{
+    for (guint i = 0; i < table->n_entries; i++)
+    {
+        DrmFormatEntry *e = &table->entries[i];
+        if (e->fourcc != fourcc)
+            continue;
+
+        e->gbm = gbm;
+        e->supported = n_modifiers == 0 || e->modifier == DRM_FORMAT_MOD_LINEAR;
+        for (guint m = 0; !e->supported && m < n_modifiers; m++)
+            e->supported = modifiers[m] == e->modifier;
+    }
+}
+
+/* ============================================================================
+ * On-disk cache
+ * ============================================================================ */
+
+gboolean
+drm_format_table_save(const DrmFormatTable *table, const gchar *path,
+                      const gchar *driver_key, GError **error)
+{
+    GKeyFile *kf = g_key_file_new();
+    gchar *dir = g_path_get_dirname(path);
+    gboolean ok;
+
+    g_key_file_set_string(kf, CACHE_GROUP, "driver", driver_key);
+    g_key_file_set_string(kf, CACHE_GROUP, "candidates", table->candidates);
+
+    /* One group per fourcc listing its supported modifiers */
+    for (guint i = 0; i < table->n_entries;)
+    {
+        guint32 fourcc = table->entries[i].fourcc;
+        GPtrArray *mods = g_ptr_array_new_with_free_func(g_free);
+        gchar name[5];
+
+        fourcc_name(fourcc, name);
+        g_key_file_set_boolean(kf, name, "gbm", table->entries[i].gbm);
+
+        for (; i < table->n_entries && table->entries[i].fourcc == fourcc; i++)
+        {
+            if (table->entries[i].supported)
+                g_ptr_array_add(mods, g_strdup_printf("0x%016" G_GINT64_MODIFIER "x",
+                                                      table->entries[i].modifier));
+        }
+
+        g_key_file_set_string_list(kf, name, "modifiers",
+                                   (const gchar *const *)mods->pdata, mods->len);
+        g_ptr_array_unref(mods);
+    }
+
+    ok = g_mkdir_with_parents(dir, 0755) == 0;
+    if (!ok)
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "Failed to create %s", dir);
+    else
+        ok = g_key_file_save_to_file(kf, path, error);
+
+    g_free(dir);
+    g_key_file_unref(kf);
+    return ok;
+}
+
+gboolean
+drm_format_table_load(DrmFormatTable *table, const gchar *path, const gchar *driver_key)
+{
+    GKeyFile *kf = g_key_file_new();
+    gboolean ok = FALSE;
+
+    if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL))
+        goto done;
+
+    /* Stale after a driver update or a change of candidates */
+    gchar *driver = g_key_file_get_string(kf, CACHE_GROUP, "driver", NULL);
+    gchar *cands = g_key_file_get_string(kf, CACHE_GROUP, "candidates", NULL);
+    ok = g_strcmp0(driver, driver_key) == 0 && g_strcmp0(cands, table->candidates) == 0;
+    g_free(driver);
+    g_free(cands);
+
+    for (guint i = 0; ok && i < G_N_ELEMENTS(candidates); i++)
+    {
+        gchar name[5];
+        gsize n = 0;
+
+        fourcc_name(candidates[i].fourcc, name);
+        gchar **mods = g_key_file_get_string_list(kf, name, "modifiers", &n, NULL);
+        gboolean gbm = g_key_file_get_boolean(kf, name, "gbm", NULL);
+        guint64 *values = g_new(guint64, n + 1);
+
+        for (gsize m = 0; m < n; m++)
+            values[m] = g_ascii_strtoull(mods[m], NULL, 16);
+
+        drm_format_table_set_device_modifiers(table, candidates[i].fourcc, values, n, gbm);
+        g_free(values);
+        g_strfreev(mods);
+    }
+
+done:
+    g_key_file_unref(kf);
+    return ok;
+}
+
+gchar *
+drm_format_table_default_cache_path(const gchar *drm_device)
+{
+    const gchar *env = g_getenv("GST_CUDA_DMABUF_FORMAT_CACHE");
+
+    if (env && *env)
+        return g_strdup(env);
+
+    gchar *node = g_path_get_basename(drm_device);
+    gchar *name = g_strdup_printf("drm-formats-%s.ini", node);
+    gchar *path = g_build_filename(g_get_user_cache_dir(), "gst-cuda-dmabuf", name, NULL);
+
+    g_free(name);
+    g_free(node);
+    return path;
+}
+
+/* ============================================================================
+ * Per-device tables
+ * ============================================================================ */
+
+/* Driver key → probed table. Tables are never freed: caps are built from
+ * them without holding a reference. */
+static GMutex device_tables_lock;
+static GHashTable *device_tables = NULL;
+
+static const DrmFormatTable *
+candidate_table(void)
+{
+    static DrmFormatTable *table = NULL;
+
+    if (g_once_init_enter(&table))
+        g_once_init_leave(&table, drm_format_table_new());
+    return table;
+}
+
+const DrmFormatTable *
+drm_format_table_get_default(void)
+{
+    return candidate_table();
+}
+
+const DrmFormatTable *
+drm_format_table_ensure_probed(const gchar *path, const gchar *driver_key,
+                               DrmFormatProbeFunc probe, gpointer user_data)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(driver_key != NULL, NULL);
+
+    DrmFormatTable *table;
+
+    /* Held across the probe so a device is probed by one caller only */
+    g_mutex_lock(&device_tables_lock);
+    if (!device_tables)
+        device_tables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    table = g_hash_table_lookup(device_tables, driver_key);
+    if (!table)
+    {
+        table = drm_format_table_new();
+
+        if (drm_format_table_load(table, path, driver_key))
+        {
+            g_debug("DRM format table loaded from %s", path);
+        }
+        else if (probe && probe(table, user_data))
+        {
+            GError *error = NULL;
+            if (!drm_format_table_save(table, path, driver_key, &error))
+            {
+                g_warning("Failed to cache DRM format table: %s", error->message);
+                g_clear_error(&error);
+            }
+        }
+        else
+        {
+            /* Not remembered: the next caller tries again */
+            drm_format_table_free(table);
+            table = NULL;
+        }
+
+        if (table)
+            g_hash_table_insert(device_tables, g_strdup(driver_key), table);
+    }
+    g_mutex_unlock(&device_tables_lock);
+
+    return table;
+}
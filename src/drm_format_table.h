@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * DRM Format Table
+ * The DRM formats and modifiers the element can output, with their plane
+ * count, bits per pixel and whether the device can allocate them. Starts
+ * as the built-in candidate list; once probed, modifiers the device does
+ * not report are marked unsupported. Each render node gets a table of
+ * its own; probe results are cached on disk per node, keyed by driver
+ * version, so later processes skip the probe.
+ */
+
+#ifndef __DRM_FORMAT_TABLE_H__
+#define __DRM_FORMAT_TABLE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Length of the longest drm-format string, "NV12:0x0300000000606010" */
+#define DRM_FORMAT_STRING_MAX 24
+
+typedef struct
+{
+    guint32 fourcc;   /* DRM fourcc (DRM_FORMAT_NV12, ...) */
+    guint64 modifier; /* DRM format modifier */
+    guint n_planes;   /* Memory planes */
+    guint bpp;        /* Bits per pixel, all planes */
+    gboolean gbm;     /* GBM can allocate the fourcc */
+    gboolean supported; /* Reported by the device (or not probed) */
+    gchar drm_format[DRM_FORMAT_STRING_MAX]; /* "FOURCC:0xMODIFIER" */
+} DrmFormatEntry;
+
+typedef struct _DrmFormatTable DrmFormatTable;
+
+/**
+ * Probe callback: report the device's modifiers per fourcc with
+ * drm_format_table_set_device_modifiers().
+ *
+ * @return FALSE if the device couldn't be queried (nothing is cached)
+ */
+typedef gboolean (*DrmFormatProbeFunc)(DrmFormatTable *table, gpointer user_data);
+
+/**
+ * Create a table holding the built-in candidates, all supported.
+ * Entries are ordered by preference within each fourcc.
+ */
+DrmFormatTable *drm_format_table_new(void);
+
+void drm_format_table_free(DrmFormatTable *table);
+
+guint drm_format_table_get_n_entries(const DrmFormatTable *table);
+
+const DrmFormatEntry *drm_format_table_get_entry(const DrmFormatTable *table, guint index);
+
+/**
+ * Find the entry of a drm-format string (e.g. "NV12:0x0300000000606010").
+ *
+ * @return The entry, or NULL if it isn't a candidate
+ */
+const DrmFormatEntry *drm_format_table_lookup(const DrmFormatTable *table,
+                                              const gchar *drm_format);
+
+/**
+ * Record what the device reported for @fourcc. Candidates not in
+ * @modifiers are marked unsupported, except LINEAR, which every output
+ * path allocates explicitly. An empty list means the device gave no
+ * answer for @fourcc and leaves its entries supported.
+ *
+ * @param table Table to update
+ * @param fourcc DRM fourcc
+ * @param modifiers Modifiers the device reported
+ * @param n_modifiers Number of @modifiers
+ * @param gbm Whether GBM can allocate @fourcc
+ */
+void drm_format_table_set_device_modifiers(DrmFormatTable *table, guint32 fourcc,
+                                           const guint64 *modifiers, guint n_modifiers,
+                                           gboolean gbm);
+
+/**
+ * Write the device columns of @table to @path (a key file), tagged with
+ * @driver_key. Missing parent directories are created.
+ */
+gboolean drm_format_table_save(const DrmFormatTable *table, const gchar *path,
+                               const gchar *driver_key, GError **error);
+
+/**
+ * Restore the device columns from a file written by
+ * drm_format_table_save().
+ *
+ * @return FALSE (leaving @table untouched) if the file is missing,
+ *         unreadable or was written for a different @driver_key
+ */
+gboolean drm_format_table_load(DrmFormatTable *table, const gchar *path,
+                               const gchar *driver_key);
+
+/**
+ * Cache file path of the render node @drm_device:
+ * $GST_CUDA_DMABUF_FORMAT_CACHE if set (one file for every device, each
+ * replacing the other's entry), otherwise drm-formats-<node>.ini under
+ * the user cache directory, e.g. drm-formats-renderD128.ini.
+ *
+ * @return Newly allocated path
+ */
+gchar *drm_format_table_default_cache_path(const gchar *drm_device);
+
+/**
+ * The built-in candidates, all supported: what a device that hasn't been
+ * probed is assumed to support. Never NULL; valid for the lifetime of the
+ * process.
+ */
+const DrmFormatTable *drm_format_table_get_default(void);
+
+/**
+ * The table of the device @driver_key identifies: from the cache file at
+ * @path when it matches @driver_key, otherwise by running @probe and
+ * caching the result. Each device is probed once per process; later calls
+ * return its table immediately.
+ *
+ * @param path Cache file of the device
+ * @param driver_key Device, driver identity and version the cache is valid for
+ * @param probe Device query, run on a cache miss
+ * @param user_data Passed to @probe
+ * @return The device's table, valid for the lifetime of the process, or
+ *         NULL if it couldn't be probed (tried again next call)
+ */
+const DrmFormatTable *drm_format_table_ensure_probed(const gchar *path,
+                                                     const gchar *driver_key,
+                                                     DrmFormatProbeFunc probe,
+                                                     gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __DRM_FORMAT_TABLE_H__ */
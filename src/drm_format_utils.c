@@ -6,6 +6,7 @@
  */
 
 #include "drm_format_utils.h"
+#include "drm_format_table.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -15,6 +16,12 @@ drm_format_parse_modifier(const gchar *drm_format)
     if (!drm_format)
         return DRM_FORMAT_MOD_INVALID;
 
+    /* Strings the element advertises are already parsed in the table */
+    const DrmFormatEntry *entry = drm_format_table_lookup(drm_format_table_get_default(),
+                                                          drm_format);
+    if (entry)
+        return entry->modifier;
+
     const gchar *colon = strchr(drm_format, ':');
     if (!colon)
         return DRM_FORMAT_MOD_INVALID;
@@ -34,6 +41,11 @@ drm_format_get_fourcc(const gchar *drm_format)
     if (!drm_format)
         return 0;
 
+    const DrmFormatEntry *entry = drm_format_table_lookup(drm_format_table_get_default(),
+                                                          drm_format);
+    if (entry)
+        return entry->fourcc;
+
     if (g_str_has_prefix(drm_format, "NV12"))
         return DRM_FORMAT_NV12;
     if (g_str_has_prefix(drm_format, "P010"))
@@ -46,6 +58,10 @@ drm_format_get_fourcc(const gchar *drm_format)
         return DRM_FORMAT_XBGR8888;
     if (g_str_has_prefix(drm_format, "AB24"))
         return DRM_FORMAT_ABGR8888;
+    if (g_str_has_prefix(drm_format, "XR30"))
+        return DRM_FORMAT_XRGB2101010;
+    if (g_str_has_prefix(drm_format, "AR30"))
+        return DRM_FORMAT_ARGB2101010;
 
     return 0;
 }
@@ -73,3 +89,10 @@ drm_format_is_xr24(const gchar *drm_format)
 {
     return drm_format && g_str_has_prefix(drm_format, "XR24");
 }
+
+gboolean
+drm_format_is_rgb10(const gchar *drm_format)
+{
+    return drm_format && (g_str_has_prefix(drm_format, "XR30") ||
+                          g_str_has_prefix(drm_format, "AR30"));
+}
@@ -49,6 +49,12 @@ gboolean drm_format_is_semi_planar_420(const gchar *drm_format);
  */
 gboolean drm_format_is_xr24(const gchar *drm_format);
 
+/**
+ * Check if a drm-format string represents a 2:10:10:10 RGB format
+ * (XR30 or AR30).
+ */
+gboolean drm_format_is_rgb10(const gchar *drm_format);
+
 G_END_DECLS
 
 #endif /* __DRM_FORMAT_UTILS_H__ */
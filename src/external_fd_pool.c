@@ -5,6 +5,8 @@
  */
 
 #include "external_fd_pool.h"
+#include "buffer_fence.h"
+#include "dmabuf_wrapper.h"
 #include <string.h>
 #include <unistd.h>
 
@@ -122,6 +124,19 @@ external_fd_buffer_import(ExternalFdBuffer *buf,
         return FALSE;
     }
 
+    /* Fence for deferred completion of copies into this buffer */
+    buf->fence = buffer_fence_new(buffer_fence_cuda_backend());
+    if (!buf->fence)
+    {
+        cuStreamDestroy(buf->cuda_stream);
+        buf->cuda_stream = NULL;
+        cuDestroyExternalMemory(buf->uv_ext_mem);
+        cuDestroyExternalMemory(buf->y_ext_mem);
+        buf->uv_ext_mem = NULL;
+        buf->y_ext_mem = NULL;
+        return FALSE;
+    }
+
     buf->initialized = TRUE;
     g_info("external_fd_buffer_import: Y fd=%d size=%zu stride=%u, UV fd=%d size=%zu stride=%u",
            y_fd, y_size, y_stride, uv_fd, uv_size, uv_stride);
@@ -134,6 +149,19 @@ void external_fd_buffer_release(ExternalFdBuffer *buf)
     if (!buf || !buf->initialized)
         return;
 
+    /* Closes our fd dups; a frame still downstream keeps its own */
+    if (buf->wrapper)
+    {
+        dmabuf_wrapper_free(buf->wrapper);
+        buf->wrapper = NULL;
+    }
+
+    if (buf->fence)
+    {
+        buffer_fence_unref(buf->fence);
+        buf->fence = NULL;
+    }
+
     if (buf->cuda_stream)
     {
         cuStreamSynchronize(buf->cuda_stream);
@@ -207,8 +235,10 @@ external_fd_pool_acquire(ExternalFdPool *pool)
 
     ExternalFdBuffer *buf = &pool->buffers[pool->current_index];
 
-    /* Sync on the stream to ensure any previous copy into this buffer is done */
-    if (buf->cuda_stream)
+    /* Wait for any previous copy into this buffer to complete */
+    if (buf->fence)
+        buffer_fence_wait(buf->fence);
+    else if (buf->cuda_stream)
         cuStreamSynchronize(buf->cuda_stream);
 
     pool->current_index = (pool->current_index + 1) % pool->count;
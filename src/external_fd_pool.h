@@ -50,6 +50,13 @@ typedef struct _ExternalFdBuffer
     /* CUDA stream for async copy operations */
     CUstream cuda_stream;
 
+    /* Completion fence recorded on cuda_stream after each copy */
+    struct _BufferFence *fence;
+
+    /* Prebuilt output GstBuffer (Y + UV memories, video meta), recycled
+     * every frame. Created lazily by the transform. */
+    struct _DmaBufWrapper *wrapper;
+
     gboolean initialized;
 } ExternalFdBuffer;
 
@@ -126,7 +133,7 @@ gboolean external_fd_pool_add(ExternalFdPool *pool,
 
 /**
  * Acquire the next buffer from the pool (round-robin).
- * Synchronizes on the buffer's CUDA stream first.
+ * Waits on the buffer's completion fence first.
  *
  * @return Pointer to the buffer, or NULL if pool is empty/uninitialized
  */
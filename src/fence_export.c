@@ -0,0 +1,247 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Fence Export - CUDA event to DMA-BUF implicit fence
+ */
+
+#include "fence_export.h"
+
+#include <EGL/eglext.h>
+#include <errno.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+
+/* EGL_NV_cuda_event, missing from older eglext.h */
+#ifndef EGL_CUDA_EVENT_HANDLE_NV
+#define EGL_CUDA_EVENT_HANDLE_NV 0x323B
+#endif
+#ifndef EGL_SYNC_CUDA_EVENT_NV
+#define EGL_SYNC_CUDA_EVENT_NV 0x323C
+#endif
+
+/* Linux 6.0 uAPI; older headers still build and fail at runtime (ENOTTY) */
+#ifndef DMA_BUF_IOCTL_IMPORT_SYNC_FILE
+struct dma_buf_import_sync_file
+{
+    __u32 flags;
+    __s32 fd;
+};
+#define DMA_BUF_IOCTL_IMPORT_SYNC_FILE _IOW(DMA_BUF_BASE, 3, struct dma_buf_import_sync_file)
+#endif
+
+typedef EGLSync (*CreateSyncFunc)(EGLDisplay dpy, EGLenum type, const EGLAttrib *attrib_list);
+typedef EGLBoolean (*DestroySyncFunc)(EGLDisplay dpy, EGLSync sync);
+typedef EGLBoolean (*WaitSyncFunc)(EGLDisplay dpy, EGLSync sync, EGLint flags);
+typedef EGLint (*ClientWaitSyncFunc)(EGLDisplay dpy, EGLSync sync, EGLint flags, EGLTime timeout);
+typedef EGLint (*DupNativeFenceFDFunc)(EGLDisplay dpy, EGLSync sync);
+
+struct _FenceExport
+{
+    EGLDisplay egl_display;
+
+    /* Surfaceless GLES context the CUDA event is waited on in, current
+     * on one thread at a time */
+    EGLContext egl_context;
+    GMutex lock;
+
+    CreateSyncFunc create_sync;
+    DestroySyncFunc destroy_sync;
+    WaitSyncFunc wait_sync;
+    ClientWaitSyncFunc client_wait_sync;
+    DupNativeFenceFDFunc dup_native_fence_fd;
+};
+
+static gboolean
+has_extension(EGLDisplay display, const gchar *name)
+{
+    const gchar *extensions = eglQueryString(display, EGL_EXTENSIONS);
+    gchar **list;
+    gboolean found;
+
+    if (!extensions)
+        return FALSE;
+
+    list = g_strsplit(extensions, " ", -1);
+    found = g_strv_contains((const gchar *const *)list, name);
+    g_strfreev(list);
+    return found;
+}
+
+FenceExport *
+fence_export_new(EGLDisplay egl_display)
+{
+    static const gchar *const required[] = {
+        "EGL_NV_cuda_event",
+        "EGL_KHR_wait_sync",
+        "EGL_ANDROID_native_fence_sync",
+        "EGL_KHR_no_config_context",
+        "EGL_KHR_surfaceless_context",
+    };
+    EGLint major = 0, minor = 0;
+
+    g_return_val_if_fail(egl_display != EGL_NO_DISPLAY, NULL);
+
+    /* EGL_CUDA_EVENT_HANDLE_NV is a pointer: needs the EGLAttrib entry
+     * points of EGL 1.5 */
+    if (!eglInitialize(egl_display, &major, &minor))
+        return NULL;
+    if (major < 1 || (major == 1 && minor < 5))
+    {
+        g_debug("Fence export needs EGL 1.5, display has %d.%d", major, minor);
+        return NULL;
+    }
+
+    for (guint i = 0; i < G_N_ELEMENTS(required); i++)
+    {
+        if (!has_extension(egl_display, required[i]))
+        {
+            g_debug("Fence export unavailable: no %s", required[i]);
+            return NULL;
+        }
+    }
+
+    FenceExport *exp = g_new0(FenceExport, 1);
+    exp->egl_display = egl_display;
+    exp->create_sync = (CreateSyncFunc)eglGetProcAddress("eglCreateSync");
+    exp->destroy_sync = (DestroySyncFunc)eglGetProcAddress("eglDestroySync");
+    exp->wait_sync = (WaitSyncFunc)eglGetProcAddress("eglWaitSync");
+    exp->client_wait_sync = (ClientWaitSyncFunc)eglGetProcAddress("eglClientWaitSync");
+    exp->dup_native_fence_fd =
+        (DupNativeFenceFDFunc)eglGetProcAddress("eglDupNativeFenceFDANDROID");
+
+    if (!exp->create_sync || !exp->destroy_sync || !exp->wait_sync ||
+        !exp->client_wait_sync || !exp->dup_native_fence_fd)
+    {
+        g_debug("Fence export unavailable: missing EGL entry points");
+        g_free(exp);
+        return NULL;
+    }
+
+    /* eglBindAPI is per thread: restore the caller's API */
+    static const EGLint context_attribs[] = {EGL_CONTEXT_MAJOR_VERSION, 2, EGL_NONE};
+    EGLenum api = eglQueryAPI();
+    eglBindAPI(EGL_OPENGL_ES_API);
+    exp->egl_context = eglCreateContext(egl_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                        context_attribs);
+    eglBindAPI(api);
+
+    if (exp->egl_context == EGL_NO_CONTEXT)
+    {
+        g_warning("Failed to create the fence export context: 0x%x", eglGetError());
+        g_free(exp);
+        return NULL;
+    }
+
+    g_mutex_init(&exp->lock);
+    return exp;
+}
+
+void fence_export_free(FenceExport *exp)
+{
+    if (!exp)
+        return;
+
+    eglDestroyContext(exp->egl_display, exp->egl_context);
+    g_mutex_clear(&exp->lock);
+    g_free(exp);
+}
+
+int fence_export_sync_file(FenceExport *exp, CUevent event)
+{
+    g_return_val_if_fail(exp != NULL, -1);
+
+    const EGLAttrib event_attribs[] = {
+        EGL_CUDA_EVENT_HANDLE_NV, (EGLAttrib)event,
+        EGL_NONE};
+    EGLSync cuda_sync = EGL_NO_SYNC;
+    EGLSync native_sync = EGL_NO_SYNC;
+    int fd = -1;
+
+    g_mutex_lock(&exp->lock);
+
+    /* The streaming thread may have a context of its own current */
+    EGLDisplay prev_display = eglGetCurrentDisplay();
+    EGLContext prev_context = eglGetCurrentContext();
+    EGLSurface prev_draw = eglGetCurrentSurface(EGL_DRAW);
+    EGLSurface prev_read = eglGetCurrentSurface(EGL_READ);
+    EGLenum prev_api = eglQueryAPI();
+
+    eglBindAPI(EGL_OPENGL_ES_API);
+    if (!eglMakeCurrent(exp->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, exp->egl_context))
+    {
+        g_warning("Failed to make the fence export context current: 0x%x", eglGetError());
+        goto out;
+    }
+
+    cuda_sync = exp->create_sync(exp->egl_display, EGL_SYNC_CUDA_EVENT_NV, event_attribs);
+    if (cuda_sync == EGL_NO_SYNC)
+    {
+        g_warning("Failed to wrap the CUDA event in an EGL sync: 0x%x", eglGetError());
+        goto release;
+    }
+
+    /* Server-side wait: the context's queue stalls until the event fires,
+     * the native fence queued after it signals once that's passed */
+    if (!exp->wait_sync(exp->egl_display, cuda_sync, 0))
+    {
+        g_warning("eglWaitSync failed: 0x%x", eglGetError());
+        goto release;
+    }
+
+    native_sync = exp->create_sync(exp->egl_display, EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+    if (native_sync == EGL_NO_SYNC)
+    {
+        g_warning("Failed to create a native fence: 0x%x", eglGetError());
+        goto release;
+    }
+
+    /* The fd only exists once the fence has been flushed to the GPU */
+    exp->client_wait_sync(exp->egl_display, native_sync, EGL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    fd = exp->dup_native_fence_fd(exp->egl_display, native_sync);
+    if (fd == EGL_NO_NATIVE_FENCE_FD_ANDROID)
+    {
+        g_warning("eglDupNativeFenceFDANDROID failed: 0x%x", eglGetError());
+        fd = -1;
+    }
+
+release:
+    if (native_sync != EGL_NO_SYNC)
+        exp->destroy_sync(exp->egl_display, native_sync);
+    if (cuda_sync != EGL_NO_SYNC)
+        exp->destroy_sync(exp->egl_display, cuda_sync);
+
+    if (prev_context != EGL_NO_CONTEXT)
+    {
+        eglBindAPI(prev_api);
+        eglMakeCurrent(prev_display, prev_draw, prev_read, prev_context);
+    }
+    else
+    {
+        eglMakeCurrent(exp->egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+out:
+    eglBindAPI(prev_api);
+    g_mutex_unlock(&exp->lock);
+    return fd;
+}
+
+gboolean
+fence_export_attach(int dmabuf_fd, int sync_file)
+{
+    struct dma_buf_import_sync_file arg = {
+        .flags = DMA_BUF_SYNC_WRITE,
+        .fd = sync_file,
+    };
+
+    g_return_val_if_fail(dmabuf_fd >= 0 && sync_file >= 0, FALSE);
+
+    while (ioctl(dmabuf_fd, DMA_BUF_IOCTL_IMPORT_SYNC_FILE, &arg) < 0)
+    {
+        if (errno == EINTR || errno == EAGAIN)
+            continue;
+        g_debug("DMA_BUF_IOCTL_IMPORT_SYNC_FILE failed: %s", g_strerror(errno));
+        return FALSE;
+    }
+    return TRUE;
+}
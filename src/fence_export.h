@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Fence Export
+ * Turns CUDA events into sync_files attached to DMA-BUFs
+ *
+ * With deferred sync the copy into an output DMA-BUF may still be running
+ * when the buffer is pushed. Rather than waiting on the CPU, the CUDA event
+ * is converted into a sync_file through EGL (EGL_NV_cuda_event, waited on
+ * by a private GLES context and followed by an EGL_ANDROID_native_fence_sync
+ * fence) and added to the DMA-BUF's implicit fences with
+ * DMA_BUF_IOCTL_IMPORT_SYNC_FILE. Importers honouring implicit sync (GL,
+ * Vulkan, KMS) then wait for the copy on the GPU.
+ */
+
+#ifndef __FENCE_EXPORT_H__
+#define __FENCE_EXPORT_H__
+
+#include <glib.h>
+#include <EGL/egl.h>
+#include <cuda.h>
+
+G_BEGIN_DECLS
+
+typedef struct _FenceExport FenceExport;
+
+/**
+ * Create an exporter on an initialized EGL display.
+ *
+ * @return The exporter, or NULL if the display lacks one of the required
+ *         extensions (callers then wait on the CPU)
+ */
+FenceExport *fence_export_new(EGLDisplay egl_display);
+
+void fence_export_free(FenceExport *exp);
+
+/**
+ * Create a sync_file that signals once @event has completed. The event
+ * must have been recorded; the current CUDA context must own it.
+ *
+ * @return The sync_file fd (owned by the caller), or -1 on failure
+ */
+int fence_export_sync_file(FenceExport *exp, CUevent event);
+
+/**
+ * Add @sync_file to the write fences of @dmabuf_fd, so implicitly synced
+ * importers wait for it. @sync_file is not consumed.
+ *
+ * @return FALSE if the kernel doesn't support it (before Linux 6.0)
+ */
+gboolean fence_export_attach(int dmabuf_fd, int sync_file);
+
+G_END_DECLS
+
+#endif /* __FENCE_EXPORT_H__ */
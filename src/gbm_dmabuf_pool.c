@@ -5,62 +5,68 @@
 #define _GNU_SOURCE
 
 #include "gbm_dmabuf_pool.h"
+#include "block_linear.h"
+#include "render_node.h"
 
 #include <gst/allocators/gstdmabuf.h>
 #include <drm/drm_fourcc.h>
 #include <gbm.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
-#include <dirent.h>
-#include <limits.h>
-#include <xf86drm.h>
 
 G_DEFINE_TYPE(GstGbmDmaBufPool, gst_gbm_dmabuf_pool, GST_TYPE_BUFFER_POOL)
 
-/* Find an NVIDIA render node dynamically */
-static int
-find_nvidia_render_node(void)
+/* CPU mapping of a BO, made once at allocation and kept for the buffer's
+ * lifetime so per-frame CPU access costs no mmap/munmap or page faults */
+typedef struct
 {
-    DIR *dir = opendir("/dev/dri");
-    if (!dir)
-        return -1;
+    int fd;
+    guint8 *data;
+    gsize size;
+} GbmMapping;
 
-    struct dirent *entry;
-    int fd = -1;
+static GQuark
+gbm_mapping_quark(void)
+{
+    return g_quark_from_static_string("gbm-mapping");
+}
 
-    while ((entry = readdir(dir)) != NULL)
-    {
-        /* Only look at render nodes (renderD*) */
-        if (strncmp(entry->d_name, "renderD", 7) != 0)
-            continue;
+static void
+gbm_mapping_free(GbmMapping *m)
+{
+    munmap(m->data, m->size);
+    g_free(m);
+}
 
-        char path[PATH_MAX];
-        snprintf(path, sizeof(path), "/dev/dri/%s", entry->d_name);
+static gboolean
+gbm_mapping_sync(GbmMapping *m, guint64 flags)
+{
+    struct dma_buf_sync sync = {.flags = flags};
+    int ret;
 
-        int test_fd = open(path, O_RDWR | O_CLOEXEC);
-        if (test_fd < 0)
-            continue;
+    do
+        ret = ioctl(m->fd, DMA_BUF_IOCTL_SYNC, &sync);
+    while (ret < 0 && (errno == EINTR || errno == EAGAIN));
 
-        drmVersionPtr version = drmGetVersion(test_fd);
-        if (version)
-        {
-            /* Check if this is an NVIDIA device */
-            if (version->name && strcmp(version->name, "nvidia-drm") == 0)
-            {
-                drmFreeVersion(version);
-                fd = test_fd;
-                break;
-            }
-            drmFreeVersion(version);
-        }
-        close(test_fd);
-    }
+    return ret == 0;
+}
 
-    closedir(dir);
-    return fd;
+static guint64
+gbm_mapping_sync_flags(GstMapFlags flags)
+{
+    guint64 rw = 0;
+    if (flags & GST_MAP_READ)
+        rw |= DMA_BUF_SYNC_READ;
+    if (flags & GST_MAP_WRITE)
+        rw |= DMA_BUF_SYNC_WRITE;
+    return rw;
 }
 
 static gboolean
@@ -68,17 +74,14 @@ gst_gbm_dmabuf_pool_start(GstBufferPool *pool)
 {
     GstGbmDmaBufPool *p = (GstGbmDmaBufPool *)pool;
 
-    /* Dynamically find the NVIDIA render node */
-    p->drm_fd = find_nvidia_render_node();
-    if (p->drm_fd < 0)
+    /* The GBM device is shared with the element instances on the node */
+    p->device = cuda_egl_device_acquire(p->drm_device);
+    if (!p->device)
     {
-        GST_ERROR_OBJECT(pool, "Failed to find NVIDIA render node");
+        GST_ERROR_OBJECT(pool, "Failed to open %s", p->drm_device);
         return FALSE;
     }
-
-    p->gbm = gbm_create_device(p->drm_fd);
-    if (!p->gbm)
-        return FALSE;
+    p->gbm = p->device->gbm;
 
     p->dmabuf_alloc = gst_dmabuf_allocator_new();
     return TRUE;
@@ -94,31 +97,29 @@ gst_gbm_dmabuf_pool_stop(GstBufferPool *pool)
         gst_object_unref(p->dmabuf_alloc);
         p->dmabuf_alloc = NULL;
     }
-    if (p->gbm)
+    if (p->device)
     {
-        gbm_device_destroy(p->gbm);
+        cuda_egl_device_release(p->device);
+        p->device = NULL;
         p->gbm = NULL;
     }
-    if (p->drm_fd >= 0)
-    {
-        close(p->drm_fd);
-        p->drm_fd = -1;
-    }
     return TRUE;
 }
 
-/* Called by pool when it needs a new buffer */
-static GstFlowReturn
-gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
-                                 GstBuffer **buffer,
-                                 GstBufferPoolAcquireParams *params)
+/* A BO for the pool's format on @gbm, with the requested modifier or
+ * LINEAR. The modifier it got is returned in @modifier; the pool itself
+ * is left untouched. */
+static struct gbm_bo *
+gst_gbm_dmabuf_pool_create_bo(GstGbmDmaBufPool *p, struct gbm_device *gbm, guint64 *modifier)
 {
-    GstGbmDmaBufPool *p = (GstGbmDmaBufPool *)pool;
-    (void)params;
-
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&p->info);
+    gboolean semi_planar = p->gbm_format == GBM_FORMAT_NV12;
     guint width = GST_VIDEO_INFO_WIDTH(&p->info);
     guint height = GST_VIDEO_INFO_HEIGHT(&p->info);
 
+    /* NV12 at width*2 has the same byte layout as P010 at width */
+    guint alloc_width = format == GST_VIDEO_FORMAT_P010_10LE ? width * 2 : width;
+
     struct gbm_bo *bo = NULL;
 
     /* Try to create with the requested modifier first (for zero-copy scanout) */
@@ -126,8 +127,8 @@ gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
     {
         uint64_t modifiers[] = {p->modifier};
         bo = gbm_bo_create_with_modifiers(
-            p->gbm,
-            width,
+            gbm,
+            alloc_width,
             height,
             p->gbm_format,
             modifiers,
@@ -135,6 +136,7 @@ gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
 
         if (bo)
         {
+            *modifier = p->modifier;
             g_print("GBM: Created buffer with modifier 0x%016lx\n", p->modifier);
         }
         else
@@ -143,28 +145,129 @@ gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
         }
     }
 
+    /* Semi-planar formats: explicit LINEAR modifier first, the
+     * GBM_BO_USE_LINEAR flag is not honoured for NV12 by every driver */
+    if (!bo && semi_planar)
+    {
+        uint64_t linear_mod[] = {DRM_FORMAT_MOD_LINEAR};
+        bo = gbm_bo_create_with_modifiers(gbm, alloc_width, height,
+                                          p->gbm_format, linear_mod, 1);
+        if (bo)
+            *modifier = DRM_FORMAT_MOD_LINEAR;
+    }
+
     /* Fallback to LINEAR if tiled creation failed or not requested */
     if (!bo)
     {
         bo = gbm_bo_create(
-            p->gbm,
-            width,
+            gbm,
+            alloc_width,
             height,
             p->gbm_format,
             GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR);
 
         if (bo)
         {
-            p->modifier = DRM_FORMAT_MOD_LINEAR;
+            *modifier = DRM_FORMAT_MOD_LINEAR;
             g_print("GBM: Created LINEAR buffer\n");
         }
     }
 
+    return bo;
+}
+
+static guint
+gst_gbm_dmabuf_pool_n_planes(GstGbmDmaBufPool *p)
+{
+    return p->gbm_format == GBM_FORMAT_NV12 ? 2 : 1;
+}
+
+/* Every BO of the pool has the same size and format, so the same layout */
+static void
+gst_gbm_dmabuf_pool_store_layout(GstGbmDmaBufPool *p, struct gbm_bo *bo)
+{
+    for (guint i = 0; i < gst_gbm_dmabuf_pool_n_planes(p); i++)
+    {
+        p->strides[i] = gbm_bo_get_stride_for_plane(bo, i);
+        p->offsets[i] = gbm_bo_get_offset(bo, i);
+    }
+    p->layout_known = TRUE;
+}
+
+/* Without GST_BUFFER_POOL_OPTION_VIDEO_META the producer writes the
+ * default layout of the caps: the BOs must have that layout too. Only
+ * the first call before any allocation creates a BO to find out. */
+static gboolean
+gst_gbm_dmabuf_pool_has_default_layout(GstGbmDmaBufPool *p)
+{
+    if (!p->layout_known)
+    {
+        CudaEglDevice *device = cuda_egl_device_acquire(p->drm_device);
+        if (!device)
+            return FALSE;
+
+        guint64 modifier;
+        struct gbm_bo *bo = gst_gbm_dmabuf_pool_create_bo(p, device->gbm, &modifier);
+        if (bo)
+        {
+            gst_gbm_dmabuf_pool_store_layout(p, bo);
+            gbm_bo_destroy(bo);
+        }
+        cuda_egl_device_release(device);
+
+        if (!p->layout_known)
+            return FALSE;
+    }
+
+    for (guint i = 0; i < gst_gbm_dmabuf_pool_n_planes(p); i++)
+    {
+        if (p->strides[i] != (guint32)GST_VIDEO_INFO_PLANE_STRIDE(&p->info, i) ||
+            p->offsets[i] != (guint32)GST_VIDEO_INFO_PLANE_OFFSET(&p->info, i))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+gst_gbm_dmabuf_pool_set_config(GstBufferPool *pool, GstStructure *config)
+{
+    GstGbmDmaBufPool *p = (GstGbmDmaBufPool *)pool;
+
+    /* A producer ignoring the meta would write with the wrong stride, and
+     * the buffer may then be passed downstream as is */
+    if (!gst_buffer_pool_config_has_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META) &&
+        !gst_gbm_dmabuf_pool_has_default_layout(p))
+    {
+        GST_WARNING_OBJECT(pool, "GBM strides differ from the default layout, video meta required");
+        return FALSE;
+    }
+
+    return GST_BUFFER_POOL_CLASS(gst_gbm_dmabuf_pool_parent_class)->set_config(pool, config);
+}
+
+static GstFlowReturn
+gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
+                                 GstBuffer **buffer,
+                                 GstBufferPoolAcquireParams *params)
+{
+    GstGbmDmaBufPool *p = (GstGbmDmaBufPool *)pool;
+    (void)params;
+
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&p->info);
+    gboolean semi_planar = p->gbm_format == GBM_FORMAT_NV12;
+    guint width = GST_VIDEO_INFO_WIDTH(&p->info);
+    guint height = GST_VIDEO_INFO_HEIGHT(&p->info);
+
+    guint64 modifier;
+    struct gbm_bo *bo = gst_gbm_dmabuf_pool_create_bo(p, p->gbm, &modifier);
     if (!bo)
     {
         GST_ERROR_OBJECT(pool, "Failed to create GBM buffer object");
         return GST_FLOW_ERROR;
     }
+    p->modifier = modifier;
+    if (!p->layout_known)
+        gst_gbm_dmabuf_pool_store_layout(p, bo);
 
     int fd = gbm_bo_get_fd(bo);
     if (fd < 0)
@@ -173,28 +276,67 @@ gst_gbm_dmabuf_pool_alloc_buffer(GstBufferPool *pool,
         return GST_FLOW_ERROR;
     }
 
-    guint stride = gbm_bo_get_stride(bo);
-    gsize size = (gsize)stride * (gsize)height;
+    guint n_planes = gst_gbm_dmabuf_pool_n_planes(p);
+    const guint32 *strides = p->strides;
+    const guint32 *offsets = p->offsets;
+
+    gsize size = semi_planar
+                     ? offsets[1] + (gsize)strides[1] * ((height + 1) / 2)
+                     : (gsize)strides[0] * (gsize)height;
 
-    g_print("GBM ALLOC: %ux%u, gbm_stride=%u, size=%zu\n", width, height, stride, size);
+    g_print("GBM ALLOC: %ux%u, gbm_stride=%u, size=%zu\n", width, height, strides[0], size);
 
-    GstMemory *mem = gst_dmabuf_allocator_alloc(p->dmabuf_alloc, fd, size);
+    /* Keep any gst_buffer_map() mapping too (e.g. an upstream producer
+     * writing into a proposed pool) instead of remapping every frame */
+    GstMemory *mem = gst_dmabuf_allocator_alloc_with_flags(p->dmabuf_alloc, fd, size,
+                                                           GST_FD_MEMORY_FLAG_KEEP_MAPPED);
 
     GstBuffer *buf = gst_buffer_new();
     gst_buffer_append_memory(buf, mem);
 
-    /* Add video meta with actual BGRx format for proper stride/offset handling.
-     * DMA_DRM is a caps-level concept; video meta needs the real pixel format. */
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data != MAP_FAILED)
+    {
+        GbmMapping *m = g_new0(GbmMapping, 1);
+        m->fd = fd;
+        m->data = data;
+        m->size = size;
+        gst_mini_object_set_qdata(GST_MINI_OBJECT(buf), gbm_mapping_quark(), m,
+                                  (GDestroyNotify)gbm_mapping_free);
+    }
+    else
+    {
+        GST_WARNING_OBJECT(pool, "Persistent mmap failed (%s), mapping per access",
+                           g_strerror(errno));
+    }
+
+    /* Add video meta with the actual pixel format for proper stride/offset
+     * handling. DMA_DRM is a caps-level concept; video meta needs the real
+     * pixel format. */
+    GstVideoFormat meta_format;
+    if (semi_planar)
+        meta_format = format;
+    else if (p->gbm_format == GBM_FORMAT_ARGB2101010)
+        meta_format = GST_VIDEO_FORMAT_BGR10A2_LE;
+    else
+        meta_format = GST_VIDEO_FORMAT_BGRx;
+
     GstVideoMeta *vmeta = gst_buffer_add_video_meta(
         buf,
         GST_VIDEO_FRAME_FLAG_NONE,
-        GST_VIDEO_FORMAT_BGRx,
+        meta_format,
         width,
         height);
 
-    vmeta->n_planes = 1;
-    vmeta->stride[0] = stride;
-    vmeta->offset[0] = 0;
+    vmeta->n_planes = n_planes;
+    for (guint i = 0; i < n_planes; i++)
+    {
+        vmeta->stride[i] = strides[i];
+        vmeta->offset[i] = offsets[i];
+    }
+
+    /* CPU maps of block-linear buffers see linear planes */
+    block_linear_install_video_meta_map(vmeta, p->modifier);
 
     /* ensure GBM BO lifetime matches GstBuffer */
     GQuark q = g_quark_from_static_string("gbm-bo");
@@ -219,12 +361,26 @@ gst_gbm_dmabuf_pool_get_options(GstBufferPool *pool)
     return (const gchar **)pool_options;
 }
 
+static void
+gst_gbm_dmabuf_pool_finalize(GObject *object)
+{
+    GstGbmDmaBufPool *p = (GstGbmDmaBufPool *)object;
+
+    g_free(p->drm_device);
+
+    G_OBJECT_CLASS(gst_gbm_dmabuf_pool_parent_class)->finalize(object);
+}
+
 static void
 gst_gbm_dmabuf_pool_class_init(GstGbmDmaBufPoolClass *klass)
 {
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
     GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+    gobject_class->finalize = gst_gbm_dmabuf_pool_finalize;
     pool_class->start = gst_gbm_dmabuf_pool_start;
     pool_class->stop = gst_gbm_dmabuf_pool_stop;
+    pool_class->set_config = gst_gbm_dmabuf_pool_set_config;
     pool_class->alloc_buffer = gst_gbm_dmabuf_pool_alloc_buffer;
     pool_class->get_options = gst_gbm_dmabuf_pool_get_options;
 }
@@ -232,7 +388,7 @@ gst_gbm_dmabuf_pool_class_init(GstGbmDmaBufPoolClass *klass)
 static void
 gst_gbm_dmabuf_pool_init(GstGbmDmaBufPool *p)
 {
-    p->drm_fd = -1;
+    p->device = NULL;
     p->gbm = NULL;
     p->dmabuf_alloc = NULL;
     p->gbm_format = GBM_FORMAT_XRGB8888;
@@ -240,11 +396,27 @@ gst_gbm_dmabuf_pool_init(GstGbmDmaBufPool *p)
 }
 
 GstBufferPool *
-gst_gbm_dmabuf_pool_new(const GstVideoInfo *info, guint64 modifier)
+gst_gbm_dmabuf_pool_new(const GstVideoInfo *info, guint64 modifier, const gchar *drm_device)
 {
     GstGbmDmaBufPool *p = g_object_new(GST_TYPE_GBM_DMABUF_POOL, NULL);
     p->info = *info;
     p->modifier = modifier;
+    p->drm_device = g_strdup(drm_device ? drm_device : render_node_find(NULL));
+
+    /* 2:10:10:10 for XR30/AR30 output, NV12 planes for system-memory
+     * NV12/P010 uploads, XRGB8888 for everything else */
+    switch (GST_VIDEO_INFO_FORMAT(info))
+    {
+    case GST_VIDEO_FORMAT_BGR10A2_LE:
+        p->gbm_format = GBM_FORMAT_ARGB2101010;
+        break;
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_P010_10LE:
+        p->gbm_format = GBM_FORMAT_NV12;
+        break;
+    default:
+        break;
+    }
     return GST_BUFFER_POOL(p);
 }
 
@@ -253,3 +425,45 @@ gst_gbm_dmabuf_pool_get_modifier(GstGbmDmaBufPool *pool)
 {
     return pool->modifier;
 }
+
+gboolean
+gst_gbm_dmabuf_pool_begin_cpu_access(GstBuffer *buffer, GstMapFlags flags,
+                                     GstGbmCpuAccess *access)
+{
+    memset(access, 0, sizeof(*access));
+    access->buffer = buffer;
+    access->flags = flags;
+
+    access->mapping = gst_mini_object_get_qdata(GST_MINI_OBJECT(buffer), gbm_mapping_quark());
+    if (access->mapping)
+    {
+        GbmMapping *m = access->mapping;
+        if (!gbm_mapping_sync(m, DMA_BUF_SYNC_START | gbm_mapping_sync_flags(flags)))
+            GST_WARNING("DMA_BUF_IOCTL_SYNC start failed: %s", g_strerror(errno));
+        access->data = m->data;
+        access->size = m->size;
+        return TRUE;
+    }
+
+    /* Not one of ours (or the persistent mmap failed) */
+    if (!gst_buffer_map(buffer, &access->map, flags))
+        return FALSE;
+    access->data = access->map.data;
+    access->size = access->map.size;
+    return TRUE;
+}
+
+void gst_gbm_dmabuf_pool_end_cpu_access(GstGbmCpuAccess *access)
+{
+    if (access->mapping)
+    {
+        if (!gbm_mapping_sync(access->mapping,
+                              DMA_BUF_SYNC_END | gbm_mapping_sync_flags(access->flags)))
+            GST_WARNING("DMA_BUF_IOCTL_SYNC end failed: %s", g_strerror(errno));
+    }
+    else if (access->data)
+    {
+        gst_buffer_unmap(access->buffer, &access->map);
+    }
+    access->data = NULL;
+}
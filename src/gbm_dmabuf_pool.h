@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "cuda_egl_interop.h"
+
 #include <gst/gst.h>
 #include <gst/video/video.h>
 
@@ -19,14 +21,41 @@ struct _GstGbmDmaBufPool
 {
     GstBufferPool parent;
     GstVideoInfo info;
-    int drm_fd;
+    gchar *drm_device;     /* Render node the buffers are allocated on */
+    CudaEglDevice *device; /* Shared, held while the pool is active */
     struct gbm_device *gbm;
     GstAllocator *dmabuf_alloc;
     guint32 gbm_format;
     guint64 modifier; /* DRM modifier actually used */
+
+    /* Plane layout of the BOs, from the first one created */
+    gboolean layout_known;
+    guint32 strides[2];
+    guint32 offsets[2];
 };
 
-GstBufferPool *gst_gbm_dmabuf_pool_new(const GstVideoInfo *info, guint64 modifier);
+/* @drm_device is the render node to allocate on, NULL for the NVIDIA one */
+GstBufferPool *gst_gbm_dmabuf_pool_new(const GstVideoInfo *info, guint64 modifier,
+                                       const gchar *drm_device);
 guint64 gst_gbm_dmabuf_pool_get_modifier(GstGbmDmaBufPool *pool);
 
+/* CPU access to a buffer. Pool buffers use the BO's persistent mapping,
+ * bracketed with DMA_BUF_IOCTL_SYNC start/end; other buffers fall back to
+ * gst_buffer_map(). */
+typedef struct
+{
+    GstBuffer *buffer;
+    GstMapFlags flags;
+    guint8 *data;
+    gsize size;
+
+    /* private */
+    gpointer mapping;
+    GstMapInfo map;
+} GstGbmCpuAccess;
+
+gboolean gst_gbm_dmabuf_pool_begin_cpu_access(GstBuffer *buffer, GstMapFlags flags,
+                                              GstGbmCpuAccess *access);
+void gst_gbm_dmabuf_pool_end_cpu_access(GstGbmCpuAccess *access);
+
 G_END_DECLS
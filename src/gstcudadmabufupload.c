@@ -4,17 +4,27 @@
  * GStreamer CUDA DMA-BUF Upload Element
  *
  * Converts CUDA NV12 video to DMA-BUF for zero-copy compositor display.
- * Supports NV12 passthrough (preferred) and NV12→BGRx conversion paths.
+ * Supports NV12/P010 passthrough (preferred) and NV12/P010→RGB conversion paths,
+ * optionally scaled/letterboxed to a different output size in the same pass.
  */
 
 #include "gstcudadmabufupload.h"
 #include "gbm_dmabuf_pool.h"
 #include "cuda_egl_interop.h"
 #include "pooled_buffers.h"
+#include "colorimetry.h"
 #include "drm_format_utils.h"
 #include "caps_transform.h"
+#include "caps_cache.h"
+#include "drm_format_table.h"
+#include "modifier_ranking.h"
+#include "render_node.h"
 #include "buffer_transform.h"
 #include "external_fd_pool.h"
+#include "buffer_fence.h"
+#include "fence_export.h"
+#include "cpu_convert.h"
+#include "worker_pool.h"
 
 #define GST_USE_UNSTABLE_API
 #include <gst/video/video.h>
@@ -23,27 +33,85 @@
 #include <drm/drm_fourcc.h>
 #include <gbm.h>
 #include <string.h>
-
-/* Pool size for pre-allocated semi-planar buffers - larger for smoother playback */
-#define SEMI_PLANAR_POOL_SIZE 8
+#include <unistd.h>
 
 /* Property IDs */
 enum
 {
     PROP_0,
     PROP_FORCE_LINEAR,
+    PROP_DEFERRED_SYNC,
+    PROP_CONSUMER_SYNCS,
+    PROP_CUDA_EXPORT,
+    PROP_STATS,
+    PROP_SCALE_METHOD,
+    PROP_ADD_BORDERS,
+    PROP_BORDER_COLOR,
+    PROP_CPU_FALLBACK,
+    PROP_CALIBRATE_MODIFIERS,
+    PROP_MIN_BUFFERS,
+    PROP_MAX_BUFFERS,
+    PROP_ALLOCATION_MODE,
+    PROP_POOL_MAX_WIDTH,
+    PROP_POOL_MAX_HEIGHT,
+    PROP_OPEN_ON_START,
+    PROP_ASYNC_SETUP,
+    PROP_RENDER_NODE,
 };
 
+/* How the CUDA-EGL pool sizes its buffers */
+typedef enum
+{
+    ALLOCATION_MODE_EXACT = 0,    /* The negotiated output size; new pool per size */
+    ALLOCATION_MODE_MAX_SIZE = 1, /* The largest size seen; smaller sizes reuse it */
+} AllocationMode;
+
+#define DEFAULT_SCALE_METHOD SCALE_METHOD_BILINEAR
+#define DEFAULT_ADD_BORDERS FALSE
+#define DEFAULT_BORDER_COLOR 0xff000000u
+#define DEFAULT_MIN_BUFFERS POOLED_BUFFER_POOL_DEFAULT_MIN_BUFFERS
+#define DEFAULT_MAX_BUFFERS POOLED_BUFFER_POOL_DEFAULT_MAX_BUFFERS
+#define DEFAULT_ALLOCATION_MODE ALLOCATION_MODE_EXACT
+
+/* transform_caps results kept per element: both directions for a few
+ * upstream/downstream caps variants */
+#define CAPS_CACHE_SIZE 16
+
 /* Signal IDs */
 enum
 {
     SIGNAL_INIT_EXTERNAL_POOL,
     SIGNAL_ADD_EXTERNAL_BUFFER,
+    SIGNAL_SYNC_BUFFER,
     LAST_SIGNAL,
 };
 
 static guint signals[LAST_SIGNAL] = {0};
 
+/* Frames per output path, exposed through the "stats" property */
+typedef struct
+{
+    guint64 export_frames;   /* Decoder memory exported as-is */
+    guint64 copy_frames;     /* Copied into the CUDA-EGL pool */
+    guint64 external_frames; /* Copied into Vulkan-exported buffers */
+    guint64 convert_frames;  /* Converted to BGRx/XR30 */
+    guint64 system_frames;   /* System-memory upload (BGRx copy or NV12/I420/P010 plane copy) */
+    guint64 cpu_frames;      /* Converted on the CPU (GPU path unavailable) */
+    guint64 upstream_frames; /* Written by upstream into our proposed DMA-BUF pool */
+} UploadStats;
+
+/* Setup latency per phase, in microseconds, exposed through the "stats"
+ * property */
+typedef struct
+{
+    guint64 context_usec;     /* DRM device, EGL display and cuInit */
+    guint64 probe_usec;       /* DRM format table probe (or cache read) */
+    guint64 pool_usec;        /* Latest CUDA-EGL pool build */
+    guint64 wait_usec;        /* First frame waiting for the setup thread */
+    guint64 first_frame_usec; /* First caps to first output buffer */
+    gint64 caps_time;         /* Monotonic time of the first caps, 0 before */
+} StartupTimes;
+
 /* Private data structure */
 struct _GstCudaDmabufUpload
 {
@@ -57,10 +125,16 @@ struct _GstCudaDmabufUpload
     guint64 negotiated_modifier;
     gboolean semi_planar_output; /* TRUE for NV12 or P010 passthrough */
     gboolean p010_output;        /* TRUE when output is P010 (10-bit) */
+    gboolean rgb10_output;       /* TRUE when converting to XR30/AR30 */
+
+    /* Negotiated output size (differs from cuda_info when scaling) */
+    gint out_width;
+    gint out_height;
 
     /* GStreamer pools */
     GstBufferPool *pool;
     GstBufferPool *cuda_pool;
+    GstBufferPool *upstream_pool; /* GBM pool proposed for system-memory input */
     GstCudaContext *cuda_ctx;
 
     /* Flags */
@@ -68,27 +142,146 @@ struct _GstCudaDmabufUpload
 
     /* Properties */
     gboolean force_linear;
+    gboolean deferred_sync;
+    gboolean consumer_syncs; /* Downstream waits on the fences itself */
+    gboolean cuda_export;
+    ScaleMethod scale_method;
+    gboolean add_borders;
+    guint border_color;
+    gboolean cpu_fallback;
+    gboolean calibrate_modifiers;
+    guint min_buffers; /* Output pool bounds, protected by the object lock */
+    guint max_buffers;
+    AllocationMode allocation_mode; /* Also protected by the object lock */
+    guint pool_max_width;
+    guint pool_max_height;
+
+    /* Largest output size negotiated so far (object lock) */
+    guint seen_width;
+    guint seen_height;
+
+    /* Recent transform_caps results */
+    CapsCache *caps_cache;
+
+    /* Downstream understands GstVideoMeta (from decide_allocation) */
+    gboolean downstream_video_meta;
+
+    /* Protected by the object lock */
+    UploadStats stats;
+    StartupTimes startup;
+    gboolean open_on_start;
+    gboolean async_setup;
+    gchar *render_node; /* Requested node, NULL to pick automatically */
+
+    /* Render node the CUDA-EGL context and GBM pools use, resolved from
+     * render-node or upstream's CUDA device and kept until stop() (object
+     * lock) */
+    gchar *drm_device;
+
+    /* DRM format table and modifier ranking of the render node
+     * formats_device, NULL until probed; re-resolved while the node is
+     * only a guess (object lock) */
+    const DrmFormatTable *formats;
+    ModifierRanking *ranking;
+    gchar *formats_device;
+    gboolean formats_guessed;
+
+    /* CUDA-EGL setup started by set_caps with async-setup, joined by the
+     * first frame */
+    GThread *setup_thread;
+    GstCudaContext *setup_cuda_ctx;
 
     /* CUDA-EGL interop context */
     CudaEglContext egl_ctx;
-
-    /* Pre-allocated semi-planar buffer pool (NV12 or P010) */
-    PooledBufferPool semi_planar_pool;
+    gboolean egl_ctx_guessed; /* Opened before upstream's CUDA device was known */
+
+    /* Turns deferred-sync fences into sync_files on the output DMA-BUFs,
+     * NULL when the driver or kernel can't (streaming thread) */
+    FenceExport *fence_export;
+    gboolean fence_export_probed;
+
+    /* CUDA-EGL output buffer pool (NV12/P010 passthrough or RGB conversion),
+     * recycled on release */
+    GstBufferPool *egl_pool;
+
+    /* The previous layout's pool, kept active so switching back is instant */
+    GstBufferPool *egl_standby_pool;
+
+    /* Pool for the layout a pending renegotiation is expected to pick,
+     * built off the streaming thread. The lock also guards the
+     * egl_pool/egl_standby_pool swaps. */
+    GMutex prebuild_lock;
+    GCond prebuild_cond; /* prebuild_running cleared */
+    GstBufferPool *prebuilt_pool;
+    gboolean prebuild_running;     /* Prebuild thread alive */
+    gboolean prebuild_again;       /* Another request came in meanwhile */
+    gboolean reconfigure_deferred; /* Renegotiation held back until it's done */
+    GstBufferPool *topup_pool;     /* Activated with one buffer, filled to min-buffers there */
+    GstCudaContext *prebuild_cuda_ctx; /* Context the prebuild thread pushes */
+    gboolean setup_pending;            /* setup_thread owns the output state */
+    gboolean prebuild_after_setup;     /* A prebuild was requested meanwhile */
 
     /* Buffer transform context */
     BufferTransformContext btx;
 
     /* External FD pool (Vulkan-exported buffers, populated via action signals) */
     ExternalFdPool external_fd_pool;
+
+    /* Software conversion into GBM buffers when the GPU path fails */
+    gboolean gpu_convert_failed; /* CUDA-EGL setup failed for the current caps */
+    GstBufferPool *cpu_pool;
+    WorkerPool *cpu_workers;
+    CpuConvertIsa cpu_isa;
 };
 
 G_DEFINE_TYPE(GstCudaDmabufUpload, gst_cuda_dmabuf_upload, GST_TYPE_BASE_TRANSFORM)
 
+#define GST_TYPE_CUDA_DMABUF_UPLOAD_SCALE_METHOD (gst_cuda_dmabuf_upload_scale_method_get_type())
+
+#define GST_TYPE_CUDA_DMABUF_UPLOAD_ALLOCATION_MODE (gst_cuda_dmabuf_upload_allocation_mode_get_type())
+
+static GType
+gst_cuda_dmabuf_upload_allocation_mode_get_type(void)
+{
+    static gsize type = 0;
+    static const GEnumValue values[] = {
+        {ALLOCATION_MODE_EXACT, "Buffers of the negotiated size", "exact"},
+        {ALLOCATION_MODE_MAX_SIZE, "Buffers of the largest size seen, reused for smaller sizes", "max-size"},
+        {0, NULL, NULL},
+    };
+
+    if (g_once_init_enter(&type))
+    {
+        GType t = g_enum_register_static("GstCudaDmabufUploadAllocationMode", values);
+        g_once_init_leave(&type, t);
+    }
+    return (GType)type;
+}
+
+static GType
+gst_cuda_dmabuf_upload_scale_method_get_type(void)
+{
+    static gsize type = 0;
+    static const GEnumValue values[] = {
+        {SCALE_METHOD_NEAREST, "Nearest neighbour", "nearest"},
+        {SCALE_METHOD_BILINEAR, "Bilinear", "bilinear"},
+        {0, NULL, NULL},
+    };
+
+    if (g_once_init_enter(&type))
+    {
+        GType t = g_enum_register_static("GstCudaDmabufUploadScaleMethod", values);
+        g_once_init_leave(&type, t);
+    }
+    return (GType)type;
+}
+
 /* ============================================================================
  * Pad Templates
  * ============================================================================ */
 
-/* Accept CUDA NV12 or P010_10LE (preferred) or regular BGRx */
+/* Accept CUDA NV12 or P010_10LE (preferred) or system-memory BGRx,
+ * NV12, I420 or P010_10LE (e.g. from a software decoder) */
 static GstStaticPadTemplate sink_template =
     GST_STATIC_PAD_TEMPLATE(
         "sink",
@@ -102,59 +295,808 @@ static GstStaticPadTemplate sink_template =
             "framerate=(fraction)[0/1,MAX]"
             "; "
             "video/x-raw,"
-            "format=(string)BGRx,"
+            "format=(string){BGRx,NV12,I420,P010_10LE},"
             "width=(int)[1,MAX],"
             "height=(int)[1,MAX],"
             "framerate=(fraction)[0/1,MAX]"));
 
-/* Output NV12/P010 DMA-BUF (preferred) or XR24 DMA-BUF */
-static GstStaticPadTemplate src_template =
-    GST_STATIC_PAD_TEMPLATE(
-        "src",
-        GST_PAD_SRC,
-        GST_PAD_ALWAYS,
-        GST_STATIC_CAPS(
-            /* NV12 with NVIDIA tiled modifiers - zero-copy passthrough */
-            "video/x-raw(memory:DMABuf),"
-            "format=(string)DMA_DRM,"
-            "width=(int)[1,MAX],"
-            "height=(int)[1,MAX],"
-            "framerate=(fraction)[0/1,MAX],"
-            "drm-format=(string){NV12:0x0300000000606010, NV12:0x0300000000606011, "
-            "NV12:0x0300000000606012, NV12:0x0300000000606013, NV12:0x0300000000606014, "
-            "NV12:0x0300000000606015, NV12:0x0300000000e08010, NV12:0x0300000000e08011, "
-            "NV12:0x0300000000e08012, NV12:0x0300000000e08013, NV12:0x0300000000e08014, "
-            "NV12:0x0300000000e08015, NV12:0x0, NV12:0x100000000000001}"
-            "; "
-            /* P010 with NVIDIA tiled modifiers - 10-bit zero-copy passthrough */
-            "video/x-raw(memory:DMABuf),"
-            "format=(string)DMA_DRM,"
-            "width=(int)[1,MAX],"
-            "height=(int)[1,MAX],"
-            "framerate=(fraction)[0/1,MAX],"
-            "drm-format=(string){P010:0x0300000000606010, P010:0x0300000000606011, "
-            "P010:0x0300000000606012, P010:0x0300000000606013, P010:0x0300000000606014, "
-            "P010:0x0300000000606015, P010:0x0300000000e08010, P010:0x0300000000e08011, "
-            "P010:0x0300000000e08012, P010:0x0300000000e08013, P010:0x0300000000e08014, "
-            "P010:0x0300000000e08015, P010:0x0, P010:0x100000000000001}"
-            "; "
-            /* XR24 with linear modifier - for Vulkan/wgpu compatibility */
-            "video/x-raw(memory:DMABuf),"
-            "format=(string)DMA_DRM,"
-            "width=(int)[1,MAX],"
-            "height=(int)[1,MAX],"
-            "framerate=(fraction)[0/1,MAX],"
-            "drm-format=(string){XR24:0x0, XR24:0x0300000000606010, XR24:0x0300000000606011, "
-            "XR24:0x0300000000606012, XR24:0x0300000000606013, XR24:0x0300000000606014, "
-            "XR24:0x0300000000606015, XR24:0x0300000000e08010, XR24:0x0300000000e08011, "
-            "XR24:0x0300000000e08012, XR24:0x0300000000e08013, XR24:0x0300000000e08014, "
-            "XR24:0x0300000000e08015}"
-            "; "
-            "video/x-raw,"
-            "format=(string)BGRx,"
-            "width=(int)[1,MAX],"
-            "height=(int)[1,MAX],"
-            "framerate=(fraction)[0/1,MAX]"));
+/* ============================================================================
+ * CUDA-EGL Output Pool
+ * ============================================================================ */
+
+/* CUDA-EGL pool parameters of one output layout */
+typedef struct
+{
+    GstVideoInfo info;
+    guint64 modifier;
+    gboolean force_linear;
+    guint max_width; /* Buffer capacity in max-size mode, 0 otherwise */
+    guint max_height;
+} EglPoolLayout;
+
+/* NV12/P010 passthrough uses the negotiated modifier; the RGB conversion
+ * target is always LINEAR since CUDA doesn't support tiled RGB EGL interop. */
+static gboolean
+gst_cuda_dmabuf_upload_egl_pool_layout(gboolean semi_planar, gboolean p010, gboolean rgb10,
+                                       guint64 modifier, gboolean force_linear,
+                                       gint width, gint height, EglPoolLayout *layout)
+{
+    GstVideoFormat format;
+
+    if (semi_planar)
+    {
+        format = p010 ? GST_VIDEO_FORMAT_P010_10LE : GST_VIDEO_FORMAT_NV12;
+        layout->modifier = modifier;
+        layout->force_linear = force_linear;
+    }
+    else
+    {
+        format = rgb10 ? GST_VIDEO_FORMAT_BGR10A2_LE : GST_VIDEO_FORMAT_BGRx;
+        layout->modifier = DRM_FORMAT_MOD_LINEAR;
+        layout->force_linear = TRUE;
+    }
+
+    layout->max_width = 0;
+    layout->max_height = 0;
+    return gst_video_info_set_format(&layout->info, format, width, height);
+}
+
+/* In max-size mode, size @layout's buffers for the largest output seen
+ * (or the configured maximum, if larger) so smaller sizes reuse them */
+static void
+gst_cuda_dmabuf_upload_egl_pool_capacity(GstCudaDmabufUpload *self, EglPoolLayout *layout)
+{
+    guint width = GST_VIDEO_INFO_WIDTH(&layout->info);
+    guint height = GST_VIDEO_INFO_HEIGHT(&layout->info);
+
+    GST_OBJECT_LOCK(self);
+    if (self->allocation_mode == ALLOCATION_MODE_MAX_SIZE)
+    {
+        layout->max_width = MAX(MAX(self->pool_max_width, self->seen_width), width);
+        layout->max_height = MAX(MAX(self->pool_max_height, self->seen_height), height);
+    }
+    GST_OBJECT_UNLOCK(self);
+}
+
+static gboolean
+gst_cuda_dmabuf_upload_egl_pool_matches(GstBufferPool *pool, const EglPoolLayout *layout)
+{
+    return pool &&
+           !gst_pooled_buffer_pool_needs_reinit(GST_POOLED_BUFFER_POOL(pool), &layout->info,
+                                                layout->modifier, layout->force_linear);
+}
+
+/* Buffers still downstream keep a dropped pool alive until released */
+static void
+gst_cuda_dmabuf_upload_drop_pool(GstBufferPool **pool)
+{
+    if (*pool)
+    {
+        gst_buffer_pool_set_active(*pool, FALSE);
+        gst_object_unref(*pool);
+        *pool = NULL;
+    }
+}
+
+/* Store the time since @start in @phase and log it */
+static void
+gst_cuda_dmabuf_upload_record_phase(GstCudaDmabufUpload *self, guint64 *phase,
+                                    gint64 start, const gchar *name)
+{
+    guint64 usec = (guint64)(g_get_monotonic_time() - start);
+
+    GST_OBJECT_LOCK(self);
+    *phase = usec;
+    GST_OBJECT_UNLOCK(self);
+
+    GST_INFO_OBJECT(self, "Startup phase %s: %" G_GUINT64_FORMAT " us", name, usec);
+}
+
+/* Upstream's CUDA context (a new reference), or NULL */
+static GstCudaContext *
+gst_cuda_dmabuf_upload_peer_cuda_context(GstCudaDmabufUpload *self)
+{
+    GstCudaContext *cuda_ctx = NULL;
+    GstQuery *ctx_query = gst_query_new_context("gst.cuda.context");
+
+    if (gst_pad_peer_query(GST_BASE_TRANSFORM_SINK_PAD(self), ctx_query))
+    {
+        GstContext *ctx = NULL;
+        gst_query_parse_context(ctx_query, &ctx);
+        if (ctx)
+        {
+            const GstStructure *s = gst_context_get_structure(ctx);
+            gst_structure_get(s, "gst.cuda.context", GST_TYPE_CUDA_CONTEXT, &cuda_ctx, NULL);
+        }
+    }
+    gst_query_unref(ctx_query);
+
+    return cuda_ctx;
+}
+
+/* PCI bus ID of @cuda_ctx's device into @bus_id */
+static gboolean
+gst_cuda_dmabuf_upload_cuda_bus_id(GstCudaContext *cuda_ctx, gchar *bus_id, gint len)
+{
+    guint device_id = 0;
+    CUdevice device;
+
+    g_object_get(cuda_ctx, "cuda-device-id", &device_id, NULL);
+    return cuDeviceGet(&device, (gint)device_id) == CUDA_SUCCESS &&
+           cuDeviceGetPCIBusId(bus_id, len, device) == CUDA_SUCCESS;
+}
+
+/* The render node to open: the render-node property, else the NVIDIA
+ * node on upstream's CUDA device, else the first NVIDIA node. The first
+ * two are kept until stop(); the last is only a guess (@guessed), made
+ * again next time as upstream's CUDA device may show up meanwhile.
+ * Free with g_free(). */
+static gchar *
+gst_cuda_dmabuf_upload_get_drm_device(GstCudaDmabufUpload *self, gboolean *guessed)
+{
+    GST_OBJECT_LOCK(self);
+    gchar *path = g_strdup(self->drm_device ? self->drm_device : self->render_node);
+    GST_OBJECT_UNLOCK(self);
+
+    if (guessed)
+        *guessed = FALSE;
+
+    if (!path)
+    {
+        GstCudaContext *cuda_ctx = self->cuda_ctx ? gst_object_ref(self->cuda_ctx)
+                                                  : gst_cuda_dmabuf_upload_peer_cuda_context(self);
+        gchar bus_id[32];
+        gboolean found = cuda_ctx &&
+                         gst_cuda_dmabuf_upload_cuda_bus_id(cuda_ctx, bus_id, sizeof(bus_id));
+
+        if (cuda_ctx)
+            gst_object_unref(cuda_ctx);
+
+        if (!found)
+        {
+            path = g_strdup(render_node_find(NULL));
+            GST_INFO_OBJECT(self, "No upstream CUDA device yet, using %s for now", path);
+            if (guessed)
+                *guessed = TRUE;
+            return path;
+        }
+
+        path = g_strdup(render_node_find(bus_id));
+        GST_INFO_OBJECT(self, "CUDA device on PCI %s, using %s", bus_id, path);
+    }
+
+    /* A concurrent caller (the setup thread) may have got there first */
+    GST_OBJECT_LOCK(self);
+    if (!self->drm_device)
+        self->drm_device = g_strdup(path);
+    GST_OBJECT_UNLOCK(self);
+
+    return path;
+}
+
+/* Drop the CUDA-EGL context and the pools built on its render node, so
+ * the next setup opens the node resolved then. Waits for a running
+ * prebuild, which uses both. */
+static void
+gst_cuda_dmabuf_upload_close_device(GstCudaDmabufUpload *self)
+{
+    GstBufferPool *pools[4];
+
+    g_mutex_lock(&self->prebuild_lock);
+    while (self->prebuild_running)
+        g_cond_wait(&self->prebuild_cond, &self->prebuild_lock);
+
+    pools[0] = self->egl_pool;
+    pools[1] = self->egl_standby_pool;
+    pools[2] = self->prebuilt_pool;
+    pools[3] = self->topup_pool;
+    self->egl_pool = self->egl_standby_pool = self->prebuilt_pool = self->topup_pool = NULL;
+
+    /* start_prebuild checks btx.egl_ctx under the same lock */
+    if (self->cuda_ctx)
+        gst_cuda_context_push(self->cuda_ctx);
+    buffer_transform_context_cleanup(&self->btx);
+    if (self->cuda_ctx)
+        gst_cuda_context_pop(NULL);
+    g_mutex_unlock(&self->prebuild_lock);
+
+    for (guint i = 0; i < G_N_ELEMENTS(pools); i++)
+        gst_cuda_dmabuf_upload_drop_pool(&pools[i]);
+
+    /* Its context lives on the display about to be released */
+    g_clear_pointer(&self->fence_export, fence_export_free);
+    self->fence_export_probed = FALSE;
+
+    cuda_egl_context_cleanup(&self->egl_ctx);
+    self->egl_ctx_guessed = FALSE;
+
+    /* Caps offered so far came from this node's formats */
+    GST_OBJECT_LOCK(self);
+    self->formats = NULL;
+    self->ranking = NULL;
+    g_clear_pointer(&self->formats_device, g_free);
+    GST_OBJECT_UNLOCK(self);
+    caps_cache_clear(self->caps_cache);
+}
+
+static gboolean
+gst_cuda_dmabuf_upload_ensure_transform_context(GstCudaDmabufUpload *self)
+{
+    /* Opened early (open-on-start) on a guessed node: move to the CUDA
+     * device's node once it's known, if that's another one */
+    if (self->egl_ctx.initialized && self->egl_ctx_guessed && self->cuda_ctx)
+    {
+        gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, &self->egl_ctx_guessed);
+
+        if (g_strcmp0(drm_device, self->egl_ctx.drm_device) != 0)
+        {
+            GST_INFO_OBJECT(self, "Reopening on %s instead of %s", drm_device,
+                            self->egl_ctx.drm_device);
+            gst_cuda_dmabuf_upload_close_device(self);
+
+            /* The negotiated modifier was picked from the old node's formats */
+            gst_base_transform_reconfigure_src(GST_BASE_TRANSFORM(self));
+        }
+        g_free(drm_device);
+    }
+
+    if (self->btx.egl_ctx)
+        return TRUE;
+
+    gint64 start = g_get_monotonic_time();
+    if (!self->egl_ctx.initialized)
+    {
+        gboolean guessed;
+        gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, &guessed);
+        gboolean ok = cuda_egl_context_init(&self->egl_ctx, drm_device);
+
+        if (!ok)
+            GST_ERROR_OBJECT(self, "Failed to initialize CUDA-EGL context with %s", drm_device);
+        g_free(drm_device);
+        if (!ok)
+            return FALSE;
+        self->egl_ctx_guessed = guessed;
+    }
+    if (!buffer_transform_context_init(&self->btx, &self->egl_ctx,
+                                       self->negotiated_modifier))
+    {
+        GST_ERROR_OBJECT(self, "Failed to initialize buffer transform context");
+        return FALSE;
+    }
+    gst_cuda_dmabuf_upload_record_phase(self, &self->startup.context_usec, start, "context");
+    return TRUE;
+}
+
+/* The format table of the render node the element outputs on, and its
+ * modifier ranking in @ranking (may be NULL). The first call per node
+ * pays the device probe (or the cache read). A table for a guessed node
+ * is checked again once upstream's CUDA context is known. */
+static const DrmFormatTable *
+gst_cuda_dmabuf_upload_probe_formats(GstCudaDmabufUpload *self, ModifierRanking **ranking)
+{
+    const DrmFormatTable *formats;
+    ModifierRanking *device_ranking = NULL;
+    gboolean guessed;
+
+    GST_OBJECT_LOCK(self);
+    formats = self->formats_guessed && self->cuda_ctx ? NULL : self->formats;
+    device_ranking = self->ranking;
+    GST_OBJECT_UNLOCK(self);
+
+    if (!formats)
+    {
+        gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, &guessed);
+
+        GST_OBJECT_LOCK(self);
+        if (self->formats && g_strcmp0(self->formats_device, drm_device) == 0)
+        {
+            formats = self->formats;
+            self->formats_guessed = guessed;
+        }
+        GST_OBJECT_UNLOCK(self);
+
+        if (!formats)
+        {
+            gint64 start = g_get_monotonic_time();
+            formats = buffer_transform_probe_formats(drm_device, &device_ranking);
+            gst_cuda_dmabuf_upload_record_phase(self, &self->startup.probe_usec, start, "probe");
+
+            GST_OBJECT_LOCK(self);
+            self->formats = formats;
+            self->ranking = device_ranking;
+            g_free(self->formats_device);
+            self->formats_device = g_strdup(drm_device);
+            self->formats_guessed = guessed;
+            GST_OBJECT_UNLOCK(self);
+        }
+        g_free(drm_device);
+    }
+
+    if (ranking)
+        *ranking = device_ranking;
+    return formats;
+}
+
+/* Output pool bounds from the properties; a max below min is raised to it */
+static void
+gst_cuda_dmabuf_upload_get_pool_bounds(GstCudaDmabufUpload *self, guint *min_buffers,
+                                       guint *max_buffers)
+{
+    GST_OBJECT_LOCK(self);
+    *min_buffers = self->min_buffers;
+    *max_buffers = self->max_buffers;
+    GST_OBJECT_UNLOCK(self);
+
+    if (*max_buffers && *max_buffers < *min_buffers)
+        *max_buffers = *min_buffers;
+}
+
+/* Configure and activate a pool for @layout: pays the GBM/EGL/CUDA setup
+ * of its first buffers, or of only one with @incremental (the caller has
+ * the rest added off the streaming thread). Also runs on the prebuild
+ * thread. The pool keeps its own references to the render node and to
+ * @cuda_ctx, as its buffers can outlive the element. */
+static GstBufferPool *
+gst_cuda_dmabuf_upload_build_egl_pool(GstCudaDmabufUpload *self, GstCudaContext *cuda_ctx,
+                                      const EglPoolLayout *layout, gboolean incremental)
+{
+    const GstVideoInfo *out_info = &layout->info;
+
+    /* Same node as the CUDA-EGL context */
+    GstBufferPool *pool = gst_pooled_buffer_pool_new(self->egl_ctx.drm_device,
+                                                     cuda_ctx, self->btx.dmabuf_allocator,
+                                                     out_info, layout->modifier,
+                                                     layout->force_linear);
+
+    if (!pool)
+    {
+        GST_ERROR_OBJECT(self, "Failed to create CUDA-EGL buffer pool");
+        return NULL;
+    }
+
+    if (layout->max_width)
+        gst_pooled_buffer_pool_set_max_size(GST_POOLED_BUFFER_POOL(pool),
+                                            layout->max_width, layout->max_height);
+
+    guint min_buffers, max_buffers;
+    gst_cuda_dmabuf_upload_get_pool_bounds(self, &min_buffers, &max_buffers);
+    if (incremental)
+        min_buffers = 1;
+
+    gint64 start = g_get_monotonic_time();
+
+    GstCaps *caps = gst_video_info_to_caps(out_info);
+    GstStructure *config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, caps, 0, min_buffers, max_buffers);
+    gst_caps_unref(caps);
+
+    if (!gst_buffer_pool_set_config(pool, config))
+    {
+        GST_ERROR_OBJECT(self, "Failed to configure CUDA-EGL buffer pool");
+        gst_object_unref(pool);
+        return NULL;
+    }
+
+    if (!gst_buffer_pool_set_active(pool, TRUE))
+    {
+        GST_ERROR_OBJECT(self, "Failed to activate CUDA-EGL buffer pool");
+        gst_object_unref(pool);
+        return NULL;
+    }
+
+    GST_INFO_OBJECT(self, "CUDA-EGL pool: %s %ux%u, %u-%u buffers",
+                    gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(out_info)),
+                    GST_VIDEO_INFO_WIDTH(out_info), GST_VIDEO_INFO_HEIGHT(out_info),
+                    min_buffers, max_buffers);
+    gst_cuda_dmabuf_upload_record_phase(self, &self->startup.pool_usec, start, "pool");
+
+    return pool;
+}
+
+static void gst_cuda_dmabuf_upload_start_prebuild(GstCudaDmabufUpload *self);
+
+/* (Re)create the CUDA-EGL pool when the output layout changes. A pool
+ * prebuilt for this renegotiation, or the standby of the previous layout,
+ * is switched in when it matches; otherwise one is built here on
+ * @cuda_ctx, mid-stream with a single buffer and the rest added by the
+ * prebuild thread. The replaced pool becomes the standby unless the new
+ * one covers it. */
+static gboolean
+gst_cuda_dmabuf_upload_ensure_egl_pool(GstCudaDmabufUpload *self, GstCudaContext *cuda_ctx)
+{
+    EglPoolLayout layout;
+    GstBufferPool *pool = NULL;
+    GstBufferPool *drop;
+
+    if (!gst_cuda_dmabuf_upload_egl_pool_layout(self->semi_planar_output, self->p010_output,
+                                                self->rgb10_output, self->negotiated_modifier,
+                                                self->force_linear, self->out_width,
+                                                self->out_height, &layout))
+        return FALSE;
+    gst_cuda_dmabuf_upload_egl_pool_capacity(self, &layout);
+
+    GST_OBJECT_LOCK(self);
+    self->seen_width = MAX(self->seen_width, (guint)self->out_width);
+    self->seen_height = MAX(self->seen_height, (guint)self->out_height);
+    GST_OBJECT_UNLOCK(self);
+
+    /* Max-size pools take smaller frames as they are */
+    if (gst_cuda_dmabuf_upload_egl_pool_matches(self->egl_pool, &layout))
+        return gst_pooled_buffer_pool_set_frame_size(GST_POOLED_BUFFER_POOL(self->egl_pool),
+                                                     self->out_width, self->out_height);
+
+    if (!gst_cuda_dmabuf_upload_ensure_transform_context(self))
+        return FALSE;
+
+    g_mutex_lock(&self->prebuild_lock);
+    if (gst_cuda_dmabuf_upload_egl_pool_matches(self->prebuilt_pool, &layout))
+    {
+        pool = self->prebuilt_pool;
+        self->prebuilt_pool = NULL;
+        GST_INFO_OBJECT(self, "Switching to the prebuilt CUDA-EGL pool");
+    }
+    else if (gst_cuda_dmabuf_upload_egl_pool_matches(self->egl_standby_pool, &layout))
+    {
+        pool = self->egl_standby_pool;
+        self->egl_standby_pool = NULL;
+        GST_INFO_OBJECT(self, "Switching back to the standby CUDA-EGL pool");
+    }
+    g_mutex_unlock(&self->prebuild_lock);
+
+    if (!pool)
+    {
+        gboolean incremental = self->egl_pool && self->cuda_ctx;
+
+        pool = gst_cuda_dmabuf_upload_build_egl_pool(self, cuda_ctx, &layout, incremental);
+        if (pool && incremental)
+        {
+            g_mutex_lock(&self->prebuild_lock);
+            gst_object_replace((GstObject **)&self->topup_pool, GST_OBJECT(pool));
+            g_mutex_unlock(&self->prebuild_lock);
+            gst_cuda_dmabuf_upload_start_prebuild(self);
+        }
+    }
+    if (!pool)
+        return FALSE;
+
+    gst_pooled_buffer_pool_set_frame_size(GST_POOLED_BUFFER_POOL(pool),
+                                          self->out_width, self->out_height);
+
+    /* Switch in one step, between two frames of the streaming thread. A
+     * max-size pool that grew makes the one it replaces redundant. */
+    g_mutex_lock(&self->prebuild_lock);
+    GstPooledBufferPool *old = (GstPooledBufferPool *)self->egl_pool;
+    if (old && !gst_pooled_buffer_pool_needs_reinit(GST_POOLED_BUFFER_POOL(pool), &old->info,
+                                                    old->modifier, old->force_linear))
+    {
+        drop = self->egl_pool;
+    }
+    else
+    {
+        drop = self->egl_standby_pool;
+        self->egl_standby_pool = self->egl_pool;
+    }
+    self->egl_pool = pool;
+    g_mutex_unlock(&self->prebuild_lock);
+
+    gst_cuda_dmabuf_upload_drop_pool(&drop);
+    return TRUE;
+}
+
+/* ============================================================================
+ * CPU Conversion Fallback
+ * ============================================================================ */
+
+static void
+gst_cuda_dmabuf_upload_clear_cpu_pool(GstCudaDmabufUpload *self)
+{
+    if (self->cpu_pool)
+    {
+        gst_buffer_pool_set_active(self->cpu_pool, FALSE);
+        gst_object_unref(self->cpu_pool);
+        self->cpu_pool = NULL;
+    }
+}
+
+/* The CPU writes linear RGB only: no semi-planar or tiled output */
+static gboolean
+gst_cuda_dmabuf_upload_can_cpu_convert(GstCudaDmabufUpload *self)
+{
+    return self->cpu_fallback && self->cuda_input && !self->semi_planar_output &&
+           self->negotiated_modifier == DRM_FORMAT_MOD_LINEAR;
+}
+
+/* Threads shared by the CPU converter and the system-memory copies, kept
+ * on the streaming thread's NUMA node */
+static void
+gst_cuda_dmabuf_upload_ensure_workers(GstCudaDmabufUpload *self)
+{
+    if (self->cpu_workers)
+        return;
+
+    self->cpu_workers = worker_pool_new_numa_local(0);
+    self->cpu_isa = cpu_convert_best_isa();
+}
+
+/* LINEAR XR24/XR30 GBM buffers at the output size, plus the threads */
+static gboolean
+gst_cuda_dmabuf_upload_ensure_cpu_pool(GstCudaDmabufUpload *self)
+{
+    if (self->cpu_pool)
+        return TRUE;
+
+    GstVideoFormat format = self->rgb10_output ? GST_VIDEO_FORMAT_BGR10A2_LE : GST_VIDEO_FORMAT_BGRx;
+    GstVideoInfo out_info;
+    if (!gst_video_info_set_format(&out_info, format, self->out_width, self->out_height))
+        return FALSE;
+
+    guint min_buffers, max_buffers;
+    gst_cuda_dmabuf_upload_get_pool_bounds(self, &min_buffers, &max_buffers);
+
+    gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, NULL);
+    GstBufferPool *pool = gst_gbm_dmabuf_pool_new(&out_info, DRM_FORMAT_MOD_LINEAR, drm_device);
+    g_free(drm_device);
+    GstCaps *caps = gst_video_info_to_caps(&out_info);
+    GstStructure *config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, caps, GST_VIDEO_INFO_SIZE(&out_info),
+                                      min_buffers, max_buffers);
+    gst_caps_unref(caps);
+
+    if (!gst_buffer_pool_set_config(pool, config) ||
+        !gst_buffer_pool_set_active(pool, TRUE))
+    {
+        GST_ERROR_OBJECT(self, "Failed to configure/activate CPU conversion pool");
+        gst_object_unref(pool);
+        return FALSE;
+    }
+
+    gst_cuda_dmabuf_upload_ensure_workers(self);
+
+    GST_INFO_OBJECT(self, "CPU conversion: %s %dx%d, %s, %u threads",
+                    gst_video_format_to_string(format), self->out_width, self->out_height,
+                    cpu_convert_isa_name(self->cpu_isa),
+                    worker_pool_get_n_threads(self->cpu_workers));
+
+    self->cpu_pool = pool;
+    return TRUE;
+}
+
+static GstFlowReturn
+gst_cuda_dmabuf_upload_cpu_convert(GstCudaDmabufUpload *self, GstBuffer *inbuf, GstBuffer **outbuf)
+{
+    if (!gst_cuda_dmabuf_upload_ensure_cpu_pool(self))
+        return GST_FLOW_ERROR;
+
+    GstBuffer *pooled = NULL;
+    GstFlowReturn ret = gst_buffer_pool_acquire_buffer(self->cpu_pool, &pooled, NULL);
+    if (ret != GST_FLOW_OK)
+        return ret;
+
+    /* A host mapping of CUDA memory downloads it */
+    GstVideoFrame in_frame;
+    if (!gst_video_frame_map(&in_frame, &self->cuda_info, inbuf, GST_MAP_READ))
+    {
+        GST_ERROR_OBJECT(self, "Failed to map input for CPU conversion");
+        gst_buffer_unref(pooled);
+        return GST_FLOW_ERROR;
+    }
+
+    GstGbmCpuAccess out;
+    if (!gst_gbm_dmabuf_pool_begin_cpu_access(pooled, GST_MAP_WRITE, &out))
+    {
+        GST_ERROR_OBJECT(self, "Failed to map output for CPU conversion");
+        gst_video_frame_unmap(&in_frame);
+        gst_buffer_unref(pooled);
+        return GST_FLOW_ERROR;
+    }
+
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(pooled);
+    CpuConvertFrame frame = {
+        GST_VIDEO_FRAME_PLANE_DATA(&in_frame, 0),
+        GST_VIDEO_FRAME_PLANE_DATA(&in_frame, 1),
+        GST_VIDEO_FRAME_PLANE_STRIDE(&in_frame, 0),
+        GST_VIDEO_FRAME_PLANE_STRIDE(&in_frame, 1),
+        out.data,
+        vmeta ? vmeta->stride[0] : self->out_width * 4,
+        GST_VIDEO_FRAME_WIDTH(&in_frame),
+        GST_VIDEO_FRAME_HEIGHT(&in_frame),
+        GST_VIDEO_FRAME_FORMAT(&in_frame) == GST_VIDEO_FORMAT_P010_10LE,
+        self->rgb10_output,
+        self->btx.scaling ? &self->btx.scale : NULL,
+    };
+    cpu_convert_frame(self->cpu_workers, self->cpu_isa, &frame, &self->btx.yuv_coeffs);
+
+    gst_gbm_dmabuf_pool_end_cpu_access(&out);
+    gst_video_frame_unmap(&in_frame);
+
+    *outbuf = pooled;
+    return GST_FLOW_OK;
+}
+
+/* ============================================================================
+ * Modifier Calibration
+ * ============================================================================ */
+
+/* Time the copy into each tiled modifier the first time a size is
+ * negotiated. If one beats the negotiated modifier, renegotiate: the
+ * ranked caps now offer it first. */
+static void
+gst_cuda_dmabuf_upload_calibrate(GstCudaDmabufUpload *self)
+{
+    guint32 fourcc = self->p010_output ? DRM_FORMAT_P010 : DRM_FORMAT_NV12;
+    guint64 best = DRM_FORMAT_MOD_INVALID;
+    gboolean measured;
+
+    /* Only the semi-planar passthrough has a modifier choice; the RGB
+     * conversion target is always LINEAR */
+    if (!self->cuda_input || !self->semi_planar_output || self->force_linear ||
+        self->btx.scaling)
+        return;
+
+    ModifierRanking *ranking;
+    const DrmFormatTable *formats = gst_cuda_dmabuf_upload_probe_formats(self, &ranking);
+
+    if (modifier_ranking_has(ranking, fourcc, self->out_width, self->out_height))
+        return;
+
+    if (!gst_cuda_dmabuf_upload_ensure_transform_context(self))
+        return;
+
+    if (self->cuda_ctx)
+        gst_cuda_context_push(self->cuda_ctx);
+    measured = buffer_transform_calibrate_modifiers(&self->egl_ctx, formats, ranking,
+                                                    self->p010_output, self->out_width,
+                                                    self->out_height, &best);
+    if (self->cuda_ctx)
+        gst_cuda_context_pop(NULL);
+
+    if (!measured)
+    {
+        GST_WARNING_OBJECT(self, "Modifier calibration at %dx%d measured nothing",
+                           self->out_width, self->out_height);
+        return;
+    }
+
+    GST_INFO_OBJECT(self, "Fastest modifier at %dx%d: 0x%016lx (negotiated 0x%016lx)",
+                    self->out_width, self->out_height, best, self->negotiated_modifier);
+
+    if (best != self->negotiated_modifier)
+        gst_base_transform_reconfigure_src(GST_BASE_TRANSFORM(self));
+}
+
+/* ============================================================================
+ * Startup
+ * ============================================================================ */
+
+/* The CUDA-EGL output couldn't be set up: fall back to the CPU
+ * conversion when it can take over, otherwise fail negotiation */
+static gboolean
+gst_cuda_dmabuf_upload_egl_setup_failed(GstCudaDmabufUpload *self)
+{
+    if (!gst_cuda_dmabuf_upload_can_cpu_convert(self))
+    {
+        GST_ERROR_OBJECT(self, "Failed to set up output buffer pool");
+        return FALSE;
+    }
+
+    GST_WARNING_OBJECT(self, "GPU conversion unavailable, converting on the CPU");
+    self->gpu_convert_failed = TRUE;
+    return TRUE;
+}
+
+static gpointer
+gst_cuda_dmabuf_upload_setup_thread(gpointer data)
+{
+    GstCudaDmabufUpload *self = data;
+    gboolean ok;
+
+    if (self->setup_cuda_ctx)
+        gst_cuda_context_push(self->setup_cuda_ctx);
+    ok = gst_cuda_dmabuf_upload_ensure_egl_pool(self, self->setup_cuda_ctx);
+    if (self->setup_cuda_ctx)
+        gst_cuda_context_pop(NULL);
+
+    return GINT_TO_POINTER(ok);
+}
+
+/* Build the CUDA-EGL pool while negotiation and the first decode go on.
+ * The streaming thread joins it before touching the output state again;
+ * prebuild requests from other threads (RECONFIGURE, force-linear) are
+ * held back until then, as they read btx. */
+static void
+gst_cuda_dmabuf_upload_start_setup(GstCudaDmabufUpload *self)
+{
+    if (self->cuda_ctx)
+        self->setup_cuda_ctx = gst_object_ref(self->cuda_ctx);
+
+    g_mutex_lock(&self->prebuild_lock);
+    self->setup_pending = TRUE;
+    self->prebuild_after_setup = FALSE;
+    g_mutex_unlock(&self->prebuild_lock);
+
+    self->setup_thread = g_thread_new("cudadmabuf-setup", gst_cuda_dmabuf_upload_setup_thread,
+                                      self);
+}
+
+/* Wait for the setup started by set_caps. Returns FALSE if it failed. */
+static gboolean
+gst_cuda_dmabuf_upload_join_setup(GstCudaDmabufUpload *self)
+{
+    if (!self->setup_thread)
+        return TRUE;
+
+    gint64 start = g_get_monotonic_time();
+    gboolean ok = GPOINTER_TO_INT(g_thread_join(self->setup_thread));
+    self->setup_thread = NULL;
+    gst_cuda_dmabuf_upload_record_phase(self, &self->startup.wait_usec, start, "wait");
+
+    if (self->setup_cuda_ctx)
+    {
+        gst_object_unref(self->setup_cuda_ctx);
+        self->setup_cuda_ctx = NULL;
+    }
+
+    g_mutex_lock(&self->prebuild_lock);
+    self->setup_pending = FALSE;
+    g_mutex_unlock(&self->prebuild_lock);
+
+    return ok;
+}
+
+/* Start a prebuild held back while the setup thread ran */
+static void
+gst_cuda_dmabuf_upload_resume_prebuild(GstCudaDmabufUpload *self)
+{
+    g_mutex_lock(&self->prebuild_lock);
+    gboolean prebuild = self->prebuild_after_setup;
+    self->prebuild_after_setup = FALSE;
+    g_mutex_unlock(&self->prebuild_lock);
+
+    if (prebuild)
+        gst_cuda_dmabuf_upload_start_prebuild(self);
+}
+
+/* READY→PAUSED. With open-on-start, also probe the DRM formats and open
+ * the render node, EGL display and CUDA driver now, so none of it is left
+ * for negotiation or the first frame. */
+static gboolean
+gst_cuda_dmabuf_upload_start(GstBaseTransform *base)
+{
+    GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
+
+    GST_OBJECT_LOCK(self);
+    memset(&self->startup, 0, sizeof(StartupTimes));
+    gboolean open_on_start = self->open_on_start;
+    GST_OBJECT_UNLOCK(self);
+
+    if (open_on_start)
+    {
+        gst_cuda_dmabuf_upload_probe_formats(self, NULL);
+
+        /* Not fatal: system-memory input doesn't need the interop */
+        if (!gst_cuda_dmabuf_upload_ensure_transform_context(self))
+            GST_WARNING_OBJECT(self, "Couldn't open the CUDA-EGL context early");
+    }
+
+    return TRUE;
+}
+
+static gboolean
+gst_cuda_dmabuf_upload_stop(GstBaseTransform *base)
+{
+    GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
+
+    gst_cuda_dmabuf_upload_join_setup(self);
+
+    /* The next start resolves the render node again: render-node may
+     * have changed, or upstream may bring another CUDA device */
+    gst_cuda_dmabuf_upload_close_device(self);
+    GST_OBJECT_LOCK(self);
+    g_clear_pointer(&self->drm_device, g_free);
+    GST_OBJECT_UNLOCK(self);
+
+    return TRUE;
+}
 
 /* ============================================================================
  * Caps Handling
@@ -165,6 +1107,15 @@ gst_cuda_dmabuf_upload_set_caps(GstBaseTransform *base, GstCaps *incaps, GstCaps
 {
     GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
 
+    /* A previous setup still reads the output state changed below */
+    gst_cuda_dmabuf_upload_join_setup(self);
+
+    GST_OBJECT_LOCK(self);
+    if (self->startup.caps_time == 0)
+        self->startup.caps_time = g_get_monotonic_time();
+    gboolean async_setup = self->async_setup;
+    GST_OBJECT_UNLOCK(self);
+
     /* Check if input is CUDA memory */
     GstCapsFeatures *features = gst_caps_get_features(incaps, 0);
     self->cuda_input = gst_caps_features_contains(features, GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY);
@@ -181,16 +1132,18 @@ gst_cuda_dmabuf_upload_set_caps(GstBaseTransform *base, GstCaps *incaps, GstCaps
         self->negotiated_modifier = drm_format_parse_modifier(drm_format);
         self->semi_planar_output = drm_format_is_semi_planar_420(drm_format);
         self->p010_output = drm_format_is_p010(drm_format);
+        self->rgb10_output = drm_format_is_rgb10(drm_format);
 
-        GST_INFO_OBJECT(self, "Negotiated: %s (modifier: 0x%016lx, semi_planar=%d, p010=%d)",
+        GST_INFO_OBJECT(self, "Negotiated: %s (modifier: 0x%016lx, semi_planar=%d, p010=%d, rgb10=%d)",
                         drm_format, self->negotiated_modifier,
-                        self->semi_planar_output, self->p010_output);
+                        self->semi_planar_output, self->p010_output, self->rgb10_output);
     }
     else
     {
         self->negotiated_modifier = DRM_FORMAT_MOD_INVALID;
         self->semi_planar_output = FALSE;
         self->p010_output = FALSE;
+        self->rgb10_output = FALSE;
     }
 
     /* Parse video info */
@@ -200,62 +1153,504 @@ gst_cuda_dmabuf_upload_set_caps(GstBaseTransform *base, GstCaps *incaps, GstCaps
         return FALSE;
     }
 
+    if (!gst_structure_get_int(s, "width", &self->out_width) ||
+        !gst_structure_get_int(s, "height", &self->out_height))
+    {
+        self->out_width = GST_VIDEO_INFO_WIDTH(&self->info);
+        self->out_height = GST_VIDEO_INFO_HEIGHT(&self->info);
+    }
+
+    if (!self->cuda_input &&
+        (self->out_width != GST_VIDEO_INFO_WIDTH(&self->info) ||
+         self->out_height != GST_VIDEO_INFO_HEIGHT(&self->info)))
+    {
+        GST_ERROR_OBJECT(self, "Scaling is only supported for CUDA input");
+        return FALSE;
+    }
+
+    /* System-memory YUV is written by the CPU into LINEAR planes only */
+    if (!self->cuda_input && self->semi_planar_output &&
+        self->negotiated_modifier != DRM_FORMAT_MOD_LINEAR)
+    {
+        GST_ERROR_OBJECT(self, "System-memory NV12/I420/P010 input needs LINEAR output");
+        return FALSE;
+    }
+
     if (self->cuda_input)
+    {
         self->cuda_info = self->info;
 
+        /* Conversion matrix and range follow the input colorimetry; the
+         * levels follow the input and output bit depths */
+        guint in_depth = GST_VIDEO_INFO_FORMAT(&self->cuda_info) == GST_VIDEO_FORMAT_P010_10LE ? 10 : 8;
+        guint out_depth = self->rgb10_output ? 10 : 8;
+        colorimetry_get_yuv_to_rgb_coeffs_for_depth(&GST_VIDEO_INFO_COLORIMETRY(&self->cuda_info),
+                                                    in_depth, out_depth,
+                                                    &self->btx.yuv_coeffs);
+
+        /* Scaling/letterboxing is fused into the copy or conversion kernel */
+        GST_OBJECT_LOCK(self);
+        ScaleMethod method = self->scale_method;
+        gboolean add_borders = self->add_borders;
+        guint border_color = self->border_color;
+        GST_OBJECT_UNLOCK(self);
+
+        ScaleGeometry *geo = &self->btx.scale;
+        scale_geometry_compute(GST_VIDEO_INFO_WIDTH(&self->cuda_info),
+                               GST_VIDEO_INFO_HEIGHT(&self->cuda_info),
+                               GST_VIDEO_INFO_PAR_N(&self->cuda_info),
+                               GST_VIDEO_INFO_PAR_D(&self->cuda_info),
+                               self->out_width, self->out_height,
+                               add_borders, method, geo);
+        scale_geometry_set_border_rgb(geo, border_color, self->rgb10_output);
+
+        gint32 by, bu, bv;
+        colorimetry_rgb_to_yuv(&GST_VIDEO_INFO_COLORIMETRY(&self->cuda_info), in_depth,
+                               (border_color >> 16) & 0xff, (border_color >> 8) & 0xff,
+                               border_color & 0xff, &by, &bu, &bv);
+        geo->border_y = by;
+        geo->border_u = bu;
+        geo->border_v = bv;
+
+        self->btx.scaling = scale_geometry_is_scaling(geo);
+        if (self->btx.scaling)
+            GST_INFO_OBJECT(self, "Scaling %dx%d -> %dx%d (picture %dx%d at %d,%d, %s)",
+                            geo->src_w, geo->src_h, geo->out_w, geo->out_h,
+                            geo->dst_w, geo->dst_h, geo->dst_x, geo->dst_y,
+                            method == SCALE_METHOD_NEAREST ? "nearest" : "bilinear");
+    }
+    else
+    {
+        self->btx.scaling = FALSE;
+    }
+
+    self->gpu_convert_failed = FALSE;
+    gst_cuda_dmabuf_upload_clear_cpu_pool(self);
+
+    if (self->calibrate_modifiers)
+        gst_cuda_dmabuf_upload_calibrate(self);
+
+    /* Pay the GBM/EGL/CUDA setup for the output buffers once, at negotiation,
+     * instead of on the first frame, or on a thread the first frame joins
+     * with async-setup. Not needed when Vulkan-exported buffers will be
+     * used for semi-planar output. */
+    if (self->cuda_input &&
+        !(self->semi_planar_output && self->external_fd_pool.initialized && !self->btx.scaling))
+    {
+        if (async_setup)
+        {
+            gst_cuda_dmabuf_upload_start_setup(self);
+        }
+        else
+        {
+            /* Current as on the setup thread */
+            if (self->cuda_ctx)
+                gst_cuda_context_push(self->cuda_ctx);
+            gboolean ok = gst_cuda_dmabuf_upload_ensure_egl_pool(self, self->cuda_ctx);
+            if (self->cuda_ctx)
+                gst_cuda_context_pop(NULL);
+
+            if (!ok)
+                return gst_cuda_dmabuf_upload_egl_setup_failed(self);
+        }
+    }
+
     return TRUE;
 }
 
+/* transform_caps result before the filter, offering the modifiers of
+ * @formats ordered by @ranking */
+static GstCaps *
+gst_cuda_dmabuf_upload_build_caps(GstCudaDmabufUpload *self,
+                                  GstPadDirection direction,
+                                  GstCaps *caps,
+                                  const DrmFormatTable *formats,
+                                  ModifierRanking *ranking)
+{
+    GstCaps *outcaps;
+
+    if (direction == GST_PAD_SINK)
+    {
+        /* sink → src: respect force-linear property */
+        return caps_transform_sink_to_src(caps, self->force_linear, formats, ranking);
+    }
+
+    /* src → sink: reverse transform */
+    if (gst_caps_get_size(caps) == 0 || gst_caps_is_any(caps))
+        return gst_static_pad_template_get_caps(&sink_template);
+
+    outcaps = caps_transform_src_to_sink(caps);
+
+    if (gst_caps_is_empty(outcaps))
+    {
+        gst_caps_unref(outcaps);
+        outcaps = gst_static_pad_template_get_caps(&sink_template);
+    }
+
+    return outcaps;
+}
+
 static GstCaps *
 gst_cuda_dmabuf_upload_transform_caps(GstBaseTransform *base,
                                       GstPadDirection direction,
                                       GstCaps *caps,
                                       GstCaps *filter)
 {
+    GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
     GstCaps *outcaps;
 
     GST_DEBUG_OBJECT(base, "transform_caps direction=%s",
                      direction == GST_PAD_SINK ? "SINK" : "SRC");
 
+    /* First negotiation: learn which modifiers the device supports */
+    ModifierRanking *ranking;
+    const DrmFormatTable *formats = gst_cuda_dmabuf_upload_probe_formats(self, &ranking);
+
+    /* Results depend on the format table and ranking too: new ones miss.
+     * Both are per device, so the table also tells the rankings apart. */
+    CapsCacheKey key = {direction, self->force_linear, formats,
+                        modifier_ranking_get_generation(ranking)};
+
+    outcaps = caps_cache_lookup(self->caps_cache, &key, caps);
+    if (!outcaps)
+    {
+        outcaps = gst_cuda_dmabuf_upload_build_caps(self, direction, caps, formats, ranking);
+        caps_cache_insert(self->caps_cache, &key, caps, outcaps);
+    }
+
+    if (filter)
+    {
+        GstCaps *tmp = gst_caps_intersect_full(outcaps, filter, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref(outcaps);
+        outcaps = tmp;
+    }
+
+    return outcaps;
+}
+
+/* Prefer the input size; when downstream fixes only one dimension, derive
+ * the other from the input display aspect ratio */
+static GstCaps *
+gst_cuda_dmabuf_upload_fixate_caps(GstBaseTransform *base,
+                                   GstPadDirection direction,
+                                   GstCaps *caps,
+                                   GstCaps *othercaps)
+{
+    othercaps = gst_caps_truncate(othercaps);
+    othercaps = gst_caps_make_writable(othercaps);
+
+    GstStructure *in_s = gst_caps_get_structure(caps, 0);
+    GstStructure *out_s = gst_caps_get_structure(othercaps, 0);
+    gint in_w = 0, in_h = 0, out_w = 0, out_h = 0;
+    gint par_n = 1, par_d = 1;
+
+    if (!gst_structure_get_int(in_s, "width", &in_w) ||
+        !gst_structure_get_int(in_s, "height", &in_h))
+        return gst_caps_fixate(othercaps);
+
     if (direction == GST_PAD_SINK)
+        gst_structure_get_fraction(in_s, "pixel-aspect-ratio", &par_n, &par_d);
+
+    gboolean w_fixed = gst_structure_get_int(out_s, "width", &out_w);
+    gboolean h_fixed = gst_structure_get_int(out_s, "height", &out_h);
+
+    if (w_fixed && !h_fixed && par_n > 0)
     {
-        GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
-        /* sink → src: respect force-linear property */
-        outcaps = caps_transform_sink_to_src(caps, self->force_linear);
+        gint h = (gint)gst_util_uint64_scale_int_round((guint64)out_w * in_h, par_d, in_w * par_n);
+        gst_structure_fixate_field_nearest_int(out_s, "height", MAX(h, 1));
+    }
+    else if (h_fixed && !w_fixed && par_d > 0)
+    {
+        gint w = (gint)gst_util_uint64_scale_int_round((guint64)out_h * in_w, par_n, in_h * par_d);
+        gst_structure_fixate_field_nearest_int(out_s, "width", MAX(w, 1));
     }
     else
     {
-        /* src → sink: reverse transform */
-        if (gst_caps_get_size(caps) == 0 || gst_caps_is_any(caps))
+        if (gst_structure_has_field(out_s, "width"))
+            gst_structure_fixate_field_nearest_int(out_s, "width", in_w);
+        else
+            gst_structure_set(out_s, "width", G_TYPE_INT, in_w, NULL);
+
+        if (gst_structure_has_field(out_s, "height"))
+            gst_structure_fixate_field_nearest_int(out_s, "height", in_h);
+        else
+            gst_structure_set(out_s, "height", G_TYPE_INT, in_h, NULL);
+    }
+
+    GST_DEBUG_OBJECT(base, "fixated to %" GST_PTR_FORMAT, othercaps);
+
+    return gst_caps_fixate(othercaps);
+}
+
+/* ============================================================================
+ * Live Renegotiation
+ * ============================================================================ */
+
+/* The CUDA-EGL layout the next negotiation is expected to pick: the first
+ * of our src caps downstream accepts, at the current output size unless
+ * that caps fixes another */
+static gboolean
+gst_cuda_dmabuf_upload_predict_layout(GstCudaDmabufUpload *self, EglPoolLayout *layout)
+{
+    GstBaseTransform *base = GST_BASE_TRANSFORM(self);
+    GstCaps *incaps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(base));
+    GstCaps *outcaps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SRC_PAD(base));
+    gboolean ok = FALSE;
+
+    if (!incaps || !outcaps ||
+        !gst_caps_features_contains(gst_caps_get_features(incaps, 0),
+                                    GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY))
+        goto done;
+
+    GstCaps *ours = gst_cuda_dmabuf_upload_transform_caps(base, GST_PAD_SINK, incaps, NULL);
+    GstCaps *peer = gst_pad_peer_query_caps(GST_BASE_TRANSFORM_SRC_PAD(base), ours);
+    GstCaps *next = gst_caps_intersect_full(ours, peer, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref(ours);
+    gst_caps_unref(peer);
+
+    if (!gst_caps_is_empty(next))
+    {
+        GstStructure *s = gst_caps_get_structure(next, 0);
+        GstStructure *cur = gst_caps_get_structure(outcaps, 0);
+        const gchar *drm_format = gst_structure_get_string(s, "drm-format");
+        gint width = 0, height = 0;
+
+        if (!gst_structure_get_int(s, "width", &width))
+            gst_structure_get_int(cur, "width", &width);
+        if (!gst_structure_get_int(s, "height", &height))
+            gst_structure_get_int(cur, "height", &height);
+
+        /* System-memory BGRx and Vulkan-exported buffers need no CUDA-EGL pool */
+        if (drm_format && width > 0 && height > 0 &&
+            !(drm_format_is_semi_planar_420(drm_format) && self->external_fd_pool.initialized))
+            ok = gst_cuda_dmabuf_upload_egl_pool_layout(drm_format_is_semi_planar_420(drm_format),
+                                                        drm_format_is_p010(drm_format),
+                                                        drm_format_is_rgb10(drm_format),
+                                                        drm_format_parse_modifier(drm_format),
+                                                        self->force_linear, width, height, layout);
+        if (ok)
+            gst_cuda_dmabuf_upload_egl_pool_capacity(self, layout);
+    }
+    gst_caps_unref(next);
+
+done:
+    if (incaps)
+        gst_caps_unref(incaps);
+    if (outcaps)
+        gst_caps_unref(outcaps);
+    return ok;
+}
+
+static gpointer
+gst_cuda_dmabuf_upload_prebuild_thread(gpointer data)
+{
+    GstCudaDmabufUpload *self = data;
+    gboolean again, deferred = FALSE;
+
+    do
+    {
+        EglPoolLayout layout;
+        GstBufferPool *pool = NULL;
+        GstBufferPool *drop = NULL;
+        GstBufferPool *topup;
+        GstCudaContext *cuda_ctx;
+        gboolean needed;
+
+        g_mutex_lock(&self->prebuild_lock);
+        self->prebuild_again = FALSE;
+        topup = self->topup_pool;
+        self->topup_pool = NULL;
+        cuda_ctx = gst_object_ref(self->prebuild_cuda_ctx);
+        g_mutex_unlock(&self->prebuild_lock);
+
+        /* A pool built mid-stream with one buffer: add the rest here */
+        if (topup)
         {
-            outcaps = gst_static_pad_template_get_caps(&sink_template);
-            goto filter_caps;
+            guint min_buffers, max_buffers;
+            gst_cuda_dmabuf_upload_get_pool_bounds(self, &min_buffers, &max_buffers);
+
+            gst_cuda_context_push(cuda_ctx);
+            gst_pooled_buffer_pool_preallocate(GST_POOLED_BUFFER_POOL(topup), min_buffers);
+            gst_cuda_context_pop(NULL);
+            gst_object_unref(topup);
         }
 
-        outcaps = caps_transform_src_to_sink(caps);
+        needed = gst_cuda_dmabuf_upload_predict_layout(self, &layout);
+
+        /* Nothing to do when a pool for it already exists */
+        g_mutex_lock(&self->prebuild_lock);
+        needed = needed &&
+                 !gst_cuda_dmabuf_upload_egl_pool_matches(self->egl_pool, &layout) &&
+                 !gst_cuda_dmabuf_upload_egl_pool_matches(self->egl_standby_pool, &layout) &&
+                 !gst_cuda_dmabuf_upload_egl_pool_matches(self->prebuilt_pool, &layout);
+        g_mutex_unlock(&self->prebuild_lock);
+
+        if (needed)
+        {
+            GST_DEBUG_OBJECT(self, "Prebuilding CUDA-EGL pool for %s %dx%d",
+                             gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&layout.info)),
+                             GST_VIDEO_INFO_WIDTH(&layout.info),
+                             GST_VIDEO_INFO_HEIGHT(&layout.info));
+
+            gst_cuda_context_push(cuda_ctx);
+            pool = gst_cuda_dmabuf_upload_build_egl_pool(self, cuda_ctx, &layout, FALSE);
+            gst_cuda_context_pop(NULL);
+        }
+        gst_object_unref(cuda_ctx);
 
-        if (gst_caps_is_empty(outcaps))
+        g_mutex_lock(&self->prebuild_lock);
+        if (pool)
+        {
+            drop = self->prebuilt_pool;
+            self->prebuilt_pool = pool;
+        }
+        again = self->prebuild_again;
+        if (!again)
         {
-            gst_caps_unref(outcaps);
-            outcaps = gst_static_pad_template_get_caps(&sink_template);
+            self->prebuild_running = FALSE;
+            g_cond_broadcast(&self->prebuild_cond);
+            deferred = self->reconfigure_deferred;
+            self->reconfigure_deferred = FALSE;
         }
+        g_mutex_unlock(&self->prebuild_lock);
+
+        gst_cuda_dmabuf_upload_drop_pool(&drop);
+    } while (again);
+
+    /* Let the held-back renegotiation through: it finds the pool ready */
+    if (deferred)
+        gst_pad_mark_reconfigure(GST_BASE_TRANSFORM_SRC_PAD(self));
+
+    gst_object_unref(self);
+    return NULL;
+}
+
+/* Build the pool a renegotiation will need before it happens. Until it's
+ * ready, submit_input_buffer holds the renegotiation back, so frames keep
+ * flowing in the current format instead of stalling on 4+ EGL buffer
+ * registrations. */
+static void
+gst_cuda_dmabuf_upload_start_prebuild(GstCudaDmabufUpload *self)
+{
+    g_mutex_lock(&self->prebuild_lock);
+
+    /* The setup thread is writing btx: run once it's joined */
+    if (self->setup_pending)
+    {
+        self->prebuild_after_setup = TRUE;
+        g_mutex_unlock(&self->prebuild_lock);
+        return;
     }
 
-filter_caps:
-    if (filter)
+    /* Only renegotiations of CUDA input, once the interop is set up.
+     * propose_allocation may replace cuda_ctx meanwhile: the thread pushes
+     * its own reference, taken like setup_cuda_ctx. */
+    if (!self->btx.egl_ctx || !self->cuda_ctx)
     {
-        GstCaps *tmp = gst_caps_intersect_full(outcaps, filter, GST_CAPS_INTERSECT_FIRST);
-        gst_caps_unref(outcaps);
-        outcaps = tmp;
+        g_mutex_unlock(&self->prebuild_lock);
+        return;
     }
+    gst_object_replace((GstObject **)&self->prebuild_cuda_ctx, GST_OBJECT(self->cuda_ctx));
 
-    return outcaps;
+    if (self->prebuild_running)
+    {
+        self->prebuild_again = TRUE;
+    }
+    else
+    {
+        self->prebuild_running = TRUE;
+        g_thread_unref(g_thread_new("cudadmabuf-prebuild",
+                                    gst_cuda_dmabuf_upload_prebuild_thread,
+                                    gst_object_ref(self)));
+    }
+    g_mutex_unlock(&self->prebuild_lock);
+}
+
+static gboolean
+gst_cuda_dmabuf_upload_src_event(GstBaseTransform *base, GstEvent *event)
+{
+    /* Downstream wants to renegotiate (e.g. output hotplug) */
+    if (GST_EVENT_TYPE(event) == GST_EVENT_RECONFIGURE)
+        gst_cuda_dmabuf_upload_start_prebuild(GST_CUDA_DMABUF_UPLOAD(base));
+
+    return GST_BASE_TRANSFORM_CLASS(gst_cuda_dmabuf_upload_parent_class)->src_event(base, event);
+}
+
+static GstFlowReturn
+gst_cuda_dmabuf_upload_submit_input_buffer(GstBaseTransform *base, gboolean is_discont,
+                                           GstBuffer *input)
+{
+    GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
+
+    /* Take the pending reconfigure off the pad while the prebuild runs; the
+     * prebuild thread puts it back when done */
+    g_mutex_lock(&self->prebuild_lock);
+    if (self->prebuild_running && gst_pad_check_reconfigure(GST_BASE_TRANSFORM_SRC_PAD(base)))
+        self->reconfigure_deferred = TRUE;
+    g_mutex_unlock(&self->prebuild_lock);
+
+    return GST_BASE_TRANSFORM_CLASS(gst_cuda_dmabuf_upload_parent_class)
+        ->submit_input_buffer(base, is_discont, input);
+}
+
+/* ============================================================================
+ * Allocation
+ * ============================================================================ */
+
+static void
+gst_cuda_dmabuf_upload_clear_upstream_pool(GstCudaDmabufUpload *self)
+{
+    if (!self->upstream_pool)
+        return;
+
+    gst_buffer_pool_set_active(self->upstream_pool, FALSE);
+    gst_object_unref(self->upstream_pool);
+    self->upstream_pool = NULL;
+}
+
+/* Offer upstream LINEAR GBM buffers with the negotiated output layout, so
+ * a system-memory producer writes straight into the DMA-BUF and transform()
+ * can pass the buffer on without a copy. Only BGRx, NV12 and P010 have the
+ * same layout on both sides (I420 must still be interleaved). */
+static gboolean
+gst_cuda_dmabuf_upload_propose_gbm_pool(GstCudaDmabufUpload *self, GstCaps *caps,
+                                        const GstVideoInfo *info, GstQuery *query)
+{
+    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(info);
+
+    gst_cuda_dmabuf_upload_clear_upstream_pool(self);
+
+    /* CPU writes need a LINEAR layout; tiled output keeps the copy */
+    if (self->negotiated_modifier != DRM_FORMAT_MOD_LINEAR)
+        return FALSE;
+    if (format != GST_VIDEO_FORMAT_BGRx && format != GST_VIDEO_FORMAT_NV12 &&
+        format != GST_VIDEO_FORMAT_P010_10LE)
+        return FALSE;
+
+    gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, NULL);
+    GstBufferPool *pool = gst_gbm_dmabuf_pool_new(info, DRM_FORMAT_MOD_LINEAR, drm_device);
+    g_free(drm_device);
+    GstStructure *config = gst_buffer_pool_get_config(pool);
+    guint size = GST_VIDEO_INFO_SIZE(info);
+    gst_buffer_pool_config_set_params(config, caps, size, 4, 0);
+    gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+    if (!gst_buffer_pool_set_config(pool, config))
+    {
+        GST_WARNING_OBJECT(self, "Failed to configure upstream GBM pool, copying instead");
+        gst_object_unref(pool);
+        return FALSE;
+    }
+
+    gst_query_add_allocation_pool(query, pool, size, 4, 0);
+    gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, NULL);
+    self->upstream_pool = pool;
+
+    GST_INFO_OBJECT(self, "Proposed LINEAR GBM pool upstream for %s",
+                    gst_video_format_to_string(format));
+    return TRUE;
 }
 
-/* ============================================================================
- * Allocation
- * ============================================================================ */
-
 static gboolean
 gst_cuda_dmabuf_upload_propose_allocation(GstBaseTransform *base,
                                           GstQuery *decide_query,
@@ -272,23 +1667,23 @@ gst_cuda_dmabuf_upload_propose_allocation(GstBaseTransform *base,
     GstCapsFeatures *features = gst_caps_get_features(caps, 0);
     if (!gst_caps_features_contains(features, GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY))
     {
+        if (gst_cuda_dmabuf_upload_propose_gbm_pool(self, caps, &info, query))
+            return TRUE;
+
         return GST_BASE_TRANSFORM_CLASS(gst_cuda_dmabuf_upload_parent_class)
             ->propose_allocation(base, decide_query, query);
     }
 
     /* Get CUDA context from upstream */
-    GstQuery *ctx_query = gst_query_new_context("gst.cuda.context");
-    if (gst_pad_peer_query(GST_BASE_TRANSFORM_SINK_PAD(base), ctx_query))
+    GstCudaContext *cuda_ctx = gst_cuda_dmabuf_upload_peer_cuda_context(self);
+    if (cuda_ctx)
     {
-        GstContext *ctx = NULL;
-        gst_query_parse_context(ctx_query, &ctx);
-        if (ctx)
-        {
-            const GstStructure *s = gst_context_get_structure(ctx);
-            gst_structure_get(s, "gst.cuda.context", GST_TYPE_CUDA_CONTEXT, &self->cuda_ctx, NULL);
-        }
+        /* start_prebuild refs it under the same lock */
+        g_mutex_lock(&self->prebuild_lock);
+        gst_object_replace((GstObject **)&self->cuda_ctx, GST_OBJECT(cuda_ctx));
+        g_mutex_unlock(&self->prebuild_lock);
+        gst_object_unref(cuda_ctx);
     }
-    gst_query_unref(ctx_query);
 
     if (!self->cuda_ctx)
     {
@@ -333,6 +1728,9 @@ gst_cuda_dmabuf_upload_decide_allocation(GstBaseTransform *base, GstQuery *query
 {
     GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
 
+    self->downstream_video_meta =
+        gst_query_find_allocation_meta(query, GST_VIDEO_META_API_TYPE, NULL);
+
     if (self->pool)
     {
         gst_buffer_pool_set_active(self->pool, FALSE);
@@ -346,8 +1744,26 @@ gst_cuda_dmabuf_upload_decide_allocation(GstBaseTransform *base, GstQuery *query
             ->decide_allocation(base, query);
     }
 
-    guint size = GST_VIDEO_INFO_SIZE(&self->info);
-    self->pool = gst_gbm_dmabuf_pool_new(&self->info, self->negotiated_modifier);
+    /* System-memory YUV lands in NV12/P010 planes (I420 is interleaved) */
+    GstVideoInfo pool_info = self->info;
+    if (!self->cuda_input && self->semi_planar_output)
+    {
+        gst_video_info_set_format(&pool_info,
+                                  self->p010_output ? GST_VIDEO_FORMAT_P010_10LE : GST_VIDEO_FORMAT_NV12,
+                                  GST_VIDEO_INFO_WIDTH(&self->info),
+                                  GST_VIDEO_INFO_HEIGHT(&self->info));
+    }
+
+    /* System-memory copies are split across the worker threads */
+    if (!self->cuda_input)
+        gst_cuda_dmabuf_upload_ensure_workers(self);
+
+    guint size = GST_VIDEO_INFO_SIZE(&pool_info);
+    guint min_buffers, max_buffers;
+    gst_cuda_dmabuf_upload_get_pool_bounds(self, &min_buffers, &max_buffers);
+    gchar *drm_device = gst_cuda_dmabuf_upload_get_drm_device(self, NULL);
+    self->pool = gst_gbm_dmabuf_pool_new(&pool_info, self->negotiated_modifier, drm_device);
+    g_free(drm_device);
 
     GstStructure *config = gst_buffer_pool_get_config(self->pool);
     GstCaps *caps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SRC_PAD(base));
@@ -357,7 +1773,7 @@ gst_cuda_dmabuf_upload_decide_allocation(GstBaseTransform *base, GstQuery *query
         gst_caps_set_features(caps, 0, gst_caps_features_new("memory:DMABuf", NULL));
     }
 
-    gst_buffer_pool_config_set_params(config, caps, size, 4, 8);
+    gst_buffer_pool_config_set_params(config, caps, size, min_buffers, max_buffers);
     gst_caps_unref(caps);
     gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
 
@@ -370,7 +1786,7 @@ gst_cuda_dmabuf_upload_decide_allocation(GstBaseTransform *base, GstQuery *query
         return FALSE;
     }
 
-    gst_query_add_allocation_pool(query, self->pool, size, 4, 8);
+    gst_query_add_allocation_pool(query, self->pool, size, min_buffers, max_buffers);
     gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, NULL);
     return TRUE;
 }
@@ -379,83 +1795,200 @@ gst_cuda_dmabuf_upload_decide_allocation(GstBaseTransform *base, GstQuery *query
  * Transform
  * ============================================================================ */
 
+static void
+gst_cuda_dmabuf_upload_count_frame(GstCudaDmabufUpload *self, guint64 *counter)
+{
+    guint64 first_frame = 0;
+
+    GST_OBJECT_LOCK(self);
+    (*counter)++;
+    if (self->startup.first_frame_usec == 0 && self->startup.caps_time != 0)
+        first_frame = self->startup.first_frame_usec =
+            (guint64)(g_get_monotonic_time() - self->startup.caps_time);
+    GST_OBJECT_UNLOCK(self);
+
+    if (first_frame)
+        GST_INFO_OBJECT(self, "Startup phase first-frame: %" G_GUINT64_FORMAT " us", first_frame);
+}
+
+/* Whether the decoder's own memory can be handed downstream unchanged */
+static gboolean
+gst_cuda_dmabuf_upload_can_export(GstCudaDmabufUpload *self, GstBuffer *inbuf)
+{
+    if (!self->cuda_export)
+        return FALSE;
+
+    /* The decoder's memory has the input size */
+    if (self->btx.scaling)
+        return FALSE;
+
+    /* CUDA MMAP allocations are pitch-linear */
+    if (self->negotiated_modifier != DRM_FORMAT_MOD_LINEAR)
+        return FALSE;
+
+    /* Upstream must be using the MMAP pool we proposed */
+    if (gst_buffer_n_memory(inbuf) != 1)
+        return FALSE;
+    GstMemory *mem = gst_buffer_peek_memory(inbuf, 0);
+    if (!gst_is_cuda_memory(mem) ||
+        gst_cuda_memory_get_alloc_method(GST_CUDA_MEMORY_CAST(mem)) != GST_CUDA_MEMORY_ALLOC_MMAP)
+        return FALSE;
+
+    /* Downstream honours plane strides/offsets from the video meta */
+    if (self->downstream_video_meta)
+        return TRUE;
+
+    /* Otherwise the layout must match the default one for the caps */
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(inbuf);
+    if (!vmeta)
+        return TRUE;
+
+    for (guint i = 0; i < vmeta->n_planes; i++)
+    {
+        if (vmeta->stride[i] != GST_VIDEO_INFO_PLANE_STRIDE(&self->cuda_info, i) ||
+            vmeta->offset[i] != GST_VIDEO_INFO_PLANE_OFFSET(&self->cuda_info, i))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Whether a buffer upstream wrote into our proposed GBM pool can go
+ * downstream as is. Its video meta carries GBM's strides, which downstream
+ * must either read or find equal to the default layout. */
+static gboolean
+gst_cuda_dmabuf_upload_can_pass_upstream(GstCudaDmabufUpload *self, GstBuffer *inbuf)
+{
+    if (!self->upstream_pool || inbuf->pool != self->upstream_pool ||
+        self->negotiated_modifier != DRM_FORMAT_MOD_LINEAR)
+        return FALSE;
+
+    if (self->downstream_video_meta)
+        return TRUE;
+
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(inbuf);
+    if (!vmeta)
+        return FALSE;
+
+    for (guint i = 0; i < vmeta->n_planes; i++)
+    {
+        if (vmeta->stride[i] != GST_VIDEO_INFO_PLANE_STRIDE(&self->info, i) ||
+            vmeta->offset[i] != GST_VIDEO_INFO_PLANE_OFFSET(&self->info, i))
+            return FALSE;
+    }
+    return TRUE;
+}
+
 static GstFlowReturn
 gst_cuda_dmabuf_upload_prepare_output_buffer(GstBaseTransform *base,
                                              GstBuffer *inbuf,
                                              GstBuffer **outbuf)
 {
     GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
+    GstFlowReturn ret;
+
+    /* The first frame after negotiation picks up the background setup,
+     * and any prebuild requested while it ran */
+    if (self->setup_thread)
+    {
+        if (!gst_cuda_dmabuf_upload_join_setup(self) &&
+            !gst_cuda_dmabuf_upload_egl_setup_failed(self))
+            return GST_FLOW_NOT_NEGOTIATED;
+        gst_cuda_dmabuf_upload_resume_prebuild(self);
+    }
 
     /* NV12/P010 zero-copy passthrough path */
     if (self->cuda_input && self->semi_planar_output)
     {
-        guint width = GST_VIDEO_INFO_WIDTH(&self->cuda_info);
-        guint height = GST_VIDEO_INFO_HEIGHT(&self->cuda_info);
-
-        /* Prefer external FD pool (Vulkan-exported) if available */
+        /* Prefer external FD pool (Vulkan-exported) if available. Its
+         * buffers are allocated by the application at the input size, so
+         * it is bypassed when scaling. */
         if (self->external_fd_pool.initialized &&
-            self->external_fd_pool.count > 0)
+            self->external_fd_pool.count > 0 && !self->btx.scaling)
         {
             /* Initialize dmabuf allocator if needed */
             if (!self->btx.dmabuf_allocator)
-                self->btx.dmabuf_allocator = gst_dmabuf_allocator_new();
+                self->btx.dmabuf_allocator = buffer_fence_allocator_new();
 
-            return buffer_transform_external_fd_passthrough(
+            ret = buffer_transform_external_fd_passthrough(
                 &self->btx, &self->external_fd_pool,
                 inbuf, outbuf, &self->cuda_info, self->p010_output);
+            if (ret == GST_FLOW_OK)
+                gst_cuda_dmabuf_upload_count_frame(self, &self->stats.external_frames);
+            return ret;
         }
 
-        /* Fallback: GBM/EGL path */
-
-        /* Initialize buffer transform context if needed */
-        if (!self->btx.egl_ctx)
+        /* Export mode: the decoder's memory goes straight downstream */
+        if (gst_cuda_dmabuf_upload_can_export(self, inbuf))
         {
-            if (!buffer_transform_context_init(&self->btx, &self->egl_ctx,
-                                               self->negotiated_modifier))
+            ret = buffer_transform_cuda_export(&self->btx, inbuf, outbuf, &self->cuda_info);
+            if (ret == GST_FLOW_OK)
             {
-                GST_ERROR_OBJECT(self, "Failed to initialize buffer transform context");
-                return GST_FLOW_ERROR;
+                gst_cuda_dmabuf_upload_count_frame(self, &self->stats.export_frames);
+                return ret;
             }
+            GST_DEBUG_OBJECT(self, "CUDA export failed, falling back to copy");
         }
 
-        /* For P010: allocate GBM NV12 with 2x width.
-         * P010 has 16-bit (2-byte) samples, NV12 has 8-bit (1-byte).
-         * NV12 at width*2 has identical byte layout to P010 at width. */
-        guint alloc_width = self->p010_output ? width * 2 : width;
-
-        if (pooled_buffer_pool_needs_reinit(&self->semi_planar_pool, alloc_width, height))
-        {
-            pooled_buffer_pool_cleanup(&self->semi_planar_pool, &self->egl_ctx);
-            if (!pooled_buffer_pool_init(&self->semi_planar_pool, &self->egl_ctx,
-                                         SEMI_PLANAR_POOL_SIZE, alloc_width, height,
-                                         GBM_FORMAT_NV12, self->negotiated_modifier,
-                                         self->force_linear))
-            {
-                GST_ERROR_OBJECT(self, "Failed to initialize semi-planar buffer pool");
-                return GST_FLOW_ERROR;
-            }
-        }
+        /* Fallback: GBM/EGL path */
+        if (!gst_cuda_dmabuf_upload_ensure_egl_pool(self, self->cuda_ctx))
+            return GST_FLOW_ERROR;
 
-        return buffer_transform_semi_planar_passthrough(
-            &self->btx, &self->semi_planar_pool,
+        ret = buffer_transform_semi_planar_passthrough(
+            &self->btx, self->egl_pool,
             inbuf, outbuf, &self->cuda_info, self->p010_output);
+        if (ret == GST_FLOW_OK)
+            gst_cuda_dmabuf_upload_count_frame(self, &self->stats.copy_frames);
+        return ret;
     }
 
-    /* NV12→BGRx conversion path (CUDA input, XR24 output) */
+    /* YUV→RGB conversion path (CUDA input, XR24/XR30/AR30 output) */
     if (self->cuda_input)
     {
-        /* Initialize buffer transform context if needed */
-        if (!self->btx.egl_ctx)
+        if (!self->gpu_convert_failed)
         {
-            if (!buffer_transform_context_init(&self->btx, &self->egl_ctx,
-                                               self->negotiated_modifier))
+            if (gst_cuda_dmabuf_upload_ensure_egl_pool(self, self->cuda_ctx))
+            {
+                if (GST_VIDEO_INFO_FORMAT(&self->cuda_info) == GST_VIDEO_FORMAT_P010_10LE)
+                    ret = buffer_transform_p010_to_rgb(&self->btx, self->egl_pool,
+                                                       inbuf, outbuf, &self->cuda_info,
+                                                       self->rgb10_output);
+                else
+                    ret = buffer_transform_nv12_to_bgrx(&self->btx, self->egl_pool,
+                                                        inbuf, outbuf, &self->cuda_info);
+                if (ret == GST_FLOW_OK)
+                {
+                    gst_cuda_dmabuf_upload_count_frame(self, &self->stats.convert_frames);
+                    return ret;
+                }
+            }
+            else
             {
-                GST_ERROR_OBJECT(self, "Failed to initialize buffer transform context");
-                return GST_FLOW_ERROR;
+                ret = GST_FLOW_ERROR;
+                /* Don't retry the CUDA-EGL setup on every frame */
+                if (gst_cuda_dmabuf_upload_can_cpu_convert(self))
+                    self->gpu_convert_failed = TRUE;
             }
+
+            if (!gst_cuda_dmabuf_upload_can_cpu_convert(self))
+                return ret;
+
+            GST_WARNING_OBJECT(self, "GPU conversion failed, converting on the CPU");
         }
 
-        return buffer_transform_nv12_to_bgrx(&self->btx, inbuf, outbuf, &self->cuda_info);
+        ret = gst_cuda_dmabuf_upload_cpu_convert(self, inbuf, outbuf);
+        if (ret == GST_FLOW_OK)
+            gst_cuda_dmabuf_upload_count_frame(self, &self->stats.cpu_frames);
+        return ret;
+    }
+
+    /* Upstream wrote into the pool we proposed: already a LINEAR DMA-BUF
+     * with the output layout, hand it on as is. No ref: basetransform
+     * treats outbuf == inbuf as the input's own reference, and an extra
+     * one would keep the buffer from returning to the pool. */
+    if (gst_cuda_dmabuf_upload_can_pass_upstream(self, inbuf))
+    {
+        *outbuf = inbuf;
+        return GST_FLOW_OK;
     }
 
     /* Non-CUDA path: use GBM pool */
@@ -468,17 +2001,115 @@ gst_cuda_dmabuf_upload_prepare_output_buffer(GstBaseTransform *base,
     return gst_buffer_pool_acquire_buffer(self->pool, outbuf, NULL);
 }
 
+/* State of one output buffer's fence export */
+typedef struct
+{
+    GstCudaDmabufUpload *self;
+    gpointer event; /* The event sync_file was created from */
+    int sync_file;
+} FenceExportState;
+
+/* A BufferFenceExportFunc. Planes of a buffer share one fence, and so
+ * one sync_file. */
+static gboolean
+gst_cuda_dmabuf_upload_export_fence(gpointer event, GstMemory *mem, gpointer user_data)
+{
+    FenceExportState *state = user_data;
+    GstCudaDmabufUpload *self = state->self;
+
+    if (!self->fence_export || !gst_is_dmabuf_memory(mem))
+        return FALSE;
+
+    if (state->event != event)
+    {
+        if (state->sync_file >= 0)
+            close(state->sync_file);
+        state->event = event;
+        state->sync_file = fence_export_sync_file(self->fence_export, (CUevent)event);
+    }
+    if (state->sync_file < 0)
+        return FALSE;
+
+    if (!fence_export_attach(gst_dmabuf_memory_get_fd(mem), state->sync_file))
+    {
+        /* The kernel won't grow the ioctl: stop trying */
+        GST_WARNING_OBJECT(self, "Kernel can't attach fences to DMA-BUFs, "
+                                 "waiting on the CPU before each push");
+        g_clear_pointer(&self->fence_export, fence_export_free);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Make a consumer importing the DMA-BUF without mapping it wait for the
+ * copy: with a sync_file in the DMA-BUF's implicit fences where EGL and
+ * the kernel support it, on the CPU otherwise */
+static gboolean
+gst_cuda_dmabuf_upload_fence_output(GstCudaDmabufUpload *self, GstBuffer *outbuf)
+{
+    if (!self->fence_export_probed && self->egl_ctx.initialized &&
+        self->egl_ctx.egl_display != EGL_NO_DISPLAY)
+    {
+        self->fence_export_probed = TRUE;
+        self->fence_export = fence_export_new(self->egl_ctx.egl_display);
+        if (self->fence_export)
+            GST_INFO_OBJECT(self, "Exporting output fences as sync_files");
+        else
+            GST_INFO_OBJECT(self, "Fence export unsupported, waiting on the CPU before each push");
+    }
+
+    if (!self->fence_export || !self->cuda_ctx)
+        return buffer_fence_wait_buffer(outbuf);
+
+    FenceExportState state = {self, NULL, -1};
+    gboolean ret;
+
+    /* The events belong to upstream's CUDA context */
+    gst_cuda_context_push(self->cuda_ctx);
+    ret = buffer_fence_export_buffer(outbuf, gst_cuda_dmabuf_upload_export_fence, &state);
+    gst_cuda_context_pop(NULL);
+
+    if (state.sync_file >= 0)
+        close(state.sync_file);
+    return ret;
+}
+
 static GstFlowReturn
 gst_cuda_dmabuf_upload_transform(GstBaseTransform *base, GstBuffer *inbuf, GstBuffer *outbuf)
 {
     GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(base);
 
-    /* CUDA paths handled in prepare_output_buffer */
+    /* CUDA paths handled in prepare_output_buffer. With deferred sync,
+     * a consumer importing the DMA-BUF without mapping it would sample it
+     * before the copy finishes, so the fence goes with the buffer (or is
+     * waited on here), unless the consumer syncs the buffers itself. */
     if (self->cuda_input)
+    {
+        if (self->deferred_sync && !self->consumer_syncs &&
+            !gst_cuda_dmabuf_upload_fence_output(self, outbuf))
+        {
+            GST_ERROR_OBJECT(self, "Fencing the output buffer failed");
+            return GST_FLOW_ERROR;
+        }
+        return GST_FLOW_OK;
+    }
+
+    /* Passed through from the proposed pool, nothing to copy */
+    if (inbuf == outbuf)
+    {
+        gst_cuda_dmabuf_upload_count_frame(self, &self->stats.upstream_frames);
         return GST_FLOW_OK;
+    }
 
-    /* Non-CUDA: copy BGRx to DMABUF */
-    return buffer_transform_bgrx_copy(inbuf, outbuf, &self->info);
+    /* Non-CUDA: copy NV12/I420/P010 planes or BGRx to DMABUF */
+    GstFlowReturn ret;
+    if (self->semi_planar_output)
+        ret = buffer_transform_system_semi_planar(inbuf, outbuf, &self->info, self->cpu_workers);
+    else
+        ret = buffer_transform_bgrx_copy(inbuf, outbuf, &self->info, self->cpu_workers);
+    if (ret == GST_FLOW_OK)
+        gst_cuda_dmabuf_upload_count_frame(self, &self->stats.system_frames);
+    return ret;
 }
 
 /* ============================================================================
@@ -526,6 +2157,17 @@ gst_cuda_dmabuf_upload_add_external_buffer(GstCudaDmabufUpload *self,
     return ret;
 }
 
+static gboolean
+gst_cuda_dmabuf_upload_sync_buffer(GstCudaDmabufUpload *self, GstBuffer *buffer)
+{
+    (void)self;
+
+    if (!buffer)
+        return FALSE;
+
+    return buffer_fence_wait_buffer(buffer);
+}
+
 /* ============================================================================
  * Lifecycle
  * ============================================================================ */
@@ -539,8 +2181,101 @@ gst_cuda_dmabuf_upload_set_property(GObject *object, guint prop_id,
     switch (prop_id)
     {
     case PROP_FORCE_LINEAR:
-        self->force_linear = g_value_get_boolean(value);
+    {
+        gboolean force_linear = g_value_get_boolean(value);
+        gboolean changed = force_linear != self->force_linear;
+
+        self->force_linear = force_linear;
+        caps_cache_clear(self->caps_cache);
         GST_INFO_OBJECT(self, "force-linear set to %s", self->force_linear ? "TRUE" : "FALSE");
+
+        /* Renegotiate a running stream, with its pool built beforehand */
+        if (changed)
+        {
+            gst_cuda_dmabuf_upload_start_prebuild(self);
+            gst_base_transform_reconfigure_src(GST_BASE_TRANSFORM(self));
+        }
+        break;
+    }
+    case PROP_DEFERRED_SYNC:
+        self->deferred_sync = g_value_get_boolean(value);
+        self->btx.deferred_sync = self->deferred_sync;
+        GST_INFO_OBJECT(self, "deferred-sync set to %s", self->deferred_sync ? "TRUE" : "FALSE");
+        break;
+    case PROP_CONSUMER_SYNCS:
+        self->consumer_syncs = g_value_get_boolean(value);
+        GST_INFO_OBJECT(self, "consumer-syncs set to %s", self->consumer_syncs ? "TRUE" : "FALSE");
+        break;
+    case PROP_CUDA_EXPORT:
+        self->cuda_export = g_value_get_boolean(value);
+        GST_INFO_OBJECT(self, "cuda-export set to %s", self->cuda_export ? "TRUE" : "FALSE");
+        break;
+    case PROP_SCALE_METHOD:
+        GST_OBJECT_LOCK(self);
+        self->scale_method = g_value_get_enum(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ADD_BORDERS:
+        GST_OBJECT_LOCK(self);
+        self->add_borders = g_value_get_boolean(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_BORDER_COLOR:
+        GST_OBJECT_LOCK(self);
+        self->border_color = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_CPU_FALLBACK:
+        self->cpu_fallback = g_value_get_boolean(value);
+        GST_INFO_OBJECT(self, "cpu-fallback set to %s", self->cpu_fallback ? "TRUE" : "FALSE");
+        break;
+    case PROP_CALIBRATE_MODIFIERS:
+        self->calibrate_modifiers = g_value_get_boolean(value);
+        GST_INFO_OBJECT(self, "calibrate-modifiers set to %s",
+                        self->calibrate_modifiers ? "TRUE" : "FALSE");
+        break;
+    case PROP_MIN_BUFFERS:
+        GST_OBJECT_LOCK(self);
+        self->min_buffers = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_MAX_BUFFERS:
+        GST_OBJECT_LOCK(self);
+        self->max_buffers = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ALLOCATION_MODE:
+        GST_OBJECT_LOCK(self);
+        self->allocation_mode = g_value_get_enum(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_POOL_MAX_WIDTH:
+        GST_OBJECT_LOCK(self);
+        self->pool_max_width = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_POOL_MAX_HEIGHT:
+        GST_OBJECT_LOCK(self);
+        self->pool_max_height = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_OPEN_ON_START:
+        GST_OBJECT_LOCK(self);
+        self->open_on_start = g_value_get_boolean(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ASYNC_SETUP:
+        GST_OBJECT_LOCK(self);
+        self->async_setup = g_value_get_boolean(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_RENDER_NODE:
+        GST_OBJECT_LOCK(self);
+        g_free(self->render_node);
+        self->render_node = g_value_dup_string(value);
+        GST_OBJECT_UNLOCK(self);
+        /* Caps built from another node's formats */
+        caps_cache_clear(self->caps_cache);
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -548,6 +2283,42 @@ gst_cuda_dmabuf_upload_set_property(GObject *object, guint prop_id,
     }
 }
 
+static GstStructure *
+gst_cuda_dmabuf_upload_get_stats(GstCudaDmabufUpload *self)
+{
+    guint pool_buffers = 0, pool_in_flight = 0, pool_high_water = 0;
+
+    GST_OBJECT_LOCK(self);
+    UploadStats stats = self->stats;
+    StartupTimes startup = self->startup;
+    GST_OBJECT_UNLOCK(self);
+
+    /* The CUDA-EGL pool is swapped under the prebuild lock */
+    g_mutex_lock(&self->prebuild_lock);
+    if (self->egl_pool)
+        gst_pooled_buffer_pool_get_stats(GST_POOLED_BUFFER_POOL(self->egl_pool), &pool_buffers,
+                                         &pool_in_flight, &pool_high_water);
+    g_mutex_unlock(&self->prebuild_lock);
+
+    return gst_structure_new("application/x-cuda-dmabuf-upload-stats",
+                             "export", G_TYPE_UINT64, stats.export_frames,
+                             "copy", G_TYPE_UINT64, stats.copy_frames,
+                             "external", G_TYPE_UINT64, stats.external_frames,
+                             "convert", G_TYPE_UINT64, stats.convert_frames,
+                             "system", G_TYPE_UINT64, stats.system_frames,
+                             "cpu", G_TYPE_UINT64, stats.cpu_frames,
+                             "upstream", G_TYPE_UINT64, stats.upstream_frames,
+                             "pool-buffers", G_TYPE_UINT, pool_buffers,
+                             "pool-in-flight", G_TYPE_UINT, pool_in_flight,
+                             "pool-high-water", G_TYPE_UINT, pool_high_water,
+                             "startup-context-us", G_TYPE_UINT64, startup.context_usec,
+                             "startup-probe-us", G_TYPE_UINT64, startup.probe_usec,
+                             "startup-pool-us", G_TYPE_UINT64, startup.pool_usec,
+                             "startup-wait-us", G_TYPE_UINT64, startup.wait_usec,
+                             "startup-first-frame-us", G_TYPE_UINT64, startup.first_frame_usec,
+                             NULL);
+}
+
 static void
 gst_cuda_dmabuf_upload_get_property(GObject *object, guint prop_id,
                                     GValue *value, GParamSpec *pspec)
@@ -559,6 +2330,79 @@ gst_cuda_dmabuf_upload_get_property(GObject *object, guint prop_id,
     case PROP_FORCE_LINEAR:
         g_value_set_boolean(value, self->force_linear);
         break;
+    case PROP_DEFERRED_SYNC:
+        g_value_set_boolean(value, self->deferred_sync);
+        break;
+    case PROP_CONSUMER_SYNCS:
+        g_value_set_boolean(value, self->consumer_syncs);
+        break;
+    case PROP_CUDA_EXPORT:
+        g_value_set_boolean(value, self->cuda_export);
+        break;
+    case PROP_STATS:
+        g_value_take_boxed(value, gst_cuda_dmabuf_upload_get_stats(self));
+        break;
+    case PROP_SCALE_METHOD:
+        GST_OBJECT_LOCK(self);
+        g_value_set_enum(value, self->scale_method);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ADD_BORDERS:
+        GST_OBJECT_LOCK(self);
+        g_value_set_boolean(value, self->add_borders);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_BORDER_COLOR:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->border_color);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_CPU_FALLBACK:
+        g_value_set_boolean(value, self->cpu_fallback);
+        break;
+    case PROP_CALIBRATE_MODIFIERS:
+        g_value_set_boolean(value, self->calibrate_modifiers);
+        break;
+    case PROP_MIN_BUFFERS:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->min_buffers);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_MAX_BUFFERS:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->max_buffers);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ALLOCATION_MODE:
+        GST_OBJECT_LOCK(self);
+        g_value_set_enum(value, self->allocation_mode);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_POOL_MAX_WIDTH:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->pool_max_width);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_POOL_MAX_HEIGHT:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->pool_max_height);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_OPEN_ON_START:
+        GST_OBJECT_LOCK(self);
+        g_value_set_boolean(value, self->open_on_start);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_ASYNC_SETUP:
+        GST_OBJECT_LOCK(self);
+        g_value_set_boolean(value, self->async_setup);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    case PROP_RENDER_NODE:
+        GST_OBJECT_LOCK(self);
+        g_value_set_string(value, self->render_node);
+        GST_OBJECT_UNLOCK(self);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -570,17 +2414,32 @@ gst_cuda_dmabuf_upload_finalize(GObject *object)
 {
     GstCudaDmabufUpload *self = GST_CUDA_DMABUF_UPLOAD(object);
 
+    gst_cuda_dmabuf_upload_join_setup(self);
+
     /* Clean up external FD pool */
     external_fd_pool_cleanup(&self->external_fd_pool);
 
-    /* Clean up buffer pool */
-    pooled_buffer_pool_cleanup(&self->semi_planar_pool, &self->egl_ctx);
+    /* Clean up buffer pools (slots are freed with their last buffer, on
+     * the pool's own device and CUDA context references). The prebuild
+     * thread holds a reference, so it has finished by now. */
+    gst_cuda_dmabuf_upload_drop_pool(&self->egl_pool);
+    gst_cuda_dmabuf_upload_drop_pool(&self->egl_standby_pool);
+    gst_cuda_dmabuf_upload_drop_pool(&self->prebuilt_pool);
+    if (self->topup_pool)
+        gst_object_unref(self->topup_pool);
+    if (self->prebuild_cuda_ctx)
+        gst_object_unref(self->prebuild_cuda_ctx);
+    g_mutex_clear(&self->prebuild_lock);
+    g_cond_clear(&self->prebuild_cond);
+    gst_cuda_dmabuf_upload_clear_cpu_pool(self);
+    worker_pool_free(self->cpu_workers);
 
     if (self->pool)
     {
         gst_buffer_pool_set_active(self->pool, FALSE);
         gst_object_unref(self->pool);
     }
+    gst_cuda_dmabuf_upload_clear_upstream_pool(self);
     if (self->cuda_pool)
     {
         gst_buffer_pool_set_active(self->cuda_pool, FALSE);
@@ -588,11 +2447,20 @@ gst_cuda_dmabuf_upload_finalize(GObject *object)
     }
     if (self->cuda_ctx)
         gst_object_unref(self->cuda_ctx);
-    if (self->btx.dmabuf_allocator)
-        gst_object_unref(self->btx.dmabuf_allocator);
+    buffer_transform_context_cleanup(&self->btx);
 
     /* Clean up CUDA-EGL context */
+    fence_export_free(self->fence_export);
     cuda_egl_context_cleanup(&self->egl_ctx);
+    g_free(self->drm_device);
+    g_free(self->formats_device);
+    g_free(self->render_node);
+
+    guint64 hits, misses;
+    caps_cache_get_stats(self->caps_cache, &hits, &misses);
+    GST_DEBUG_OBJECT(self, "transform_caps cache: %" G_GUINT64_FORMAT " hits, %"
+                     G_GUINT64_FORMAT " misses", hits, misses);
+    caps_cache_free(self->caps_cache);
 
     G_OBJECT_CLASS(gst_cuda_dmabuf_upload_parent_class)->finalize(object);
 }
@@ -622,6 +2490,280 @@ gst_cuda_dmabuf_upload_class_init(GstCudaDmabufUploadClass *klass)
                                                          FALSE,
                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    /**
+     * GstCudaDmabufUpload:deferred-sync:
+     *
+     * Don't block the streaming thread on GPU completion of each frame.
+     * A CUDA event is recorded per output buffer and exported with the
+     * DMA-BUF as an implicit sync_file fence, so a compositor importing it
+     * waits for the copy on the GPU. Without EGL_NV_cuda_event,
+     * EGL_ANDROID_native_fence_sync or DMA_BUF_IOCTL_IMPORT_SYNC_FILE
+     * (Linux 6.0) the fence is waited on right before the push instead.
+     * The fence is also waited on when the buffer is mapped, when its pool
+     * slot is reused, or when the application emits
+     * #GstCudaDmabufUpload::sync-buffer.
+     */
+    g_object_class_install_property(gobject_class, PROP_DEFERRED_SYNC,
+                                    g_param_spec_boolean("deferred-sync",
+                                                         "Deferred Sync",
+                                                         "Fence output buffers instead of waiting after each copy; the fence is "
+                                                         "exported with the DMA-BUF, or waited on before the push (see consumer-syncs)",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:consumer-syncs:
+     *
+     * With #GstCudaDmabufUpload:deferred-sync, push buffers without
+     * exporting or waiting for their fence. Only safe when every consumer maps the
+     * buffers or the application emits #GstCudaDmabufUpload::sync-buffer
+     * before they are used; a compositor importing the DMA-BUF directly
+     * can otherwise show a partially written frame.
+     */
+    g_object_class_install_property(gobject_class, PROP_CONSUMER_SYNCS,
+                                    g_param_spec_boolean("consumer-syncs",
+                                                         "Consumer Syncs",
+                                                         "Push deferred-sync buffers unfenced; unsafe for zero-copy import "
+                                                         "consumers unless the application emits sync-buffer",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:cuda-export:
+     *
+     * Hand the decoder's own CUDA memory downstream as a DMA-BUF instead of
+     * copying it. Used per frame when upstream accepted the proposed MMAP
+     * CUDA pool, the negotiated modifier is LINEAR and the plane layout is
+     * one downstream accepts; otherwise the copy paths are used.
+     */
+    g_object_class_install_property(gobject_class, PROP_CUDA_EXPORT,
+                                    g_param_spec_boolean("cuda-export",
+                                                         "CUDA Export",
+                                                         "Export decoder CUDA memory as DMA-BUF without copying when the layout allows",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:stats:
+     *
+     * Number of frames that took each output path: "export" (zero-copy),
+     * "copy" (CUDA-EGL pool), "external" (Vulkan-exported buffers),
+     * "convert" (NV12/P010→RGB), "system" (system-memory upload copy),
+     * "cpu" (NV12/P010→RGB on the CPU, see #GstCudaDmabufUpload:cpu-fallback)
+     * and "upstream" (written by upstream into the proposed GBM pool).
+     * For the CUDA-EGL pool: "pool-buffers" (current size),
+     * "pool-in-flight" (buffers held downstream) and "pool-high-water"
+     * (deepest in-flight count since the pool was created).
+     * Setup latency in microseconds: "startup-context-us" (render node,
+     * EGL and CUDA init), "startup-probe-us" (DRM format probe),
+     * "startup-pool-us" (latest CUDA-EGL pool build), "startup-wait-us"
+     * (first frame waiting for #GstCudaDmabufUpload:async-setup) and
+     * "startup-first-frame-us" (first caps to first output buffer).
+     */
+    g_object_class_install_property(gobject_class, PROP_STATS,
+                                    g_param_spec_boxed("stats",
+                                                       "Statistics",
+                                                       "Per-path frame counters",
+                                                       GST_TYPE_STRUCTURE,
+                                                       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:scale-method:
+     *
+     * Filter used when the negotiated output size differs from the input.
+     * Scaling runs inside the copy/conversion kernel, so it costs no extra
+     * pass. Takes effect at the next caps negotiation.
+     */
+    g_object_class_install_property(gobject_class, PROP_SCALE_METHOD,
+                                    g_param_spec_enum("scale-method",
+                                                      "Scale Method",
+                                                      "Filter used when scaling to a different output size",
+                                                      GST_TYPE_CUDA_DMABUF_UPLOAD_SCALE_METHOD,
+                                                      DEFAULT_SCALE_METHOD,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:add-borders:
+     *
+     * Keep the input display aspect ratio when scaling, centring the
+     * picture and filling the rest of the output with
+     * #GstCudaDmabufUpload:border-color. Otherwise the picture is
+     * stretched over the whole output. Takes effect at the next caps
+     * negotiation.
+     */
+    g_object_class_install_property(gobject_class, PROP_ADD_BORDERS,
+                                    g_param_spec_boolean("add-borders",
+                                                         "Add Borders",
+                                                         "Letterbox/pillarbox to preserve the aspect ratio when scaling",
+                                                         DEFAULT_ADD_BORDERS,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:border-color:
+     *
+     * Border colour as 0xAARRGGBB (alpha is ignored, borders are opaque).
+     * Converted to the output format and the input colorimetry for
+     * NV12/P010 output.
+     */
+    g_object_class_install_property(gobject_class, PROP_BORDER_COLOR,
+                                    g_param_spec_uint("border-color",
+                                                      "Border Color",
+                                                      "Border colour as 0xAARRGGBB",
+                                                      0, G_MAXUINT32, DEFAULT_BORDER_COLOR,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:cpu-fallback:
+     *
+     * Convert NV12/P010 to LINEAR XR24/XR30/AR30 on the CPU (SIMD, split
+     * across threads) when the CUDA-EGL output can't be set up or the
+     * conversion kernel fails, instead of failing the stream. The output
+     * is bit-identical to the GPU conversion.
+     */
+    g_object_class_install_property(gobject_class, PROP_CPU_FALLBACK,
+                                    g_param_spec_boolean("cpu-fallback",
+                                                         "CPU Fallback",
+                                                         "Convert on the CPU when the GPU conversion path is unavailable",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:calibrate-modifiers:
+     *
+     * The first time an NV12/P010 passthrough size is negotiated, time the
+     * copy into every tiled modifier the device supports and renegotiate
+     * if one beats the negotiated modifier. The ranking is kept per render
+     * node, cached next to its DRM format table, and orders the modifiers
+     * advertised on that node fastest first, also for elements without
+     * this property set.
+     */
+    g_object_class_install_property(gobject_class, PROP_CALIBRATE_MODIFIERS,
+                                    g_param_spec_boolean("calibrate-modifiers",
+                                                         "Calibrate Modifiers",
+                                                         "Benchmark the tiled modifiers at the negotiated size and prefer the fastest",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:min-buffers:
+     *
+     * Buffers allocated up front in the output pools. The CUDA-EGL pool
+     * frees idle buffers after sustained slack but never goes below this.
+     * Takes effect when the next pool is created.
+     */
+    g_object_class_install_property(gobject_class, PROP_MIN_BUFFERS,
+                                    g_param_spec_uint("min-buffers",
+                                                      "Min Buffers",
+                                                      "Minimum number of buffers in the output pools",
+                                                      1, 64, DEFAULT_MIN_BUFFERS,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:max-buffers:
+     *
+     * Upper bound the output pools grow to when downstream holds more
+     * buffers, or (CUDA-EGL pool) when the next free buffer is still being
+     * written by the GPU. 0 means unlimited; a value below
+     * #GstCudaDmabufUpload:min-buffers is raised to it. Takes effect when
+     * the next pool is created.
+     */
+    g_object_class_install_property(gobject_class, PROP_MAX_BUFFERS,
+                                    g_param_spec_uint("max-buffers",
+                                                      "Max Buffers",
+                                                      "Maximum number of buffers in the output pools (0 = unlimited)",
+                                                      0, 128, DEFAULT_MAX_BUFFERS,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:allocation-mode:
+     *
+     * With "max-size", CUDA-EGL buffers are allocated for the largest
+     * output size negotiated so far (or #GstCudaDmabufUpload:pool-max-width
+     * x #GstCudaDmabufUpload:pool-max-height, if larger) and reused for
+     * smaller sizes with a smaller video meta, so resolution switches of
+     * adaptive streams don't rebuild the pool. Takes effect when the next
+     * pool is created.
+     */
+    g_object_class_install_property(gobject_class, PROP_ALLOCATION_MODE,
+                                    g_param_spec_enum("allocation-mode",
+                                                      "Allocation Mode",
+                                                      "Size CUDA-EGL buffers exactly or for the largest size seen",
+                                                      GST_TYPE_CUDA_DMABUF_UPLOAD_ALLOCATION_MODE,
+                                                      DEFAULT_ALLOCATION_MODE,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:pool-max-width:
+     *
+     * Width the CUDA-EGL buffers are allocated for in "max-size"
+     * #GstCudaDmabufUpload:allocation-mode, e.g. the top rung of the
+     * bitrate ladder. 0 uses the largest width seen.
+     */
+    g_object_class_install_property(gobject_class, PROP_POOL_MAX_WIDTH,
+                                    g_param_spec_uint("pool-max-width",
+                                                      "Pool Max Width",
+                                                      "Width to allocate for in max-size mode (0 = largest seen)",
+                                                      0, 16384, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:pool-max-height:
+     *
+     * Height counterpart of #GstCudaDmabufUpload:pool-max-width.
+     */
+    g_object_class_install_property(gobject_class, PROP_POOL_MAX_HEIGHT,
+                                    g_param_spec_uint("pool-max-height",
+                                                      "Pool Max Height",
+                                                      "Height to allocate for in max-size mode (0 = largest seen)",
+                                                      0, 16384, 0,
+                                                      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:open-on-start:
+     *
+     * Probe the DRM formats and open the render node, EGL display and CUDA
+     * driver in the READY→PAUSED transition rather than at the first caps,
+     * so players that preroll early start playing without that cost.
+     */
+    g_object_class_install_property(gobject_class, PROP_OPEN_ON_START,
+                                    g_param_spec_boolean("open-on-start",
+                                                         "Open On Start",
+                                                         "Open the GPU devices in READY->PAUSED instead of at negotiation",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:async-setup:
+     *
+     * Build the CUDA-EGL output pool on a background thread started at
+     * caps negotiation instead of in set_caps; the first frame waits for
+     * it. Negotiation then no longer fails when the pool can't be set up,
+     * the first frame does.
+     */
+    g_object_class_install_property(gobject_class, PROP_ASYNC_SETUP,
+                                    g_param_spec_boolean("async-setup",
+                                                         "Async Setup",
+                                                         "Build the output pool in the background while negotiation continues",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    /**
+     * GstCudaDmabufUpload:render-node:
+     *
+     * DRM render node to allocate the output on, e.g. "/dev/dri/renderD129".
+     * When unset, the NVIDIA node on the PCI bus of upstream's CUDA device
+     * is used, or the first NVIDIA node until there is a CUDA context.
+     * The node is resolved again on every READY→PAUSED, and closed when
+     * going back to READY.
+     */
+    g_object_class_install_property(gobject_class, PROP_RENDER_NODE,
+                                    g_param_spec_string("render-node",
+                                                        "Render Node",
+                                                        "DRM render node to use (NULL to match the CUDA device)",
+                                                        NULL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+                                                            GST_PARAM_MUTABLE_READY));
+
     /**
      * GstCudaDmabufUpload::init-external-pool:
      * @upload: the element
@@ -666,10 +2808,34 @@ gst_cuda_dmabuf_upload_class_init(GstCudaDmabufUploadClass *klass)
                      G_TYPE_INT, G_TYPE_UINT64, G_TYPE_UINT,
                      G_TYPE_INT, G_TYPE_UINT64, G_TYPE_UINT);
 
+    /**
+     * GstCudaDmabufUpload::sync-buffer:
+     * @upload: the element
+     * @buffer: an output buffer produced by this element
+     *
+     * Block until the GPU work writing @buffer has completed. Only needed
+     * with #GstCudaDmabufUpload:deferred-sync when the DMA-BUF is consumed
+     * without mapping it (e.g. imported into Vulkan or EGL).
+     *
+     * Returns: TRUE on success
+     */
+    signals[SIGNAL_SYNC_BUFFER] =
+        g_signal_new("sync-buffer",
+                     G_TYPE_FROM_CLASS(klass),
+                     G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+                     0, NULL, NULL, NULL,
+                     G_TYPE_BOOLEAN, 1,
+                     GST_TYPE_BUFFER);
+
     gst_element_class_add_pad_template(element_class,
                                        gst_static_pad_template_get(&sink_template));
+    /* Output NV12/P010 DMA-BUF (preferred), XR30/AR30 or XR24 DMA-BUF, from
+     * the candidates of the DRM format table */
+    GstCaps *src_caps = caps_transform_src_template_caps();
     gst_element_class_add_pad_template(element_class,
-                                       gst_static_pad_template_get(&src_template));
+                                       gst_pad_template_new("src", GST_PAD_SRC,
+                                                            GST_PAD_ALWAYS, src_caps));
+    gst_caps_unref(src_caps);
 
     gst_element_class_set_static_metadata(element_class,
                                           "CUDA → DMA-BUF Upload",
@@ -677,12 +2843,17 @@ gst_cuda_dmabuf_upload_class_init(GstCudaDmabufUploadClass *klass)
                                           "Zero-copy CUDA to DMA-BUF for Wayland compositor display",
                                           "Ericky");
 
+    base_class->start = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_start);
+    base_class->stop = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_stop);
     base_class->set_caps = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_set_caps);
     base_class->propose_allocation = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_propose_allocation);
     base_class->decide_allocation = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_decide_allocation);
     base_class->prepare_output_buffer = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_prepare_output_buffer);
     base_class->transform = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_transform);
     base_class->transform_caps = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_transform_caps);
+    base_class->fixate_caps = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_fixate_caps);
+    base_class->src_event = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_src_event);
+    base_class->submit_input_buffer = GST_DEBUG_FUNCPTR(gst_cuda_dmabuf_upload_submit_input_buffer);
     base_class->passthrough_on_same_caps = FALSE;
 }
 
@@ -693,14 +2864,33 @@ gst_cuda_dmabuf_upload_init(GstCudaDmabufUpload *self)
     gst_video_info_init(&self->cuda_info);
     self->negotiated_modifier = DRM_FORMAT_MOD_INVALID;
     self->force_linear = FALSE;
+    self->deferred_sync = FALSE;
+    self->consumer_syncs = FALSE;
+    self->cuda_export = TRUE;
+    self->scale_method = DEFAULT_SCALE_METHOD;
+    self->add_borders = DEFAULT_ADD_BORDERS;
+    self->border_color = DEFAULT_BORDER_COLOR;
+    self->cpu_fallback = TRUE;
+    self->calibrate_modifiers = FALSE;
+    self->min_buffers = DEFAULT_MIN_BUFFERS;
+    self->max_buffers = DEFAULT_MAX_BUFFERS;
+    self->allocation_mode = DEFAULT_ALLOCATION_MODE;
+    self->open_on_start = FALSE;
+    self->async_setup = FALSE;
+    memset(&self->stats, 0, sizeof(UploadStats));
+    memset(&self->startup, 0, sizeof(StartupTimes));
     memset(&self->egl_ctx, 0, sizeof(CudaEglContext));
-    memset(&self->semi_planar_pool, 0, sizeof(PooledBufferPool));
     memset(&self->btx, 0, sizeof(BufferTransformContext));
     memset(&self->external_fd_pool, 0, sizeof(ExternalFdPool));
+    self->caps_cache = caps_cache_new(CAPS_CACHE_SIZE);
+    g_mutex_init(&self->prebuild_lock);
+    g_cond_init(&self->prebuild_cond);
 
     /* Connect action signal handlers */
     g_signal_connect(self, "init-external-pool",
                      G_CALLBACK(gst_cuda_dmabuf_upload_init_external_pool), NULL);
     g_signal_connect(self, "add-external-buffer",
                      G_CALLBACK(gst_cuda_dmabuf_upload_add_external_buffer), NULL);
+    g_signal_connect(self, "sync-buffer",
+                     G_CALLBACK(gst_cuda_dmabuf_upload_sync_buffer), NULL);
 }
@@ -0,0 +1,383 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Modifier Ranking
+ */
+
+#include "modifier_ranking.h"
+#include "drm_format_table.h"
+
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CACHE_GROUP "cache"
+
+typedef struct
+{
+    guint32 fourcc;
+    guint width;
+    guint height;
+    guint64 modifier;
+    gdouble usec;
+    guint64 serial; /* Order of recording, for "most recent" */
+} RankingRecord;
+
+struct _ModifierRanking
+{
+    GMutex lock;
+    GArray *records; /* RankingRecord */
+    guint64 serial;
+    guint generation;
+};
+
+ModifierRanking *
+modifier_ranking_new(void)
+{
+    ModifierRanking *ranking = g_new0(ModifierRanking, 1);
+
+    g_mutex_init(&ranking->lock);
+    ranking->records = g_array_new(FALSE, FALSE, sizeof(RankingRecord));
+    return ranking;
+}
+
+void modifier_ranking_free(ModifierRanking *ranking)
+{
+    if (!ranking)
+        return;
+
+    g_array_unref(ranking->records);
+    g_mutex_clear(&ranking->lock);
+    g_free(ranking);
+}
+
+static RankingRecord *
+find_record(ModifierRanking *ranking, guint32 fourcc, guint width, guint height,
+            guint64 modifier)
+{
+    for (guint i = 0; i < ranking->records->len; i++)
+    {
+        RankingRecord *r = &g_array_index(ranking->records, RankingRecord, i);
+        if (r->fourcc == fourcc && r->width == width && r->height == height &&
+            r->modifier == modifier)
+            return r;
+    }
+    return NULL;
+}
+
+static void
+record_locked(ModifierRanking *ranking, guint32 fourcc, guint width, guint height,
+              guint64 modifier, gdouble usec)
+{
+    RankingRecord *r = find_record(ranking, fourcc, width, height, modifier);
+
+    if (!r)
+    {
+        RankingRecord rec = {fourcc, width, height, modifier, 0, 0};
+        g_array_append_val(ranking->records, rec);
+        r = &g_array_index(ranking->records, RankingRecord, ranking->records->len - 1);
+    }
+
+    r->usec = usec;
+    r->serial = ++ranking->serial;
+    ranking->generation++;
+}
+
+void modifier_ranking_record(ModifierRanking *ranking, guint32 fourcc,
+                             guint width, guint height, guint64 modifier,
+                             gdouble usec_per_frame)
+{
+    g_mutex_lock(&ranking->lock);
+    record_locked(ranking, fourcc, width, height, modifier, usec_per_frame);
+    g_mutex_unlock(&ranking->lock);
+}
+
+gboolean
+modifier_ranking_has(ModifierRanking *ranking, guint32 fourcc, guint width, guint height)
+{
+    gboolean found = FALSE;
+
+    g_mutex_lock(&ranking->lock);
+    for (guint i = 0; !found && i < ranking->records->len; i++)
+    {
+        const RankingRecord *r = &g_array_index(ranking->records, RankingRecord, i);
+        found = r->fourcc == fourcc && r->width == width && r->height == height;
+    }
+    g_mutex_unlock(&ranking->lock);
+
+    return found;
+}
+
+/* The calibrated resolution of @fourcc to rank by (see the header) */
+static gboolean
+pick_resolution(ModifierRanking *ranking, guint32 fourcc, guint width, guint height,
+                guint *out_width, guint *out_height)
+{
+    const RankingRecord *best = NULL;
+    guint64 pixels = (guint64)width * height;
+    guint64 best_dist = G_MAXUINT64;
+
+    for (guint i = 0; i < ranking->records->len; i++)
+    {
+        const RankingRecord *r = &g_array_index(ranking->records, RankingRecord, i);
+        if (r->fourcc != fourcc)
+            continue;
+
+        if (pixels == 0)
+        {
+            if (!best || r->serial > best->serial)
+                best = r;
+            continue;
+        }
+
+        guint64 p = (guint64)r->width * r->height;
+        guint64 dist = p > pixels ? p - pixels : pixels - p;
+        if (r->width == width && r->height == height)
+            dist = 0;
+        if (dist < best_dist)
+        {
+            best = r;
+            best_dist = dist;
+        }
+    }
+
+    if (!best)
+        return FALSE;
+
+    *out_width = best->width;
+    *out_height = best->height;
+    return TRUE;
+}
+
+void modifier_ranking_sort(ModifierRanking *ranking, guint32 fourcc,
+                           guint width, guint height,
+                           guint64 *modifiers, guint n_modifiers)
+{
+    guint w, h;
+
+    if (n_modifiers < 2)
+        return;
+
+    g_mutex_lock(&ranking->lock);
+
+    if (!pick_resolution(ranking, fourcc, width, height, &w, &h))
+    {
+        g_mutex_unlock(&ranking->lock);
+        return;
+    }
+
+    /* Positions held by measured modifiers, and their costs */
+    guint *slots = g_new(guint, n_modifiers);
+    guint64 *mods = g_new(guint64, n_modifiers);
+    gdouble *cost = g_new(gdouble, n_modifiers);
+    guint n = 0;
+
+    for (guint i = 0; i < n_modifiers; i++)
+    {
+        const RankingRecord *r = find_record(ranking, fourcc, w, h, modifiers[i]);
+        if (!r)
+            continue;
+
+        /* Insertion sort: stable, so ties keep the preference order */
+        guint j = n;
+        for (; j > 0 && cost[j - 1] > r->usec; j--)
+        {
+            mods[j] = mods[j - 1];
+            cost[j] = cost[j - 1];
+        }
+        mods[j] = modifiers[i];
+        cost[j] = r->usec;
+        slots[n++] = i;
+    }
+
+    g_mutex_unlock(&ranking->lock);
+
+    for (guint i = 0; i < n; i++)
+        modifiers[slots[i]] = mods[i];
+
+    g_free(slots);
+    g_free(mods);
+    g_free(cost);
+}
+
+guint modifier_ranking_get_generation(ModifierRanking *ranking)
+{
+    g_mutex_lock(&ranking->lock);
+    guint generation = ranking->generation;
+    g_mutex_unlock(&ranking->lock);
+
+    return generation;
+}
+
+/* ============================================================================
+ * On-disk cache
+ * ============================================================================ */
+
+/* One group per fourcc and resolution, e.g. "NV12 1920x1080", with the
+ * cost in microseconds per modifier */
+static gchar *
+group_name(guint32 fourcc, guint width, guint height)
+{
+    gchar name[5];
+
+    for (guint i = 0; i < 4; i++)
+        name[i] = (gchar)((fourcc >> (8 * i)) & 0xff);
+    name[4] = '\0';
+
+    return g_strdup_printf("%s %ux%u", name, width, height);
+}
+
+static gboolean
+parse_group_name(const gchar *group, guint32 *fourcc, guint *width, guint *height)
+{
+    if (strlen(group) < 8 || group[4] != ' ')
+        return FALSE;
+    if (sscanf(group + 5, "%ux%u", width, height) != 2 || *width == 0 || *height == 0)
+        return FALSE;
+
+    *fourcc = (guint32)(guchar)group[0] | ((guint32)(guchar)group[1] << 8) |
+              ((guint32)(guchar)group[2] << 16) | ((guint32)(guchar)group[3] << 24);
+    return TRUE;
+}
+
+gboolean
+modifier_ranking_save(ModifierRanking *ranking, const gchar *path,
+                      const gchar *driver_key, GError **error)
+{
+    GKeyFile *kf = g_key_file_new();
+    gchar *dir = g_path_get_dirname(path);
+    gboolean ok;
+
+    g_key_file_set_string(kf, CACHE_GROUP, "driver", driver_key);
+
+    g_mutex_lock(&ranking->lock);
+    for (guint i = 0; i < ranking->records->len; i++)
+    {
+        const RankingRecord *r = &g_array_index(ranking->records, RankingRecord, i);
+        gchar *group = group_name(r->fourcc, r->width, r->height);
+        gchar key[24];
+
+        g_snprintf(key, sizeof(key), "0x%016" G_GINT64_MODIFIER "x", r->modifier);
+        g_key_file_set_double(kf, group, key, r->usec);
+        g_free(group);
+    }
+    g_mutex_unlock(&ranking->lock);
+
+    ok = g_mkdir_with_parents(dir, 0755) == 0;
+    if (!ok)
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "Failed to create %s", dir);
+    else
+        ok = g_key_file_save_to_file(kf, path, error);
+
+    g_free(dir);
+    g_key_file_unref(kf);
+    return ok;
+}
+
+gboolean
+modifier_ranking_load(ModifierRanking *ranking, const gchar *path, const gchar *driver_key)
+{
+    GKeyFile *kf = g_key_file_new();
+    gboolean ok = FALSE;
+
+    if (!g_key_file_load_from_file(kf, path, G_KEY_FILE_NONE, NULL))
+        goto done;
+
+    /* Timings from another driver version may no longer hold */
+    gchar *driver = g_key_file_get_string(kf, CACHE_GROUP, "driver", NULL);
+    ok = g_strcmp0(driver, driver_key) == 0;
+    g_free(driver);
+    if (!ok)
+        goto done;
+
+    gchar **groups = g_key_file_get_groups(kf, NULL);
+
+    g_mutex_lock(&ranking->lock);
+    for (guint g = 0; groups[g]; g++)
+    {
+        guint32 fourcc;
+        guint width, height;
+
+        if (!parse_group_name(groups[g], &fourcc, &width, &height))
+            continue;
+
+        gchar **keys = g_key_file_get_keys(kf, groups[g], NULL, NULL);
+        for (guint k = 0; keys && keys[k]; k++)
+        {
+            GError *err = NULL;
+            gdouble usec = g_key_file_get_double(kf, groups[g], keys[k], &err);
+
+            if (err)
+            {
+                g_clear_error(&err);
+                continue;
+            }
+            record_locked(ranking, fourcc, width, height,
+                          g_ascii_strtoull(keys[k], NULL, 16), usec);
+        }
+        g_strfreev(keys);
+    }
+    g_mutex_unlock(&ranking->lock);
+
+    g_strfreev(groups);
+
+done:
+    g_key_file_unref(kf);
+    return ok;
+}
+
+gchar *
+modifier_ranking_default_cache_path(const gchar *drm_device)
+{
+    const gchar *env = g_getenv("GST_CUDA_DMABUF_RANKING_CACHE");
+
+    if (env && *env)
+        return g_strdup(env);
+
+    gchar *formats = drm_format_table_default_cache_path(drm_device);
+    gchar *dir = g_path_get_dirname(formats);
+    gchar *node = g_path_get_basename(drm_device);
+    gchar *name = g_strdup_printf("modifier-ranking-%s.ini", node);
+    gchar *path = g_build_filename(dir, name, NULL);
+
+    g_free(name);
+    g_free(node);
+    g_free(dir);
+    g_free(formats);
+    return path;
+}
+
+/* ============================================================================
+ * Per-device rankings
+ * ============================================================================ */
+
+/* Driver key → ranking, never freed like the format tables */
+static GMutex device_rankings_lock;
+static GHashTable *device_rankings = NULL;
+
+ModifierRanking *
+modifier_ranking_ensure_loaded(const gchar *path, const gchar *driver_key)
+{
+    g_return_val_if_fail(path != NULL, NULL);
+    g_return_val_if_fail(driver_key != NULL, NULL);
+
+    ModifierRanking *ranking;
+
+    g_mutex_lock(&device_rankings_lock);
+    if (!device_rankings)
+        device_rankings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    ranking = g_hash_table_lookup(device_rankings, driver_key);
+    if (!ranking)
+    {
+        ranking = modifier_ranking_new();
+        if (modifier_ranking_load(ranking, path, driver_key))
+            g_debug("Modifier ranking loaded from %s", path);
+        g_hash_table_insert(device_rankings, g_strdup(driver_key), ranking);
+    }
+    g_mutex_unlock(&device_rankings_lock);
+
+    return ranking;
+}
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Modifier Ranking
+ * Measured copy cost per DRM modifier, fourcc and resolution, used to
+ * reorder the advertised drm-formats fastest first. Filled by the
+ * element's calibration run and cached on disk next to the format table,
+ * one ranking and file per render node, keyed by driver version.
+ */
+
+#ifndef __MODIFIER_RANKING_H__
+#define __MODIFIER_RANKING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ModifierRanking ModifierRanking;
+
+ModifierRanking *modifier_ranking_new(void);
+
+void modifier_ranking_free(ModifierRanking *ranking);
+
+/**
+ * Store the cost of writing one @width x @height frame of @fourcc with
+ * @modifier, replacing an earlier measurement.
+ */
+void modifier_ranking_record(ModifierRanking *ranking, guint32 fourcc,
+                             guint width, guint height, guint64 modifier,
+                             gdouble usec_per_frame);
+
+/**
+ * Whether @fourcc was calibrated at exactly @width x @height.
+ */
+gboolean modifier_ranking_has(ModifierRanking *ranking, guint32 fourcc,
+                              guint width, guint height);
+
+/**
+ * Reorder @modifiers (all of @fourcc, in preference order) fastest first.
+ * Only measured modifiers move, among the positions they already hold;
+ * unmeasured ones, LINEAR included unless it was measured, stay put.
+ *
+ * Measurements at @width x @height are used when present, otherwise
+ * those of the calibrated resolution closest in pixel count. With an
+ * unknown size (0) the most recently calibrated resolution is used.
+ */
+void modifier_ranking_sort(ModifierRanking *ranking, guint32 fourcc,
+                           guint width, guint height,
+                           guint64 *modifiers, guint n_modifiers);
+
+/**
+ * Bumped by every change, so cached caps built from an older ranking can
+ * be told apart.
+ */
+guint modifier_ranking_get_generation(ModifierRanking *ranking);
+
+/**
+ * Write every measurement to @path (a key file) tagged with @driver_key.
+ * Missing parent directories are created.
+ */
+gboolean modifier_ranking_save(ModifierRanking *ranking, const gchar *path,
+                               const gchar *driver_key, GError **error);
+
+/**
+ * Add the measurements of a file written by modifier_ranking_save().
+ *
+ * @return FALSE (leaving @ranking untouched) if the file is missing,
+ *         unreadable or was written for a different @driver_key
+ */
+gboolean modifier_ranking_load(ModifierRanking *ranking, const gchar *path,
+                               const gchar *driver_key);
+
+/**
+ * Cache file path of the render node @drm_device:
+ * $GST_CUDA_DMABUF_RANKING_CACHE if set (one file for every device),
+ * otherwise modifier-ranking-<node>.ini next to the DRM format table
+ * cache, e.g. modifier-ranking-renderD128.ini.
+ *
+ * @return Newly allocated path
+ */
+gchar *modifier_ranking_default_cache_path(const gchar *drm_device);
+
+/**
+ * The ranking of the device @driver_key identifies, loaded from the cache
+ * file at @path on first use (empty if it's missing or was written for
+ * another driver key). Later calls return the same ranking.
+ *
+ * @return The ranking, never NULL; valid for the lifetime of the process
+ */
+ModifierRanking *modifier_ranking_ensure_loaded(const gchar *path, const gchar *driver_key);
+
+G_END_DECLS
+
+#endif /* __MODIFIER_RANKING_H__ */
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * NV12→BGRx Launch Geometry
+ */
+
+#include "nv12_launch.h"
+
+static unsigned
+div_up(unsigned a, unsigned b)
+{
+    return (a + b - 1) / b;
+}
+
+void nv12_launch_geometry(int width, int height,
+                          uintptr_t y_plane, uintptr_t uv_plane, uintptr_t bgrx_out,
+                          int y_stride, int uv_stride, int out_stride,
+                          Nv12LaunchGeometry *geo)
+{
+    /* A 4-wide tile stores 16 bytes per row and loads 4 luma + 4 chroma
+     * bytes: the output rows must be 16-byte aligned and the inputs 4-byte
+     * aligned. A 2-wide tile halves every requirement. */
+    int out_align16 = (bgrx_out % 16) == 0 && (out_stride % 16) == 0;
+    int out_align8 = (bgrx_out % 8) == 0 && (out_stride % 8) == 0;
+    int in_align4 = (y_plane % 4) == 0 && (uv_plane % 4) == 0 &&
+                    (y_stride % 4) == 0 && (uv_stride % 4) == 0;
+    int in_align2 = (y_plane % 2) == 0 && (uv_plane % 2) == 0 &&
+                    (y_stride % 2) == 0 && (uv_stride % 2) == 0;
+
+    if (out_align16 && in_align4 && width >= 4)
+    {
+        geo->tile_w = 4;
+        geo->vectorized = 1;
+    }
+    else
+    {
+        geo->tile_w = 2;
+        geo->vectorized = out_align8 && in_align2;
+    }
+
+    unsigned threads_x = div_up((unsigned)width, geo->tile_w);
+    unsigned threads_y = div_up((unsigned)height, NV12_TILE_H);
+
+    /* 32x8 threads covers 128x16 pixels with 4-wide tiles: a warp writes
+     * 512 contiguous bytes per row. Small frames shrink the block so there
+     * are still enough blocks to spread across SMs. */
+    geo->block_x = 32;
+    geo->block_y = 8;
+
+    while (div_up(threads_x, geo->block_x) * div_up(threads_y, geo->block_y) < NV12_LAUNCH_MIN_BLOCKS)
+    {
+        if (geo->block_y > 2)
+            geo->block_y /= 2;
+        else if (geo->block_x > 8)
+            geo->block_x /= 2;
+        else
+            break;
+    }
+
+    geo->grid_x = div_up(threads_x, geo->block_x);
+    geo->grid_y = div_up(threads_y, geo->block_y);
+}
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * NV12→BGRx Launch Geometry
+ * Tile size, vectorisation and grid/block selection for the conversion
+ * kernel. Plain C (no CUDA) so it can be unit-tested and benchmarked.
+ */
+
+#ifndef NV12_LAUNCH_H
+#define NV12_LAUNCH_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Each thread converts a tile of NV12_TILE_MAX_W x 2 (or 2 x 2) pixels:
+ * two luma rows share one chroma row in 4:2:0. */
+#define NV12_TILE_H 2
+#define NV12_TILE_MAX_W 4
+
+/* Below this many blocks the block shape is shrunk to keep SMs busy */
+#define NV12_LAUNCH_MIN_BLOCKS 128
+
+    typedef struct
+    {
+        /* Pixels per thread horizontally: 4 (one 128-bit store per row)
+         * or 2 (one 64-bit store per row) */
+        unsigned tile_w;
+
+        /* Whether whole tiles may use vector loads/stores; requires
+         * suitably aligned planes and strides */
+        int vectorized;
+
+        unsigned block_x;
+        unsigned block_y;
+        unsigned grid_x;
+        unsigned grid_y;
+    } Nv12LaunchGeometry;
+
+    /**
+     * Choose the launch configuration for a frame.
+     *
+     * @param width       Image width in pixels
+     * @param height      Image height in pixels
+     * @param y_plane     Y plane address (only alignment is inspected)
+     * @param uv_plane    UV plane address
+     * @param bgrx_out    Output address
+     * @param y_stride    Stride of Y plane in bytes
+     * @param uv_stride   Stride of UV plane in bytes
+     * @param out_stride  Stride of output in bytes
+     * @param geo         Resulting geometry
+     */
+    void nv12_launch_geometry(int width, int height,
+                              uintptr_t y_plane, uintptr_t uv_plane, uintptr_t bgrx_out,
+                              int y_stride, int uv_stride, int out_stride,
+                              Nv12LaunchGeometry *geo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NV12_LAUNCH_H */
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Pool Sizing
+ */
+
+#include "pool_sizing.h"
+
+#include <string.h>
+
+void pool_sizing_init(PoolSizing *sizing, guint min_buffers, guint max_buffers)
+{
+    memset(sizing, 0, sizeof(*sizing));
+    sizing->min_buffers = min_buffers;
+    sizing->max_buffers = max_buffers;
+}
+
+void pool_sizing_buffer_added(PoolSizing *sizing)
+{
+    sizing->allocated++;
+}
+
+void pool_sizing_buffer_removed(PoolSizing *sizing)
+{
+    if (sizing->allocated > 0)
+        sizing->allocated--;
+}
+
+static void
+end_window(PoolSizing *sizing)
+{
+    /* Slack: more buffers than the window's deepest pipeline plus one
+     * spare for the frame being written */
+    if (sizing->window_peak + 1 < sizing->allocated && sizing->allocated > sizing->min_buffers)
+        sizing->slack_windows++;
+    else
+        sizing->slack_windows = 0;
+
+    if (sizing->slack_windows >= POOL_SIZING_SLACK_WINDOWS)
+    {
+        sizing->pending_shrink = 1;
+        sizing->slack_windows = 0;
+    }
+
+    sizing->window_acquires = 0;
+    sizing->window_peak = sizing->in_flight;
+}
+
+gboolean
+pool_sizing_acquire(PoolSizing *sizing, gboolean busy)
+{
+    sizing->in_flight++;
+    sizing->high_water = MAX(sizing->high_water, sizing->in_flight);
+    sizing->window_peak = MAX(sizing->window_peak, sizing->in_flight);
+
+    if (++sizing->window_acquires >= POOL_SIZING_WINDOW)
+        end_window(sizing);
+
+    if (!busy || (sizing->max_buffers && sizing->allocated >= sizing->max_buffers))
+        return FALSE;
+
+    /* Needing more buffers cancels any slack seen so far */
+    sizing->grows++;
+    sizing->slack_windows = 0;
+    sizing->pending_shrink = 0;
+    return TRUE;
+}
+
+gboolean
+pool_sizing_release(PoolSizing *sizing)
+{
+    if (sizing->in_flight > 0)
+        sizing->in_flight--;
+
+    if (sizing->pending_shrink == 0 || sizing->allocated <= sizing->min_buffers)
+        return FALSE;
+
+    sizing->pending_shrink--;
+    sizing->shrinks++;
+    return TRUE;
+}
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Pool Sizing
+ * Adaptive buffer count for an output pool, driven by the in-flight depth
+ * (buffers acquired and not yet released by downstream). The pool grows
+ * when the next free buffer is still being written by the GPU and gives
+ * buffers back one at a time after sustained slack, always staying within
+ * [min, max].
+ */
+
+#ifndef __POOL_SIZING_H__
+#define __POOL_SIZING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Acquisitions per observation window */
+#define POOL_SIZING_WINDOW 256
+
+/* Consecutive windows with slack before one buffer is freed */
+#define POOL_SIZING_SLACK_WINDOWS 4
+
+typedef struct
+{
+    guint min_buffers;
+    guint max_buffers; /* 0 for unlimited */
+
+    guint allocated; /* Buffers that currently exist */
+    guint in_flight; /* Acquired and not yet released */
+    guint high_water; /* Highest in_flight seen */
+
+    /* Current window */
+    guint window_acquires;
+    guint window_peak;
+    guint slack_windows;
+
+    /* Buffers to free as they come back */
+    guint pending_shrink;
+
+    guint64 grows;
+    guint64 shrinks;
+} PoolSizing;
+
+void pool_sizing_init(PoolSizing *sizing, guint min_buffers, guint max_buffers);
+
+/**
+ * Account for a buffer created or destroyed by the pool.
+ */
+void pool_sizing_buffer_added(PoolSizing *sizing);
+void pool_sizing_buffer_removed(PoolSizing *sizing);
+
+/**
+ * A buffer was handed out. @busy is TRUE if the GPU is still writing its
+ * previous contents, so using it means waiting.
+ *
+ * @return TRUE if the pool may grow: the caller should take a fresh buffer
+ *         instead of waiting on this one
+ */
+gboolean pool_sizing_acquire(PoolSizing *sizing, gboolean busy);
+
+/**
+ * A buffer came back from downstream.
+ *
+ * @return TRUE if it should be freed rather than returned to the free list
+ */
+gboolean pool_sizing_release(PoolSizing *sizing);
+
+G_END_DECLS
+
+#endif /* __POOL_SIZING_H__ */
@@ -2,125 +2,552 @@
  * SPDX-FileCopyrightText: 2025 Ericky
  *
  * Pooled Buffer Management
- * Pre-allocated buffer pools for zero-copy video paths
+ * GstBufferPool of pre-allocated CUDA-EGL buffers for zero-copy video paths
  */
 
 #include "pooled_buffers.h"
+#include "buffer_fence.h"
+#include "block_linear.h"
+
+#include <gst/allocators/allocators.h>
+#include <drm/drm_fourcc.h>
+#include <unistd.h>
 #include <string.h>
 
-gboolean
-pooled_buffer_pool_init(PooledBufferPool *pool,
-                        CudaEglContext *ctx,
-                        guint pool_size,
-                        guint width,
-                        guint height,
-                        guint32 format,
-                        guint64 modifier,
-                        gboolean force_linear)
+G_DEFINE_TYPE(GstPooledBufferPool, gst_pooled_buffer_pool, GST_TYPE_BUFFER_POOL)
+
+static GQuark
+pooled_slot_quark(void)
+{
+    static GQuark quark = 0;
+    if (!quark)
+        quark = g_quark_from_static_string("pooled-buffer-slot");
+    return quark;
+}
+
+/* Buffers are set up on the streaming or prebuild thread and freed on
+ * whichever thread drops them last, so the pool brings its own context */
+static void
+pooled_push_context(GstPooledBufferPool *self)
+{
+    if (self->cuda_ctx)
+        gst_cuda_context_push(self->cuda_ctx);
+}
+
+static void
+pooled_pop_context(GstPooledBufferPool *self)
 {
-    g_return_val_if_fail(pool != NULL, FALSE);
-    g_return_val_if_fail(ctx != NULL && ctx->initialized, FALSE);
-    g_return_val_if_fail(pool_size > 0, FALSE);
+    if (self->cuda_ctx)
+        gst_cuda_context_pop(NULL);
+}
 
-    memset(pool, 0, sizeof(PooledBufferPool));
+static CudaEglBuffer *
+pooled_slot_new(GstPooledBufferPool *self)
+{
+    CudaEglBuffer *slot = g_new0(CudaEglBuffer, 1);
 
-    pool->buffers = g_new0(CudaEglBuffer, pool_size);
-    if (!pool->buffers)
+    if (!cuda_egl_buffer_alloc(&self->egl_ctx, slot,
+                               self->alloc_width, self->alloc_height,
+                               self->gbm_format, self->modifier, self->force_linear))
     {
-        g_warning("Failed to allocate buffer pool array");
-        return FALSE;
+        g_free(slot);
+        return NULL;
+    }
+
+    /* Fence for deferred completion; NULL falls back to stream sync */
+    slot->fence = buffer_fence_new(buffer_fence_cuda_backend());
+
+    g_debug("Pool buffer: fd=%d, strides=[%u,%u], offsets=[%u,%u], modifier=0x%016lx, size=%zu",
+            slot->dmabuf_fd, slot->strides[0], slot->strides[1],
+            slot->offsets[0], slot->offsets[1], slot->modifier, slot->size);
+
+    return slot;
+}
+
+static void
+pooled_slot_free(GstPooledBufferPool *self, CudaEglBuffer *slot)
+{
+    if (slot->fence)
+    {
+        buffer_fence_unref(slot->fence);
+        slot->fence = NULL;
     }
+    cuda_egl_buffer_free(&self->egl_ctx, slot);
+    g_free(slot);
+}
 
-    pool->pool_size = pool_size;
-    pool->width = width;
-    pool->height = height;
-    pool->format = format;
-    pool->modifier = modifier;
-    pool->force_linear = force_linear;
+static const gchar **
+gst_pooled_buffer_pool_get_options(GstBufferPool *pool)
+{
+    static const gchar *options[] = {GST_BUFFER_POOL_OPTION_VIDEO_META, NULL};
+    (void)pool;
+    return options;
+}
 
-    g_info("Initializing buffer pool: %ux%u, format=0x%x, modifier=0x%016lx, size=%u, force_linear=%s",
-           width, height, format, modifier, pool_size, force_linear ? "TRUE" : "FALSE");
+static gboolean
+gst_pooled_buffer_pool_set_config(GstBufferPool *pool, GstStructure *config)
+{
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(pool);
+    GstCaps *caps;
+    guint size, min_buffers, max_buffers;
+
+    if (!gst_buffer_pool_config_get_params(config, &caps, &size, &min_buffers, &max_buffers))
+        return FALSE;
 
-    for (guint i = 0; i < pool_size; i++)
+    /* The buffer size depends on the stride and modifier the driver picks.
+     * Allocate the first slot now and advertise its real size; alloc_buffer
+     * hands it out first. Buffers are released back into the free list only
+     * if their size matches the configured one. */
+    if (!self->probe_slot)
     {
-        if (!cuda_egl_buffer_alloc(ctx, &pool->buffers[i],
-                                   width, height, format, modifier, force_linear))
+        pooled_push_context(self);
+        self->probe_slot = pooled_slot_new(self);
+        pooled_pop_context(self);
+        if (!self->probe_slot)
         {
-            g_warning("Failed to allocate buffer %u in pool", i);
-
-            /* Clean up already allocated buffers */
-            for (guint j = 0; j < i; j++)
-            {
-                cuda_egl_buffer_free(ctx, &pool->buffers[j]);
-            }
-            g_free(pool->buffers);
-            pool->buffers = NULL;
+            GST_ERROR_OBJECT(pool, "Failed to allocate %ux%u buffer (format=0x%x, modifier=0x%016lx)",
+                             self->alloc_width, self->alloc_height, self->gbm_format, self->modifier);
             return FALSE;
         }
+    }
 
-        g_debug("Pool buffer %u: fd=%d, strides=[%u,%u], offsets=[%u,%u], modifier=0x%016lx",
-                i, pool->buffers[i].dmabuf_fd,
-                pool->buffers[i].strides[0], pool->buffers[i].strides[1],
-                pool->buffers[i].offsets[0], pool->buffers[i].offsets[1],
-                pool->buffers[i].modifier);
+    gst_buffer_pool_config_set_params(config, caps, (guint)self->probe_slot->size,
+                                      min_buffers, max_buffers);
+
+    g_mutex_lock(&self->sizing_lock);
+    guint allocated = self->sizing.allocated;
+    pool_sizing_init(&self->sizing, min_buffers, max_buffers);
+    self->sizing.allocated = allocated;
+    g_mutex_unlock(&self->sizing_lock);
+
+    return GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class)->set_config(pool, config);
+}
+
+static GstFlowReturn
+gst_pooled_buffer_pool_alloc_buffer(GstBufferPool *pool,
+                                    GstBuffer **buffer,
+                                    GstBufferPoolAcquireParams *params)
+{
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(pool);
+    (void)params;
+
+    CudaEglBuffer *slot = self->probe_slot;
+    self->probe_slot = NULL;
+
+    pooled_push_context(self);
+    if (!slot)
+        slot = pooled_slot_new(self);
+    if (!slot)
+    {
+        pooled_pop_context(self);
+        GST_ERROR_OBJECT(pool, "Failed to allocate pool buffer");
+        return GST_FLOW_ERROR;
     }
 
-    pool->current_index = 0;
-    pool->initialized = TRUE;
+    /* The GstMemory owns a dup of the BO fd for the whole lifetime of the
+     * pooled buffer; it is created once here, not per frame. */
+    int fd_dup = dup(slot->dmabuf_fd);
+    if (fd_dup < 0)
+    {
+        GST_ERROR_OBJECT(pool, "Failed to dup fd");
+        pooled_slot_free(self, slot);
+        pooled_pop_context(self);
+        return GST_FLOW_ERROR;
+    }
 
-    g_info("Buffer pool initialized with %u buffers", pool_size);
-    return TRUE;
+    GstMemory *mem = gst_dmabuf_allocator_alloc(self->dmabuf_alloc, fd_dup, slot->size);
+    if (!mem)
+    {
+        close(fd_dup);
+        pooled_slot_free(self, slot);
+        pooled_pop_context(self);
+        return GST_FLOW_ERROR;
+    }
+    pooled_pop_context(self);
+
+    if (slot->fence)
+        buffer_fence_attach(mem, slot->fence);
+
+    GstBuffer *buf = gst_buffer_new();
+    gst_buffer_append_memory(buf, mem);
+
+    /* Add video meta with actual pixel format for proper stride/offset handling */
+    guint n_planes = GST_VIDEO_INFO_N_PLANES(&self->info);
+    gsize offsets[GST_VIDEO_MAX_PLANES] = {0};
+    gint strides[GST_VIDEO_MAX_PLANES] = {0};
+    for (guint i = 0; i < n_planes && i < 4; i++)
+    {
+        offsets[i] = slot->offsets[i];
+        strides[i] = (gint)slot->strides[i];
+    }
+    GstVideoMeta *vmeta = gst_buffer_add_video_meta_full(buf, GST_VIDEO_FRAME_FLAG_NONE,
+                                                         GST_VIDEO_INFO_FORMAT(&self->info),
+                                                         GST_VIDEO_INFO_WIDTH(&self->info),
+                                                         GST_VIDEO_INFO_HEIGHT(&self->info),
+                                                         n_planes, offsets, strides);
+
+    /* CPU maps of block-linear slots (thumbnailers, frame hashing) see
+     * linear planes */
+    block_linear_install_video_meta_map(vmeta, slot->modifier);
+
+    gst_mini_object_set_qdata(GST_MINI_OBJECT(buf), pooled_slot_quark(), slot, NULL);
+
+    g_mutex_lock(&self->sizing_lock);
+    pool_sizing_buffer_added(&self->sizing);
+    g_mutex_unlock(&self->sizing_lock);
+
+    *buffer = buf;
+    return GST_FLOW_OK;
 }
 
-void pooled_buffer_pool_cleanup(PooledBufferPool *pool, CudaEglContext *ctx)
+static void
+gst_pooled_buffer_pool_free_buffer(GstBufferPool *pool, GstBuffer *buffer)
 {
-    if (!pool || !pool->buffers)
-        return;
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(pool);
+    CudaEglBuffer *slot = gst_pooled_buffer_pool_get_slot(buffer);
 
-    g_debug("Cleaning up buffer pool");
+    /* Drop the GstMemory (and its fd dup) before tearing down the BO */
+    GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class)->free_buffer(pool, buffer);
 
-    for (guint i = 0; i < pool->pool_size; i++)
+    if (slot)
     {
-        cuda_egl_buffer_free(ctx, &pool->buffers[i]);
+        pooled_push_context(self);
+        pooled_slot_free(self, slot);
+        pooled_pop_context(self);
     }
 
-    g_free(pool->buffers);
-    pool->buffers = NULL;
-    pool->pool_size = 0;
-    pool->initialized = FALSE;
+    g_mutex_lock(&self->sizing_lock);
+    pool_sizing_buffer_removed(&self->sizing);
+    g_mutex_unlock(&self->sizing_lock);
 }
 
-CudaEglBuffer *
-pooled_buffer_pool_acquire(PooledBufferPool *pool)
+/* Free a buffer release_buffer picked for shrinking. Done here rather
+ * than on the sink's thread that released it: the teardown waits on the
+ * slot's stream. Kept when no other buffer is available without waiting. */
+static void
+pooled_retire(GstPooledBufferPool *self, GstBuffer **buffer)
 {
-    g_return_val_if_fail(pool != NULL && pool->initialized, NULL);
-    g_return_val_if_fail(pool->buffers != NULL, NULL);
+    GstBufferPool *pool = GST_BUFFER_POOL(self);
+    GstBufferPoolClass *parent_class = GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class);
+    GstBufferPoolAcquireParams dontwait = {0};
+    GstBuffer *other = NULL;
+
+    gst_pooled_buffer_pool_get_slot(*buffer)->retire = FALSE;
 
-    CudaEglBuffer *buf = &pool->buffers[pool->current_index];
-    pool->current_index = (pool->current_index + 1) % pool->pool_size;
+    dontwait.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    if (parent_class->acquire_buffer(pool, &other, &dontwait) != GST_FLOW_OK)
+        return;
 
-    /* Synchronize on this buffer's stream to ensure previous operations complete.
-     * Due to round-robin, we're pool_size frames behind, giving time for async completion. */
-    if (buf->cuda_stream)
+    /* Tagged buffers are freed by the base class instead of queued;
+     * free_buffer pushes the pool's CUDA context */
+    GST_DEBUG_OBJECT(pool, "Freeing idle buffer %p", *buffer);
+    GST_BUFFER_FLAG_SET(*buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+    parent_class->release_buffer(pool, *buffer);
+    *buffer = other;
+}
+
+static GstFlowReturn
+gst_pooled_buffer_pool_acquire_buffer(GstBufferPool *pool,
+                                      GstBuffer **buffer,
+                                      GstBufferPoolAcquireParams *params)
+{
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(pool);
+    GstBufferPoolClass *parent_class = GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class);
+
+    GstFlowReturn ret = parent_class->acquire_buffer(pool, buffer, params);
+    if (ret != GST_FLOW_OK)
+        return ret;
+
+    if (gst_pooled_buffer_pool_get_slot(*buffer)->retire)
+        pooled_retire(self, buffer);
+
+    CudaEglBuffer *slot = gst_pooled_buffer_pool_get_slot(*buffer);
+
+    g_mutex_lock(&self->sizing_lock);
+    gboolean grow = pool_sizing_acquire(&self->sizing,
+                                        slot->fence && !buffer_fence_is_signaled(slot->fence));
+    g_mutex_unlock(&self->sizing_lock);
+
+    /* The GPU is still writing this one: rather than stall the streaming
+     * thread on it, take another free buffer (or a new one, below max)
+     * and put this one back at the end of the free list */
+    if (grow)
     {
-        CUresult cu_res = cuStreamSynchronize(buf->cuda_stream);
-        if (cu_res != CUDA_SUCCESS)
+        GstBufferPoolAcquireParams dontwait = {0};
+        GstBuffer *other = NULL;
+
+        dontwait.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+        if (parent_class->acquire_buffer(pool, &other, &dontwait) == GST_FLOW_OK)
         {
-            g_warning("cuStreamSynchronize failed: %d", cu_res);
+            GST_DEBUG_OBJECT(pool, "Buffer %p still busy, using %p", *buffer, other);
+            parent_class->release_buffer(pool, *buffer);
+            *buffer = other;
+            slot = gst_pooled_buffer_pool_get_slot(other);
         }
     }
 
-    buf->in_use = TRUE;
-    return buf;
+    /* Downstream released the buffer; make sure the GPU is done with it too */
+    if (slot->fence)
+        buffer_fence_wait(slot->fence);
+    else if (slot->cuda_stream)
+        cuStreamSynchronize(slot->cuda_stream);
+
+    /* Frames smaller than the allocation only change the meta's size */
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(*buffer);
+    if (vmeta)
+    {
+        GST_OBJECT_LOCK(pool);
+        vmeta->width = GST_VIDEO_INFO_WIDTH(&self->info);
+        vmeta->height = GST_VIDEO_INFO_HEIGHT(&self->info);
+        GST_OBJECT_UNLOCK(pool);
+    }
+
+    slot->in_use = TRUE;
+    return GST_FLOW_OK;
+}
+
+static void
+gst_pooled_buffer_pool_release_buffer(GstBufferPool *pool, GstBuffer *buffer)
+{
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(pool);
+    CudaEglBuffer *slot = gst_pooled_buffer_pool_get_slot(buffer);
+
+    /* Last GstBuffer reference dropped: the compositor is done with it */
+    if (slot)
+        slot->in_use = FALSE;
+
+    g_mutex_lock(&self->sizing_lock);
+    gboolean shrink = pool_sizing_release(&self->sizing);
+    g_mutex_unlock(&self->sizing_lock);
+
+    /* This may be the sink's or compositor's thread: only mark it, the
+     * next acquire frees it on the streaming thread */
+    if (shrink && slot)
+    {
+        GST_DEBUG_OBJECT(pool, "Retiring idle buffer %p", buffer);
+        slot->retire = TRUE;
+    }
+
+    GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class)->release_buffer(pool, buffer);
+}
+
+static void
+gst_pooled_buffer_pool_finalize(GObject *object)
+{
+    GstPooledBufferPool *self = GST_POOLED_BUFFER_POOL(object);
+
+    if (self->probe_slot)
+    {
+        pooled_push_context(self);
+        pooled_slot_free(self, self->probe_slot);
+        pooled_pop_context(self);
+        self->probe_slot = NULL;
+    }
+    if (self->dmabuf_alloc)
+    {
+        gst_object_unref(self->dmabuf_alloc);
+        self->dmabuf_alloc = NULL;
+    }
+
+    /* Every buffer is gone by now: the device and context can go too */
+    cuda_egl_context_cleanup(&self->egl_ctx);
+    if (self->cuda_ctx)
+    {
+        gst_object_unref(self->cuda_ctx);
+        self->cuda_ctx = NULL;
+    }
+    g_mutex_clear(&self->sizing_lock);
+
+    G_OBJECT_CLASS(gst_pooled_buffer_pool_parent_class)->finalize(object);
+}
+
+static void
+gst_pooled_buffer_pool_class_init(GstPooledBufferPoolClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+    gobject_class->finalize = gst_pooled_buffer_pool_finalize;
+
+    pool_class->get_options = gst_pooled_buffer_pool_get_options;
+    pool_class->set_config = gst_pooled_buffer_pool_set_config;
+    pool_class->alloc_buffer = gst_pooled_buffer_pool_alloc_buffer;
+    pool_class->free_buffer = gst_pooled_buffer_pool_free_buffer;
+    pool_class->acquire_buffer = gst_pooled_buffer_pool_acquire_buffer;
+    pool_class->release_buffer = gst_pooled_buffer_pool_release_buffer;
+}
+
+static void
+gst_pooled_buffer_pool_init(GstPooledBufferPool *self)
+{
+    gst_video_info_init(&self->info);
+    self->modifier = DRM_FORMAT_MOD_INVALID;
+    g_mutex_init(&self->sizing_lock);
+    pool_sizing_init(&self->sizing, POOLED_BUFFER_POOL_DEFAULT_MIN_BUFFERS,
+                     POOLED_BUFFER_POOL_DEFAULT_MAX_BUFFERS);
+}
+
+static void
+pooled_set_alloc_size(GstPooledBufferPool *self, guint width, guint height)
+{
+    /* P010 has 16-bit (2-byte) samples, NV12 has 8-bit (1-byte).
+     * NV12 at width*2 has identical byte layout to P010 at width. */
+    if (GST_VIDEO_INFO_FORMAT(&self->info) == GST_VIDEO_FORMAT_P010_10LE)
+        width *= 2;
+
+    self->alloc_width = width;
+    self->alloc_height = height;
+}
+
+GstBufferPool *
+gst_pooled_buffer_pool_new(const gchar *drm_device,
+                           GstCudaContext *cuda_ctx,
+                           GstAllocator *dmabuf_alloc,
+                           const GstVideoInfo *info,
+                           guint64 modifier,
+                           gboolean force_linear)
+{
+    g_return_val_if_fail(drm_device != NULL, NULL);
+    g_return_val_if_fail(dmabuf_alloc != NULL, NULL);
+    g_return_val_if_fail(info != NULL, NULL);
+
+    GstPooledBufferPool *self = g_object_new(GST_TYPE_POOLED_BUFFER_POOL, NULL);
+    gst_object_ref_sink(self);
+
+    /* Usually just a reference on the device the element already opened */
+    if (!cuda_egl_context_init(&self->egl_ctx, drm_device))
+    {
+        g_warning("Failed to open %s for the buffer pool", drm_device);
+        gst_object_unref(self);
+        return NULL;
+    }
+    if (cuda_ctx)
+        self->cuda_ctx = gst_object_ref(cuda_ctx);
+    self->dmabuf_alloc = gst_object_ref(dmabuf_alloc);
+    self->info = *info;
+    self->modifier = modifier;
+    self->force_linear = force_linear;
+
+    switch (GST_VIDEO_INFO_FORMAT(info))
+    {
+    case GST_VIDEO_FORMAT_P010_10LE:
+    case GST_VIDEO_FORMAT_NV12:
+        self->gbm_format = GBM_FORMAT_NV12;
+        break;
+    case GST_VIDEO_FORMAT_BGR10A2_LE:
+        /* Also backs XR30: same layout, the kernel writes opaque alpha */
+        self->gbm_format = GBM_FORMAT_ARGB2101010;
+        break;
+    default:
+        self->gbm_format = GBM_FORMAT_XRGB8888;
+        break;
+    }
+    pooled_set_alloc_size(self, GST_VIDEO_INFO_WIDTH(info), GST_VIDEO_INFO_HEIGHT(info));
+
+    g_info("Creating buffer pool: %ux%u, format=0x%x, modifier=0x%016lx, force_linear=%s",
+           self->alloc_width, self->alloc_height, self->gbm_format, modifier,
+           force_linear ? "TRUE" : "FALSE");
+
+    return GST_BUFFER_POOL(self);
+}
+
+CudaEglBuffer *
+gst_pooled_buffer_pool_get_slot(GstBuffer *buffer)
+{
+    return gst_mini_object_get_qdata(GST_MINI_OBJECT(buffer), pooled_slot_quark());
+}
+
+void gst_pooled_buffer_pool_set_max_size(GstPooledBufferPool *pool,
+                                         guint max_width,
+                                         guint max_height)
+{
+    g_return_if_fail(!gst_buffer_pool_is_active(GST_BUFFER_POOL(pool)));
+
+    /* Even sizes keep the 4:2:0 chroma plane whole */
+    pool->max_width = GST_ROUND_UP_2(MAX(max_width, (guint)GST_VIDEO_INFO_WIDTH(&pool->info)));
+    pool->max_height = GST_ROUND_UP_2(MAX(max_height, (guint)GST_VIDEO_INFO_HEIGHT(&pool->info)));
+    pooled_set_alloc_size(pool, pool->max_width, pool->max_height);
+
+    g_info("Buffer pool sized for frames up to %ux%u", pool->max_width, pool->max_height);
+}
+
+static gboolean
+pooled_fits(GstPooledBufferPool *pool, guint width, guint height)
+{
+    if (pool->max_width)
+        return width <= pool->max_width && height <= pool->max_height;
+
+    return width == (guint)GST_VIDEO_INFO_WIDTH(&pool->info) &&
+           height == (guint)GST_VIDEO_INFO_HEIGHT(&pool->info);
 }
 
 gboolean
-pooled_buffer_pool_needs_reinit(PooledBufferPool *pool,
-                                guint width,
-                                guint height)
+gst_pooled_buffer_pool_set_frame_size(GstPooledBufferPool *pool, guint width, guint height)
 {
-    if (!pool || !pool->initialized)
+    if (!pooled_fits(pool, width, height))
+        return FALSE;
+
+    GST_OBJECT_LOCK(pool);
+    GST_VIDEO_INFO_WIDTH(&pool->info) = (gint)width;
+    GST_VIDEO_INFO_HEIGHT(&pool->info) = (gint)height;
+    GST_OBJECT_UNLOCK(pool);
+
+    return TRUE;
+}
+
+void gst_pooled_buffer_pool_preallocate(GstPooledBufferPool *pool, guint n_buffers)
+{
+    GstBufferPool *bpool = GST_BUFFER_POOL(pool);
+    GstBufferPoolClass *parent_class = GST_BUFFER_POOL_CLASS(gst_pooled_buffer_pool_parent_class);
+    GstBufferPoolAcquireParams params = {0};
+    GstBuffer **held = g_new0(GstBuffer *, n_buffers);
+    guint n = 0;
+
+    /* Holding the free buffers makes the base class allocate the missing
+     * ones; at max-buffers the acquire fails instead of waiting. This goes
+     * straight to the base class: no frame is in flight, so the sizing
+     * stats, the slack window and the fence wait must not see it. */
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+    while (n < n_buffers && parent_class->acquire_buffer(bpool, &held[n], &params) == GST_FLOW_OK)
+        n++;
+
+    g_mutex_lock(&pool->sizing_lock);
+    pool->sizing.min_buffers = MAX(pool->sizing.min_buffers, n_buffers);
+    g_mutex_unlock(&pool->sizing_lock);
+
+    for (guint i = 0; i < n; i++)
+        parent_class->release_buffer(bpool, held[i]);
+    g_free(held);
+
+    GST_DEBUG_OBJECT(pool, "Preallocated up to %u buffers (%u held)", n_buffers, n);
+}
+
+gboolean
+gst_pooled_buffer_pool_needs_reinit(GstPooledBufferPool *pool,
+                                    const GstVideoInfo *info,
+                                    guint64 modifier,
+                                    gboolean force_linear)
+{
+    if (!pool || !gst_buffer_pool_is_active(GST_BUFFER_POOL(pool)))
         return TRUE;
 
-    return (pool->width != width || pool->height != height);
+    return GST_VIDEO_INFO_FORMAT(&pool->info) != GST_VIDEO_INFO_FORMAT(info) ||
+           !pooled_fits(pool, GST_VIDEO_INFO_WIDTH(info), GST_VIDEO_INFO_HEIGHT(info)) ||
+           pool->modifier != modifier ||
+           pool->force_linear != force_linear;
+}
+
+void gst_pooled_buffer_pool_get_stats(GstPooledBufferPool *pool,
+                                      guint *buffers,
+                                      guint *in_flight,
+                                      guint *high_water)
+{
+    g_mutex_lock(&pool->sizing_lock);
+    if (buffers)
+        *buffers = pool->sizing.allocated;
+    if (in_flight)
+        *in_flight = pool->sizing.in_flight;
+    if (high_water)
+        *high_water = pool->sizing.high_water;
+    g_mutex_unlock(&pool->sizing_lock);
 }
@@ -2,82 +2,145 @@
  * SPDX-FileCopyrightText: 2025 Ericky
  *
  * Pooled Buffer Management
- * Pre-allocated buffer pools for zero-copy video paths
+ * GstBufferPool of pre-allocated CUDA-EGL buffers for zero-copy video paths
+ *
+ * Each pooled GstBuffer wraps one CudaEglBuffer (GBM BO + EGLImage + CUDA
+ * registration + stream). Buffers only return to the free list once the last
+ * GstBuffer reference is dropped, i.e. once waylandsink/the compositor has
+ * released the wl_buffer, so a slot is never overwritten while on screen.
+ * When every buffer is in flight the pool grows up to max-buffers and then
+ * blocks in acquire. It also grows when the next free buffer is still being
+ * written by the GPU (deferred sync), and frees buffers again after
+ * sustained slack, never going below min-buffers (see pool_sizing.h).
  */
 
 #ifndef __POOLED_BUFFERS_H__
 #define __POOLED_BUFFERS_H__
 
 #include "cuda_egl_interop.h"
+#include "pool_sizing.h"
 #include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/cuda/gstcuda.h>
 
 G_BEGIN_DECLS
 
 /* Default pool sizes */
-#define POOLED_BUFFER_DEFAULT_SIZE 4
+#define POOLED_BUFFER_POOL_DEFAULT_MIN_BUFFERS 4
+#define POOLED_BUFFER_POOL_DEFAULT_MAX_BUFFERS 16
 
-/**
- * PooledBufferPool - A pool of pre-allocated CUDA-EGL buffers
- */
-typedef struct _PooledBufferPool
+#define GST_TYPE_POOLED_BUFFER_POOL (gst_pooled_buffer_pool_get_type())
+G_DECLARE_FINAL_TYPE(GstPooledBufferPool, gst_pooled_buffer_pool, GST, POOLED_BUFFER_POOL, GstBufferPool)
+
+struct _GstPooledBufferPool
 {
-    CudaEglBuffer *buffers;
-    guint pool_size;
-    guint current_index; /* Round-robin index */
-
-    /* Pool configuration */
-    guint width;
-    guint height;
-    guint32 format;
+    GstBufferPool parent;
+
+    /* Own references: buffers still downstream keep the pool, and with it
+     * the device and CUDA context, alive after the element is gone */
+    CudaEglContext egl_ctx;
+    GstCudaContext *cuda_ctx; /* Pushed around buffer setup and teardown */
+    GstAllocator *dmabuf_alloc;
+
+    /* Output frame layout (NV12, P010_10LE or BGRx) */
+    GstVideoInfo info;
+
+    /* Largest frame the buffers hold (0 when sized exactly for info);
+     * smaller frames reuse them with a smaller video meta */
+    guint max_width;
+    guint max_height;
+
+    /* GBM allocation parameters derived from info (or the max size) */
+    guint alloc_width;
+    guint alloc_height;
+    guint32 gbm_format;
     guint64 modifier;
     gboolean force_linear;
 
-    gboolean initialized;
-} PooledBufferPool;
+    /* First slot, allocated in set_config to learn the real buffer size */
+    CudaEglBuffer *probe_slot;
+
+    /* Adaptive sizing; acquire and release run on different threads */
+    GMutex sizing_lock;
+    PoolSizing sizing;
+};
 
 /**
- * Initialize a buffer pool with the specified parameters.
+ * Create a pool of CUDA-EGL buffers for the given output frame layout.
+ * P010 is allocated as NV12 at twice the width (identical byte layout).
+ * The pool must be configured (caps, min/max buffers) and activated by the
+ * caller; the configured size is replaced by the real buffer size.
  *
- * @param pool Pool structure to initialize
- * @param ctx CUDA-EGL context for buffer allocation
- * @param pool_size Number of buffers in the pool
- * @param width Buffer width
- * @param height Buffer height
- * @param format GBM format (GBM_FORMAT_NV12 or GBM_FORMAT_XRGB8888)
+ * @param drm_device Render node to allocate on; the pool holds its own
+ *                   reference to the shared device
+ * @param cuda_ctx CUDA context the buffers are registered in (may be NULL
+ *                 when the caller keeps one current)
+ * @param dmabuf_alloc DMA-BUF allocator used to wrap the pooled fds
+ * @param info Output video info (NV12, P010_10LE or BGRx)
  * @param modifier DRM modifier
  * @param force_linear If TRUE, force LINEAR modifier for Vulkan compatibility
- * @return TRUE on success
+ * @return New buffer pool, or NULL if the device couldn't be opened
  */
-gboolean pooled_buffer_pool_init(PooledBufferPool *pool,
-                                 CudaEglContext *ctx,
-                                 guint pool_size,
-                                 guint width,
-                                 guint height,
-                                 guint32 format,
-                                 guint64 modifier,
-                                 gboolean force_linear);
+GstBufferPool *gst_pooled_buffer_pool_new(const gchar *drm_device,
+                                          GstCudaContext *cuda_ctx,
+                                          GstAllocator *dmabuf_alloc,
+                                          const GstVideoInfo *info,
+                                          guint64 modifier,
+                                          gboolean force_linear);
 
 /**
- * Clean up a buffer pool and free all resources.
+ * Get the CUDA-EGL buffer backing a pooled GstBuffer.
+ *
+ * @return The slot, or NULL if the buffer does not come from a GstPooledBufferPool
  */
-void pooled_buffer_pool_cleanup(PooledBufferPool *pool, CudaEglContext *ctx);
+CudaEglBuffer *gst_pooled_buffer_pool_get_slot(GstBuffer *buffer);
 
 /**
- * Acquire the next buffer from the pool (round-robin).
- * This will synchronize on the buffer's CUDA stream to ensure
- * any previous async operations are complete.
+ * Allocate buffers for frames up to @max_width x @max_height instead of
+ * the size in the pool's info, so smaller frames of the same format can
+ * reuse them (see gst_pooled_buffer_pool_set_frame_size()). Must be called
+ * before the pool is configured.
+ */
+void gst_pooled_buffer_pool_set_max_size(GstPooledBufferPool *pool,
+                                         guint max_width,
+                                         guint max_height);
+
+/**
+ * Switch the frame size the buffers are handed out for. Buffers acquired
+ * from now on carry a video meta of that size; strides and offsets stay
+ * those of the allocation.
  *
- * @param pool The buffer pool
- * @return Pointer to the acquired buffer, or NULL on error
+ * @return FALSE if the buffers can't hold a frame of that size
+ */
+gboolean gst_pooled_buffer_pool_set_frame_size(GstPooledBufferPool *pool,
+                                               guint width,
+                                               guint height);
+
+/**
+ * Allocate buffers until the pool holds at least @n_buffers (bounded by
+ * max-buffers), and keep at least that many from then on. Blocks for the
+ * GBM/EGL/CUDA setup of each one, so call it off the streaming thread
+ * with the CUDA context current.
+ */
+void gst_pooled_buffer_pool_preallocate(GstPooledBufferPool *pool, guint n_buffers);
+
+/**
+ * Check if the pool needs to be replaced for a new output layout. A pool
+ * with a max size only needs replacing for frames larger than that.
  */
-CudaEglBuffer *pooled_buffer_pool_acquire(PooledBufferPool *pool);
+gboolean gst_pooled_buffer_pool_needs_reinit(GstPooledBufferPool *pool,
+                                             const GstVideoInfo *info,
+                                             guint64 modifier,
+                                             gboolean force_linear);
 
 /**
- * Check if the pool needs reinitialization due to dimension changes.
+ * Current buffer count, in-flight depth and its high-water mark since the
+ * pool was configured.
  */
-gboolean pooled_buffer_pool_needs_reinit(PooledBufferPool *pool,
-                                         guint width,
-                                         guint height);
+void gst_pooled_buffer_pool_get_stats(GstPooledBufferPool *pool,
+                                      guint *buffers,
+                                      guint *in_flight,
+                                      guint *high_water);
 
 G_END_DECLS
 
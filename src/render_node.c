@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Render Node Discovery
+ */
+
+#include "render_node.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct _RenderNodeTable
+{
+    GArray *nodes; /* RenderNode */
+};
+
+static gint
+compare_names(gconstpointer a, gconstpointer b)
+{
+    const gchar *na = *(const gchar *const *)a;
+    const gchar *nb = *(const gchar *const *)b;
+
+    /* renderD128 < renderD129 < renderD1000 */
+    gsize la = strlen(na), lb = strlen(nb);
+    if (la != lb)
+        return la < lb ? -1 : 1;
+    return strcmp(na, nb);
+}
+
+/* DRIVER= and PCI_SLOT_NAME= of the node's device */
+static void
+read_uevent(const gchar *root, const gchar *name, RenderNode *node)
+{
+    gchar *path = g_build_filename(root, "sys", "class", "drm", name, "device", "uevent", NULL);
+    gchar *contents = NULL;
+
+    if (g_file_get_contents(path, &contents, NULL, NULL))
+    {
+        gchar **lines = g_strsplit(contents, "\n", -1);
+        for (guint i = 0; lines[i]; i++)
+        {
+            if (g_str_has_prefix(lines[i], "DRIVER="))
+                node->driver = g_strdup(lines[i] + strlen("DRIVER="));
+            else if (g_str_has_prefix(lines[i], "PCI_SLOT_NAME="))
+                node->pci_bus_id = g_strdup(lines[i] + strlen("PCI_SLOT_NAME="));
+        }
+        g_strfreev(lines);
+    }
+
+    g_free(contents);
+    g_free(path);
+}
+
+static void
+clear_node(gpointer data)
+{
+    RenderNode *node = data;
+
+    g_free(node->path);
+    g_free(node->driver);
+    g_free(node->pci_bus_id);
+}
+
+RenderNodeTable *
+render_node_table_scan(const gchar *root)
+{
+    RenderNodeTable *table = g_new0(RenderNodeTable, 1);
+    gchar *dri = g_build_filename(root, "dev", "dri", NULL);
+    GDir *dir = g_dir_open(dri, 0, NULL);
+    GPtrArray *names = g_ptr_array_new_with_free_func(g_free);
+
+    table->nodes = g_array_new(FALSE, TRUE, sizeof(RenderNode));
+    g_array_set_clear_func(table->nodes, clear_node);
+
+    if (dir)
+    {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir)) != NULL)
+            if (g_str_has_prefix(name, "renderD"))
+                g_ptr_array_add(names, g_strdup(name));
+        g_dir_close(dir);
+    }
+
+    /* Directory order is arbitrary; "the first node" should not be */
+    g_ptr_array_sort(names, compare_names);
+
+    for (guint i = 0; i < names->len; i++)
+    {
+        const gchar *name = g_ptr_array_index(names, i);
+        RenderNode node = {0};
+
+        node.path = g_strdup_printf("/dev/dri/%s", name);
+        read_uevent(root, name, &node);
+        g_array_append_val(table->nodes, node);
+
+        g_debug("Render node %s: driver %s, PCI %s", node.path,
+                node.driver ? node.driver : "unknown",
+                node.pci_bus_id ? node.pci_bus_id : "none");
+    }
+
+    g_ptr_array_unref(names);
+    g_free(dri);
+    return table;
+}
+
+void render_node_table_free(RenderNodeTable *table)
+{
+    if (!table)
+        return;
+
+    g_array_unref(table->nodes);
+    g_free(table);
+}
+
+guint render_node_table_get_n_nodes(RenderNodeTable *table)
+{
+    return table->nodes->len;
+}
+
+const RenderNode *
+render_node_table_get_node(RenderNodeTable *table, guint index)
+{
+    g_return_val_if_fail(index < table->nodes->len, NULL);
+
+    return &g_array_index(table->nodes, RenderNode, index);
+}
+
+static gboolean
+parse_bus_id(const gchar *bus_id, guint *domain, guint *bus, guint *device, guint *function)
+{
+    return bus_id && sscanf(bus_id, "%x:%x:%x.%x", domain, bus, device, function) == 4;
+}
+
+gboolean
+render_node_bus_id_equal(const gchar *a, const gchar *b)
+{
+    guint da, ba, sa, fa;
+    guint db, bb, sb, fb;
+
+    if (!parse_bus_id(a, &da, &ba, &sa, &fa) || !parse_bus_id(b, &db, &bb, &sb, &fb))
+        return FALSE;
+    return da == db && ba == bb && sa == sb && fa == fb;
+}
+
+const gchar *
+render_node_table_find_nvidia(RenderNodeTable *table, const gchar *pci_bus_id)
+{
+    const gchar *unknown = NULL;
+
+    for (guint i = 0; i < table->nodes->len; i++)
+    {
+        const RenderNode *node = &g_array_index(table->nodes, RenderNode, i);
+
+        if (!node->driver)
+        {
+            if (!unknown)
+                unknown = node->path;
+            continue;
+        }
+        if (strcmp(node->driver, "nvidia") != 0)
+            continue;
+        if (!pci_bus_id || render_node_bus_id_equal(node->pci_bus_id, pci_bus_id))
+            return node->path;
+    }
+
+    return pci_bus_id ? NULL : unknown;
+}
+
+RenderNodeTable *
+render_node_table_get_default(void)
+{
+    static RenderNodeTable *table = NULL;
+
+    if (g_once_init_enter(&table))
+        g_once_init_leave(&table, render_node_table_scan("/"));
+    return table;
+}
+
+const gchar *
+render_node_find(const gchar *pci_bus_id)
+{
+    RenderNodeTable *table = render_node_table_get_default();
+    const gchar *path = NULL;
+
+    if (pci_bus_id)
+    {
+        path = render_node_table_find_nvidia(table, pci_bus_id);
+        if (!path)
+            g_warning("No NVIDIA render node on PCI %s, using the first one", pci_bus_id);
+    }
+    if (!path)
+        path = render_node_table_find_nvidia(table, NULL);
+
+    return path ? path : RENDER_NODE_FALLBACK;
+}
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Render Node Discovery
+ * DRM render nodes (/dev/dri/renderD*) with the kernel driver and PCI
+ * slot of their device, read from sysfs rather than by opening every
+ * node. Scanned once per process; lookups pick the NVIDIA node, or the
+ * one on a given PCI bus ID to match a CUDA device.
+ */
+
+#ifndef __RENDER_NODE_H__
+#define __RENDER_NODE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Used when no render node can be found at all */
+#define RENDER_NODE_FALLBACK "/dev/dri/renderD128"
+
+typedef struct
+{
+    gchar *path;       /* e.g. "/dev/dri/renderD128" */
+    gchar *driver;     /* Kernel driver ("nvidia", "amdgpu", ...), NULL if unknown */
+    gchar *pci_bus_id; /* e.g. "0000:01:00.0", NULL if unknown or not PCI */
+} RenderNode;
+
+typedef struct _RenderNodeTable RenderNodeTable;
+
+/**
+ * Scan @root/dev/dri for render nodes, sorted by name, reading each one's
+ * driver and PCI slot from @root/sys/class/drm/<node>/device/uevent.
+ * Node paths are reported without @root. Never NULL; the table is empty
+ * if the directory can't be read.
+ *
+ * @param root Filesystem root, "/" outside of tests
+ */
+RenderNodeTable *render_node_table_scan(const gchar *root);
+
+void render_node_table_free(RenderNodeTable *table);
+
+guint render_node_table_get_n_nodes(RenderNodeTable *table);
+
+const RenderNode *render_node_table_get_node(RenderNodeTable *table, guint index);
+
+/**
+ * The NVIDIA render node on @pci_bus_id, or the first NVIDIA node if
+ * @pci_bus_id is NULL. Bus IDs compare by value, so "0000:0A:00.0" and
+ * "00000000:0a:00.0" match. Without a bus ID, a node whose driver is
+ * unknown (no sysfs) is taken when no node is known to be NVIDIA.
+ *
+ * @return Node path owned by @table, or NULL
+ */
+const gchar *render_node_table_find_nvidia(RenderNodeTable *table, const gchar *pci_bus_id);
+
+/**
+ * Whether @a and @b ("domain:bus:device.function", hex) are the same slot.
+ */
+gboolean render_node_bus_id_equal(const gchar *a, const gchar *b);
+
+/**
+ * The process-wide table, scanned from "/" on first use. Never NULL;
+ * valid for the lifetime of the process.
+ */
+RenderNodeTable *render_node_table_get_default(void);
+
+/**
+ * render_node_table_find_nvidia() on the process-wide table, falling back
+ * to the first NVIDIA node when none is on @pci_bus_id, then to
+ * #RENDER_NODE_FALLBACK.
+ *
+ * @return Static node path
+ */
+const gchar *render_node_find(const gchar *pci_bus_id);
+
+G_END_DECLS
+
+#endif /* __RENDER_NODE_H__ */
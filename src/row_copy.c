@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Row Copy
+ */
+
+#include "row_copy.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Bands below this size cost more to hand off than to copy */
+#define ROW_COPY_MIN_BAND_BYTES (256 * 1024)
+
+gboolean row_copy_has_stream(void)
+{
+#if defined(__SSE2__)
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/* Copy @n bytes, streaming the 16-byte aligned body of the destination */
+static void
+copy_stream(guint8 *dst, const guint8 *src, gsize n)
+{
+#if defined(__SSE2__)
+    gsize head = (16 - ((uintptr_t)dst & 15)) & 15;
+    if (head > n)
+        head = n;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    n -= head;
+
+    for (; n >= 64; n -= 64, dst += 64, src += 64)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)src);
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)dst, a);
+        _mm_stream_si128((__m128i *)(dst + 16), b);
+        _mm_stream_si128((__m128i *)(dst + 32), c);
+        _mm_stream_si128((__m128i *)(dst + 48), d);
+    }
+    for (; n >= 16; n -= 16, dst += 16, src += 16)
+        _mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+#endif
+
+    memcpy(dst, src, n);
+}
+
+static inline void
+copy_block(RowCopyMethod method, guint8 *dst, const guint8 *src, gsize n)
+{
+    if (method == ROW_COPY_STREAM)
+        copy_stream(dst, src, n);
+    else
+        memcpy(dst, src, n);
+}
+
+void row_copy_rows(RowCopyMethod method, const RowCopy *copy, gint y0, gint y1)
+{
+    if (y1 <= y0)
+        return;
+
+    const guint8 *src = copy->src + (gsize)y0 * copy->src_stride;
+    guint8 *dst = copy->dst + (gsize)y0 * copy->dst_stride;
+
+    if (copy->src_stride == copy->dst_stride)
+    {
+        /* Same layout: one block, stopping at the end of the last row so
+         * trailing padding past it is never touched */
+        copy_block(method, dst, src,
+                   (gsize)(y1 - y0 - 1) * copy->src_stride + copy->row_bytes);
+    }
+    else
+    {
+        for (gint y = y0; y < y1; y++)
+        {
+            copy_block(method, dst, src, copy->row_bytes);
+            src += copy->src_stride;
+            dst += copy->dst_stride;
+        }
+    }
+
+#if defined(__SSE2__)
+    /* Streaming stores are weakly ordered: drain them before the band is
+     * reported done */
+    if (method == ROW_COPY_STREAM)
+        _mm_sfence();
+#endif
+}
+
+typedef struct
+{
+    RowCopyMethod method;
+    const RowCopy *copy;
+    gint band_rows;
+} BandJob;
+
+static void
+copy_band(guint job, gpointer user_data)
+{
+    const BandJob *b = user_data;
+    gint y0 = (gint)job * b->band_rows;
+    gint y1 = MIN(y0 + b->band_rows, b->copy->rows);
+
+    row_copy_rows(b->method, b->copy, y0, y1);
+}
+
+void row_copy_frame(WorkerPool *pool, RowCopyMethod method, const RowCopy *copy)
+{
+    if (copy->rows <= 0)
+        return;
+
+    guint n_threads = pool ? worker_pool_get_n_threads(pool) : 1;
+    gint min_rows = (gint)MAX(ROW_COPY_MIN_BAND_BYTES / MAX(copy->row_bytes, 1), 1);
+    gint band_rows = MAX((copy->rows + (gint)n_threads - 1) / (gint)n_threads, min_rows);
+
+    BandJob b = {method, copy, band_rows};
+    guint n_bands = (guint)((copy->rows + band_rows - 1) / band_rows);
+
+    if (pool)
+        worker_pool_run(pool, n_bands, copy_band, &b);
+    else
+        row_copy_rows(method, copy, 0, copy->rows);
+}
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Row Copy
+ * Strided single-plane copy (system-memory BGRx into a DMA-BUF) split into
+ * row bands across a worker pool, with non-temporal stores so the
+ * write-combined destination doesn't evict the source from the caches.
+ */
+
+#ifndef __ROW_COPY_H__
+#define __ROW_COPY_H__
+
+#include "worker_pool.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    ROW_COPY_MEMCPY, /* Plain memcpy per row */
+    ROW_COPY_STREAM, /* Non-temporal stores where the CPU has them */
+} RowCopyMethod;
+
+typedef struct
+{
+    const guint8 *src;
+    gint src_stride;
+    guint8 *dst;
+    gint dst_stride;
+    gsize row_bytes;
+    gint rows;
+} RowCopy;
+
+/**
+ * Whether ROW_COPY_STREAM uses non-temporal stores on this build (it falls
+ * back to memcpy otherwise).
+ */
+gboolean row_copy_has_stream(void);
+
+/**
+ * Copy rows [@y0, @y1) on the calling thread. Rows are copied as one block
+ * when both strides are equal, so the padding between them is copied too;
+ * nothing past the last row's @row_bytes is written.
+ */
+void row_copy_rows(RowCopyMethod method, const RowCopy *copy, gint y0, gint y1);
+
+/**
+ * Copy all rows, split into bands across @pool.
+ *
+ * @param pool Worker pool (NULL to copy on the calling thread)
+ * @param method Store method
+ * @param copy Rows to copy
+ */
+void row_copy_frame(WorkerPool *pool, RowCopyMethod method, const RowCopy *copy);
+
+G_END_DECLS
+
+#endif /* __ROW_COPY_H__ */
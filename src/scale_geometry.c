@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Scale Geometry
+ */
+
+#include "scale_geometry.h"
+
+/* Round to the nearest even size (4:2:0 chroma alignment), at least 1 and
+ * at most @max */
+static int32_t
+even_size(int64_t v, int32_t max)
+{
+    int32_t s = (int32_t)((v + 1) & ~(int64_t)1);
+    if (s > max)
+        s = max;
+    return s < 1 ? 1 : s;
+}
+
+void scale_geometry_compute(int src_w, int src_h,
+                            int src_par_n, int src_par_d,
+                            int out_w, int out_h,
+                            int letterbox, ScaleMethod method,
+                            ScaleGeometry *geo)
+{
+    memset(geo, 0, sizeof(*geo));
+    geo->src_w = src_w;
+    geo->src_h = src_h;
+    geo->out_w = out_w;
+    geo->out_h = out_h;
+    geo->method = method;
+
+    geo->dst_w = out_w;
+    geo->dst_h = out_h;
+
+    if (letterbox)
+    {
+        if (src_par_n <= 0 || src_par_d <= 0)
+            src_par_n = src_par_d = 1;
+
+        /* Display width/height of the input, compared by cross-multiplying */
+        int64_t disp_w = (int64_t)src_w * src_par_n;
+        int64_t disp_h = (int64_t)src_h * src_par_d;
+
+        if ((int64_t)out_w * disp_h <= (int64_t)out_h * disp_w)
+        {
+            /* Output is narrower: full width, bars top and bottom */
+            geo->dst_h = even_size(((int64_t)out_w * disp_h + disp_w / 2) / disp_w, out_h);
+        }
+        else
+        {
+            /* Output is wider: full height, bars left and right */
+            geo->dst_w = even_size(((int64_t)out_h * disp_w + disp_h / 2) / disp_h, out_w);
+        }
+
+        geo->dst_x = ((out_w - geo->dst_w) / 2) & ~1;
+        geo->dst_y = ((out_h - geo->dst_h) / 2) & ~1;
+    }
+
+    /* Opaque black */
+    geo->border_rgb = 0xff000000u;
+    geo->border_y = 16;
+    geo->border_u = 128;
+    geo->border_v = 128;
+}
+
+void scale_geometry_set_border_rgb(ScaleGeometry *geo, uint32_t argb, int rgb10)
+{
+    uint32_t r = (argb >> 16) & 0xff;
+    uint32_t g = (argb >> 8) & 0xff;
+    uint32_t b = argb & 0xff;
+
+    if (rgb10)
+    {
+        /* Replicate the top bits so 0xff maps to 1023 */
+        r = (r << 2) | (r >> 6);
+        g = (g << 2) | (g >> 6);
+        b = (b << 2) | (b >> 6);
+        geo->border_rgb = b | (g << 10) | (r << 20) | 0xc0000000u;
+    }
+    else
+    {
+        geo->border_rgb = b | (g << 8) | (r << 16) | 0xff000000u;
+    }
+}
+
+int scale_geometry_is_scaling(const ScaleGeometry *geo)
+{
+    return geo->src_w != geo->out_w || geo->src_h != geo->out_h ||
+           geo->dst_x != 0 || geo->dst_y != 0 ||
+           geo->dst_w != geo->out_w || geo->dst_h != geo->out_h;
+}
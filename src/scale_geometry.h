@@ -0,0 +1,335 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Scale Geometry
+ * Output rectangle, source sampling and border fill for scaling inside the
+ * copy/conversion pass. Plain C shared with nvcc: the samplers below run
+ * in the CUDA kernels and in the CPU references used by the tests.
+ */
+
+#ifndef SCALE_GEOMETRY_H
+#define SCALE_GEOMETRY_H
+
+#include "cuda_nv12_to_bgrx.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        SCALE_METHOD_NEAREST = 0,
+        SCALE_METHOD_BILINEAR = 1,
+    } ScaleMethod;
+
+    typedef struct
+    {
+        /* Input picture size */
+        int32_t src_w;
+        int32_t src_h;
+
+        /* Output frame size */
+        int32_t out_w;
+        int32_t out_h;
+
+        /* Picture rectangle inside the output (even-aligned); the rest is
+         * border. Covers the whole output unless letterboxing. */
+        int32_t dst_x;
+        int32_t dst_y;
+        int32_t dst_w;
+        int32_t dst_h;
+
+        int32_t method; /* ScaleMethod */
+
+        /* Border fill as a packed RGB output word (BGRx or 2:10:10:10) and
+         * as Y/U/V sample values (10-bit for P010) for semi-planar output */
+        uint32_t border_rgb;
+        int32_t border_y;
+        int32_t border_u;
+        int32_t border_v;
+    } ScaleGeometry;
+
+    /**
+     * Compute the picture rectangle for scaling @src_w x @src_h to
+     * @out_w x @out_h. With @letterbox the display aspect ratio (using the
+     * input pixel aspect ratio, square output pixels) is kept and the
+     * picture is centred; otherwise it is stretched over the whole output.
+     * The border is initialised to opaque black for 8-bit limited range.
+     *
+     * @param src_w, src_h       Input size in pixels
+     * @param src_par_n, src_par_d Input pixel aspect ratio (0/x treated as 1/1)
+     * @param out_w, out_h       Output size in pixels
+     * @param letterbox          Non-zero to preserve the aspect ratio
+     * @param method             Sampling filter
+     * @param geo                Resulting geometry
+     */
+    void scale_geometry_compute(int src_w, int src_h,
+                                int src_par_n, int src_par_d,
+                                int out_w, int out_h,
+                                int letterbox, ScaleMethod method,
+                                ScaleGeometry *geo);
+
+    /**
+     * Set the packed RGB border word from an 0xAARRGGBB colour.
+     *
+     * @param geo    Geometry to update
+     * @param argb   Border colour (alpha is ignored, borders are opaque)
+     * @param rgb10  Non-zero for 2:10:10:10 output, zero for BGRx
+     */
+    void scale_geometry_set_border_rgb(ScaleGeometry *geo, uint32_t argb, int rgb10);
+
+    /**
+     * Whether @geo actually resamples or letterboxes, i.e. differs from a
+     * plain copy.
+     */
+    int scale_geometry_is_scaling(const ScaleGeometry *geo);
+
+    /* Source position, in Q8 sample units, of the centre of output sample
+     * @o along one axis. @sub is 2 when sampling a 4:2:0 chroma plane from
+     * luma output coordinates and 1 otherwise; the result is clamped to the
+     * @plane_len samples of the plane. Chroma is treated as centre-sited. */
+    YUV_TO_RGB_INLINE int32_t scale_src_pos_q8(int32_t o, int32_t dst_len, int32_t src_len,
+                                               int32_t sub, int32_t plane_len)
+    {
+        int64_t pos = ((int64_t)(2 * o + 1) * src_len * 128) / ((int64_t)dst_len * sub) - 128;
+        int64_t max = (int64_t)(plane_len - 1) << 8;
+        return (int32_t)(pos < 0 ? 0 : (pos > max ? max : pos));
+    }
+
+    /* One sample of an 8-bit (@bps = 1) or P010 (@bps = 2) plane with
+     * @n_comp interleaved components per pixel */
+    YUV_TO_RGB_INLINE int32_t scale_read(const uint8_t *plane, int stride, int bps,
+                                         int n_comp, int comp, int x, int y)
+    {
+        const uint8_t *p = plane + y * stride + (x * n_comp + comp) * bps;
+        return bps == 2 ? p010_sample(p) : (int32_t)p[0];
+    }
+
+    YUV_TO_RGB_INLINE void scale_write(uint8_t *p, int bps, int32_t value)
+    {
+        if (bps == 2)
+        {
+            uint32_t w = (uint32_t)value << 6;
+            p[0] = (uint8_t)w;
+            p[1] = (uint8_t)(w >> 8);
+        }
+        else
+        {
+            p[0] = (uint8_t)value;
+        }
+    }
+
+    /**
+     * Sample component @comp of a plane at a Q8 position with nearest
+     * (round half up) or bilinear filtering. An exact 2:1 bilinear
+     * downscale lands half-way between samples and so averages pairs
+     * (box filter).
+     */
+    YUV_TO_RGB_INLINE int32_t scale_sample(const uint8_t *plane, int stride, int bps,
+                                           int n_comp, int comp,
+                                           int plane_w, int plane_h,
+                                           int32_t px_q8, int32_t py_q8, int method)
+    {
+        if (method == SCALE_METHOD_NEAREST)
+        {
+            int x = (px_q8 + 128) >> 8;
+            int y = (py_q8 + 128) >> 8;
+            x = x < plane_w ? x : plane_w - 1;
+            y = y < plane_h ? y : plane_h - 1;
+            return scale_read(plane, stride, bps, n_comp, comp, x, y);
+        }
+
+        int x0 = px_q8 >> 8, y0 = py_q8 >> 8;
+        int32_t fx = px_q8 & 255, fy = py_q8 & 255;
+        int x1 = x0 + 1 < plane_w ? x0 + 1 : x0;
+        int y1 = y0 + 1 < plane_h ? y0 + 1 : y0;
+
+        int32_t top = scale_read(plane, stride, bps, n_comp, comp, x0, y0) * (256 - fx) +
+                      scale_read(plane, stride, bps, n_comp, comp, x1, y0) * fx;
+        int32_t bottom = scale_read(plane, stride, bps, n_comp, comp, x0, y1) * (256 - fx) +
+                         scale_read(plane, stride, bps, n_comp, comp, x1, y1) * fx;
+        return (top * (256 - fy) + bottom * fy + (1 << 15)) >> 16;
+    }
+
+    /**
+     * Scaled YUV→RGB for output pixel (@ox, @oy): returns the packed BGRx
+     * or 2:10:10:10 word, or the border word outside the picture rectangle.
+     */
+    YUV_TO_RGB_INLINE uint32_t scale_yuv_to_rgb_pixel(const ScaleGeometry *g,
+                                                      const YuvToRgbCoeffs *c,
+                                                      const uint8_t *y_plane,
+                                                      const uint8_t *uv_plane,
+                                                      int y_stride, int uv_stride,
+                                                      int p010, int rgb10,
+                                                      int ox, int oy)
+    {
+        int lx = ox - g->dst_x;
+        int ly = oy - g->dst_y;
+        if (lx < 0 || ly < 0 || lx >= g->dst_w || ly >= g->dst_h)
+            return g->border_rgb;
+
+        int bps = p010 ? 2 : 1;
+        int cw = (g->src_w + 1) / 2;
+        int ch = (g->src_h + 1) / 2;
+
+        int32_t yx = scale_src_pos_q8(lx, g->dst_w, g->src_w, 1, g->src_w);
+        int32_t yy = scale_src_pos_q8(ly, g->dst_h, g->src_h, 1, g->src_h);
+        int32_t cx = scale_src_pos_q8(lx, g->dst_w, g->src_w, 2, cw);
+        int32_t cy = scale_src_pos_q8(ly, g->dst_h, g->src_h, 2, ch);
+
+        int32_t y = scale_sample(y_plane, y_stride, bps, 1, 0, g->src_w, g->src_h, yx, yy, g->method);
+        int32_t u = scale_sample(uv_plane, uv_stride, bps, 2, 0, cw, ch, cx, cy, g->method);
+        int32_t v = scale_sample(uv_plane, uv_stride, bps, 2, 1, cw, ch, cx, cy, g->method);
+
+        return rgb10 ? yuv_to_x2rgb10_packed(c, y, u, v) : yuv_to_bgrx_packed(c, y, u, v);
+    }
+
+    /**
+     * Scaled semi-planar (NV12/P010) output for the 2x2 luma block and
+     * the chroma sample at chroma position (@bx, @by). Luma and chroma are
+     * each resampled from their own plane.
+     */
+    YUV_TO_RGB_INLINE void scale_semi_planar_block(const ScaleGeometry *g,
+                                                   const uint8_t *y_plane,
+                                                   const uint8_t *uv_plane,
+                                                   int y_stride, int uv_stride,
+                                                   uint8_t *y_out, uint8_t *uv_out,
+                                                   int y_out_stride, int uv_out_stride,
+                                                   int p010, int bx, int by)
+    {
+        int bps = p010 ? 2 : 1;
+        int cw = (g->src_w + 1) / 2;
+        int ch = (g->src_h + 1) / 2;
+
+        for (int r = 0; r < 2; r++)
+        {
+            int oy = by * 2 + r;
+            if (oy >= g->out_h)
+                break;
+
+            for (int i = 0; i < 2; i++)
+            {
+                int ox = bx * 2 + i;
+                if (ox >= g->out_w)
+                    break;
+
+                int lx = ox - g->dst_x;
+                int ly = oy - g->dst_y;
+                int32_t value = g->border_y;
+                if (lx >= 0 && ly >= 0 && lx < g->dst_w && ly < g->dst_h)
+                    value = scale_sample(y_plane, y_stride, bps, 1, 0, g->src_w, g->src_h,
+                                         scale_src_pos_q8(lx, g->dst_w, g->src_w, 1, g->src_w),
+                                         scale_src_pos_q8(ly, g->dst_h, g->src_h, 1, g->src_h),
+                                         g->method);
+                scale_write(y_out + oy * y_out_stride + ox * bps, bps, value);
+            }
+        }
+
+        /* dst_x/dst_y are even, so chroma rows/columns align with the
+         * picture rectangle */
+        int lcx = bx - g->dst_x / 2;
+        int lcy = by - g->dst_y / 2;
+        int32_t u = g->border_u, v = g->border_v;
+        if (lcx >= 0 && lcy >= 0 && lcx < (g->dst_w + 1) / 2 && lcy < (g->dst_h + 1) / 2)
+        {
+            int32_t cx = scale_src_pos_q8(lcx, g->dst_w, g->src_w, 1, cw);
+            int32_t cy = scale_src_pos_q8(lcy, g->dst_h, g->src_h, 1, ch);
+            u = scale_sample(uv_plane, uv_stride, bps, 2, 0, cw, ch, cx, cy, g->method);
+            v = scale_sample(uv_plane, uv_stride, bps, 2, 1, cw, ch, cx, cy, g->method);
+        }
+
+        uint8_t *dst = uv_out + by * uv_out_stride + bx * 2 * bps;
+        scale_write(dst, bps, u);
+        scale_write(dst + bps, bps, v);
+    }
+
+    /**
+     * Scale and convert NV12/P010 to BGRx or XRGB2101010 on the GPU
+     * (implemented in cuda_nv12_to_bgrx.cu)
+     *
+     * @param y_plane     Pointer to input Y plane in device memory
+     * @param uv_plane    Pointer to input UV plane in device memory
+     * @param y_stride    Stride of input Y plane in bytes
+     * @param uv_stride   Stride of input UV plane in bytes
+     * @param p010        Non-zero for P010 input, zero for NV12
+     * @param rgb_out     Pointer to output buffer (geo->out_w x geo->out_h)
+     * @param out_stride  Stride of output buffer in bytes
+     * @param geo         Scale geometry (sizes, filter, border)
+     * @param coeffs      Conversion matrix/range for the input/output depths
+     * @param rgb10       Non-zero for XRGB2101010 output, zero for BGRx
+     * @param stream      CUDA stream to use (NULL/0 for default)
+     *
+     * @return 0 (cudaSuccess) on success, CUDA error code otherwise
+     */
+    int cuda_scale_yuv_to_rgb(const void *y_plane, const void *uv_plane,
+                              int y_stride, int uv_stride, int p010,
+                              void *rgb_out, int out_stride,
+                              const ScaleGeometry *geo,
+                              const YuvToRgbCoeffs *coeffs,
+                              int rgb10, void *stream);
+
+    /**
+     * Scale NV12/P010 into NV12/P010 on the GPU (implemented in
+     * cuda_nv12_to_bgrx.cu)
+     *
+     * @param y_plane        Pointer to input Y plane in device memory
+     * @param uv_plane       Pointer to input UV plane in device memory
+     * @param y_stride       Stride of input Y plane in bytes
+     * @param uv_stride      Stride of input UV plane in bytes
+     * @param y_out          Pointer to output Y plane (pitch-linear)
+     * @param uv_out         Pointer to output UV plane (pitch-linear)
+     * @param y_out_stride   Stride of output Y plane in bytes
+     * @param uv_out_stride  Stride of output UV plane in bytes
+     * @param geo            Scale geometry (sizes, filter, border)
+     * @param p010           Non-zero for P010, zero for NV12
+     * @param stream         CUDA stream to use (NULL/0 for default)
+     *
+     * @return 0 (cudaSuccess) on success, CUDA error code otherwise
+     */
+    int cuda_scale_semi_planar(const void *y_plane, const void *uv_plane,
+                               int y_stride, int uv_stride,
+                               void *y_out, void *uv_out,
+                               int y_out_stride, int uv_out_stride,
+                               const ScaleGeometry *geo,
+                               int p010, void *stream);
+
+    /**
+     * CPU reference of cuda_scale_yuv_to_rgb().
+     */
+    YUV_TO_RGB_INLINE void scale_yuv_to_rgb_reference(const uint8_t *y_plane, const uint8_t *uv_plane,
+                                                      int y_stride, int uv_stride, int p010,
+                                                      uint8_t *rgb_out, int out_stride,
+                                                      const ScaleGeometry *geo,
+                                                      const YuvToRgbCoeffs *coeffs, int rgb10)
+    {
+        for (int oy = 0; oy < geo->out_h; oy++)
+            for (int ox = 0; ox < geo->out_w; ox++)
+            {
+                uint32_t px = scale_yuv_to_rgb_pixel(geo, coeffs, y_plane, uv_plane,
+                                                     y_stride, uv_stride, p010, rgb10, ox, oy);
+                memcpy(rgb_out + oy * out_stride + ox * 4, &px, 4);
+            }
+    }
+
+    /**
+     * CPU reference of cuda_scale_semi_planar().
+     */
+    YUV_TO_RGB_INLINE void scale_semi_planar_reference(const uint8_t *y_plane, const uint8_t *uv_plane,
+                                                       int y_stride, int uv_stride,
+                                                       uint8_t *y_out, uint8_t *uv_out,
+                                                       int y_out_stride, int uv_out_stride,
+                                                       const ScaleGeometry *geo, int p010)
+    {
+        for (int by = 0; by < (geo->out_h + 1) / 2; by++)
+            for (int bx = 0; bx < (geo->out_w + 1) / 2; bx++)
+                scale_semi_planar_block(geo, y_plane, uv_plane, y_stride, uv_stride,
+                                        y_out, uv_out, y_out_stride, uv_out_stride,
+                                        p010, bx, by);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCALE_GEOMETRY_H */
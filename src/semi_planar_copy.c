@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Semi-Planar Copy
+ */
+
+#include "semi_planar_copy.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* Bands smaller than this cost more to hand off than to copy */
+#define SEMI_PLANAR_MIN_BAND_ROWS 32
+
+/* U0 V0 U1 V1 ... from separate U and V rows of @n samples */
+static void
+interleave_row(guint8 *dst, const guint8 *u, const guint8 *v, gint n)
+{
+    gint i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i uu = _mm_loadu_si128((const __m128i *)(u + i));
+        __m128i vv = _mm_loadu_si128((const __m128i *)(v + i));
+        _mm_storeu_si128((__m128i *)(dst + i * 2), _mm_unpacklo_epi8(uu, vv));
+        _mm_storeu_si128((__m128i *)(dst + i * 2 + 16), _mm_unpackhi_epi8(uu, vv));
+    }
+#elif defined(__aarch64__)
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16x2_t uv = {{vld1q_u8(u + i), vld1q_u8(v + i)}};
+        vst2q_u8(dst + i * 2, uv);
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        dst[i * 2] = u[i];
+        dst[i * 2 + 1] = v[i];
+    }
+}
+
+void semi_planar_copy_rows(const SemiPlanarCopy *copy, gint y0, gint y1)
+{
+    gint bps = copy->src_format == SEMI_PLANAR_SRC_P010 ? 2 : 1;
+    gint chroma_w = (copy->width + 1) / 2;
+    gsize luma_bytes = (gsize)copy->width * bps;
+    gsize chroma_bytes = (gsize)chroma_w * 2 * bps;
+
+    for (gint y = y0; y < y1; y++)
+        memcpy(copy->dst[0] + (gsize)y * copy->dst_stride[0],
+               copy->src[0] + (gsize)y * copy->src_stride[0], luma_bytes);
+
+    for (gint cy = y0 / 2; cy < (y1 + 1) / 2; cy++)
+    {
+        guint8 *dst = copy->dst[1] + (gsize)cy * copy->dst_stride[1];
+
+        if (copy->src_format == SEMI_PLANAR_SRC_I420)
+            interleave_row(dst,
+                           copy->src[1] + (gsize)cy * copy->src_stride[1],
+                           copy->src[2] + (gsize)cy * copy->src_stride[2],
+                           chroma_w);
+        else
+            memcpy(dst, copy->src[1] + (gsize)cy * copy->src_stride[1], chroma_bytes);
+    }
+}
+
+typedef struct
+{
+    const SemiPlanarCopy *copy;
+    gint band_rows;
+} BandJob;
+
+static void
+copy_band(guint job, gpointer user_data)
+{
+    const BandJob *b = user_data;
+    gint y0 = (gint)job * b->band_rows;
+    gint y1 = MIN(y0 + b->band_rows, b->copy->height);
+
+    semi_planar_copy_rows(b->copy, y0, y1);
+}
+
+void semi_planar_copy_frame(WorkerPool *pool, const SemiPlanarCopy *copy)
+{
+    guint n_threads = pool ? worker_pool_get_n_threads(pool) : 1;
+
+    /* Even band heights so each chroma row belongs to exactly one band */
+    gint band_rows = MAX((copy->height + (gint)n_threads - 1) / (gint)n_threads,
+                         SEMI_PLANAR_MIN_BAND_ROWS);
+    band_rows = (band_rows + 1) & ~1;
+
+    BandJob b = {copy, band_rows};
+    guint n_bands = (guint)((copy->height + band_rows - 1) / band_rows);
+
+    if (pool)
+        worker_pool_run(pool, n_bands, copy_band, &b);
+    else
+        semi_planar_copy_rows(copy, 0, copy->height);
+}
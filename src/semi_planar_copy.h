@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Semi-Planar Copy
+ * System-memory NV12/I420/P010 into NV12/P010 DMA-BUF planes: stride-aware
+ * row copies, with U/V interleaved for I420, split into row bands across a
+ * worker pool.
+ */
+
+#ifndef __SEMI_PLANAR_COPY_H__
+#define __SEMI_PLANAR_COPY_H__
+
+#include "worker_pool.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    SEMI_PLANAR_SRC_NV12, /* Y + interleaved UV, copied as is */
+    SEMI_PLANAR_SRC_I420, /* Y + U + V, chroma interleaved into UV */
+    SEMI_PLANAR_SRC_P010, /* Y + interleaved UV, 16-bit samples */
+} SemiPlanarSrc;
+
+typedef struct
+{
+    SemiPlanarSrc src_format;
+
+    /* Source planes: Y, UV (or U, V for I420) */
+    const guint8 *src[3];
+    gint src_stride[3];
+
+    /* Destination Y and UV planes */
+    guint8 *dst[2];
+    gint dst_stride[2];
+
+    gint width;
+    gint height;
+} SemiPlanarCopy;
+
+/**
+ * Copy luma rows [@y0, @y1) and the chroma rows they use, on the calling
+ * thread. @y0 must be even.
+ */
+void semi_planar_copy_rows(const SemiPlanarCopy *copy, gint y0, gint y1);
+
+/**
+ * Copy a whole frame, split into row bands across @pool.
+ *
+ * @param pool Worker pool (NULL to copy on the calling thread)
+ * @param copy Planes to copy
+ */
+void semi_planar_copy_frame(WorkerPool *pool, const SemiPlanarCopy *copy);
+
+G_END_DECLS
+
+#endif /* __SEMI_PLANAR_COPY_H__ */
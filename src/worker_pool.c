@@ -0,0 +1,270 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Worker Pool
+ */
+
+#define _GNU_SOURCE
+
+#include "worker_pool.h"
+
+#include <stdlib.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+struct _WorkerPool
+{
+    GMutex lock;
+    GCond work_cond; /* New batch or quit */
+    GCond done_cond; /* Last job of the batch finished */
+
+    GThread **threads;
+    guint n_workers;
+    gboolean quit;
+
+#ifdef __linux__
+    /* CPUs the workers restrict themselves to (pin_workers only) */
+    gboolean pin_workers;
+    cpu_set_t cpus;
+#endif
+
+    /* Current batch, protected by lock. Jobs are claimed under the lock
+     * so a worker waking late can never run a job of a newer batch with
+     * the old function. */
+    guint64 batch;
+    WorkerPoolFunc func;
+    gpointer user_data;
+    guint n_jobs;
+    guint next_job;
+    guint done_jobs;
+};
+
+/* Claim and run jobs of @batch until none are left */
+static void
+worker_pool_drain(WorkerPool *pool, guint64 batch)
+{
+    g_mutex_lock(&pool->lock);
+    while (pool->batch == batch && pool->next_job < pool->n_jobs)
+    {
+        guint job = pool->next_job++;
+        WorkerPoolFunc func = pool->func;
+        gpointer user_data = pool->user_data;
+        g_mutex_unlock(&pool->lock);
+
+        func(job, user_data);
+
+        g_mutex_lock(&pool->lock);
+        if (++pool->done_jobs == pool->n_jobs)
+            g_cond_signal(&pool->done_cond);
+    }
+    g_mutex_unlock(&pool->lock);
+}
+
+static gpointer
+worker_pool_thread(gpointer data)
+{
+    WorkerPool *pool = data;
+    guint64 seen = 0;
+
+#ifdef __linux__
+    if (pool->pin_workers && sched_setaffinity(0, sizeof(pool->cpus), &pool->cpus) != 0)
+        g_debug("Failed to set worker affinity");
+#endif
+
+    for (;;)
+    {
+        g_mutex_lock(&pool->lock);
+        while (!pool->quit && pool->batch == seen)
+            g_cond_wait(&pool->work_cond, &pool->lock);
+        if (pool->quit)
+        {
+            g_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->batch;
+        g_mutex_unlock(&pool->lock);
+
+        worker_pool_drain(pool, seen);
+    }
+}
+
+static void
+worker_pool_start(WorkerPool *pool, guint n_threads)
+{
+    g_mutex_init(&pool->lock);
+    g_cond_init(&pool->work_cond);
+    g_cond_init(&pool->done_cond);
+
+    pool->threads = g_new0(GThread *, MAX(n_threads, 1));
+    for (guint i = 1; i < n_threads; i++)
+    {
+        GError *error = NULL;
+        GThread *thread = g_thread_try_new("worker-pool", worker_pool_thread, pool, &error);
+        if (!thread)
+        {
+            g_warning("Failed to start worker thread: %s", error->message);
+            g_error_free(error);
+            break;
+        }
+        pool->threads[pool->n_workers++] = thread;
+    }
+}
+
+WorkerPool *
+worker_pool_new(guint n_threads)
+{
+    WorkerPool *pool = g_new0(WorkerPool, 1);
+
+    if (n_threads == 0)
+        n_threads = g_get_num_processors();
+
+    worker_pool_start(pool, n_threads);
+    return pool;
+}
+
+#ifdef __linux__
+/* CPUs of NUMA node @node from its sysfs cpulist ("0-7,16-23") */
+static gboolean
+worker_pool_node_cpus(int node, cpu_set_t *cpus)
+{
+    gchar path[64];
+    gchar *list = NULL;
+
+    g_snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if (!g_file_get_contents(path, &list, NULL, NULL))
+        return FALSE;
+
+    CPU_ZERO(cpus);
+    for (gchar *p = list; *p && *p != '\n';)
+    {
+        gchar *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p)
+            break;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, cpus);
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    g_free(list);
+    return CPU_COUNT(cpus) > 0;
+}
+
+/* Node of @cpu: the nodeN entry in its sysfs directory */
+static int
+worker_pool_cpu_node(int cpu)
+{
+    gchar path[64];
+
+    g_snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    GDir *dir = g_dir_open(path, 0, NULL);
+    if (!dir)
+        return -1;
+
+    int node = -1;
+    const gchar *name;
+    while ((name = g_dir_read_name(dir)) != NULL)
+    {
+        if (g_str_has_prefix(name, "node") && g_ascii_isdigit(name[4]))
+        {
+            node = atoi(name + 4);
+            break;
+        }
+    }
+
+    g_dir_close(dir);
+    return node;
+}
+#endif
+
+WorkerPool *
+worker_pool_new_numa_local(guint n_threads)
+{
+#ifdef __linux__
+    cpu_set_t allowed, local;
+    int cpu = sched_getcpu();
+    int node = cpu >= 0 ? worker_pool_cpu_node(cpu) : -1;
+
+    if (node >= 0 && sched_getaffinity(0, sizeof(allowed), &allowed) == 0 &&
+        worker_pool_node_cpus(node, &local))
+    {
+        CPU_AND(&local, &local, &allowed);
+        if (CPU_COUNT(&local) > 0)
+        {
+            WorkerPool *pool = g_new0(WorkerPool, 1);
+            pool->pin_workers = TRUE;
+            pool->cpus = local;
+
+            if (n_threads == 0)
+                n_threads = CPU_COUNT(&local);
+
+            worker_pool_start(pool, n_threads);
+            return pool;
+        }
+    }
+#endif
+
+    return worker_pool_new(n_threads);
+}
+
+guint worker_pool_get_n_threads(const WorkerPool *pool)
+{
+    return pool->n_workers + 1;
+}
+
+void worker_pool_run(WorkerPool *pool, guint n_jobs,
+                     WorkerPoolFunc func, gpointer user_data)
+{
+    if (n_jobs == 0)
+        return;
+
+    /* Nothing to hand off */
+    if (n_jobs == 1 || pool->n_workers == 0)
+    {
+        for (guint i = 0; i < n_jobs; i++)
+            func(i, user_data);
+        return;
+    }
+
+    g_mutex_lock(&pool->lock);
+    guint64 batch = ++pool->batch;
+    pool->func = func;
+    pool->user_data = user_data;
+    pool->n_jobs = n_jobs;
+    pool->next_job = 0;
+    pool->done_jobs = 0;
+    g_cond_broadcast(&pool->work_cond);
+    g_mutex_unlock(&pool->lock);
+
+    worker_pool_drain(pool, batch);
+
+    g_mutex_lock(&pool->lock);
+    while (pool->done_jobs < pool->n_jobs)
+        g_cond_wait(&pool->done_cond, &pool->lock);
+    g_mutex_unlock(&pool->lock);
+}
+
+void worker_pool_free(WorkerPool *pool)
+{
+    if (!pool)
+        return;
+
+    g_mutex_lock(&pool->lock);
+    pool->quit = TRUE;
+    g_cond_broadcast(&pool->work_cond);
+    g_mutex_unlock(&pool->lock);
+
+    for (guint i = 0; i < pool->n_workers; i++)
+        g_thread_join(pool->threads[i]);
+
+    g_free(pool->threads);
+    g_cond_clear(&pool->done_cond);
+    g_cond_clear(&pool->work_cond);
+    g_mutex_clear(&pool->lock);
+    g_free(pool);
+}
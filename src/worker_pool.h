@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Worker Pool
+ * Persistent threads that run a batch of independent jobs (e.g. row bands
+ * of a frame) and return once all of them are done. The calling thread
+ * takes jobs too, so a pool of N threads starts N - 1 workers.
+ */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _WorkerPool WorkerPool;
+
+/**
+ * Run job @job of a batch.
+ */
+typedef void (*WorkerPoolFunc)(guint job, gpointer user_data);
+
+/**
+ * Create a pool.
+ *
+ * @param n_threads Threads taking jobs, the caller included (0 for one per
+ *                  online processor)
+ * @return New pool (free with worker_pool_free())
+ */
+WorkerPool *worker_pool_new(guint n_threads);
+
+/**
+ * Create a pool whose workers stay on the NUMA node of the calling thread.
+ * Each worker is restricted to that node's CPUs (within the process
+ * affinity mask), so bands of a frame touched by the streaming thread are
+ * read from local memory. Falls back to worker_pool_new() where the node
+ * can't be determined.
+ *
+ * @param n_threads Threads taking jobs, the caller included (0 for one per
+ *                  CPU of the local node)
+ * @return New pool (free with worker_pool_free())
+ */
+WorkerPool *worker_pool_new_numa_local(guint n_threads);
+
+/**
+ * Number of threads taking jobs, the caller included.
+ */
+guint worker_pool_get_n_threads(const WorkerPool *pool);
+
+/**
+ * Run @n_jobs calls of @func and wait for all of them. Jobs may run in
+ * any order and concurrently. Not reentrant: one batch at a time.
+ *
+ * @param pool Pool
+ * @param n_jobs Number of jobs
+ * @param func Job function
+ * @param user_data Passed to every job
+ */
+void worker_pool_run(WorkerPool *pool, guint n_jobs,
+                     WorkerPoolFunc func, gpointer user_data);
+
+/**
+ * Stop the workers and free the pool.
+ */
+void worker_pool_free(WorkerPool *pool);
+
+G_END_DECLS
+
+#endif /* __WORKER_POOL_H__ */
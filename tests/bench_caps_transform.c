@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Caps negotiation microbenchmark: time per transform_caps call in each
+ * direction, rebuilding the caps every time versus answering from the
+ * caps cache, both followed by the filter intersection the element does.
+ * Needs no GPU; run with `meson test --benchmark`.
+ */
+
+#include "caps_cache.h"
+#include "caps_transform.h"
+#include "drm_format_table.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_MIN_USEC 300000
+
+/* What a Wayland sink typically answers: a few modifiers plus LINEAR */
+#define DOWNSTREAM_CAPS                                                          \
+    "video/x-raw(memory:DMABuf), format=DMA_DRM, width=1920, height=1080, "     \
+    "framerate=30/1, drm-format={ NV12:0x0300000000606014, "                    \
+    "NV12:0x0300000000606015, NV12:0x0, XR24:0x0, XR24:0x0300000000606015 }; " \
+    "video/x-raw, format=BGRx, width=1920, height=1080, framerate=30/1"
+
+#define UPSTREAM_CAPS                                                           \
+    "video/x-raw(memory:CUDAMemory), format={ NV12, P010_10LE }, "             \
+    "width=1920, height=1080, framerate=30/1"
+
+static GstCaps *
+build(GstPadDirection direction, GstCaps *caps)
+{
+    return direction == GST_PAD_SINK
+               ? caps_transform_sink_to_src(caps, FALSE, drm_format_table_get_default(), NULL)
+               : caps_transform_src_to_sink(caps);
+}
+
+/* The element's transform_caps, with or without @cache, on an unprobed
+ * device without a ranking */
+static GstCaps *
+transform(CapsCache *cache, GstPadDirection direction, GstCaps *caps, GstCaps *filter)
+{
+    CapsCacheKey key = {direction, FALSE, drm_format_table_get_default(), 0};
+    GstCaps *out = cache ? caps_cache_lookup(cache, &key, caps) : NULL;
+
+    if (!out)
+    {
+        out = build(direction, caps);
+        if (cache)
+            caps_cache_insert(cache, &key, caps, out);
+    }
+
+    GstCaps *tmp = gst_caps_intersect_full(out, filter, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref(out);
+    return tmp;
+}
+
+/* Microseconds per call until at least BENCH_MIN_USEC have passed */
+static double
+bench_run(CapsCache *cache, GstPadDirection direction, GstCaps *caps, GstCaps *filter)
+{
+    guint calls = 0;
+
+    /* Warm-up: fills the cache */
+    gst_caps_unref(transform(cache, direction, caps, filter));
+
+    gint64 start = g_get_monotonic_time();
+    gint64 elapsed;
+    do
+    {
+        /* A fresh copy each time, as peers send new caps objects */
+        GstCaps *in = gst_caps_copy(caps);
+        gst_caps_unref(transform(cache, direction, in, filter));
+        gst_caps_unref(in);
+        calls++;
+        elapsed = g_get_monotonic_time() - start;
+    } while (elapsed < BENCH_MIN_USEC);
+
+    return (double)elapsed / calls;
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    GstCaps *upstream = gst_caps_from_string(UPSTREAM_CAPS);
+    GstCaps *downstream = gst_caps_from_string(DOWNSTREAM_CAPS);
+    GstCaps *any = gst_caps_new_any();
+
+    static const struct
+    {
+        const gchar *name;
+        GstPadDirection direction;
+    } cases[] = {{"sink->src", GST_PAD_SINK}, {"src->sink", GST_PAD_SRC}};
+
+    printf("transform_caps benchmark, %u DRM format candidates\n\n",
+           drm_format_table_get_n_entries(drm_format_table_get_default()));
+    printf("%-10s %-10s %12s %12s %9s\n", "Direction", "Filter", "rebuild", "cached", "speedup");
+
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++)
+    {
+        GstCaps *caps = cases[i].direction == GST_PAD_SINK ? upstream : downstream;
+        GstCaps *filters[] = {any, cases[i].direction == GST_PAD_SINK ? downstream : upstream};
+        const gchar *filter_names[] = {"none", "peer"};
+
+        for (guint f = 0; f < G_N_ELEMENTS(filters); f++)
+        {
+            CapsCache *cache = caps_cache_new(16);
+            double rebuild = bench_run(NULL, cases[i].direction, caps, filters[f]);
+            double cached = bench_run(cache, cases[i].direction, caps, filters[f]);
+
+            printf("%-10s %-10s %9.2f us %9.2f us %8.1fx\n", cases[i].name, filter_names[f],
+                   rebuild, cached, rebuild / cached);
+            caps_cache_free(cache);
+        }
+    }
+
+    gst_caps_unref(upstream);
+    gst_caps_unref(downstream);
+    gst_caps_unref(any);
+
+    gst_deinit();
+    return 0;
+}
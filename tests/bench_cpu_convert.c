@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * CPU converter microbenchmark: pixels/second per ISA for NV12→BGRx and
+ * P010→XR30 at 1080p, single-threaded and across a worker pool. Needs no
+ * GPU; run with `meson test --benchmark`.
+ */
+
+#include "colorimetry.h"
+#include "cpu_convert.h"
+#include "worker_pool.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_MIN_USEC 300000
+
+/* Mpixels/s of converting @f until at least BENCH_MIN_USEC have passed */
+static double
+bench_run(WorkerPool *pool, CpuConvertIsa isa, const CpuConvertFrame *f,
+          const YuvToRgbCoeffs *c)
+{
+    guint frames = 0;
+
+    /* Warm-up: page in the planes and start the workers */
+    cpu_convert_frame(pool, isa, f, c);
+
+    gint64 start = g_get_monotonic_time();
+    gint64 elapsed;
+    do
+    {
+        cpu_convert_frame(pool, isa, f, c);
+        frames++;
+        elapsed = g_get_monotonic_time() - start;
+    } while (elapsed < BENCH_MIN_USEC);
+
+    return (double)frames * f->width * f->height / (double)elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    int bps_max = 2;
+    int y_stride = BENCH_WIDTH * bps_max;
+    int uv_stride = BENCH_WIDTH * bps_max;
+    int out_stride = BENCH_WIDTH * 4;
+    guint8 *y_plane = g_malloc((gsize)y_stride * BENCH_HEIGHT);
+    guint8 *uv_plane = g_malloc((gsize)uv_stride * BENCH_HEIGHT / 2);
+    guint8 *out = g_malloc((gsize)out_stride * BENCH_HEIGHT);
+
+    for (gsize i = 0; i < (gsize)y_stride * BENCH_HEIGHT; i++)
+        y_plane[i] = (guint8)(i * 7 + 3);
+    for (gsize i = 0; i < (gsize)uv_stride * BENCH_HEIGHT / 2; i++)
+        uv_plane[i] = (guint8)(i * 13 + 101);
+
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, "bt709");
+    YuvToRgbCoeffs c8, c10;
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(&cinfo, 8, 8, &c8);
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(&cinfo, 10, 10, &c10);
+
+    WorkerPool *pool = worker_pool_new(0);
+
+    printf("CPU converter benchmark, %dx%d, %u threads\n\n",
+           BENCH_WIDTH, BENCH_HEIGHT, worker_pool_get_n_threads(pool));
+    printf("%-8s %-12s %14s %14s\n", "ISA", "Path", "1 thread", "pool");
+
+    for (int isa = 0; isa < CPU_CONVERT_ISA_COUNT; isa++)
+    {
+        if (!cpu_convert_isa_supported(isa))
+            continue;
+
+        CpuConvertFrame nv12 = {y_plane, uv_plane, BENCH_WIDTH, BENCH_WIDTH, out, out_stride,
+                                BENCH_WIDTH, BENCH_HEIGHT, FALSE, FALSE, NULL};
+        CpuConvertFrame p010 = {y_plane, uv_plane, y_stride, uv_stride, out, out_stride,
+                                BENCH_WIDTH, BENCH_HEIGHT, TRUE, TRUE, NULL};
+
+        printf("%-8s %-12s %9.1f Mpx/s %9.1f Mpx/s\n", cpu_convert_isa_name(isa), "NV12→BGRx",
+               bench_run(NULL, isa, &nv12, &c8), bench_run(pool, isa, &nv12, &c8));
+        printf("%-8s %-12s %9.1f Mpx/s %9.1f Mpx/s\n", cpu_convert_isa_name(isa), "P010→XR30",
+               bench_run(NULL, isa, &p010, &c10), bench_run(pool, isa, &p010, &c10));
+    }
+
+    worker_pool_free(pool);
+    g_free(y_plane);
+    g_free(uv_plane);
+    g_free(out);
+
+    gst_deinit();
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the NVIDIA block-linear layout: the vectorised detile and
+ * tile match the scalar per-byte reference, and CPU maps through the
+ * video meta see linear planes. Needs no GPU.
+ */
+
+#include "block_linear.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <drm/drm_fourcc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define PAD_BYTE 0xAA
+
+/**
+ * Modifier fields decode, and only uncompressed desktop-sector layouts are
+ * convertible
+ */
+static void
+test_modifier_decode(void)
+{
+    BlockLinearLayout l;
+
+    TEST_ASSERT(block_linear_layout_from_modifier(0x0300000000606010ULL, &l),
+                "0x0300000000606010 should be convertible");
+    TEST_ASSERT(l.log2_block_height == 0 && l.kind == 0x06 && l.gob_generation == 2 &&
+                    l.desktop_sectors && l.compression == 0,
+                "0x0300000000606010 fields");
+
+    TEST_ASSERT(block_linear_layout_from_modifier(0x0300000000606015ULL, &l) &&
+                    l.log2_block_height == 5 && block_linear_block_rows(&l) == 256,
+                "0x0300000000606015 should have 32-GOB blocks");
+
+    TEST_ASSERT(block_linear_layout_from_modifier(
+                    DRM_FORMAT_MOD_NVIDIA_BLOCK_LINEAR_2D(0, 1, 2, 0xfe, 4), &l) &&
+                    l.kind == 0xfe && l.log2_block_height == 4,
+                "Generic desktop block-linear modifier");
+
+    TEST_ASSERT(!block_linear_layout_from_modifier(0x0300000000e08010ULL, &l) &&
+                    l.compression == 1,
+                "Compressed modifier must be rejected");
+    TEST_ASSERT(!block_linear_layout_from_modifier(DRM_FORMAT_MOD_NVIDIA_16BX2_BLOCK(2), NULL),
+                "Tegra sector layout must be rejected");
+    TEST_ASSERT(!block_linear_layout_from_modifier(DRM_FORMAT_MOD_LINEAR, NULL),
+                "LINEAR is not block-linear");
+    TEST_ASSERT(!block_linear_layout_from_modifier(DRM_FORMAT_MOD_INVALID, NULL),
+                "INVALID is not block-linear");
+
+    TEST_PASS("test_modifier_decode");
+}
+
+/**
+ * The reference offset maps a padded plane onto itself one to one
+ */
+static void
+test_offset_is_bijective(void)
+{
+    for (guint h = 0; h <= 5; h++)
+    {
+        BlockLinearLayout l = {h, 0x06, 2, TRUE, 0};
+        guint pitch = 3 * BLOCK_LINEAR_GOB_WIDTH;
+        guint rows = block_linear_block_rows(&l) * 2;
+        gsize size = block_linear_plane_size(&l, pitch, rows);
+        guint8 *hits = g_malloc0(size);
+        gboolean ok = size == (gsize)pitch * rows;
+
+        for (guint y = 0; ok && y < rows; y++)
+            for (guint x = 0; ok && x < pitch; x++)
+            {
+                gsize off = block_linear_offset(&l, pitch, x, y);
+                ok = off < size && hits[off]++ == 0;
+            }
+
+        g_free(hits);
+        TEST_ASSERT(ok, "Offsets should cover the plane exactly once");
+    }
+
+    /* First row of a GOB is split into 16-byte runs 32 bytes apart */
+    BlockLinearLayout l = {0, 0x06, 2, TRUE, 0};
+    TEST_ASSERT(block_linear_offset(&l, 64, 15, 0) == 15 &&
+                    block_linear_offset(&l, 64, 16, 0) == 32 &&
+                    block_linear_offset(&l, 64, 0, 1) == 16 &&
+                    block_linear_offset(&l, 64, 32, 0) == 256 &&
+                    block_linear_offset(&l, 64, 0, 8) == 512,
+                "GOB swizzle offsets");
+
+    TEST_PASS("test_offset_is_bijective");
+}
+
+/**
+ * Detile and tile match the per-byte reference across block heights, row
+ * lengths that end mid-run and mid-GOB, and row counts that end mid-block
+ */
+static void
+test_matches_reference(void)
+{
+    static const guint row_bytes[] = {1, 15, 16, 17, 64, 100, 192, 1000};
+    static const guint rows[] = {1, 7, 8, 9, 37};
+
+    for (guint h = 0; h <= 5; h++)
+        for (guint ri = 0; ri < G_N_ELEMENTS(row_bytes); ri++)
+            for (guint hi = 0; hi < G_N_ELEMENTS(rows); hi++)
+            {
+                BlockLinearLayout l = {h, 0x06, 2, TRUE, 0};
+                guint w = row_bytes[ri], n = rows[hi];
+                guint pitch = (w + BLOCK_LINEAR_GOB_WIDTH - 1) & ~(BLOCK_LINEAR_GOB_WIDTH - 1);
+                gsize size = block_linear_plane_size(&l, pitch, n);
+                gint stride = (gint)w + 5;
+
+                guint8 *tiled = g_malloc(size);
+                guint8 *linear = g_malloc((gsize)stride * n);
+                guint8 *retiled = g_malloc(size);
+                gboolean ok = TRUE;
+
+                for (gsize i = 0; i < size; i++)
+                    tiled[i] = (guint8)(i * 7 + 3);
+                memset(linear, PAD_BYTE, (gsize)stride * n);
+                memset(retiled, PAD_BYTE, size);
+
+                block_linear_detile(&l, tiled, pitch, linear, stride, w, n);
+                for (guint y = 0; ok && y < n; y++)
+                {
+                    for (guint x = 0; ok && x < w; x++)
+                        ok = linear[y * stride + x] == tiled[block_linear_offset(&l, pitch, x, y)];
+                    ok = ok && linear[y * stride + w] == PAD_BYTE;
+                }
+
+                /* Tiling back writes exactly the converted bytes */
+                block_linear_tile(&l, linear, stride, retiled, pitch, w, n);
+                for (guint y = 0; ok && y < n; y++)
+                    for (guint x = 0; ok && x < w; x++)
+                    {
+                        gsize off = block_linear_offset(&l, pitch, x, y);
+                        ok = retiled[off] == tiled[off];
+                        retiled[off] = PAD_BYTE;
+                    }
+                for (gsize i = 0; ok && i < size; i++)
+                    ok = retiled[i] == PAD_BYTE;
+
+                if (!ok)
+                    fprintf(stderr, "  h=%u %ux%u\n", h, w, n);
+                g_free(tiled);
+                g_free(linear);
+                g_free(retiled);
+                TEST_ASSERT(ok, "Block-linear conversion differs from reference");
+            }
+
+    TEST_PASS("test_matches_reference");
+}
+
+/**
+ * gst_video_frame_map() of a tiled NV12 buffer sees linear planes, and
+ * writes through a write map land in the tiled layout
+ */
+static void
+test_video_meta_map(void)
+{
+    const guint64 modifier = 0x0300000000606011ULL;
+    const guint width = 100, height = 36;
+    BlockLinearLayout l;
+    block_linear_layout_from_modifier(modifier, &l);
+
+    guint pitch = 128;
+    gsize y_size = block_linear_plane_size(&l, pitch, height);
+    gsize uv_size = block_linear_plane_size(&l, pitch, height / 2);
+    gsize offsets[GST_VIDEO_MAX_PLANES] = {0, y_size};
+    gint strides[GST_VIDEO_MAX_PLANES] = {(gint)pitch, (gint)pitch};
+
+    GstBuffer *buf = gst_buffer_new_allocate(NULL, y_size + uv_size, NULL);
+    GstMapInfo map;
+    gst_buffer_map(buf, &map, GST_MAP_WRITE);
+    for (gsize i = 0; i < map.size; i++)
+        map.data[i] = (guint8)(i * 13 + 1);
+    gst_buffer_unmap(buf, &map);
+
+    GstVideoMeta *vmeta = gst_buffer_add_video_meta_full(buf, GST_VIDEO_FRAME_FLAG_NONE,
+                                                         GST_VIDEO_FORMAT_NV12, width, height,
+                                                         2, offsets, strides);
+    TEST_ASSERT(block_linear_install_video_meta_map(vmeta, modifier), "Hook should install");
+
+    GstVideoInfo info;
+    gst_video_info_set_format(&info, GST_VIDEO_FORMAT_NV12, width, height);
+    GstVideoFrame frame;
+    TEST_ASSERT(gst_video_frame_map(&frame, &info, buf, GST_MAP_READWRITE), "Frame map");
+
+    /* Compare with the tiled bytes through the reference offsets */
+    gst_buffer_map(buf, &map, GST_MAP_READ);
+    gboolean ok = TRUE;
+    for (guint p = 0; p < 2; p++)
+    {
+        const guint8 *plane = GST_VIDEO_FRAME_PLANE_DATA(&frame, p);
+        gint stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, p);
+        guint rows = p == 0 ? height : height / 2;
+        for (guint y = 0; ok && y < rows; y++)
+            for (guint x = 0; ok && x < width; x++)
+                ok = plane[y * stride + x] ==
+                     map.data[offsets[p] + block_linear_offset(&l, pitch, x, y)];
+    }
+    gst_buffer_unmap(buf, &map);
+
+    /* Write a pixel at a run boundary, then unmap to retile */
+    guint8 *y_plane = GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
+    y_plane[17 * GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0) + 48] = 0x5a;
+    gst_video_frame_unmap(&frame);
+
+    gst_buffer_map(buf, &map, GST_MAP_READ);
+    ok = ok && map.data[block_linear_offset(&l, pitch, 48, 17)] == 0x5a;
+    gst_buffer_unmap(buf, &map);
+
+    gst_buffer_unref(buf);
+    TEST_ASSERT(ok, "Mapped planes should be linear and written back tiled");
+
+    TEST_PASS("test_video_meta_map");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running block-linear tests...\n\n");
+
+    test_modifier_decode();
+    test_offset_is_bijective();
+    test_matches_reference();
+    test_video_meta_map();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,381 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for deferred-completion buffer fences (mock backend, no GPU)
+ */
+
+#define _GNU_SOURCE
+
+#include "buffer_fence.h"
+
+#include <gst/gst.h>
+#include <gst/allocators/allocators.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+/* ============================================================================
+ * Mock backend
+ *
+ * Records every backend call in an op log so tests can assert ordering:
+ *   C = create, R = record, Q = query, S = synchronize, D = destroy
+ * ============================================================================ */
+
+typedef struct
+{
+    gboolean complete;
+} MockEvent;
+
+typedef struct
+{
+    GString *log;
+    gpointer last_stream;
+    /* When TRUE the "GPU" finishes work immediately (visible via query) */
+    gboolean gpu_idle;
+} MockState;
+
+static MockState mock;
+
+static gpointer
+mock_event_create(gpointer user_data)
+{
+    (void)user_data;
+    g_string_append_c(mock.log, 'C');
+    return g_new0(MockEvent, 1);
+}
+
+static gboolean
+mock_event_record(gpointer event, gpointer stream, gpointer user_data)
+{
+    (void)user_data;
+    g_string_append_c(mock.log, 'R');
+    ((MockEvent *)event)->complete = FALSE;
+    mock.last_stream = stream;
+    return TRUE;
+}
+
+static gboolean
+mock_event_query(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+    g_string_append_c(mock.log, 'Q');
+    if (mock.gpu_idle)
+        ((MockEvent *)event)->complete = TRUE;
+    return ((MockEvent *)event)->complete;
+}
+
+static gboolean
+mock_event_synchronize(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+    g_string_append_c(mock.log, 'S');
+    ((MockEvent *)event)->complete = TRUE;
+    return TRUE;
+}
+
+static void
+mock_event_destroy(gpointer event, gpointer user_data)
+{
+    (void)user_data;
+    g_string_append_c(mock.log, 'D');
+    g_free(event);
+}
+
+static const BufferFenceBackend mock_backend = {
+    .event_create = mock_event_create,
+    .event_record = mock_event_record,
+    .event_query = mock_event_query,
+    .event_synchronize = mock_event_synchronize,
+    .event_destroy = mock_event_destroy,
+    .user_data = NULL,
+};
+
+static void
+mock_reset(void)
+{
+    if (mock.log)
+        g_string_free(mock.log, TRUE);
+    memset(&mock, 0, sizeof(mock));
+    mock.log = g_string_new(NULL);
+}
+
+#define LOG_IS(expected) (g_strcmp0(mock.log->str, (expected)) == 0)
+
+/* Wrap an anonymous shared-memory fd as a DMA-BUF memory */
+static GstMemory *
+new_fenced_memory(GstAllocator *alloc, gsize size)
+{
+    int fd = memfd_create("fence-test", MFD_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate(fd, (off_t)size) < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    return gst_dmabuf_allocator_alloc(alloc, fd, size);
+}
+
+/**
+ * Recording must not block: no synchronize until someone waits
+ */
+static void
+test_record_does_not_block(void)
+{
+    mock_reset();
+
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    TEST_ASSERT(fence != NULL, "Failed to create fence");
+
+    TEST_ASSERT(buffer_fence_record(fence, GINT_TO_POINTER(0x42), NULL), "Record failed");
+    TEST_ASSERT(mock.last_stream == GINT_TO_POINTER(0x42), "Record used wrong stream");
+    TEST_ASSERT(LOG_IS("CR"), "Record should not synchronize");
+    TEST_ASSERT(!buffer_fence_is_signaled(fence), "Fence should be pending");
+
+    TEST_ASSERT(buffer_fence_wait(fence), "Wait failed");
+    TEST_ASSERT(LOG_IS("CRQS"), "Wait should synchronize exactly once");
+
+    /* Nothing pending: neither a second wait nor a query reach the backend */
+    TEST_ASSERT(buffer_fence_wait(fence), "Second wait failed");
+    TEST_ASSERT(buffer_fence_is_signaled(fence), "Fence should be signaled");
+    TEST_ASSERT(LOG_IS("CRQS"), "Completed fence should not touch the backend");
+
+    buffer_fence_unref(fence);
+    TEST_ASSERT(LOG_IS("CRQSD"), "Unref should destroy the event");
+
+    TEST_PASS("test_record_does_not_block");
+}
+
+/**
+ * Reusing a slot waits on the previous frame before recording the next
+ */
+static void
+test_rerecord_waits_previous(void)
+{
+    mock_reset();
+
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    TEST_ASSERT(fence != NULL, "Failed to create fence");
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "First record failed");
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "Second record failed");
+    TEST_ASSERT(LOG_IS("CRSR"), "Previous frame must be waited before re-record");
+
+    buffer_fence_unref(fence);
+    TEST_ASSERT(LOG_IS("CRSRSD"), "Last unref must wait before destroy");
+
+    TEST_PASS("test_rerecord_waits_previous");
+}
+
+/**
+ * The input buffer is held until the GPU is done reading it
+ */
+static void
+test_keepalive_released_on_completion(void)
+{
+    mock_reset();
+
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    GstBuffer *inbuf = gst_buffer_new();
+    TEST_ASSERT(fence != NULL && inbuf != NULL, "Setup failed");
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, inbuf), "Record failed");
+    TEST_ASSERT(GST_MINI_OBJECT_REFCOUNT_VALUE(inbuf) == 2, "Fence should hold the input");
+
+    /* GPU still busy: query keeps the reference */
+    TEST_ASSERT(!buffer_fence_is_signaled(fence), "Fence should be pending");
+    TEST_ASSERT(GST_MINI_OBJECT_REFCOUNT_VALUE(inbuf) == 2, "Input released too early");
+
+    /* GPU done: a non-blocking query is enough to release it */
+    mock.gpu_idle = TRUE;
+    TEST_ASSERT(buffer_fence_is_signaled(fence), "Fence should be signaled");
+    TEST_ASSERT(GST_MINI_OBJECT_REFCOUNT_VALUE(inbuf) == 1, "Input not released");
+    TEST_ASSERT(strchr(mock.log->str, 'S') == NULL, "Query path must not synchronize");
+
+    buffer_fence_unref(fence);
+    gst_buffer_unref(inbuf);
+
+    TEST_PASS("test_keepalive_released_on_completion");
+}
+
+/**
+ * Mapping a fenced memory waits for completion first
+ */
+static void
+test_map_waits(void)
+{
+    mock_reset();
+
+    GstAllocator *alloc = buffer_fence_allocator_new();
+    TEST_ASSERT(alloc != NULL, "Failed to create allocator");
+
+    GstMemory *mem = new_fenced_memory(alloc, 4096);
+    TEST_ASSERT(mem != NULL, "Failed to create memory");
+    TEST_ASSERT(gst_is_dmabuf_memory(mem), "Memory should be DMA-BUF");
+
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    TEST_ASSERT(fence != NULL, "Failed to create fence");
+    buffer_fence_attach(mem, fence);
+    TEST_ASSERT(buffer_fence_get(mem) == fence, "Attached fence not found");
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "Record failed");
+    TEST_ASSERT(LOG_IS("CR"), "Unexpected backend calls before map");
+
+    GstMapInfo map;
+    TEST_ASSERT(gst_memory_map(mem, &map, GST_MAP_READ), "Map failed");
+    TEST_ASSERT(LOG_IS("CRS"), "Map must synchronize the fence");
+    TEST_ASSERT(buffer_fence_is_signaled(fence), "Fence should be signaled after map");
+    gst_memory_unmap(mem, &map);
+
+    /* Mapping again does not wait again */
+    TEST_ASSERT(gst_memory_map(mem, &map, GST_MAP_READ), "Second map failed");
+    gst_memory_unmap(mem, &map);
+    TEST_ASSERT(LOG_IS("CRS"), "Second map should not synchronize");
+
+    /* Memory keeps the fence alive after the owner drops it */
+    buffer_fence_unref(fence);
+    TEST_ASSERT(LOG_IS("CRS"), "Fence destroyed while attached");
+    gst_memory_unref(mem);
+    TEST_ASSERT(LOG_IS("CRSD"), "Fence not destroyed with memory");
+
+    gst_object_unref(alloc);
+    TEST_PASS("test_map_waits");
+}
+
+/**
+ * Syncing a buffer waits on every plane's fence
+ */
+static void
+test_wait_buffer(void)
+{
+    mock_reset();
+
+    GstAllocator *alloc = buffer_fence_allocator_new();
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    GstMemory *y_mem = new_fenced_memory(alloc, 4096);
+    GstMemory *uv_mem = new_fenced_memory(alloc, 2048);
+    TEST_ASSERT(alloc && fence && y_mem && uv_mem, "Setup failed");
+
+    buffer_fence_attach(y_mem, fence);
+    buffer_fence_attach(uv_mem, fence);
+
+    GstBuffer *buf = gst_buffer_new();
+    gst_buffer_append_memory(buf, y_mem);
+    gst_buffer_append_memory(buf, uv_mem);
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "Record failed");
+    TEST_ASSERT(buffer_fence_wait_buffer(buf), "Wait buffer failed");
+    TEST_ASSERT(LOG_IS("CRS"), "Shared fence should synchronize once");
+
+    /* Buffers without fences are trivially complete */
+    GstBuffer *plain = gst_buffer_new_allocate(NULL, 64, NULL);
+    TEST_ASSERT(buffer_fence_wait_buffer(plain), "Unfenced buffer should succeed");
+
+    gst_buffer_unref(plain);
+    gst_buffer_unref(buf);
+    buffer_fence_unref(fence);
+    gst_object_unref(alloc);
+
+    TEST_PASS("test_wait_buffer");
+}
+
+static gboolean
+mock_export(gpointer event, GstMemory *mem, gpointer user_data)
+{
+    (void)event;
+    (void)mem;
+    g_string_append_c(mock.log, 'E');
+    return GPOINTER_TO_INT(user_data);
+}
+
+/**
+ * Exported fences are pushed without a CPU wait; failed exports fall back
+ * to waiting, and completed fences aren't exported at all
+ */
+static void
+test_export_buffer(void)
+{
+    mock_reset();
+
+    GstAllocator *alloc = buffer_fence_allocator_new();
+    BufferFence *fence = buffer_fence_new(&mock_backend);
+    GstMemory *mem = new_fenced_memory(alloc, 4096);
+    TEST_ASSERT(alloc && fence && mem, "Setup failed");
+
+    buffer_fence_attach(mem, fence);
+
+    GstBuffer *buf = gst_buffer_new();
+    gst_buffer_append_memory(buf, mem);
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "Record failed");
+    TEST_ASSERT(buffer_fence_export_buffer(buf, mock_export, GINT_TO_POINTER(TRUE)),
+                "Export failed");
+    TEST_ASSERT(LOG_IS("CRE"), "Exported fence must not be waited on");
+
+    /* Still pending for CPU readers */
+    TEST_ASSERT(buffer_fence_wait_buffer(buf), "Wait buffer failed");
+    TEST_ASSERT(LOG_IS("CRES"), "Exported fence should stay pending");
+
+    /* Nothing pending: nothing to export */
+    TEST_ASSERT(buffer_fence_export_buffer(buf, mock_export, GINT_TO_POINTER(TRUE)),
+                "Export of a completed fence failed");
+    TEST_ASSERT(LOG_IS("CRES"), "Completed fence should be skipped");
+
+    TEST_ASSERT(buffer_fence_record(fence, NULL, NULL), "Re-record failed");
+    TEST_ASSERT(buffer_fence_export_buffer(buf, mock_export, GINT_TO_POINTER(FALSE)),
+                "Fallback wait failed");
+    TEST_ASSERT(LOG_IS("CRESRES"), "Failed export should wait");
+
+    gst_buffer_unref(buf);
+    buffer_fence_unref(fence);
+    gst_object_unref(alloc);
+
+    TEST_PASS("test_export_buffer");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running buffer fence tests...\n\n");
+
+    test_record_does_not_block();
+    test_rerecord_waits_previous();
+    test_keepalive_released_on_completion();
+    test_map_waits();
+    test_wait_buffer();
+    test_export_buffer();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    mock_reset();
+    g_string_free(mock.log, TRUE);
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the transform_caps result cache
+ */
+
+#include "caps_cache.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+static GstCaps *
+nv12_caps(gint width)
+{
+    return gst_caps_new_simple("video/x-raw",
+                               "format", G_TYPE_STRING, "NV12",
+                               "width", G_TYPE_INT, width,
+                               "height", G_TYPE_INT, 720,
+                               NULL);
+}
+
+/**
+ * Equal input caps hit even as a different object, and the result is the
+ * cached (shared, so not writable) caps
+ */
+static void
+test_hit_on_equal_caps(void)
+{
+    CapsCache *cache = caps_cache_new(4);
+    CapsCacheKey key = {GST_PAD_SINK, FALSE, NULL};
+    GstCaps *in = nv12_caps(1280);
+    GstCaps *out = gst_caps_new_empty_simple("video/x-raw");
+
+    TEST_ASSERT(caps_cache_lookup(cache, &key, in) == NULL, "Empty cache should miss");
+    caps_cache_insert(cache, &key, in, out);
+
+    GstCaps *same = nv12_caps(1280);
+    GstCaps *hit = caps_cache_lookup(cache, &key, same);
+    TEST_ASSERT(hit == out, "Equal caps should return the cached result");
+    TEST_ASSERT(!gst_caps_is_writable(hit), "Cached result should be shared");
+
+    guint64 hits, misses;
+    caps_cache_get_stats(cache, &hits, &misses);
+    TEST_ASSERT(hits == 1 && misses == 1, "Counters");
+
+    gst_caps_unref(hit);
+    gst_caps_unref(same);
+    gst_caps_unref(in);
+    gst_caps_unref(out);
+    caps_cache_free(cache);
+    TEST_PASS("test_hit_on_equal_caps");
+}
+
+/**
+ * Direction, force-linear, the format table and the ranking are part of
+ * the key
+ */
+static void
+test_key_fields(void)
+{
+    CapsCache *cache = caps_cache_new(4);
+    static const int tables[2];
+    CapsCacheKey key = {GST_PAD_SINK, FALSE, &tables[0]};
+    GstCaps *in = nv12_caps(1280);
+    GstCaps *out = gst_caps_new_empty_simple("video/x-raw");
+
+    caps_cache_insert(cache, &key, in, out);
+
+    CapsCacheKey other = key;
+    other.direction = GST_PAD_SRC;
+    TEST_ASSERT(caps_cache_lookup(cache, &other, in) == NULL, "Direction should miss");
+
+    other = key;
+    other.force_linear = TRUE;
+    TEST_ASSERT(caps_cache_lookup(cache, &other, in) == NULL, "force-linear should miss");
+
+    other = key;
+    other.formats = &tables[1];
+    TEST_ASSERT(caps_cache_lookup(cache, &other, in) == NULL, "New format table should miss");
+
+    other = key;
+    other.ranking++;
+    TEST_ASSERT(caps_cache_lookup(cache, &other, in) == NULL, "New ranking should miss");
+
+    GstCaps *wider = nv12_caps(1920);
+    TEST_ASSERT(caps_cache_lookup(cache, &key, wider) == NULL, "Different caps should miss");
+
+    caps_cache_clear(cache);
+    TEST_ASSERT(caps_cache_lookup(cache, &key, in) == NULL, "Clear should drop entries");
+
+    gst_caps_unref(wider);
+    gst_caps_unref(in);
+    gst_caps_unref(out);
+    caps_cache_free(cache);
+    TEST_PASS("test_key_fields");
+}
+
+/**
+ * A full cache evicts the least recently used entry
+ */
+static void
+test_lru_eviction(void)
+{
+    CapsCache *cache = caps_cache_new(2);
+    CapsCacheKey key = {GST_PAD_SINK, FALSE, NULL};
+    GstCaps *in[3] = {nv12_caps(640), nv12_caps(1280), nv12_caps(1920)};
+    GstCaps *out = gst_caps_new_empty_simple("video/x-raw");
+
+    caps_cache_insert(cache, &key, in[0], out);
+    caps_cache_insert(cache, &key, in[1], out);
+
+    /* Touch 640 so 1280 becomes the oldest */
+    GstCaps *hit = caps_cache_lookup(cache, &key, in[0]);
+    TEST_ASSERT(hit != NULL, "640 should hit");
+    gst_caps_unref(hit);
+
+    caps_cache_insert(cache, &key, in[2], out);
+
+    hit = caps_cache_lookup(cache, &key, in[1]);
+    TEST_ASSERT(hit == NULL, "Least recently used entry should be evicted");
+    hit = caps_cache_lookup(cache, &key, in[0]);
+    TEST_ASSERT(hit != NULL, "Recently used entry should stay");
+    gst_caps_unref(hit);
+    hit = caps_cache_lookup(cache, &key, in[2]);
+    TEST_ASSERT(hit != NULL, "Newest entry should stay");
+    gst_caps_unref(hit);
+
+    for (guint i = 0; i < G_N_ELEMENTS(in); i++)
+        gst_caps_unref(in[i]);
+    gst_caps_unref(out);
+    caps_cache_free(cache);
+    TEST_PASS("test_lru_eviction");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running caps cache tests...\n\n");
+
+    test_hit_on_equal_caps();
+    test_key_fields();
+    test_lru_eviction();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
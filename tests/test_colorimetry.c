@@ -0,0 +1,392 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for colorimetry-aware YUV→RGB coefficients and the CPU
+ * references of the NV12→BGRx and P010→RGB kernels (no GPU)
+ */
+
+#include "colorimetry.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+static void
+coeffs_for(const gchar *colorimetry, YuvToRgbCoeffs *coeffs)
+{
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, colorimetry);
+    colorimetry_get_yuv_to_rgb_coeffs(&cinfo, coeffs);
+}
+
+static gboolean
+near(int a, int b, int tol)
+{
+    return abs(a - b) <= tol;
+}
+
+static gboolean
+pixel_is(const YuvToRgbCoeffs *c, int y, int u, int v, int r, int g, int b, int tol)
+{
+    uint8_t R, G, B;
+    yuv_to_rgb_pixel(c, y, u, v, &R, &G, &B);
+    return near(R, r, tol) && near(G, g, tol) && near(B, b, tol);
+}
+
+/* Double-precision conversion straight from Kr/Kb, for comparison */
+static void
+float_reference(gdouble Kr, gdouble Kb, gboolean full, int y, int u, int v,
+                gdouble *r, gdouble *g, gdouble *b)
+{
+    gdouble Y = full ? y / 255.0 : (y - 16) / 219.0;
+    gdouble U = full ? (u - 128) / 255.0 : (u - 128) / 224.0;
+    gdouble V = full ? (v - 128) / 255.0 : (v - 128) / 224.0;
+    gdouble Kg = 1.0 - Kr - Kb;
+
+    *r = 255.0 * (Y + 2.0 * (1.0 - Kr) * V);
+    *g = 255.0 * (Y - 2.0 * Kb * (1.0 - Kb) / Kg * U - 2.0 * Kr * (1.0 - Kr) / Kg * V);
+    *b = 255.0 * (Y + 2.0 * (1.0 - Kb) * U);
+}
+
+static int
+clamp255(gdouble v)
+{
+    int i = (int)(v + 0.5);
+    return i < 0 ? 0 : (i > 255 ? 255 : i);
+}
+
+/**
+ * Limited range maps 16/235 to black/white, full range 0/255
+ */
+static void
+test_range(void)
+{
+    YuvToRgbCoeffs c;
+
+    coeffs_for("bt709", &c);
+    TEST_ASSERT(c.y_offset == 16, "bt709 should be limited range");
+    TEST_ASSERT(pixel_is(&c, 16, 128, 128, 0, 0, 0, 0), "Limited black");
+    TEST_ASSERT(pixel_is(&c, 235, 128, 128, 255, 255, 255, 0), "Limited white");
+    TEST_ASSERT(pixel_is(&c, 126, 128, 128, 128, 128, 128, 1), "Limited mid-grey");
+
+    coeffs_for("1:3:5:1", &c); /* full range, BT.709 */
+    TEST_ASSERT(c.y_offset == 0, "0_255 range should be full");
+    TEST_ASSERT(pixel_is(&c, 0, 128, 128, 0, 0, 0, 0), "Full black");
+    TEST_ASSERT(pixel_is(&c, 255, 128, 128, 255, 255, 255, 0), "Full white");
+
+    TEST_PASS("test_range");
+}
+
+/**
+ * Primary colours land on the right matrix (values from the BT.601 and
+ * BT.709 limited-range colour bars)
+ */
+static void
+test_matrix(void)
+{
+    YuvToRgbCoeffs c601, c709, c2020;
+
+    coeffs_for("bt601", &c601);
+    coeffs_for("bt709", &c709);
+    coeffs_for("bt2020", &c2020);
+
+    TEST_ASSERT(pixel_is(&c601, 81, 90, 240, 255, 0, 0, 2), "BT.601 red");
+    TEST_ASSERT(pixel_is(&c601, 145, 54, 34, 0, 255, 0, 2), "BT.601 green");
+    TEST_ASSERT(pixel_is(&c601, 41, 240, 110, 0, 0, 255, 2), "BT.601 blue");
+
+    TEST_ASSERT(pixel_is(&c709, 63, 102, 240, 255, 0, 0, 2), "BT.709 red");
+    TEST_ASSERT(pixel_is(&c709, 173, 42, 26, 0, 255, 0, 2), "BT.709 green");
+    TEST_ASSERT(pixel_is(&c709, 32, 240, 118, 0, 0, 255, 2), "BT.709 blue");
+
+    /* The matrices differ enough that mixing them up is visible */
+    TEST_ASSERT(c601.crv != c709.crv && c709.crv != c2020.crv, "Matrices not distinguished");
+    TEST_ASSERT(!pixel_is(&c709, 81, 90, 240, 255, 0, 0, 2), "BT.601 red decoded as BT.709");
+
+    TEST_PASS("test_matrix");
+}
+
+/**
+ * Fixed point stays within one code value of the double-precision formula
+ * for every matrix/range, and all coefficients fit in int16
+ */
+static void
+test_against_float(void)
+{
+    static const struct
+    {
+        const gchar *colorimetry;
+        GstVideoColorMatrix matrix;
+        gboolean full;
+    } cases[] = {
+        {"bt601", GST_VIDEO_COLOR_MATRIX_BT601, FALSE},
+        {"bt709", GST_VIDEO_COLOR_MATRIX_BT709, FALSE},
+        {"bt2020", GST_VIDEO_COLOR_MATRIX_BT2020, FALSE},
+        {"smpte240m", GST_VIDEO_COLOR_MATRIX_SMPTE240M, FALSE},
+        {"1:4:0:0", GST_VIDEO_COLOR_MATRIX_BT601, TRUE},
+        {"1:3:5:1", GST_VIDEO_COLOR_MATRIX_BT709, TRUE},
+    };
+
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++)
+    {
+        YuvToRgbCoeffs c;
+        gdouble Kr, Kb;
+        int max_err = 0;
+
+        coeffs_for(cases[i].colorimetry, &c);
+        gst_video_color_matrix_get_Kr_Kb(cases[i].matrix, &Kr, &Kb);
+
+        const int32_t k[] = {c.cy, c.crv, c.cgu, c.cgv, c.cbu};
+        for (guint j = 0; j < G_N_ELEMENTS(k); j++)
+            TEST_ASSERT(k[j] >= G_MININT16 && k[j] <= G_MAXINT16, "Coefficient exceeds int16");
+
+        for (int y = 0; y < 256; y += 3)
+            for (int u = 0; u < 256; u += 5)
+                for (int v = 0; v < 256; v += 7)
+                {
+                    uint8_t R, G, B;
+                    gdouble r, g, b;
+                    yuv_to_rgb_pixel(&c, y, u, v, &R, &G, &B);
+                    float_reference(Kr, Kb, cases[i].full, y, u, v, &r, &g, &b);
+                    max_err = MAX(max_err, abs(R - clamp255(r)));
+                    max_err = MAX(max_err, abs(G - clamp255(g)));
+                    max_err = MAX(max_err, abs(B - clamp255(b)));
+                }
+
+        printf("  %-10s max error %d\n", cases[i].colorimetry, max_err);
+        TEST_ASSERT(max_err <= 1, "Fixed point deviates from float reference");
+    }
+
+    TEST_PASS("test_against_float");
+}
+
+/**
+ * Unknown matrix falls back to BT.709, unknown range to limited
+ */
+static void
+test_unknown_fallback(void)
+{
+    GstVideoColorimetry cinfo = {GST_VIDEO_COLOR_RANGE_UNKNOWN, GST_VIDEO_COLOR_MATRIX_UNKNOWN,
+                                 GST_VIDEO_TRANSFER_UNKNOWN, GST_VIDEO_COLOR_PRIMARIES_UNKNOWN};
+    YuvToRgbCoeffs unknown, c709;
+
+    colorimetry_get_yuv_to_rgb_coeffs(&cinfo, &unknown);
+    coeffs_for("bt709", &c709);
+    TEST_ASSERT(memcmp(&unknown, &c709, sizeof(YuvToRgbCoeffs)) == 0,
+                "Unknown colorimetry should match limited BT.709");
+
+    TEST_PASS("test_unknown_fallback");
+}
+
+/**
+ * The frame-level reference honours strides and 4:2:0 chroma siting
+ */
+static void
+test_frame_reference(void)
+{
+    enum
+    {
+        W = 6,
+        H = 4,
+        Y_STRIDE = 8,
+        UV_STRIDE = 8,
+        OUT_STRIDE = W * 4 + 8
+    };
+    uint8_t y_plane[Y_STRIDE * H];
+    uint8_t uv_plane[UV_STRIDE * H / 2];
+    uint8_t out[OUT_STRIDE * H];
+    YuvToRgbCoeffs c;
+
+    coeffs_for("bt709", &c);
+    memset(y_plane, 0, sizeof(y_plane));
+    memset(uv_plane, 0, sizeof(uv_plane));
+    memset(out, 0xAA, sizeof(out));
+
+    for (int y = 0; y < H; y++)
+        for (int x = 0; x < W; x++)
+            y_plane[y * Y_STRIDE + x] = (uint8_t)(16 + 30 * x + 5 * y);
+    for (int y = 0; y < H / 2; y++)
+        for (int x = 0; x < W / 2; x++)
+        {
+            uv_plane[y * UV_STRIDE + x * 2] = (uint8_t)(100 + 20 * x);
+            uv_plane[y * UV_STRIDE + x * 2 + 1] = (uint8_t)(150 - 20 * y);
+        }
+
+    nv12_to_bgrx_reference(y_plane, uv_plane, out, W, H,
+                           Y_STRIDE, UV_STRIDE, OUT_STRIDE, &c);
+
+    for (int y = 0; y < H; y++)
+    {
+        for (int x = 0; x < W; x++)
+        {
+            uint8_t R, G, B;
+            const uint8_t *px = out + y * OUT_STRIDE + x * 4;
+            yuv_to_rgb_pixel(&c, y_plane[y * Y_STRIDE + x],
+                             uv_plane[(y / 2) * UV_STRIDE + (x / 2) * 2],
+                             uv_plane[(y / 2) * UV_STRIDE + (x / 2) * 2 + 1],
+                             &R, &G, &B);
+            TEST_ASSERT(px[0] == B && px[1] == G && px[2] == R && px[3] == 255,
+                        "Reference pixel mismatch");
+        }
+        /* Row padding is left untouched */
+        TEST_ASSERT(out[y * OUT_STRIDE + W * 4] == 0xAA, "Wrote past row end");
+    }
+
+    TEST_PASS("test_frame_reference");
+}
+
+static void
+coeffs_for_depth(const gchar *colorimetry, guint in_depth, guint out_depth, YuvToRgbCoeffs *coeffs)
+{
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, colorimetry);
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(&cinfo, in_depth, out_depth, coeffs);
+}
+
+/**
+ * 10-bit input uses 64-940 levels; 10-bit output spans 0-1023, and the
+ * 10→8-bit table agrees with the 8-bit one on equivalent code values
+ */
+static void
+test_10bit_levels(void)
+{
+    YuvToRgbCoeffs c8, c10_8, c10_10;
+    int32_t r, g, b;
+
+    coeffs_for("bt2020", &c8);
+    coeffs_for_depth("bt2020", 10, 8, &c10_8);
+    coeffs_for_depth("bt2020", 10, 10, &c10_10);
+
+    TEST_ASSERT(c10_10.y_offset == 64 && c10_10.uv_offset == 512, "10-bit limited offsets");
+    TEST_ASSERT(c10_10.out_max == 1023 && c10_8.out_max == 255, "Output depth");
+
+    yuv_to_rgb(&c10_10, 64, 512, 512, &r, &g, &b);
+    TEST_ASSERT(r == 0 && g == 0 && b == 0, "10-bit black");
+    yuv_to_rgb(&c10_10, 940, 512, 512, &r, &g, &b);
+    TEST_ASSERT(r == 1023 && g == 1023 && b == 1023, "10-bit white");
+    yuv_to_rgb(&c10_8, 940, 512, 512, &r, &g, &b);
+    TEST_ASSERT(r == 255 && g == 255 && b == 255, "10-bit white to 8-bit");
+
+    const int32_t k[] = {c10_8.cy, c10_8.crv, c10_8.cgu, c10_8.cgv, c10_8.cbu,
+                         c10_10.cy, c10_10.crv, c10_10.cgu, c10_10.cgv, c10_10.cbu};
+    for (guint i = 0; i < G_N_ELEMENTS(k); i++)
+        TEST_ASSERT(k[i] >= G_MININT16 && k[i] <= G_MAXINT16, "Coefficient exceeds int16");
+
+    /* Same colour at both depths: 8-bit samples shifted up by 2 */
+    for (int y = 16; y <= 235; y += 17)
+        for (int u = 16; u <= 240; u += 28)
+            for (int v = 16; v <= 240; v += 28)
+            {
+                uint8_t R8, G8, B8;
+                yuv_to_rgb_pixel(&c8, y, u, v, &R8, &G8, &B8);
+                yuv_to_rgb(&c10_8, y << 2, u << 2, v << 2, &r, &g, &b);
+                TEST_ASSERT(abs(r - R8) <= 1 && abs(g - G8) <= 1 && abs(b - B8) <= 1,
+                            "10→8-bit differs from 8-bit conversion");
+            }
+
+    TEST_PASS("test_10bit_levels");
+}
+
+/**
+ * The P010 tile matches the per-pixel reference for BGRx and XRGB2101010,
+ * including odd sizes and row padding
+ */
+static void
+test_p010_reference(void)
+{
+    enum
+    {
+        W = 7,
+        H = 5,
+        Y_STRIDE = W * 2 + 6,
+        UV_STRIDE = 8 * 2 + 4,
+        OUT_STRIDE = W * 4 + 8
+    };
+    uint8_t y_plane[Y_STRIDE * H];
+    uint8_t uv_plane[UV_STRIDE * ((H + 1) / 2)];
+    uint8_t tiled[OUT_STRIDE * H];
+    uint8_t ref[OUT_STRIDE * H];
+
+    for (guint i = 0; i < sizeof(y_plane); i++)
+        y_plane[i] = (uint8_t)(i * 37 + 11);
+    for (guint i = 0; i < sizeof(uv_plane); i++)
+        uv_plane[i] = (uint8_t)(i * 53 + 7);
+
+    for (int rgb10 = 0; rgb10 <= 1; rgb10++)
+    {
+        YuvToRgbCoeffs c;
+        coeffs_for_depth("bt2020", 10, rgb10 ? 10 : 8, &c);
+
+        memset(tiled, 0xAA, sizeof(tiled));
+        memset(ref, 0xAA, sizeof(ref));
+
+        for (int y0 = 0; y0 < H; y0 += 2)
+            for (int x0 = 0; x0 < W; x0 += 2)
+                p010_to_rgb_tile(&c, y_plane, uv_plane, tiled, W, H,
+                                 Y_STRIDE, UV_STRIDE, OUT_STRIDE, x0, y0, rgb10);
+        p010_to_rgb_reference(y_plane, uv_plane, ref, W, H,
+                              Y_STRIDE, UV_STRIDE, OUT_STRIDE, &c, rgb10);
+
+        TEST_ASSERT(memcmp(tiled, ref, sizeof(ref)) == 0, "P010 tile differs from reference");
+        TEST_ASSERT(ref[W * 4] == 0xAA, "Wrote past row end");
+    }
+
+    /* Known values: limited-range white packs to all-ones components */
+    YuvToRgbCoeffs c10;
+    uint8_t white_y[4] = {0x00, 0xeb, 0x00, 0xeb}; /* 940 << 6 */
+    uint8_t grey_uv[4] = {0x00, 0x80, 0x00, 0x80}; /* 512 << 6 */
+    uint8_t px[8];
+    uint32_t word;
+
+    coeffs_for_depth("bt2020", 10, 10, &c10);
+    p010_to_rgb_reference(white_y, grey_uv, px, 2, 1, 4, 4, 8, &c10, 1);
+    memcpy(&word, px, 4);
+    TEST_ASSERT(word == 0xffffffffu, "10-bit white should pack to 0xffffffff");
+
+    TEST_PASS("test_p010_reference");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running colorimetry tests...\n\n");
+
+    test_range();
+    test_matrix();
+    test_against_float();
+    test_unknown_fallback();
+    test_frame_reference();
+    test_10bit_levels();
+    test_p010_reference();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
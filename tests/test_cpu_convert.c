@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the SIMD CPU converter: every ISA supported by the host
+ * must match the scalar GPU reference bit for bit
+ */
+
+#include "colorimetry.h"
+#include "cpu_convert.h"
+#include "worker_pool.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define PAD_BYTE 0xAA
+
+/* Input planes with padded strides and an output/reference pair, all
+ * offset by @misalign bytes */
+typedef struct
+{
+    CpuConvertFrame frame;
+    guint8 *storage;
+    guint8 *ref;
+    gsize out_size;
+} TestFrame;
+
+static void
+test_frame_init(TestFrame *t, int width, int height, gboolean p010, gboolean rgb10,
+                int stride_pad, int misalign)
+{
+    int bps = p010 ? 2 : 1;
+    int y_stride = width * bps + stride_pad;
+    int uv_stride = ((width + 1) / 2) * 2 * bps + stride_pad;
+    int out_stride = width * 4 + stride_pad * 4;
+    gsize y_size = (gsize)y_stride * height;
+    gsize uv_size = (gsize)uv_stride * ((height + 1) / 2);
+
+    t->out_size = (gsize)out_stride * height;
+    t->storage = g_malloc(y_size + uv_size + 2 * t->out_size + 4 * 64);
+
+    guint8 *y_plane = t->storage + misalign;
+    guint8 *uv_plane = y_plane + y_size + 64;
+    guint8 *out = uv_plane + uv_size + 64;
+    t->ref = out + t->out_size + 64;
+
+    /* Full code range including values outside the nominal levels, so
+     * clamping is exercised */
+    for (gsize i = 0; i < y_size; i++)
+        y_plane[i] = (guint8)(i * 7 + 3);
+    for (gsize i = 0; i < uv_size; i++)
+        uv_plane[i] = (guint8)(i * 13 + 101);
+    memset(out, PAD_BYTE, t->out_size);
+    memset(t->ref, PAD_BYTE, t->out_size);
+
+    CpuConvertFrame f = {y_plane, uv_plane, y_stride, uv_stride, out, out_stride,
+                         width, height, p010, rgb10, NULL};
+    t->frame = f;
+}
+
+static void
+test_frame_reference(TestFrame *t, const YuvToRgbCoeffs *c)
+{
+    const CpuConvertFrame *f = &t->frame;
+
+    if (f->p010)
+        p010_to_rgb_reference(f->y_plane, f->uv_plane, t->ref, f->width, f->height,
+                              f->y_stride, f->uv_stride, f->out_stride, c, f->rgb10);
+    else
+        nv12_to_bgrx_reference(f->y_plane, f->uv_plane, t->ref, f->width, f->height,
+                               f->y_stride, f->uv_stride, f->out_stride, c);
+}
+
+static void
+coeffs_for(const gchar *colorimetry, guint in_depth, guint out_depth, YuvToRgbCoeffs *c)
+{
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, colorimetry);
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(&cinfo, in_depth, out_depth, c);
+}
+
+/**
+ * Every supported ISA matches the reference for NV12→BGRx, P010→BGRx and
+ * P010→XR30 across sizes, strides, alignment and colorimetries
+ */
+static void
+test_isa_matches_reference(void)
+{
+    static const struct
+    {
+        int width, height, stride_pad, misalign;
+    } sizes[] = {
+        {1, 1, 0, 0},
+        {2, 2, 0, 0},
+        {7, 3, 0, 1},
+        {8, 2, 0, 0},
+        {15, 5, 2, 3},
+        {16, 4, 0, 0},
+        {17, 9, 3, 1},
+        {33, 7, 0, 2},
+        {64, 32, 4, 0},
+        {1366, 6, 2, 1},
+    };
+    static const struct
+    {
+        gboolean p010, rgb10;
+    } formats[] = {{FALSE, FALSE}, {TRUE, FALSE}, {TRUE, TRUE}};
+    static const gchar *colorimetries[] = {"bt601", "bt709", "bt2020", "1:4:0:0"};
+
+    for (int isa = 0; isa < CPU_CONVERT_ISA_COUNT; isa++)
+    {
+        if (!cpu_convert_isa_supported(isa))
+        {
+            printf("  %s: not supported, skipped\n", cpu_convert_isa_name(isa));
+            continue;
+        }
+
+        for (guint fi = 0; fi < G_N_ELEMENTS(formats); fi++)
+            for (guint ci = 0; ci < G_N_ELEMENTS(colorimetries); ci++)
+                for (guint si = 0; si < G_N_ELEMENTS(sizes); si++)
+                {
+                    TestFrame t;
+                    YuvToRgbCoeffs c;
+
+                    coeffs_for(colorimetries[ci], formats[fi].p010 ? 10 : 8,
+                               formats[fi].rgb10 ? 10 : 8, &c);
+                    test_frame_init(&t, sizes[si].width, sizes[si].height,
+                                    formats[fi].p010, formats[fi].rgb10,
+                                    sizes[si].stride_pad, sizes[si].misalign);
+
+                    cpu_convert_rows(isa, &t.frame, &c, 0, t.frame.height);
+                    test_frame_reference(&t, &c);
+
+                    gboolean same = memcmp(t.frame.out, t.ref, t.out_size) == 0;
+                    if (!same)
+                        fprintf(stderr, "  %s %dx%d p010=%d rgb10=%d %s\n",
+                                cpu_convert_isa_name(isa), t.frame.width, t.frame.height,
+                                t.frame.p010, t.frame.rgb10, colorimetries[ci]);
+                    g_free(t.storage);
+                    TEST_ASSERT(same, "CPU conversion differs from reference");
+                }
+
+        printf("  %s: bit-exact\n", cpu_convert_isa_name(isa));
+    }
+
+    TEST_PASS("test_isa_matches_reference");
+}
+
+/**
+ * Row bands across a worker pool produce the same frame as one pass
+ */
+static void
+test_banded_frame(void)
+{
+    static const int threads[] = {1, 2, 3, 8};
+    YuvToRgbCoeffs c;
+    coeffs_for("bt709", 8, 8, &c);
+
+    for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+    {
+        WorkerPool *pool = worker_pool_new(threads[i]);
+        TestFrame t;
+
+        test_frame_init(&t, 321, 243, FALSE, FALSE, 3, 0);
+        cpu_convert_frame(pool, cpu_convert_best_isa(), &t.frame, &c);
+        test_frame_reference(&t, &c);
+
+        gboolean same = memcmp(t.frame.out, t.ref, t.out_size) == 0;
+        g_free(t.storage);
+        worker_pool_free(pool);
+        TEST_ASSERT(same, "Banded conversion differs from reference");
+    }
+
+    TEST_PASS("test_banded_frame");
+}
+
+/**
+ * Scaled frames go through the fused scale sampler
+ */
+static void
+test_scaled_frame(void)
+{
+    YuvToRgbCoeffs c;
+    ScaleGeometry g;
+    TestFrame t;
+    WorkerPool *pool = worker_pool_new(4);
+
+    coeffs_for("bt709", 8, 8, &c);
+    test_frame_init(&t, 64, 36, FALSE, FALSE, 0, 0);
+    scale_geometry_compute(64, 36, 1, 1, 32, 32, TRUE, SCALE_METHOD_BILINEAR, &g);
+
+    CpuConvertFrame f = t.frame;
+    f.scale = &g;
+    f.out_stride = 32 * 4;
+    guint8 *out = g_malloc0(32 * 4 * 32);
+    guint8 *ref = g_malloc0(32 * 4 * 32);
+    f.out = out;
+
+    cpu_convert_frame(pool, cpu_convert_best_isa(), &f, &c);
+    scale_yuv_to_rgb_reference(f.y_plane, f.uv_plane, f.y_stride, f.uv_stride, FALSE,
+                               ref, 32 * 4, &g, &c, FALSE);
+
+    gboolean same = memcmp(out, ref, 32 * 4 * 32) == 0;
+    g_free(out);
+    g_free(ref);
+    g_free(t.storage);
+    worker_pool_free(pool);
+    TEST_ASSERT(same, "Scaled CPU conversion differs from reference");
+
+    TEST_PASS("test_scaled_frame");
+}
+
+static void
+count_job(guint job, gpointer user_data)
+{
+    gint *hits = user_data;
+    g_atomic_int_inc(&hits[job]);
+}
+
+/**
+ * Each job of every batch runs exactly once
+ */
+static void
+test_worker_pool(void)
+{
+    WorkerPool *pool = worker_pool_new(4);
+    gint hits[37];
+
+    TEST_ASSERT(worker_pool_get_n_threads(pool) == 4, "Pool should report 4 threads");
+
+    for (int round = 0; round < 200; round++)
+    {
+        guint n_jobs = 1 + round % G_N_ELEMENTS(hits);
+        memset(hits, 0, sizeof(hits));
+        worker_pool_run(pool, n_jobs, count_job, hits);
+
+        for (guint i = 0; i < G_N_ELEMENTS(hits); i++)
+        {
+            if (hits[i] != (i < n_jobs ? 1 : 0))
+            {
+                worker_pool_free(pool);
+                TEST_ASSERT(FALSE, "Job ran the wrong number of times");
+            }
+        }
+    }
+
+    worker_pool_free(pool);
+    TEST_PASS("test_worker_pool");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running CPU converter tests (best ISA: %s)...\n\n",
+           cpu_convert_isa_name(cpu_convert_best_isa()));
+
+    test_isa_matches_reference();
+    test_banded_frame();
+    test_scaled_frame();
+    test_worker_pool();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
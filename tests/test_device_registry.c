@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the shared device registry: sharing per path, closing
+ * with the last reference, failed opens and concurrent first acquires.
+ * Uses fake devices; needs no GPU.
+ */
+
+#include "device_registry.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define N_THREADS 8
+
+typedef struct
+{
+    gint opened;
+    gint closed;
+    gulong open_delay_usec;
+} FakeDevices;
+
+static gpointer
+fake_open(const gchar *path, gpointer user_data)
+{
+    FakeDevices *fake = user_data;
+
+    if (fake->open_delay_usec)
+        g_usleep(fake->open_delay_usec);
+    if (strstr(path, "missing"))
+        return NULL;
+
+    g_atomic_int_inc(&fake->opened);
+    return g_strdup(path);
+}
+
+static void
+fake_close(gpointer device, gpointer user_data)
+{
+    FakeDevices *fake = user_data;
+
+    g_atomic_int_inc(&fake->closed);
+    g_free(device);
+}
+
+/**
+ * One device per path, shared by every acquire and closed with the last
+ * release
+ */
+static void
+test_sharing(void)
+{
+    FakeDevices fake = {0, 0, 0};
+    DeviceRegistry *registry = device_registry_new(fake_open, fake_close, &fake);
+
+    gpointer a1 = device_registry_acquire(registry, "/dev/dri/renderD128");
+    gpointer a2 = device_registry_acquire(registry, "/dev/dri/renderD128");
+    gpointer b = device_registry_acquire(registry, "/dev/dri/renderD129");
+
+    TEST_ASSERT(a1 && a1 == a2, "Same path should share one device");
+    TEST_ASSERT(b && b != a1, "Another path should get its own device");
+    TEST_ASSERT(fake.opened == 2 && device_registry_get_n_devices(registry) == 2,
+                "Two devices should be open");
+
+    device_registry_release(registry, a1);
+    TEST_ASSERT(fake.closed == 0, "A remaining user should keep the device open");
+
+    device_registry_release(registry, a2);
+    TEST_ASSERT(fake.closed == 1 && device_registry_get_n_devices(registry) == 1,
+                "Last release should close the device");
+
+    /* Reopened from scratch after the close */
+    gpointer a3 = device_registry_acquire(registry, "/dev/dri/renderD128");
+    TEST_ASSERT(a3 && fake.opened == 3, "A closed device should be reopened");
+
+    device_registry_release(registry, a3);
+    device_registry_release(registry, b);
+    TEST_ASSERT(fake.closed == 3 && device_registry_get_n_devices(registry) == 0,
+                "Everything should be closed");
+
+    device_registry_free(registry);
+    TEST_PASS("test_sharing");
+}
+
+/**
+ * A failed open returns NULL, caches nothing and is retried next time
+ */
+static void
+test_open_failure(void)
+{
+    FakeDevices fake = {0, 0, 0};
+    DeviceRegistry *registry = device_registry_new(fake_open, fake_close, &fake);
+
+    TEST_ASSERT(device_registry_acquire(registry, "/dev/dri/missing") == NULL,
+                "Failed open should return NULL");
+    TEST_ASSERT(device_registry_get_n_devices(registry) == 0, "Failure should not be cached");
+
+    /* Releasing NULL (a failed acquire) is harmless */
+    device_registry_release(registry, NULL);
+    TEST_ASSERT(fake.closed == 0, "Nothing should be closed");
+
+    device_registry_free(registry);
+    TEST_PASS("test_open_failure");
+}
+
+typedef struct
+{
+    DeviceRegistry *registry;
+    gpointer device;
+} AcquireJob;
+
+static gpointer
+acquire_thread(gpointer data)
+{
+    AcquireJob *job = data;
+
+    job->device = device_registry_acquire(job->registry, "/dev/dri/renderD128");
+    return NULL;
+}
+
+/**
+ * Threads racing on the first acquire of a node open it once and all get
+ * the same device
+ */
+static void
+test_concurrent_open(void)
+{
+    FakeDevices fake = {0, 0, 20000};
+    DeviceRegistry *registry = device_registry_new(fake_open, fake_close, &fake);
+    AcquireJob jobs[N_THREADS];
+    GThread *threads[N_THREADS];
+
+    for (guint i = 0; i < N_THREADS; i++)
+    {
+        jobs[i].registry = registry;
+        jobs[i].device = NULL;
+        threads[i] = g_thread_new("acquire", acquire_thread, &jobs[i]);
+    }
+    for (guint i = 0; i < N_THREADS; i++)
+        g_thread_join(threads[i]);
+
+    TEST_ASSERT(fake.opened == 1, "The node should be opened once");
+    for (guint i = 0; i < N_THREADS; i++)
+        TEST_ASSERT(jobs[i].device && jobs[i].device == jobs[0].device,
+                    "Every thread should get the same device");
+
+    for (guint i = 0; i < N_THREADS; i++)
+        device_registry_release(registry, jobs[i].device);
+    TEST_ASSERT(fake.closed == 1, "Last release should close the device once");
+
+    device_registry_free(registry);
+    TEST_PASS("test_concurrent_open");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running device registry tests...\n\n");
+
+    test_sharing();
+    test_open_failure();
+    test_concurrent_open();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,367 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for recycled DMA-BUF output buffers (memfd-backed, no GPU)
+ *
+ * malloc/calloc/realloc and dup are interposed so the steady-state
+ * acquire/release cycle can be checked for zero allocations and zero fd
+ * syscalls per frame.
+ */
+
+#define _GNU_SOURCE
+
+#include "dmabuf_wrapper.h"
+#include "buffer_fence.h"
+
+#include <gst/gst.h>
+#include <gst/allocators/allocators.h>
+#include <gst/video/video.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+/* ============================================================================
+ * Allocation / syscall counters
+ * ============================================================================ */
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile gboolean counting = FALSE;
+static volatile guint n_allocs = 0;
+static volatile guint n_dups = 0;
+
+void *malloc(size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (counting)
+        n_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+int dup(int fd)
+{
+    if (counting)
+        n_dups++;
+    return (int)syscall(SYS_dup, fd);
+}
+
+static void
+counters_start(void)
+{
+    n_allocs = 0;
+    n_dups = 0;
+    counting = TRUE;
+}
+
+static void
+counters_stop(void)
+{
+    counting = FALSE;
+}
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+#define TEST_WIDTH 64
+#define TEST_HEIGHT 32
+#define Y_SIZE (TEST_WIDTH * TEST_HEIGHT)
+#define UV_SIZE (TEST_WIDTH * TEST_HEIGHT / 2)
+
+typedef struct
+{
+    GstAllocator *alloc;
+    int fds[2];
+} Fixture;
+
+static gboolean
+fixture_init(Fixture *fx)
+{
+    const gsize sizes[2] = {Y_SIZE, UV_SIZE};
+
+    fx->alloc = buffer_fence_allocator_new();
+    for (guint i = 0; i < 2; i++)
+    {
+        fx->fds[i] = memfd_create("wrapper-test", MFD_CLOEXEC);
+        if (fx->fds[i] < 0 || ftruncate(fx->fds[i], (off_t)sizes[i]) < 0)
+            return FALSE;
+    }
+    return fx->alloc != NULL;
+}
+
+static void
+fixture_clear(Fixture *fx)
+{
+    for (guint i = 0; i < 2; i++)
+        if (fx->fds[i] >= 0)
+            close(fx->fds[i]);
+    gst_object_unref(fx->alloc);
+}
+
+static GstBuffer *
+build_nv12(Fixture *fx)
+{
+    const gsize sizes[2] = {Y_SIZE, UV_SIZE};
+    const gsize offsets[4] = {0, 0, 0, 0};
+    const gint strides[4] = {TEST_WIDTH, TEST_WIDTH, 0, 0};
+
+    return dmabuf_wrapper_build_buffer(fx->alloc, 2, fx->fds, sizes, NULL,
+                                       GST_VIDEO_FORMAT_NV12, TEST_WIDTH, TEST_HEIGHT,
+                                       2, offsets, strides);
+}
+
+static void
+mark_finalized(gpointer data, GstMiniObject *obj)
+{
+    (void)obj;
+    *(gboolean *)data = TRUE;
+}
+
+/* ============================================================================
+ * Tests
+ * ============================================================================ */
+
+/**
+ * Building wraps dups of the caller's fds with a POOLED video meta
+ */
+static void
+test_build_buffer(void)
+{
+    Fixture fx;
+    TEST_ASSERT(fixture_init(&fx), "Fixture setup failed");
+
+    counters_start();
+    GstBuffer *buf = build_nv12(&fx);
+    counters_stop();
+
+    TEST_ASSERT(buf != NULL, "Build failed");
+    TEST_ASSERT(n_dups == 2, "Build should dup each fd once");
+    TEST_ASSERT(gst_buffer_n_memory(buf) == 2, "Expected two memories");
+
+    for (guint i = 0; i < 2; i++)
+    {
+        GstMemory *mem = gst_buffer_peek_memory(buf, i);
+        TEST_ASSERT(gst_is_dmabuf_memory(mem), "Memory should be DMA-BUF");
+        TEST_ASSERT(gst_dmabuf_memory_get_fd(mem) != fx.fds[i], "Memory should own a dup");
+    }
+
+    GstVideoMeta *vmeta = gst_buffer_get_video_meta(buf);
+    TEST_ASSERT(vmeta != NULL, "Missing video meta");
+    TEST_ASSERT(vmeta->format == GST_VIDEO_FORMAT_NV12, "Wrong format");
+    TEST_ASSERT(vmeta->stride[1] == TEST_WIDTH, "Wrong UV stride");
+    TEST_ASSERT(GST_META_FLAG_IS_SET(vmeta, GST_META_FLAG_POOLED), "Video meta not POOLED");
+
+    gst_buffer_unref(buf);
+    TEST_ASSERT(fcntl(fx.fds[0], F_GETFD) >= 0, "Caller fd closed by the buffer");
+
+    fixture_clear(&fx);
+    TEST_PASS("test_build_buffer");
+}
+
+/**
+ * Steady state: no heap allocations and no dup per frame
+ */
+static void
+test_recycle_no_alloc(void)
+{
+    Fixture fx;
+    TEST_ASSERT(fixture_init(&fx), "Fixture setup failed");
+
+    GstBuffer *built = build_nv12(&fx);
+    TEST_ASSERT(built != NULL, "Build failed");
+    GstBuffer *first = built;
+    DmaBufWrapper *wrapper = dmabuf_wrapper_new(built);
+
+    /* Warm up once outside the measured loop */
+    GstBuffer *buf = dmabuf_wrapper_acquire(wrapper);
+    TEST_ASSERT(buf != NULL, "Initial acquire failed");
+    gst_buffer_unref(buf);
+
+    const guint frames = 1000;
+    gboolean same = TRUE;
+
+    counters_start();
+    for (guint i = 0; i < frames; i++)
+    {
+        buf = dmabuf_wrapper_acquire(wrapper);
+        if (!buf)
+            break;
+        same = same && buf == first;
+        GST_BUFFER_PTS(buf) = i * GST_MSECOND;
+
+        /* Downstream holds it for a while, then drops it */
+        gst_buffer_ref(buf);
+        gst_buffer_unref(buf);
+        gst_buffer_unref(buf);
+    }
+    counters_stop();
+
+    printf("  %u frames: %u allocations, %u dups\n", frames, n_allocs, n_dups);
+    TEST_ASSERT(buf != NULL, "Acquire failed in steady state");
+    TEST_ASSERT(same, "Buffer was not recycled");
+    TEST_ASSERT(n_allocs == 0, "Steady state allocated memory");
+    TEST_ASSERT(n_dups == 0, "Steady state dup'd fds");
+
+    dmabuf_wrapper_free(wrapper);
+    fixture_clear(&fx);
+    TEST_PASS("test_recycle_no_alloc");
+}
+
+/**
+ * A frame still held downstream is not handed out again
+ */
+static void
+test_busy_while_downstream(void)
+{
+    Fixture fx;
+    TEST_ASSERT(fixture_init(&fx), "Fixture setup failed");
+
+    DmaBufWrapper *wrapper = dmabuf_wrapper_new(build_nv12(&fx));
+    TEST_ASSERT(dmabuf_wrapper_is_free(wrapper), "Fresh wrapper should be free");
+
+    GstBuffer *buf = dmabuf_wrapper_acquire(wrapper);
+    TEST_ASSERT(buf != NULL, "Acquire failed");
+    TEST_ASSERT(GST_MINI_OBJECT_REFCOUNT_VALUE(buf) == 1, "Caller should own the only ref");
+    TEST_ASSERT(gst_buffer_is_writable(buf), "Acquired buffer should be writable");
+    TEST_ASSERT(!dmabuf_wrapper_is_free(wrapper), "Wrapper should be busy");
+    TEST_ASSERT(dmabuf_wrapper_acquire(wrapper) == NULL, "Busy wrapper handed out twice");
+
+    gst_buffer_unref(buf);
+    TEST_ASSERT(dmabuf_wrapper_is_free(wrapper), "Released buffer not parked");
+
+    dmabuf_wrapper_free(wrapper);
+    fixture_clear(&fx);
+    TEST_PASS("test_busy_while_downstream");
+}
+
+/**
+ * Per-frame state from the previous round does not leak into the next
+ */
+static void
+test_reset_on_acquire(void)
+{
+    Fixture fx;
+    TEST_ASSERT(fixture_init(&fx), "Fixture setup failed");
+
+    DmaBufWrapper *wrapper = dmabuf_wrapper_new(build_nv12(&fx));
+
+    GstBuffer *buf = dmabuf_wrapper_acquire(wrapper);
+    TEST_ASSERT(buf != NULL, "Acquire failed");
+    GST_BUFFER_PTS(buf) = 5 * GST_SECOND;
+    GST_BUFFER_FLAG_SET(buf, GST_BUFFER_FLAG_DISCONT);
+    gst_buffer_add_video_crop_meta(buf);
+    gst_buffer_unref(buf);
+
+    buf = dmabuf_wrapper_acquire(wrapper);
+    TEST_ASSERT(buf != NULL, "Second acquire failed");
+    TEST_ASSERT(!GST_BUFFER_PTS_IS_VALID(buf), "PTS not reset");
+    TEST_ASSERT(!GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_DISCONT), "Flags not reset");
+    TEST_ASSERT(gst_buffer_get_video_crop_meta(buf) == NULL, "Downstream meta not removed");
+    TEST_ASSERT(gst_buffer_get_video_meta(buf) != NULL, "Pooled video meta removed");
+    gst_buffer_unref(buf);
+
+    dmabuf_wrapper_free(wrapper);
+    fixture_clear(&fx);
+    TEST_PASS("test_reset_on_acquire");
+}
+
+/**
+ * Freeing the wrapper releases a parked buffer immediately and an
+ * in-flight one when downstream drops it
+ */
+static void
+test_free(void)
+{
+    Fixture fx;
+    TEST_ASSERT(fixture_init(&fx), "Fixture setup failed");
+
+    /* Parked */
+    gboolean finalized = FALSE;
+    GstBuffer *built = build_nv12(&fx);
+    gst_mini_object_weak_ref(GST_MINI_OBJECT(built), mark_finalized, &finalized);
+    DmaBufWrapper *wrapper = dmabuf_wrapper_new(built);
+    dmabuf_wrapper_free(wrapper);
+    TEST_ASSERT(finalized, "Parked buffer not freed with the wrapper");
+
+    /* In flight */
+    finalized = FALSE;
+    built = build_nv12(&fx);
+    gst_mini_object_weak_ref(GST_MINI_OBJECT(built), mark_finalized, &finalized);
+    wrapper = dmabuf_wrapper_new(built);
+    GstBuffer *buf = dmabuf_wrapper_acquire(wrapper);
+    TEST_ASSERT(buf != NULL, "Acquire failed");
+
+    dmabuf_wrapper_free(wrapper);
+    TEST_ASSERT(!finalized, "In-flight buffer freed too early");
+
+    GstMapInfo map;
+    TEST_ASSERT(gst_buffer_map(buf, &map, GST_MAP_READ), "In-flight buffer unusable");
+    gst_buffer_unmap(buf, &map);
+
+    gst_buffer_unref(buf);
+    TEST_ASSERT(finalized, "In-flight buffer not freed on release");
+
+    fixture_clear(&fx);
+    TEST_PASS("test_free");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running DMA-BUF wrapper tests...\n\n");
+
+    test_build_buffer();
+    test_recycle_no_alloc();
+    test_busy_while_downstream();
+    test_reset_on_acquire();
+    test_free();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,277 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the DRM format table: candidate entries, device
+ * filtering and the on-disk cache. Needs no GPU.
+ */
+
+#include "drm_format_table.h"
+#include "drm_format_utils.h"
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+#include <drm/drm_fourcc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+static gchar *tmp_dir = NULL;
+
+static gboolean
+is_supported(const DrmFormatTable *table, const gchar *drm_format)
+{
+    const DrmFormatEntry *e = drm_format_table_lookup(table, drm_format);
+    return e && e->supported;
+}
+
+/**
+ * Candidates keep the caps strings and preference order, and every string
+ * looks up its own entry
+ */
+static void
+test_candidates(void)
+{
+    DrmFormatTable *table = drm_format_table_new();
+    guint n = drm_format_table_get_n_entries(table);
+
+    TEST_ASSERT(n > 0, "Table should have candidates");
+    TEST_ASSERT(strcmp(drm_format_table_get_entry(table, 0)->drm_format,
+                       "NV12:0x0300000000606010") == 0,
+                "Tiled NV12 should come first");
+
+    const DrmFormatEntry *e = drm_format_table_lookup(table, "NV12:0x0");
+    TEST_ASSERT(e && e->fourcc == DRM_FORMAT_NV12 && e->modifier == DRM_FORMAT_MOD_LINEAR &&
+                    e->n_planes == 2 && e->bpp == 12,
+                "LINEAR NV12 entry");
+
+    e = drm_format_table_lookup(table, "P010:0x0300000000e08015");
+    TEST_ASSERT(e && e->fourcc == DRM_FORMAT_P010 && e->modifier == 0x0300000000e08015ULL &&
+                    e->bpp == 24,
+                "Compressed P010 entry");
+
+    e = drm_format_table_lookup(table, "XR24:0x0");
+    TEST_ASSERT(e && e->n_planes == 1 && e->bpp == 32, "LINEAR XR24 entry");
+    TEST_ASSERT(drm_format_table_lookup(table, "AR30:0x0") != NULL, "AR30 entry");
+
+    TEST_ASSERT(drm_format_table_lookup(table, "NV12") == NULL &&
+                    drm_format_table_lookup(table, "YUYV:0x0") == NULL &&
+                    drm_format_table_lookup(table, NULL) == NULL,
+                "Unknown strings have no entry");
+
+    for (guint i = 0; i < n; i++)
+    {
+        e = drm_format_table_get_entry(table, i);
+        TEST_ASSERT(drm_format_table_lookup(table, e->drm_format) == e,
+                    "Every entry should look itself up");
+        TEST_ASSERT(e->supported && e->gbm, "Candidates start supported");
+        TEST_ASSERT(drm_format_get_fourcc(e->drm_format) == e->fourcc &&
+                        drm_format_parse_modifier(e->drm_format) == e->modifier,
+                    "Table and string parsing should agree");
+    }
+
+    /* Strings outside the table still parse */
+    TEST_ASSERT(drm_format_parse_modifier("XR24:0x5") == 5 &&
+                    drm_format_get_fourcc("XR24:0x5") == DRM_FORMAT_XRGB8888,
+                "Non-candidate strings should fall back to parsing");
+
+    drm_format_table_free(table);
+    TEST_PASS("test_candidates");
+}
+
+/**
+ * Modifiers the device doesn't report are dropped, LINEAR is kept, and an
+ * empty report leaves a fourcc alone
+ */
+static void
+test_device_modifiers(void)
+{
+    DrmFormatTable *table = drm_format_table_new();
+    const guint64 reported[] = {0x0300000000606012ULL, 0x0300000000606015ULL, 0x1234ULL};
+
+    drm_format_table_set_device_modifiers(table, DRM_FORMAT_NV12, reported,
+                                          G_N_ELEMENTS(reported), FALSE);
+    drm_format_table_set_device_modifiers(table, DRM_FORMAT_P010, NULL, 0, TRUE);
+
+    TEST_ASSERT(is_supported(table, "NV12:0x0300000000606012") &&
+                    is_supported(table, "NV12:0x0300000000606015") &&
+                    is_supported(table, "NV12:0x0"),
+                "Reported modifiers and LINEAR stay supported");
+    TEST_ASSERT(!is_supported(table, "NV12:0x0300000000606010") &&
+                    !is_supported(table, "NV12:0x0300000000e08012") &&
+                    !is_supported(table, "NV12:0x0100000000000001"),
+                "Unreported modifiers are dropped");
+    TEST_ASSERT(!drm_format_table_lookup(table, "NV12:0x0")->gbm, "GBM column should be set");
+    TEST_ASSERT(is_supported(table, "P010:0x0300000000606010") &&
+                    is_supported(table, "XR24:0x0300000000606010"),
+                "Other fourccs are untouched");
+
+    drm_format_table_free(table);
+    TEST_PASS("test_device_modifiers");
+}
+
+/**
+ * The cache round-trips the device columns and is ignored for another
+ * driver version
+ */
+static void
+test_cache_roundtrip(void)
+{
+    gchar *path = g_build_filename(tmp_dir, "sub", "drm-formats.ini", NULL);
+    DrmFormatTable *table = drm_format_table_new();
+    const guint64 reported[] = {0x0300000000606011ULL};
+    GError *error = NULL;
+
+    drm_format_table_set_device_modifiers(table, DRM_FORMAT_XRGB8888, reported,
+                                          G_N_ELEMENTS(reported), FALSE);
+    TEST_ASSERT(drm_format_table_save(table, path, "nvidia-drm 580.1", &error),
+                "Cache should save (creating its directory)");
+
+    DrmFormatTable *loaded = drm_format_table_new();
+    TEST_ASSERT(drm_format_table_load(loaded, path, "nvidia-drm 580.1"), "Cache should load");
+    for (guint i = 0; i < drm_format_table_get_n_entries(table); i++)
+    {
+        const DrmFormatEntry *a = drm_format_table_get_entry(table, i);
+        const DrmFormatEntry *b = drm_format_table_get_entry(loaded, i);
+        TEST_ASSERT(a->supported == b->supported && a->gbm == b->gbm,
+                    "Loaded table should match the saved one");
+    }
+
+    DrmFormatTable *stale = drm_format_table_new();
+    TEST_ASSERT(!drm_format_table_load(stale, path, "nvidia-drm 590.2"),
+                "Another driver version should miss");
+    TEST_ASSERT(is_supported(stale, "XR24:0x0300000000606010"),
+                "A missed load should leave the table alone");
+
+    gchar *missing = g_build_filename(tmp_dir, "missing.ini", NULL);
+    TEST_ASSERT(!drm_format_table_load(stale, missing, "nvidia-drm 580.1"),
+                "Missing file should miss");
+
+    drm_format_table_free(table);
+    drm_format_table_free(loaded);
+    drm_format_table_free(stale);
+    g_free(missing);
+    g_free(path);
+    TEST_PASS("test_cache_roundtrip");
+}
+
+static gboolean
+count_probe(DrmFormatTable *table, gpointer user_data)
+{
+    (void)table;
+    (*(gint *)user_data)++;
+    return TRUE;
+}
+
+/**
+ * Each device gets a table of its own: a matching cache fills it without
+ * probing, the candidate table is left alone
+ */
+static void
+test_cold_start_uses_cache(void)
+{
+    gchar *path = g_build_filename(tmp_dir, "default.ini", NULL);
+    gchar *other_path = g_build_filename(tmp_dir, "other.ini", NULL);
+    DrmFormatTable *table = drm_format_table_new();
+    const guint64 reported[] = {0x0300000000606014ULL};
+    const DrmFormatTable *device, *other;
+    gint probes = 0;
+
+    drm_format_table_set_device_modifiers(table, DRM_FORMAT_NV12, reported,
+                                          G_N_ELEMENTS(reported), TRUE);
+    TEST_ASSERT(drm_format_table_save(table, path, "key", NULL), "Cache should save");
+    drm_format_table_free(table);
+
+    device = drm_format_table_ensure_probed(path, "key", count_probe, &probes);
+    TEST_ASSERT(device != NULL, "Device table should be populated");
+    TEST_ASSERT(probes == 0, "A matching cache should skip the probe");
+    TEST_ASSERT(!is_supported(device, "NV12:0x0300000000606010") &&
+                    is_supported(device, "NV12:0x0300000000606014"),
+                "Device table should hold the cached results");
+    TEST_ASSERT(is_supported(drm_format_table_get_default(), "NV12:0x0300000000606010"),
+                "Default table keeps the candidates");
+
+    TEST_ASSERT(drm_format_table_ensure_probed(path, "key", count_probe, &probes) == device &&
+                    probes == 0,
+                "Later calls for the device return its table");
+
+    other = drm_format_table_ensure_probed(other_path, "other", count_probe, &probes);
+    TEST_ASSERT(other != NULL && other != device && probes == 1,
+                "Another device is probed into its own table");
+    TEST_ASSERT(g_file_test(other_path, G_FILE_TEST_EXISTS),
+                "The other device's probe should be cached in its own file");
+
+    g_free(other_path);
+    g_free(path);
+    TEST_PASS("test_cold_start_uses_cache");
+}
+
+static void
+remove_tree(const gchar *dir)
+{
+    GDir *d = g_dir_open(dir, 0, NULL);
+    const gchar *name;
+
+    while (d && (name = g_dir_read_name(d)))
+    {
+        gchar *p = g_build_filename(dir, name, NULL);
+        if (g_file_test(p, G_FILE_TEST_IS_DIR))
+            remove_tree(p);
+        else
+            g_unlink(p);
+        g_free(p);
+    }
+    if (d)
+        g_dir_close(d);
+    g_rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running DRM format table tests...\n\n");
+
+    tmp_dir = g_dir_make_tmp("drm-format-table-XXXXXX", NULL);
+    if (!tmp_dir)
+    {
+        fprintf(stderr, "Failed to create a temporary directory\n");
+        return 1;
+    }
+
+    test_candidates();
+    test_device_modifiers();
+    test_cache_roundtrip();
+    test_cold_start_uses_cache();
+
+    remove_tree(tmp_dir);
+    g_free(tmp_dir);
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
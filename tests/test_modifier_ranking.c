@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the modifier ranking: reordering by measured cost,
+ * resolution fallback and the on-disk cache. Needs no GPU.
+ */
+
+#include "modifier_ranking.h"
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+#include <drm/drm_fourcc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define BL(h) (0x0300000000606010ULL + (h))
+
+static gchar *tmp_dir = NULL;
+
+/**
+ * Measured modifiers are reordered fastest first within their own
+ * positions; LINEAR and unmeasured ones keep theirs
+ */
+static void
+test_sort(void)
+{
+    ModifierRanking *ranking = modifier_ranking_new();
+    guint64 mods[] = {BL(0), BL(1), BL(4), BL(5), DRM_FORMAT_MOD_LINEAR};
+    guint generation = modifier_ranking_get_generation(ranking);
+
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 1920, 1080, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(0) && mods[4] == DRM_FORMAT_MOD_LINEAR,
+                "No measurements should leave the order alone");
+
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(0), 90.0);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(4), 40.0);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(5), 60.0);
+    TEST_ASSERT(modifier_ranking_get_generation(ranking) != generation,
+                "Recording should bump the generation");
+    TEST_ASSERT(modifier_ranking_has(ranking, DRM_FORMAT_NV12, 1920, 1080) &&
+                    !modifier_ranking_has(ranking, DRM_FORMAT_NV12, 1280, 720) &&
+                    !modifier_ranking_has(ranking, DRM_FORMAT_P010, 1920, 1080),
+                "has() matches fourcc and exact size");
+
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 1920, 1080, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(4) && mods[1] == BL(1) && mods[2] == BL(5) &&
+                    mods[3] == BL(0) && mods[4] == DRM_FORMAT_MOD_LINEAR,
+                "Measured slots sorted by cost, others fixed");
+
+    /* A re-measurement replaces the old cost */
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(0), 10.0);
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 1920, 1080, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(0) && mods[2] == BL(4) && mods[3] == BL(5),
+                "Re-measurement should win");
+
+    guint64 p010[] = {BL(0), BL(4)};
+    modifier_ranking_sort(ranking, DRM_FORMAT_P010, 1920, 1080, p010, G_N_ELEMENTS(p010));
+    TEST_ASSERT(p010[0] == BL(0), "Other fourccs are untouched");
+
+    modifier_ranking_free(ranking);
+    TEST_PASS("test_sort");
+}
+
+/**
+ * Uncalibrated sizes use the closest calibrated resolution, unknown sizes
+ * the most recent one
+ */
+static void
+test_resolution_fallback(void)
+{
+    ModifierRanking *ranking = modifier_ranking_new();
+
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 3840, 2160, BL(1), 10.0);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 3840, 2160, BL(5), 20.0);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1280, 720, BL(1), 20.0);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1280, 720, BL(5), 10.0);
+
+    guint64 mods[] = {BL(1), BL(5)};
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 3200, 1800, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(1), "3200x1800 should rank by 4K");
+
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 1920, 1080, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(5), "1080p should rank by 720p");
+
+    /* 720p (the closest to nothing) would keep BL(5) first */
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 3840, 2160, BL(1), 5.0);
+    modifier_ranking_sort(ranking, DRM_FORMAT_NV12, 0, 0, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(1), "Unknown size should rank by the latest calibration");
+
+    modifier_ranking_free(ranking);
+    TEST_PASS("test_resolution_fallback");
+}
+
+/**
+ * The cache round-trips the measurements and is ignored for another
+ * driver version
+ */
+static void
+test_cache_roundtrip(void)
+{
+    gchar *path = g_build_filename(tmp_dir, "sub", "modifier-ranking.ini", NULL);
+    ModifierRanking *ranking = modifier_ranking_new();
+    GError *error = NULL;
+
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(2), 55.5);
+    modifier_ranking_record(ranking, DRM_FORMAT_NV12, 1920, 1080, BL(5), 44.25);
+    modifier_ranking_record(ranking, DRM_FORMAT_P010, 3840, 2160, BL(4), 120.0);
+    TEST_ASSERT(modifier_ranking_save(ranking, path, "nvidia-drm 580.1", &error),
+                "Ranking should save (creating its directory)");
+
+    ModifierRanking *loaded = modifier_ranking_new();
+    guint generation = modifier_ranking_get_generation(loaded);
+    TEST_ASSERT(modifier_ranking_load(loaded, path, "nvidia-drm 580.1"), "Ranking should load");
+    TEST_ASSERT(modifier_ranking_get_generation(loaded) != generation,
+                "Loading should bump the generation");
+    TEST_ASSERT(modifier_ranking_has(loaded, DRM_FORMAT_NV12, 1920, 1080) &&
+                    modifier_ranking_has(loaded, DRM_FORMAT_P010, 3840, 2160),
+                "Both resolutions should load");
+
+    guint64 mods[] = {BL(2), BL(5)};
+    modifier_ranking_sort(loaded, DRM_FORMAT_NV12, 1920, 1080, mods, G_N_ELEMENTS(mods));
+    TEST_ASSERT(mods[0] == BL(5) && mods[1] == BL(2), "Loaded costs should rank");
+
+    ModifierRanking *stale = modifier_ranking_new();
+    TEST_ASSERT(!modifier_ranking_load(stale, path, "nvidia-drm 590.2"),
+                "Another driver version should miss");
+    TEST_ASSERT(!modifier_ranking_has(stale, DRM_FORMAT_NV12, 1920, 1080),
+                "A missed load should leave the ranking empty");
+
+    gchar *missing = g_build_filename(tmp_dir, "missing.ini", NULL);
+    TEST_ASSERT(!modifier_ranking_load(stale, missing, "nvidia-drm 580.1"),
+                "Missing file should miss");
+
+    g_unlink(path);
+    gchar *sub = g_path_get_dirname(path);
+    g_rmdir(sub);
+
+    modifier_ranking_free(ranking);
+    modifier_ranking_free(loaded);
+    modifier_ranking_free(stale);
+    g_free(sub);
+    g_free(missing);
+    g_free(path);
+    TEST_PASS("test_cache_roundtrip");
+}
+
+/**
+ * Each device keeps its own ranking and cache file
+ */
+static void
+test_per_device(void)
+{
+    gchar *path = g_build_filename(tmp_dir, "device-a.ini", NULL);
+    gchar *other_path = g_build_filename(tmp_dir, "device-b.ini", NULL);
+    ModifierRanking *saved = modifier_ranking_new();
+
+    modifier_ranking_record(saved, DRM_FORMAT_NV12, 1920, 1080, BL(3), 40.0);
+    TEST_ASSERT(modifier_ranking_save(saved, path, "renderD128 nvidia-drm 580.1", NULL),
+                "Ranking should save");
+
+    ModifierRanking *a = modifier_ranking_ensure_loaded(path, "renderD128 nvidia-drm 580.1");
+    ModifierRanking *b = modifier_ranking_ensure_loaded(other_path, "renderD129 nvidia-drm 580.1");
+    TEST_ASSERT(a && b && a != b, "Devices should get rankings of their own");
+    TEST_ASSERT(modifier_ranking_has(a, DRM_FORMAT_NV12, 1920, 1080),
+                "A device's ranking should load from its file");
+    TEST_ASSERT(!modifier_ranking_has(b, DRM_FORMAT_NV12, 1920, 1080),
+                "Another device's ranking should stay empty");
+    TEST_ASSERT(modifier_ranking_ensure_loaded(path, "renderD128 nvidia-drm 580.1") == a,
+                "Later calls should return the device's ranking");
+
+    g_unsetenv("GST_CUDA_DMABUF_RANKING_CACHE");
+    gchar *file_a = modifier_ranking_default_cache_path("/dev/dri/renderD128");
+    gchar *file_b = modifier_ranking_default_cache_path("/dev/dri/renderD129");
+    TEST_ASSERT(g_str_has_suffix(file_a, "modifier-ranking-renderD128.ini") &&
+                    g_strcmp0(file_a, file_b) != 0,
+                "Devices should be cached in separate files");
+
+    g_unlink(path);
+    modifier_ranking_free(saved);
+    g_free(file_a);
+    g_free(file_b);
+    g_free(other_path);
+    g_free(path);
+    TEST_PASS("test_per_device");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running modifier ranking tests...\n\n");
+
+    tmp_dir = g_dir_make_tmp("modifier-ranking-XXXXXX", NULL);
+    if (!tmp_dir)
+    {
+        fprintf(stderr, "Failed to create a temporary directory\n");
+        return 1;
+    }
+
+    test_sort();
+    test_resolution_fallback();
+    test_cache_roundtrip();
+    test_per_device();
+
+    g_rmdir(tmp_dir);
+    g_free(tmp_dir);
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
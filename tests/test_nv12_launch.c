@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the NV12→BGRx launch geometry and a CPU emulation of the
+ * tiled kernel (no GPU)
+ */
+
+#include "colorimetry.h"
+#include "nv12_launch.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define PAD_BYTE 0xAA
+
+/* Planes carved out of one allocation at a chosen misalignment, with
+ * stride padding filled with PAD_BYTE so stray writes are visible */
+typedef struct
+{
+    int width, height;
+    int y_stride, uv_stride, out_stride;
+    guint8 *storage;
+    guint8 *y_plane, *uv_plane, *out, *ref;
+} TestFrame;
+
+static void
+test_frame_init(TestFrame *f, int width, int height, int stride_pad, int misalign)
+{
+    int uv_rows = (height + 1) / 2;
+
+    f->width = width;
+    f->height = height;
+    f->y_stride = width + stride_pad;
+    f->uv_stride = ((width + 1) / 2) * 2 + stride_pad;
+    f->out_stride = width * 4 + stride_pad * 4;
+
+    gsize y_size = (gsize)f->y_stride * height;
+    gsize uv_size = (gsize)f->uv_stride * uv_rows;
+    gsize out_size = (gsize)f->out_stride * height;
+
+    /* 64 bytes of slack in front of each plane for the misalignment */
+    f->storage = g_malloc(y_size + uv_size + 2 * out_size + 4 * 64);
+    f->y_plane = (guint8 *)GSIZE_TO_POINTER(GPOINTER_TO_SIZE(f->storage + 63) & ~(gsize)63) + misalign;
+    f->uv_plane = (guint8 *)GSIZE_TO_POINTER(GPOINTER_TO_SIZE(f->y_plane + y_size + 63) & ~(gsize)63) + misalign;
+    f->out = (guint8 *)GSIZE_TO_POINTER(GPOINTER_TO_SIZE(f->uv_plane + uv_size + 63) & ~(gsize)63) + misalign;
+    f->ref = (guint8 *)GSIZE_TO_POINTER(GPOINTER_TO_SIZE(f->out + out_size + 63) & ~(gsize)63);
+
+    for (gsize i = 0; i < y_size; i++)
+        f->y_plane[i] = (guint8)(i * 7 + 3);
+    for (gsize i = 0; i < uv_size; i++)
+        f->uv_plane[i] = (guint8)(i * 13 + 101);
+    memset(f->out, PAD_BYTE, out_size);
+    memset(f->ref, PAD_BYTE, out_size);
+}
+
+static void
+test_frame_clear(TestFrame *f)
+{
+    g_free(f->storage);
+}
+
+/* Run the kernel body exactly as the CUDA launch would: every thread of
+ * every block, with the same early-out and tile arguments */
+static void
+emulate_launch(const TestFrame *f, const YuvToRgbCoeffs *c, const Nv12LaunchGeometry *geo)
+{
+    for (unsigned by = 0; by < geo->grid_y; by++)
+        for (unsigned bx = 0; bx < geo->grid_x; bx++)
+            for (unsigned ty = 0; ty < geo->block_y; ty++)
+                for (unsigned tx = 0; tx < geo->block_x; tx++)
+                {
+                    int x0 = (int)((bx * geo->block_x + tx) * geo->tile_w);
+                    int y0 = (int)((by * geo->block_y + ty) * NV12_TILE_H);
+
+                    if (x0 >= f->width || y0 >= f->height)
+                        continue;
+
+                    nv12_to_bgrx_tile(c, f->y_plane, f->uv_plane, f->out,
+                                      f->width, f->height,
+                                      f->y_stride, f->uv_stride, f->out_stride,
+                                      x0, y0, (int)geo->tile_w, geo->vectorized);
+                }
+}
+
+static void
+frame_geometry(const TestFrame *f, Nv12LaunchGeometry *geo)
+{
+    nv12_launch_geometry(f->width, f->height,
+                         (uintptr_t)f->y_plane, (uintptr_t)f->uv_plane, (uintptr_t)f->out,
+                         f->y_stride, f->uv_stride, f->out_stride, geo);
+}
+
+static void
+bt709_coeffs(YuvToRgbCoeffs *c)
+{
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, "bt709");
+    colorimetry_get_yuv_to_rgb_coeffs(&cinfo, c);
+}
+
+/**
+ * The tiled emulation matches the per-pixel reference byte for byte
+ * (padding included) for odd/even sizes, padded strides and misaligned
+ * planes, i.e. across every tile width / vectorisation combination
+ */
+static void
+test_tiled_matches_reference(void)
+{
+    static const struct
+    {
+        int width, height, stride_pad, misalign;
+    } cases[] = {
+        {1, 1, 0, 0},
+        {2, 2, 0, 0},
+        {3, 5, 0, 0},
+        {4, 2, 0, 0},
+        {17, 9, 3, 0},
+        {64, 32, 0, 0},
+        {64, 32, 0, 1},
+        {66, 31, 2, 2},
+        {320, 240, 0, 4},
+        {1366, 768, 2, 0},
+        {1920, 1080, 0, 0},
+    };
+    YuvToRgbCoeffs c;
+    bt709_coeffs(&c);
+
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++)
+    {
+        TestFrame f;
+        Nv12LaunchGeometry geo;
+
+        test_frame_init(&f, cases[i].width, cases[i].height, cases[i].stride_pad, cases[i].misalign);
+        frame_geometry(&f, &geo);
+
+        emulate_launch(&f, &c, &geo);
+        nv12_to_bgrx_reference(f.y_plane, f.uv_plane, f.ref, f.width, f.height,
+                               f.y_stride, f.uv_stride, f.out_stride, &c);
+
+        gboolean same = memcmp(f.out, f.ref, (gsize)f.out_stride * f.height) == 0;
+        if (!same)
+            fprintf(stderr, "  %dx%d pad %d misalign %d (tile %u, vec %d)\n",
+                    f.width, f.height, cases[i].stride_pad, cases[i].misalign,
+                    geo.tile_w, geo.vectorized);
+        test_frame_clear(&f);
+        TEST_ASSERT(same, "Tiled output differs from reference");
+    }
+
+    TEST_PASS("test_tiled_matches_reference");
+}
+
+/**
+ * Tile width and vectorisation follow plane/stride alignment
+ */
+static void
+test_alignment_selection(void)
+{
+    Nv12LaunchGeometry geo;
+
+    nv12_launch_geometry(1920, 1080, 0x1000, 0x2000, 0x4000, 1920, 1920, 7680, &geo);
+    TEST_ASSERT(geo.tile_w == 4 && geo.vectorized, "Aligned frame should use 128-bit stores");
+
+    /* Output stride only 8-byte aligned */
+    nv12_launch_geometry(1922, 1080, 0x1000, 0x2000, 0x4000, 1924, 1924, 7688, &geo);
+    TEST_ASSERT(geo.tile_w == 2 && geo.vectorized, "8-byte output should use 64-bit stores");
+
+    /* Odd luma pointer */
+    nv12_launch_geometry(1920, 1080, 0x1001, 0x2000, 0x4000, 1920, 1920, 7680, &geo);
+    TEST_ASSERT(geo.tile_w == 2 && !geo.vectorized, "Odd input must not be vectorised");
+
+    /* Output pointer 4-byte aligned only */
+    nv12_launch_geometry(1920, 1080, 0x1000, 0x2000, 0x4004, 1920, 1920, 7680, &geo);
+    TEST_ASSERT(geo.tile_w == 2 && !geo.vectorized, "4-byte output must not be vectorised");
+
+    /* Too narrow for a 4-wide tile */
+    nv12_launch_geometry(2, 2, 0x1000, 0x2000, 0x4000, 16, 16, 16, &geo);
+    TEST_ASSERT(geo.tile_w == 2, "Width 2 should use 2-wide tiles");
+
+    TEST_PASS("test_alignment_selection");
+}
+
+/**
+ * The grid covers the whole frame, large frames keep the 32x8 block and
+ * small frames shrink it to produce more blocks
+ */
+static void
+test_grid_shape(void)
+{
+    static const int sizes[][2] = {
+        {1, 1}, {3, 5}, {160, 120}, {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+
+    for (guint i = 0; i < G_N_ELEMENTS(sizes); i++)
+    {
+        int w = sizes[i][0], h = sizes[i][1];
+        Nv12LaunchGeometry geo;
+
+        nv12_launch_geometry(w, h, 0, 0, 0, GST_ROUND_UP_16(w), GST_ROUND_UP_16(w),
+                             GST_ROUND_UP_16(w) * 4, &geo);
+
+        TEST_ASSERT((guint64)geo.grid_x * geo.block_x * geo.tile_w >= (guint64)w, "Grid too narrow");
+        TEST_ASSERT((guint64)geo.grid_y * geo.block_y * NV12_TILE_H >= (guint64)h, "Grid too short");
+        TEST_ASSERT((geo.grid_x - 1) * geo.block_x * geo.tile_w < (unsigned)w, "Wasted block column");
+        TEST_ASSERT((geo.grid_y - 1) * geo.block_y * NV12_TILE_H < (unsigned)h, "Wasted block row");
+        TEST_ASSERT(geo.block_x * geo.block_y >= 16 && geo.block_x * geo.block_y <= 256,
+                    "Block size out of range");
+
+        printf("  %5dx%-5d tile %ux2 block %2ux%u grid %4ux%u\n",
+               w, h, geo.tile_w, geo.block_x, geo.block_y, geo.grid_x, geo.grid_y);
+    }
+
+    Nv12LaunchGeometry big, small;
+    nv12_launch_geometry(1920, 1080, 0, 0, 0, 1920, 1920, 7680, &big);
+    nv12_launch_geometry(320, 240, 0, 0, 0, 320, 320, 1280, &small);
+    TEST_ASSERT(big.block_x == 32 && big.block_y == 8, "1080p should use 32x8 blocks");
+    TEST_ASSERT(small.block_x * small.block_y < 256, "Small frame should shrink the block");
+    /* 320x240 with 4x2 tiles is 80x120 threads: only 3x15 blocks at 32x8 */
+    TEST_ASSERT(small.grid_x * small.grid_y > 3 * 15,
+                "Small frame should produce more blocks than a fixed 32x8 shape");
+
+    TEST_PASS("test_grid_shape");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running NV12 launch geometry tests...\n\n");
+
+    test_tiled_matches_reference();
+    test_alignment_selection();
+    test_grid_shape();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
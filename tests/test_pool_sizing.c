@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the adaptive pool sizing policy: growth on busy buffers,
+ * the max bound, shrinking after sustained slack and the min bound.
+ * Needs no GPU.
+ */
+
+#include "pool_sizing.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+/* A pool that starts with @n buffers, as after activation */
+static void
+setup(PoolSizing *sizing, guint min_buffers, guint max_buffers, guint n)
+{
+    pool_sizing_init(sizing, min_buffers, max_buffers);
+    for (guint i = 0; i < n; i++)
+        pool_sizing_buffer_added(sizing);
+}
+
+/* @frames acquire/release cycles keeping @depth buffers in flight; frees
+ * the buffers the policy gives back. Returns the number freed. */
+static guint
+run(PoolSizing *sizing, guint depth, guint frames)
+{
+    guint freed = 0;
+
+    for (guint i = 0; i < depth; i++)
+        pool_sizing_acquire(sizing, FALSE);
+
+    for (guint f = 0; f < frames; f++)
+    {
+        pool_sizing_acquire(sizing, FALSE);
+        if (pool_sizing_release(sizing))
+        {
+            pool_sizing_buffer_removed(sizing);
+            freed++;
+        }
+    }
+
+    for (guint i = 0; i < depth; i++)
+    {
+        if (pool_sizing_release(sizing))
+        {
+            pool_sizing_buffer_removed(sizing);
+            freed++;
+        }
+    }
+
+    return freed;
+}
+
+/**
+ * Busy buffers ask for growth until max; in-flight depth and high-water
+ * mark follow acquire/release
+ */
+static void
+test_grow(void)
+{
+    PoolSizing sizing;
+
+    setup(&sizing, 4, 6, 4);
+
+    TEST_ASSERT(!pool_sizing_acquire(&sizing, FALSE), "An idle buffer needs no growth");
+    TEST_ASSERT(pool_sizing_acquire(&sizing, TRUE), "A busy buffer below max should grow");
+    pool_sizing_buffer_added(&sizing);
+    TEST_ASSERT(pool_sizing_acquire(&sizing, TRUE), "Still below max");
+    pool_sizing_buffer_added(&sizing);
+    TEST_ASSERT(!pool_sizing_acquire(&sizing, TRUE), "At max the caller must wait");
+    TEST_ASSERT(sizing.grows == 2 && sizing.allocated == 6, "Two growths");
+
+    TEST_ASSERT(sizing.in_flight == 4 && sizing.high_water == 4, "Four in flight");
+    pool_sizing_release(&sizing);
+    pool_sizing_release(&sizing);
+    TEST_ASSERT(sizing.in_flight == 2 && sizing.high_water == 4,
+                "High-water mark survives releases");
+
+    setup(&sizing, 4, 0, 4);
+    for (guint i = 0; i < 100; i++)
+    {
+        TEST_ASSERT(pool_sizing_acquire(&sizing, TRUE), "max 0 means unlimited");
+        pool_sizing_buffer_added(&sizing);
+    }
+
+    TEST_PASS("test_grow");
+}
+
+/**
+ * Buffers are given back one per POOL_SIZING_SLACK_WINDOWS windows of
+ * slack, never below min and not while the pipeline is deep
+ */
+static void
+test_shrink(void)
+{
+    PoolSizing sizing;
+    const guint slack_frames = POOL_SIZING_WINDOW * POOL_SIZING_SLACK_WINDOWS;
+
+    setup(&sizing, 4, 16, 10);
+    TEST_ASSERT(run(&sizing, 8, slack_frames * 4) == 0,
+                "Depth 9 with 10 buffers has no slack");
+
+    /* run() acquires depth + frames times: one short of the slack period */
+    setup(&sizing, 4, 16, 10);
+    TEST_ASSERT(run(&sizing, 1, slack_frames - 2) == 0, "Slack must be sustained");
+    TEST_ASSERT(run(&sizing, 1, 1) == 1, "One buffer per slack period");
+    TEST_ASSERT(sizing.allocated == 9 && sizing.shrinks == 1, "Shrunk by one");
+
+    run(&sizing, 1, slack_frames * 20);
+    TEST_ASSERT(sizing.allocated == 4, "Shrinking stops at min");
+
+    /* Slack then a busy buffer: pending shrink is cancelled */
+    setup(&sizing, 2, 16, 8);
+    run(&sizing, 0, slack_frames - 1);
+    pool_sizing_acquire(&sizing, FALSE);
+    pool_sizing_acquire(&sizing, TRUE);
+    TEST_ASSERT(!pool_sizing_release(&sizing), "Growth cancels the pending shrink");
+
+    TEST_PASS("test_shrink");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running pool sizing tests...\n\n");
+
+    test_grow();
+    test_shrink();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
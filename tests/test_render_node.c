@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for render node discovery against fake /dev/dri and sysfs
+ * trees: ordering, driver/PCI parsing, NVIDIA selection and bus ID
+ * matching. Needs no GPU.
+ */
+
+#include "render_node.h"
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+static gchar *tmp_dir = NULL;
+
+static void
+fake_file(const gchar *root, const gchar *rel, const gchar *contents)
+{
+    gchar *path = g_build_filename(root, rel, NULL);
+    gchar *dir = g_path_get_dirname(path);
+
+    g_mkdir_with_parents(dir, 0755);
+    g_file_set_contents(path, contents, -1, NULL);
+    g_free(path);
+    g_free(dir);
+}
+
+/* Render node @name with a device bound to @driver at @slot (NULL for a
+ * node without sysfs information) */
+static void
+fake_node(const gchar *root, const gchar *name, const gchar *driver, const gchar *slot)
+{
+    gchar *dev = g_strdup_printf("dev/dri/%s", name);
+    fake_file(root, dev, "");
+    g_free(dev);
+
+    if (!driver)
+        return;
+
+    gchar *rel = g_strdup_printf("sys/class/drm/%s/device/uevent", name);
+    gchar *uevent = g_strdup_printf("DRIVER=%s\nPCI_CLASS=30000\nPCI_SLOT_NAME=%s\n"
+                                    "MODALIAS=pci:v000010DE\n", driver, slot);
+    fake_file(root, rel, uevent);
+    g_free(uevent);
+    g_free(rel);
+}
+
+static void
+remove_tree(const gchar *path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+
+    if (dir)
+    {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir)) != NULL)
+        {
+            gchar *child = g_build_filename(path, name, NULL);
+            remove_tree(child);
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_remove(path);
+}
+
+/**
+ * Nodes are listed in numeric order with their driver and PCI slot;
+ * card and control nodes are ignored
+ */
+static void
+test_scan(void)
+{
+    gchar *root = g_build_filename(tmp_dir, "scan", NULL);
+
+    fake_node(root, "renderD1000", "amdgpu", "0000:0c:00.0");
+    fake_node(root, "renderD129", "nvidia", "0000:01:00.0");
+    fake_node(root, "renderD128", "i915", "0000:00:02.0");
+    fake_file(root, "dev/dri/card0", "");
+
+    RenderNodeTable *table = render_node_table_scan(root);
+    TEST_ASSERT(render_node_table_get_n_nodes(table) == 3, "Three render nodes expected");
+
+    const RenderNode *n0 = render_node_table_get_node(table, 0);
+    const RenderNode *n1 = render_node_table_get_node(table, 1);
+    const RenderNode *n2 = render_node_table_get_node(table, 2);
+    TEST_ASSERT(g_strcmp0(n0->path, "/dev/dri/renderD128") == 0 &&
+                    g_strcmp0(n1->path, "/dev/dri/renderD129") == 0 &&
+                    g_strcmp0(n2->path, "/dev/dri/renderD1000") == 0,
+                "Nodes should be sorted numerically and reported without the root");
+    TEST_ASSERT(g_strcmp0(n1->driver, "nvidia") == 0 &&
+                    g_strcmp0(n1->pci_bus_id, "0000:01:00.0") == 0,
+                "Driver and PCI slot should come from uevent");
+
+    TEST_ASSERT(g_strcmp0(render_node_table_find_nvidia(table, NULL), "/dev/dri/renderD129") == 0,
+                "The NVIDIA node should be found among others");
+
+    render_node_table_free(table);
+
+    /* A missing tree gives an empty table */
+    table = render_node_table_scan(tmp_dir);
+    TEST_ASSERT(render_node_table_get_n_nodes(table) == 0, "No /dev/dri should scan empty");
+    TEST_ASSERT(render_node_table_find_nvidia(table, NULL) == NULL, "Nothing to find");
+    render_node_table_free(table);
+
+    remove_tree(root);
+    g_free(root);
+    TEST_PASS("test_scan");
+}
+
+/**
+ * With several NVIDIA GPUs the node on the CUDA device's bus is picked;
+ * bus IDs compare by value
+ */
+static void
+test_bus_id_match(void)
+{
+    gchar *root = g_build_filename(tmp_dir, "multi", NULL);
+
+    fake_node(root, "renderD128", "nvidia", "0000:01:00.0");
+    fake_node(root, "renderD129", "nvidia", "0000:0a:00.0");
+
+    RenderNodeTable *table = render_node_table_scan(root);
+
+    TEST_ASSERT(g_strcmp0(render_node_table_find_nvidia(table, NULL), "/dev/dri/renderD128") == 0,
+                "Without a bus ID the first NVIDIA node is used");
+    TEST_ASSERT(g_strcmp0(render_node_table_find_nvidia(table, "0000:0A:00.0"),
+                          "/dev/dri/renderD129") == 0,
+                "CUDA-style upper-case bus ID should match");
+    TEST_ASSERT(g_strcmp0(render_node_table_find_nvidia(table, "00000000:0a:00.0"),
+                          "/dev/dri/renderD129") == 0,
+                "Eight-digit domain should match");
+    TEST_ASSERT(render_node_table_find_nvidia(table, "0000:02:00.0") == NULL,
+                "An unknown bus should not match");
+
+    TEST_ASSERT(render_node_bus_id_equal("0000:01:00.0", "0:1:0.0"), "Value comparison");
+    TEST_ASSERT(!render_node_bus_id_equal("0000:01:00.0", "0000:01:00.1"), "Function differs");
+    TEST_ASSERT(!render_node_bus_id_equal("garbage", "0000:01:00.0"), "Unparsable never matches");
+    TEST_ASSERT(!render_node_bus_id_equal(NULL, "0000:01:00.0"), "NULL never matches");
+
+    render_node_table_free(table);
+    remove_tree(root);
+    g_free(root);
+    TEST_PASS("test_bus_id_match");
+}
+
+/**
+ * Without sysfs, a node of unknown driver stands in for NVIDIA unless a
+ * bus ID is asked for
+ */
+static void
+test_no_sysfs(void)
+{
+    gchar *root = g_build_filename(tmp_dir, "nosys", NULL);
+
+    fake_node(root, "renderD128", NULL, NULL);
+    fake_node(root, "renderD129", "amdgpu", "0000:03:00.0");
+
+    RenderNodeTable *table = render_node_table_scan(root);
+    const RenderNode *n0 = render_node_table_get_node(table, 0);
+
+    TEST_ASSERT(n0 && n0->driver == NULL && n0->pci_bus_id == NULL,
+                "Node without uevent should have no driver or slot");
+    TEST_ASSERT(g_strcmp0(render_node_table_find_nvidia(table, NULL), "/dev/dri/renderD128") == 0,
+                "Unknown-driver node should be the fallback");
+    TEST_ASSERT(render_node_table_find_nvidia(table, "0000:03:00.0") == NULL,
+                "A bus ID only matches NVIDIA nodes");
+
+    render_node_table_free(table);
+    remove_tree(root);
+    g_free(root);
+    TEST_PASS("test_no_sysfs");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running render node tests...\n\n");
+
+    tmp_dir = g_dir_make_tmp("render-node-XXXXXX", NULL);
+    if (!tmp_dir)
+    {
+        fprintf(stderr, "Failed to create a temporary directory\n");
+        return 1;
+    }
+
+    test_scan();
+    test_bus_id_match();
+    test_no_sysfs();
+
+    remove_tree(tmp_dir);
+    g_free(tmp_dir);
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
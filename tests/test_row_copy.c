@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the banded, non-temporal row copy and NUMA-local workers
+ */
+
+#include "row_copy.h"
+#include "worker_pool.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define PAD_BYTE 0xAA
+
+/* Copy a @row_bytes x @rows block between buffers offset by @misalign
+ * bytes and compare against a reference, padding included: per row, or as
+ * one block (inter-row padding too) when the strides match */
+static gboolean
+check_copy(WorkerPool *pool, RowCopyMethod method, gsize row_bytes, gint rows,
+           gint src_stride, gint dst_stride, gint misalign)
+{
+    gsize src_size = (gsize)src_stride * rows;
+    gsize dst_size = (gsize)dst_stride * rows;
+    guint8 *src_mem = g_malloc(src_size + 64);
+    guint8 *dst_mem = g_malloc(dst_size + 64);
+    guint8 *ref = g_malloc(dst_size);
+    guint8 *src = src_mem + misalign;
+    guint8 *dst = dst_mem + (misalign * 3) % 16;
+
+    for (gsize i = 0; i < src_size; i++)
+        src[i] = (guint8)(i * 7 + 3);
+    memset(dst, PAD_BYTE, dst_size);
+    memset(ref, PAD_BYTE, dst_size);
+    if (src_stride == dst_stride)
+        memcpy(ref, src, (gsize)(rows - 1) * src_stride + row_bytes);
+    else
+        for (gint y = 0; y < rows; y++)
+            memcpy(ref + (gsize)y * dst_stride, src + (gsize)y * src_stride, row_bytes);
+
+    RowCopy copy = {src, src_stride, dst, dst_stride, row_bytes, rows};
+    row_copy_frame(pool, method, &copy);
+
+    gboolean same = memcmp(dst, ref, dst_size) == 0;
+    if (!same)
+        fprintf(stderr, "  method %d, %zu x %d, strides %d/%d, misalign %d\n",
+                method, row_bytes, rows, src_stride, dst_stride, misalign);
+
+    g_free(src_mem);
+    g_free(dst_mem);
+    g_free(ref);
+    return same;
+}
+
+/**
+ * Both methods match the reference for equal and different strides,
+ * any alignment and row lengths around the 16/64-byte store sizes
+ */
+static void
+test_methods_match_reference(void)
+{
+    static const gsize row_bytes[] = {1, 15, 16, 17, 63, 64, 65, 200, 7680};
+    static const RowCopyMethod methods[] = {ROW_COPY_MEMCPY, ROW_COPY_STREAM};
+
+    for (guint mi = 0; mi < G_N_ELEMENTS(methods); mi++)
+        for (guint ri = 0; ri < G_N_ELEMENTS(row_bytes); ri++)
+            for (gint misalign = 0; misalign < 16; misalign += 5)
+            {
+                gint stride = (gint)row_bytes[ri] + 3;
+
+                TEST_ASSERT(check_copy(NULL, methods[mi], row_bytes[ri], 9,
+                                       stride, stride, misalign),
+                            "Equal-stride copy differs from reference");
+                TEST_ASSERT(check_copy(NULL, methods[mi], row_bytes[ri], 9,
+                                       stride, stride + 29, misalign),
+                            "Strided copy differs from reference");
+                TEST_ASSERT(check_copy(NULL, methods[mi], row_bytes[ri], 9,
+                                       (gint)row_bytes[ri], (gint)row_bytes[ri], misalign),
+                            "Contiguous copy differs from reference");
+            }
+
+    printf("  non-temporal stores: %s\n", row_copy_has_stream() ? "yes" : "no (memcpy)");
+    TEST_PASS("test_methods_match_reference");
+}
+
+/**
+ * Row bands across a worker pool produce the same frame as one pass
+ */
+static void
+test_banded_copy(void)
+{
+    static const int threads[] = {1, 2, 3, 8};
+
+    for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+    {
+        WorkerPool *pool = worker_pool_new(threads[i]);
+        gboolean ok = check_copy(pool, ROW_COPY_STREAM, 1920 * 4, 543, 1920 * 4, 1920 * 4 + 256, 1) &&
+                      check_copy(pool, ROW_COPY_STREAM, 1920 * 4, 543, 1920 * 4, 1920 * 4, 0) &&
+                      check_copy(pool, ROW_COPY_MEMCPY, 333, 1001, 340, 512, 2);
+        worker_pool_free(pool);
+        TEST_ASSERT(ok, "Banded copy differs from reference");
+    }
+
+    TEST_PASS("test_banded_copy");
+}
+
+static void
+count_job(guint job, gpointer user_data)
+{
+    gint *hits = user_data;
+    g_atomic_int_inc(&hits[job]);
+}
+
+/**
+ * A NUMA-local pool has at least one thread and runs every job once
+ */
+static void
+test_numa_local_pool(void)
+{
+    WorkerPool *pool = worker_pool_new_numa_local(0);
+    gint hits[16] = {0};
+
+    TEST_ASSERT(worker_pool_get_n_threads(pool) >= 1, "Pool should have a thread");
+
+    worker_pool_run(pool, G_N_ELEMENTS(hits), count_job, hits);
+    for (guint i = 0; i < G_N_ELEMENTS(hits); i++)
+    {
+        if (hits[i] != 1)
+        {
+            worker_pool_free(pool);
+            TEST_ASSERT(FALSE, "Job ran the wrong number of times");
+        }
+    }
+
+    printf("  NUMA-local pool: %u threads\n", worker_pool_get_n_threads(pool));
+    worker_pool_free(pool);
+    TEST_PASS("test_numa_local_pool");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running row copy tests...\n\n");
+
+    test_methods_match_reference();
+    test_banded_copy();
+    test_numa_local_pool();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,431 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the scaling geometry and the CPU references of the fused
+ * scale + copy/conversion kernels (no GPU)
+ */
+
+#include "colorimetry.h"
+#include "scale_geometry.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+/* Semi-planar input with stride padding; @bps is 1 for NV12, 2 for P010 */
+typedef struct
+{
+    int width, height, bps;
+    int y_stride, uv_stride;
+    guint8 *y_plane, *uv_plane;
+} TestInput;
+
+static void
+test_input_init(TestInput *in, int width, int height, int bps)
+{
+    in->width = width;
+    in->height = height;
+    in->bps = bps;
+    in->y_stride = width * bps + 6;
+    in->uv_stride = ((width + 1) / 2) * 2 * bps + 6;
+    in->y_plane = g_malloc((gsize)in->y_stride * height);
+    in->uv_plane = g_malloc((gsize)in->uv_stride * ((height + 1) / 2));
+
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            scale_write(in->y_plane + y * in->y_stride + x * bps, bps,
+                        bps == 2 ? (x * 37 + y * 11) % 1024 : (x * 7 + y * 3) & 0xff);
+
+    for (int y = 0; y < (height + 1) / 2; y++)
+        for (int x = 0; x < ((width + 1) / 2) * 2; x++)
+            scale_write(in->uv_plane + y * in->uv_stride + x * bps, bps,
+                        bps == 2 ? (x * 53 + y * 29 + 64) % 1024 : (x * 13 + y * 5 + 101) & 0xff);
+}
+
+static void
+test_input_fill(TestInput *in, int y_value, int u_value, int v_value)
+{
+    for (int y = 0; y < in->height; y++)
+        for (int x = 0; x < in->width; x++)
+            scale_write(in->y_plane + y * in->y_stride + x * in->bps, in->bps, y_value);
+
+    for (int y = 0; y < (in->height + 1) / 2; y++)
+        for (int x = 0; x < (in->width + 1) / 2; x++)
+        {
+            guint8 *p = in->uv_plane + y * in->uv_stride + x * 2 * in->bps;
+            scale_write(p, in->bps, u_value);
+            scale_write(p + in->bps, in->bps, v_value);
+        }
+}
+
+static void
+test_input_clear(TestInput *in)
+{
+    g_free(in->y_plane);
+    g_free(in->uv_plane);
+}
+
+static void
+coeffs_for(const gchar *colorimetry, guint in_depth, guint out_depth, YuvToRgbCoeffs *c)
+{
+    GstVideoColorimetry cinfo;
+    gst_video_colorimetry_from_string(&cinfo, colorimetry);
+    colorimetry_get_yuv_to_rgb_coeffs_for_depth(&cinfo, in_depth, out_depth, c);
+}
+
+static guint32
+pixel_at(const guint8 *rgb, int stride, int x, int y)
+{
+    guint32 px;
+    memcpy(&px, rgb + y * stride + x * 4, 4);
+    return px;
+}
+
+/**
+ * Letterbox and pillarbox rectangles keep the display aspect ratio, are
+ * even-aligned and centred; without borders the picture fills the output
+ */
+static void
+test_letterbox_geometry(void)
+{
+    ScaleGeometry g;
+
+    /* 16:9 into 4:3: bars top and bottom */
+    scale_geometry_compute(3840, 2160, 1, 1, 960, 720, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_w == 960 && g.dst_h == 540, "16:9 in 4:3 should be 960x540");
+    TEST_ASSERT(g.dst_x == 0 && g.dst_y == 90, "16:9 in 4:3 should be centred vertically");
+
+    /* 4:3 into 16:9: bars left and right */
+    scale_geometry_compute(640, 480, 1, 1, 1920, 1080, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_w == 1440 && g.dst_h == 1080, "4:3 in 16:9 should be 1440x1080");
+    TEST_ASSERT(g.dst_x == 240 && g.dst_y == 0, "4:3 in 16:9 should be centred horizontally");
+
+    /* Anamorphic 720x576 at 64:45 is 16:9 on screen */
+    scale_geometry_compute(720, 576, 64, 45, 1920, 1080, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_w == 1920 && g.dst_h == 1080, "Anamorphic 16:9 should fill 1920x1080");
+
+    /* Odd results are rounded to even sizes and offsets */
+    scale_geometry_compute(1920, 1080, 1, 1, 501, 500, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_w == 501 && (g.dst_h % 2) == 0 && (g.dst_y % 2) == 0,
+                "Letterbox height and offset should be even");
+
+    /* Same aspect ratio: no bars */
+    scale_geometry_compute(1920, 1080, 1, 1, 1280, 720, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_x == 0 && g.dst_y == 0 && g.dst_w == 1280 && g.dst_h == 720,
+                "Matching aspect ratio should not add borders");
+
+    /* Stretch */
+    scale_geometry_compute(3840, 2160, 1, 1, 960, 720, FALSE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_x == 0 && g.dst_y == 0 && g.dst_w == 960 && g.dst_h == 720,
+                "Without borders the picture should fill the output");
+
+    TEST_ASSERT(scale_geometry_is_scaling(&g), "Downscale should be reported as scaling");
+    scale_geometry_compute(1920, 1080, 1, 1, 1920, 1080, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(!scale_geometry_is_scaling(&g), "Same size should not be reported as scaling");
+
+    TEST_PASS("test_letterbox_geometry");
+}
+
+/**
+ * Nearest at the same size reproduces the unscaled conversion exactly
+ */
+static void
+test_identity_matches_conversion(void)
+{
+    static const int sizes[][2] = {{2, 2}, {3, 5}, {17, 9}, {64, 36}};
+
+    for (guint i = 0; i < G_N_ELEMENTS(sizes); i++)
+    {
+        int w = sizes[i][0], h = sizes[i][1];
+        int out_stride = w * 4;
+        TestInput in;
+        ScaleGeometry g;
+        YuvToRgbCoeffs c;
+
+        test_input_init(&in, w, h, 1);
+        coeffs_for("bt709", 8, 8, &c);
+        scale_geometry_compute(w, h, 1, 1, w, h, FALSE, SCALE_METHOD_NEAREST, &g);
+
+        guint8 *scaled = g_malloc0((gsize)out_stride * h);
+        guint8 *ref = g_malloc0((gsize)out_stride * h);
+        scale_yuv_to_rgb_reference(in.y_plane, in.uv_plane, in.y_stride, in.uv_stride, FALSE,
+                                   scaled, out_stride, &g, &c, FALSE);
+        nv12_to_bgrx_reference(in.y_plane, in.uv_plane, ref, w, h,
+                               in.y_stride, in.uv_stride, out_stride, &c);
+        gboolean same = memcmp(scaled, ref, (gsize)out_stride * h) == 0;
+
+        g_free(scaled);
+        g_free(ref);
+        test_input_clear(&in);
+        TEST_ASSERT(same, "Identity nearest scale differs from NV12→BGRx");
+    }
+
+    TEST_PASS("test_identity_matches_conversion");
+}
+
+/**
+ * A flat picture stays flat under bilinear up- and downscaling
+ */
+static void
+test_constant_stays_constant(void)
+{
+    static const int outs[][2] = {{1, 1}, {7, 3}, {320, 180}, {1921, 1081}};
+    TestInput in;
+    YuvToRgbCoeffs c;
+
+    test_input_init(&in, 64, 36, 1);
+    test_input_fill(&in, 120, 90, 200);
+    coeffs_for("bt709", 8, 8, &c);
+
+    guint32 expected = yuv_to_bgrx_packed(&c, 120, 90, 200);
+
+    for (guint i = 0; i < G_N_ELEMENTS(outs); i++)
+    {
+        ScaleGeometry g;
+        scale_geometry_compute(64, 36, 1, 1, outs[i][0], outs[i][1], FALSE,
+                               SCALE_METHOD_BILINEAR, &g);
+
+        for (int y = 0; y < g.out_h; y++)
+            for (int x = 0; x < g.out_w; x++)
+            {
+                guint32 px = scale_yuv_to_rgb_pixel(&g, &c, in.y_plane, in.uv_plane,
+                                                    in.y_stride, in.uv_stride,
+                                                    FALSE, FALSE, x, y);
+                if (px != expected)
+                {
+                    test_input_clear(&in);
+                    TEST_ASSERT(FALSE, "Constant input changed under bilinear scaling");
+                }
+            }
+    }
+
+    test_input_clear(&in);
+    TEST_PASS("test_constant_stays_constant");
+}
+
+/**
+ * An exact 2:1 bilinear downscale averages each 2x2 luma block
+ */
+static void
+test_half_size_box_filter(void)
+{
+    TestInput in;
+    ScaleGeometry g;
+
+    test_input_init(&in, 16, 8, 1);
+    scale_geometry_compute(16, 8, 1, 1, 8, 4, FALSE, SCALE_METHOD_BILINEAR, &g);
+
+    for (int oy = 0; oy < 4; oy++)
+        for (int ox = 0; ox < 8; ox++)
+        {
+            int sum = 0;
+            for (int dy = 0; dy < 2; dy++)
+                for (int dx = 0; dx < 2; dx++)
+                    sum += in.y_plane[(oy * 2 + dy) * in.y_stride + ox * 2 + dx];
+
+            int value = scale_sample(in.y_plane, in.y_stride, 1, 1, 0, 16, 8,
+                                     scale_src_pos_q8(ox, 8, 16, 1, 16),
+                                     scale_src_pos_q8(oy, 4, 8, 1, 8),
+                                     SCALE_METHOD_BILINEAR);
+            if (value != (sum + 2) / 4)
+            {
+                test_input_clear(&in);
+                TEST_ASSERT(FALSE, "2:1 bilinear should average 2x2 blocks");
+            }
+        }
+
+    test_input_clear(&in);
+    TEST_PASS("test_half_size_box_filter");
+}
+
+/**
+ * Pixels outside the picture rectangle get the border colour, in both
+ * 8-bit BGRx and 2:10:10:10 output
+ */
+static void
+test_border_fill(void)
+{
+    TestInput in;
+    ScaleGeometry g;
+    YuvToRgbCoeffs c;
+
+    test_input_init(&in, 64, 36, 1);
+    coeffs_for("bt709", 8, 8, &c);
+    scale_geometry_compute(64, 36, 1, 1, 48, 48, TRUE, SCALE_METHOD_BILINEAR, &g);
+    TEST_ASSERT(g.dst_y > 0 && g.dst_x == 0, "16:9 in 1:1 should letterbox");
+
+    scale_geometry_set_border_rgb(&g, 0xff204080, FALSE);
+    TEST_ASSERT(g.border_rgb == 0xff204080, "BGRx border word");
+
+    guint8 *rgb = g_malloc0(48 * 4 * 48);
+    scale_yuv_to_rgb_reference(in.y_plane, in.uv_plane, in.y_stride, in.uv_stride, FALSE,
+                               rgb, 48 * 4, &g, &c, FALSE);
+
+    gboolean ok = pixel_at(rgb, 48 * 4, 0, 0) == 0xff204080 &&
+                  pixel_at(rgb, 48 * 4, 47, g.dst_y - 1) == 0xff204080 &&
+                  pixel_at(rgb, 48 * 4, 10, g.dst_y + g.dst_h) == 0xff204080 &&
+                  pixel_at(rgb, 48 * 4, 47, 47) == 0xff204080 &&
+                  pixel_at(rgb, 48 * 4, 10, g.dst_y) != 0xff204080;
+    g_free(rgb);
+    test_input_clear(&in);
+    TEST_ASSERT(ok, "Border pixels should carry the border colour");
+
+    scale_geometry_set_border_rgb(&g, 0xffffffff, TRUE);
+    TEST_ASSERT(g.border_rgb == 0xffffffff, "White 2:10:10:10 border should be full scale");
+    scale_geometry_set_border_rgb(&g, 0xff000000, TRUE);
+    TEST_ASSERT(g.border_rgb == 0xc0000000, "Black 2:10:10:10 border should be zero");
+
+    TEST_PASS("test_border_fill");
+}
+
+/**
+ * Semi-planar scaling at the same size is a plain copy, for NV12 and P010
+ */
+static void
+test_semi_planar_identity(void)
+{
+    for (int bps = 1; bps <= 2; bps++)
+    {
+        int w = 18, h = 10;
+        TestInput in;
+        ScaleGeometry g;
+
+        test_input_init(&in, w, h, bps);
+        scale_geometry_compute(w, h, 1, 1, w, h, FALSE, SCALE_METHOD_BILINEAR, &g);
+
+        int y_out_stride = w * bps, uv_out_stride = w * bps;
+        guint8 *y_out = g_malloc0((gsize)y_out_stride * h);
+        guint8 *uv_out = g_malloc0((gsize)uv_out_stride * h / 2);
+        scale_semi_planar_reference(in.y_plane, in.uv_plane, in.y_stride, in.uv_stride,
+                                    y_out, uv_out, y_out_stride, uv_out_stride, &g, bps == 2);
+
+        gboolean same = TRUE;
+        for (int y = 0; y < h; y++)
+            same &= memcmp(y_out + y * y_out_stride, in.y_plane + y * in.y_stride, w * bps) == 0;
+        for (int y = 0; y < h / 2; y++)
+            same &= memcmp(uv_out + y * uv_out_stride, in.uv_plane + y * in.uv_stride, w * bps) == 0;
+
+        g_free(y_out);
+        g_free(uv_out);
+        test_input_clear(&in);
+        TEST_ASSERT(same, bps == 2 ? "P010 identity scale is not a copy"
+                                   : "NV12 identity scale is not a copy");
+    }
+
+    TEST_PASS("test_semi_planar_identity");
+}
+
+/**
+ * Semi-planar letterbox borders carry the Y/U/V border values
+ */
+static void
+test_semi_planar_border(void)
+{
+    TestInput in;
+    ScaleGeometry g;
+
+    test_input_init(&in, 64, 36, 2);
+    scale_geometry_compute(64, 36, 1, 1, 32, 32, TRUE, SCALE_METHOD_NEAREST, &g);
+    g.border_y = 64;
+    g.border_u = 512;
+    g.border_v = 512;
+
+    guint8 *y_out = g_malloc0(32 * 2 * 32);
+    guint8 *uv_out = g_malloc0(32 * 2 * 16);
+    scale_semi_planar_reference(in.y_plane, in.uv_plane, in.y_stride, in.uv_stride,
+                                y_out, uv_out, 64, 64, &g, TRUE);
+
+    gboolean ok = p010_sample(y_out) == 64 &&
+                  p010_sample(y_out + (g.dst_y + g.dst_h) * 64) == 64 &&
+                  p010_sample(uv_out) == 512 && p010_sample(uv_out + 2) == 512 &&
+                  p010_sample(uv_out + 15 * 64) == 512;
+    g_free(y_out);
+    g_free(uv_out);
+    test_input_clear(&in);
+    TEST_ASSERT(ok, "Semi-planar border should carry the border Y/U/V");
+
+    TEST_PASS("test_semi_planar_border");
+}
+
+/**
+ * RGB border colours map to the expected limited-range Y/U/V code values
+ */
+static void
+test_rgb_to_yuv(void)
+{
+    GstVideoColorimetry cinfo;
+    gint32 y, u, v;
+
+    gst_video_colorimetry_from_string(&cinfo, "bt709");
+
+    colorimetry_rgb_to_yuv(&cinfo, 8, 0, 0, 0, &y, &u, &v);
+    TEST_ASSERT(y == 16 && u == 128 && v == 128, "8-bit black should be 16/128/128");
+
+    colorimetry_rgb_to_yuv(&cinfo, 8, 255, 255, 255, &y, &u, &v);
+    TEST_ASSERT(y == 235 && u == 128 && v == 128, "8-bit white should be 235/128/128");
+
+    colorimetry_rgb_to_yuv(&cinfo, 10, 0, 0, 0, &y, &u, &v);
+    TEST_ASSERT(y == 64 && u == 512 && v == 512, "10-bit black should be 64/512/512");
+
+    colorimetry_rgb_to_yuv(&cinfo, 10, 255, 255, 255, &y, &u, &v);
+    TEST_ASSERT(y == 940 && u == 512 && v == 512, "10-bit white should be 940/512/512");
+
+    /* Round trip through the conversion matrix stays within one step */
+    YuvToRgbCoeffs c;
+    coeffs_for("bt709", 8, 8, &c);
+    colorimetry_rgb_to_yuv(&cinfo, 8, 32, 64, 128, &y, &u, &v);
+    guint32 px = yuv_to_bgrx_packed(&c, y, u, v);
+    TEST_ASSERT(abs((int)((px >> 16) & 0xff) - 32) <= 2 &&
+                    abs((int)((px >> 8) & 0xff) - 64) <= 2 &&
+                    abs((int)(px & 0xff) - 128) <= 2,
+                "RGB→YUV→RGB should round trip");
+
+    TEST_PASS("test_rgb_to_yuv");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running scale geometry tests...\n\n");
+
+    test_letterbox_geometry();
+    test_identity_matches_conversion();
+    test_constant_stays_constant();
+    test_half_size_box_filter();
+    test_border_fill();
+    test_semi_planar_identity();
+    test_semi_planar_border();
+    test_rgb_to_yuv();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: MIT
+ * SPDX-FileCopyrightText: 2025 Ericky
+ *
+ * Unit tests for the system-memory NV12/I420/P010 plane copy
+ */
+
+#include "semi_planar_copy.h"
+#include "worker_pool.h"
+
+#include <gst/gst.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg)                  \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            fprintf(stderr, "FAIL: %s\n", msg); \
+            tests_failed++;                     \
+            return;                             \
+        }                                       \
+    } while (0)
+
+#define TEST_PASS(name)             \
+    do                              \
+    {                               \
+        printf("PASS: %s\n", name); \
+        tests_passed++;             \
+    } while (0)
+
+#define PAD_BYTE 0xAA
+
+/* Source planes and two destinations (under test and reference), all with
+ * padded strides */
+typedef struct
+{
+    SemiPlanarCopy copy;
+    guint8 *src[3];
+    guint8 *ref[2];
+    gsize dst_size[2];
+} TestCopy;
+
+static void
+test_copy_init(TestCopy *t, SemiPlanarSrc fmt, int width, int height, int stride_pad)
+{
+    int bps = fmt == SEMI_PLANAR_SRC_P010 ? 2 : 1;
+    int chroma_w = (width + 1) / 2;
+    int chroma_h = (height + 1) / 2;
+    int n_src = fmt == SEMI_PLANAR_SRC_I420 ? 3 : 2;
+
+    memset(t, 0, sizeof(*t));
+    t->copy.src_format = fmt;
+    t->copy.width = width;
+    t->copy.height = height;
+
+    t->copy.src_stride[0] = width * bps + stride_pad;
+    if (fmt == SEMI_PLANAR_SRC_I420)
+        t->copy.src_stride[1] = t->copy.src_stride[2] = chroma_w + stride_pad;
+    else
+        t->copy.src_stride[1] = chroma_w * 2 * bps + stride_pad;
+
+    for (int p = 0; p < n_src; p++)
+    {
+        gsize size = (gsize)t->copy.src_stride[p] * (p == 0 ? height : chroma_h);
+        t->src[p] = g_malloc(size);
+        for (gsize i = 0; i < size; i++)
+            t->src[p][i] = (guint8)(i * (7 + p * 6) + 3 + p * 50);
+        t->copy.src[p] = t->src[p];
+    }
+
+    /* Destination strides differ from the source to catch mixed-up strides */
+    t->copy.dst_stride[0] = width * bps + stride_pad * 2 + 5;
+    t->copy.dst_stride[1] = chroma_w * 2 * bps + stride_pad * 2 + 5;
+    for (int p = 0; p < 2; p++)
+    {
+        t->dst_size[p] = (gsize)t->copy.dst_stride[p] * (p == 0 ? height : chroma_h);
+        t->copy.dst[p] = g_malloc(t->dst_size[p]);
+        t->ref[p] = g_malloc(t->dst_size[p]);
+        memset(t->copy.dst[p], PAD_BYTE, t->dst_size[p]);
+        memset(t->ref[p], PAD_BYTE, t->dst_size[p]);
+    }
+}
+
+/* Straightforward per-sample copy into ref[] */
+static void
+test_copy_reference(TestCopy *t)
+{
+    const SemiPlanarCopy *c = &t->copy;
+    int bps = c->src_format == SEMI_PLANAR_SRC_P010 ? 2 : 1;
+    int chroma_w = (c->width + 1) / 2;
+
+    for (int y = 0; y < c->height; y++)
+        for (int x = 0; x < c->width * bps; x++)
+            t->ref[0][y * c->dst_stride[0] + x] = c->src[0][y * c->src_stride[0] + x];
+
+    for (int y = 0; y < (c->height + 1) / 2; y++)
+        for (int x = 0; x < chroma_w; x++)
+            for (int b = 0; b < 2 * bps; b++)
+            {
+                guint8 v;
+                if (c->src_format == SEMI_PLANAR_SRC_I420)
+                    v = c->src[1 + b][y * c->src_stride[1 + b] + x];
+                else
+                    v = c->src[1][y * c->src_stride[1] + x * 2 * bps + b];
+                t->ref[1][y * c->dst_stride[1] + x * 2 * bps + b] = v;
+            }
+}
+
+static gboolean
+test_copy_matches(const TestCopy *t)
+{
+    return memcmp(t->copy.dst[0], t->ref[0], t->dst_size[0]) == 0 &&
+           memcmp(t->copy.dst[1], t->ref[1], t->dst_size[1]) == 0;
+}
+
+static void
+test_copy_clear(TestCopy *t)
+{
+    for (int p = 0; p < 3; p++)
+        g_free(t->src[p]);
+    for (int p = 0; p < 2; p++)
+    {
+        g_free(t->copy.dst[p]);
+        g_free(t->ref[p]);
+    }
+}
+
+/**
+ * NV12, I420 and P010 copies match the reference across odd sizes and
+ * padded strides, and leave the destination padding untouched
+ */
+static void
+test_formats_match_reference(void)
+{
+    static const struct
+    {
+        int width, height, stride_pad;
+    } sizes[] = {
+        {1, 1, 0}, {2, 2, 0}, {7, 3, 1}, {15, 5, 3}, {16, 4, 0},
+        {17, 9, 2}, {33, 7, 0}, {64, 32, 16}, {1366, 6, 2},
+    };
+    static const SemiPlanarSrc formats[] = {
+        SEMI_PLANAR_SRC_NV12, SEMI_PLANAR_SRC_I420, SEMI_PLANAR_SRC_P010};
+
+    for (guint fi = 0; fi < G_N_ELEMENTS(formats); fi++)
+        for (guint si = 0; si < G_N_ELEMENTS(sizes); si++)
+        {
+            TestCopy t;
+
+            test_copy_init(&t, formats[fi], sizes[si].width, sizes[si].height,
+                           sizes[si].stride_pad);
+            semi_planar_copy_rows(&t.copy, 0, t.copy.height);
+            test_copy_reference(&t);
+
+            gboolean same = test_copy_matches(&t);
+            if (!same)
+                fprintf(stderr, "  format %d %dx%d pad %d\n", formats[fi],
+                        sizes[si].width, sizes[si].height, sizes[si].stride_pad);
+            test_copy_clear(&t);
+            TEST_ASSERT(same, "Plane copy differs from reference");
+        }
+
+    TEST_PASS("test_formats_match_reference");
+}
+
+/**
+ * Row bands across a worker pool produce the same planes as one pass
+ */
+static void
+test_banded_copy(void)
+{
+    static const int threads[] = {1, 2, 3, 8};
+    static const SemiPlanarSrc formats[] = {
+        SEMI_PLANAR_SRC_NV12, SEMI_PLANAR_SRC_I420, SEMI_PLANAR_SRC_P010};
+
+    for (guint i = 0; i < G_N_ELEMENTS(threads); i++)
+    {
+        WorkerPool *pool = worker_pool_new(threads[i]);
+
+        for (guint fi = 0; fi < G_N_ELEMENTS(formats); fi++)
+        {
+            TestCopy t;
+
+            test_copy_init(&t, formats[fi], 321, 243, 3);
+            semi_planar_copy_frame(pool, &t.copy);
+            test_copy_reference(&t);
+
+            gboolean same = test_copy_matches(&t);
+            test_copy_clear(&t);
+            if (!same)
+                worker_pool_free(pool);
+            TEST_ASSERT(same, "Banded plane copy differs from reference");
+        }
+
+        worker_pool_free(pool);
+    }
+
+    TEST_PASS("test_banded_copy");
+}
+
+/**
+ * A NULL pool copies on the calling thread
+ */
+static void
+test_no_pool(void)
+{
+    TestCopy t;
+
+    test_copy_init(&t, SEMI_PLANAR_SRC_I420, 99, 77, 1);
+    semi_planar_copy_frame(NULL, &t.copy);
+    test_copy_reference(&t);
+
+    gboolean same = test_copy_matches(&t);
+    test_copy_clear(&t);
+    TEST_ASSERT(same, "Unpooled plane copy differs from reference");
+
+    TEST_PASS("test_no_pool");
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+
+    printf("Running semi-planar copy tests...\n\n");
+
+    test_formats_match_reference();
+    test_banded_copy();
+    test_no_pool();
+
+    printf("\n========================================\n");
+    printf("Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("========================================\n");
+
+    gst_deinit();
+
+    return tests_failed > 0 ? 1 : 0;
+}